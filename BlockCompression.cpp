@@ -0,0 +1,579 @@
+#include "BlockCompression.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// BC7 interpolation weights for 4-bit indices (out of 64)
+	const int Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// ----------------------------------------------------
+	// Mean and dominant direction of the block's colors,
+	// found with a few rounds of power iteration on the
+	// covariance matrix
+	// ----------------------------------------------------
+	void PrincipalAxis(const float pixels[16][4], int channels, float mean[4], float axis[4])
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			mean[c] = 0;
+			for (int i = 0; i < 16; i++)
+				mean[c] += pixels[i][c];
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float d[4];
+			for (int c = 0; c < channels; c++)
+				d[c] = pixels[i][c] - mean[c];
+			for (int r = 0; r < channels; r++)
+				for (int c = 0; c < channels; c++)
+					covariance[r][c] += d[r] * d[c];
+		}
+
+		float v[4] = { 1, 1, 1, 1 };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			for (int r = 0; r < channels; r++)
+				for (int c = 0; c < channels; c++)
+					next[r] += covariance[r][c] * v[c];
+
+			float length = 0;
+			for (int c = 0; c < channels; c++)
+				length += next[c] * next[c];
+			length = sqrtf(length);
+
+			// Flat block (or one perpendicular to the guess)
+			if (length < 1e-6f)
+				break;
+			for (int c = 0; c < channels; c++)
+				v[c] = next[c] / length;
+		}
+
+		float length = 0;
+		for (int c = 0; c < channels; c++)
+			length += v[c] * v[c];
+		length = sqrtf(length);
+		for (int c = 0; c < 4; c++)
+			axis[c] = c < channels ? v[c] / length : 0.0f;
+	}
+
+	// Furthest points of the block along its principal axis
+	void FitLine(const float pixels[16][4], int channels, float low[4], float high[4])
+	{
+		float mean[4];
+		float axis[4];
+		PrincipalAxis(pixels, channels, mean, axis);
+
+		float minT = 0;
+		float maxT = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0;
+			for (int c = 0; c < channels; c++)
+				t += (pixels[i][c] - mean[c]) * axis[c];
+			if (t < minT) minT = t;
+			if (t > maxT) maxT = t;
+		}
+
+		for (int c = 0; c < 4; c++)
+		{
+			low[c] = mean[c] + axis[c] * minT;
+			high[c] = mean[c] + axis[c] * maxT;
+		}
+	}
+
+	void LoadBlock(const unsigned char* rgba, float pixels[16][4])
+	{
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 4; c++)
+				pixels[i][c] = rgba[i * 4 + c];
+	}
+
+	unsigned short Pack565(const float color[3])
+	{
+		int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+		r = r < 0 ? 0 : r > 31 ? 31 : r;
+		g = g < 0 ? 0 : g > 63 ? 63 : g;
+		b = b < 0 ? 0 : b > 31 ? 31 : b;
+		return (unsigned short)((r << 11) | (g << 5) | b);
+	}
+
+	void Unpack565(unsigned short c, int color[3])
+	{
+		int r = (c >> 11) & 31;
+		int g = (c >> 5) & 63;
+		int b = c & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// Writes bits least significant first, as BC7 expects
+	struct BitWriter {
+		unsigned char* data;
+		int pos;
+
+		void Write(unsigned int value, int bits)
+		{
+			for (int i = 0; i < bits; i++, pos++)
+				if ((value >> i) & 1)
+					data[pos / 8] |= (unsigned char)(1 << (pos % 8));
+		}
+	};
+
+	struct BitReader {
+		const unsigned char* data;
+		int pos;
+
+		unsigned int Read(int bits)
+		{
+			unsigned int value = 0;
+			for (int i = 0; i < bits; i++, pos++)
+				value |= (unsigned int)((data[pos / 8] >> (pos % 8)) & 1) << i;
+			return value;
+		}
+	};
+
+	// ----------------------------------------------------
+	// BC7 mode 6 helpers. Endpoints are 7 bits per channel
+	// plus one shared low bit (the "p-bit") per endpoint.
+	// ----------------------------------------------------
+	struct Mode6Endpoint {
+		int q[4];	// 7-bit channels
+		int p;		// p-bit
+	};
+
+	Mode6Endpoint QuantizeMode6(const float color[4])
+	{
+		Mode6Endpoint best = {};
+		float bestError = 1e30f;
+		for (int p = 0; p < 2; p++)
+		{
+			Mode6Endpoint e = {};
+			e.p = p;
+			float error = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				int q = (int)floorf((color[c] - p) / 2.0f + 0.5f);
+				e.q[c] = q < 0 ? 0 : q > 127 ? 127 : q;
+				float d = (float)((e.q[c] << 1) | p) - color[c];
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				best = e;
+			}
+		}
+		return best;
+	}
+
+	// Picks the closest of the 16 interpolated colors per pixel, returns total error
+	float ChooseMode6Indices(const float pixels[16][4], const Mode6Endpoint& e0, const Mode6Endpoint& e1, int indices[16])
+	{
+		int palette[16][4];
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				int a = (e0.q[c] << 1) | e0.p;
+				int b = (e1.q[c] << 1) | e1.p;
+				palette[i][c] = ((64 - Weights4[i]) * a + Weights4[i] * b + 32) >> 6;
+			}
+		}
+
+		float total = 0;
+		for (int p = 0; p < 16; p++)
+		{
+			float bestError = 1e30f;
+			for (int i = 0; i < 16; i++)
+			{
+				float error = 0;
+				for (int c = 0; c < 4; c++)
+				{
+					float d = palette[i][c] - pixels[p][c];
+					error += d * d;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					indices[p] = i;
+				}
+			}
+			total += bestError;
+		}
+		return total;
+	}
+
+	// Solves for the endpoints that best fit the chosen indices
+	void RefineMode6(const float pixels[16][4], const int indices[16], float low[4], float high[4])
+	{
+		float aa = 0, ab = 0, bb = 0;
+		float ax[4] = {}, bx[4] = {};
+		for (int p = 0; p < 16; p++)
+		{
+			float w = Weights4[indices[p]] / 64.0f;
+			float iw = 1.0f - w;
+			aa += iw * iw;
+			ab += iw * w;
+			bb += w * w;
+			for (int c = 0; c < 4; c++)
+			{
+				ax[c] += iw * pixels[p][c];
+				bx[c] += w * pixels[p][c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (fabsf(det) < 1e-6f)
+			return;
+
+		for (int c = 0; c < 4; c++)
+		{
+			float l = (bb * ax[c] - ab * bx[c]) / det;
+			float h = (aa * bx[c] - ab * ax[c]) / det;
+			low[c] = l < 0 ? 0 : l > 255 ? 255 : l;
+			high[c] = h < 0 ? 0 : h > 255 ? 255 : h;
+		}
+	}
+}
+
+void BlockCompression::EncodeBC1(const unsigned char* rgba, unsigned char* block)
+{
+	float pixels[16][4];
+	LoadBlock(rgba, pixels);
+
+	float low[4];
+	float high[4];
+	FitLine(pixels, 3, low, high);
+
+	// 4-color mode needs the first endpoint to be the larger one
+	unsigned short c0 = Pack565(high);
+	unsigned short c1 = Pack565(low);
+	if (c0 < c1)
+	{
+		unsigned short t = c0;
+		c0 = c1;
+		c1 = t;
+	}
+
+	unsigned int indices = 0;
+	if (c0 != c1)
+	{
+		int palette[4][3];
+		Unpack565(c0, palette[0]);
+		Unpack565(c1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int p = 0; p < 16; p++)
+		{
+			int best = 0;
+			float bestError = 1e30f;
+			for (int i = 0; i < 4; i++)
+			{
+				float error = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					float d = palette[i][c] - pixels[p][c];
+					error += d * d;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					best = i;
+				}
+			}
+			indices |= (unsigned int)best << (p * 2);
+		}
+	}
+
+	block[0] = (unsigned char)(c0 & 255);
+	block[1] = (unsigned char)(c0 >> 8);
+	block[2] = (unsigned char)(c1 & 255);
+	block[3] = (unsigned char)(c1 >> 8);
+	memcpy(block + 4, &indices, 4);
+}
+
+void BlockCompression::EncodeBC4(const unsigned char* rgba, int channel, unsigned char* block)
+{
+	int high = 0;
+	int low = 255;
+	for (int i = 0; i < 16; i++)
+	{
+		int v = rgba[i * 4 + channel];
+		if (v > high) high = v;
+		if (v < low) low = v;
+	}
+
+	// 8-level mode: first endpoint larger than the second
+	block[0] = (unsigned char)high;
+	block[1] = (unsigned char)low;
+
+	unsigned long long indices = 0;
+	if (high != low)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			// Position along high -> low, then the format's index order
+			int step = (int)((high - rgba[i * 4 + channel]) * 7.0f / (high - low) + 0.5f);
+			int index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+			indices |= (unsigned long long)index << (i * 3);
+		}
+	}
+
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+void BlockCompression::EncodeBC5(const unsigned char* rgba, unsigned char* block)
+{
+	EncodeBC4(rgba, 0, block);
+	EncodeBC4(rgba, 1, block + 8);
+}
+
+void BlockCompression::EncodeBC7(const unsigned char* rgba, unsigned char* block)
+{
+	float pixels[16][4];
+	LoadBlock(rgba, pixels);
+
+	float low[4];
+	float high[4];
+	FitLine(pixels, 4, low, high);
+
+	Mode6Endpoint e0 = QuantizeMode6(low);
+	Mode6Endpoint e1 = QuantizeMode6(high);
+	int indices[16];
+	float error = ChooseMode6Indices(pixels, e0, e1, indices);
+
+	// One least-squares pass, kept only if it actually helps
+	RefineMode6(pixels, indices, low, high);
+	Mode6Endpoint r0 = QuantizeMode6(low);
+	Mode6Endpoint r1 = QuantizeMode6(high);
+	int refined[16];
+	if (ChooseMode6Indices(pixels, r0, r1, refined) < error)
+	{
+		e0 = r0;
+		e1 = r1;
+		memcpy(indices, refined, sizeof(indices));
+	}
+
+	// The first index drops its top bit, so it must be < 8
+	if (indices[0] >= 8)
+	{
+		Mode6Endpoint t = e0;
+		e0 = e1;
+		e1 = t;
+		for (int i = 0; i < 16; i++)
+			indices[i] = 15 - indices[i];
+	}
+
+	memset(block, 0, 16);
+	BitWriter out = { block, 0 };
+	out.Write(1 << 6, 7); // Mode 6
+	for (int c = 0; c < 4; c++)
+	{
+		out.Write(e0.q[c], 7);
+		out.Write(e1.q[c], 7);
+	}
+	out.Write(e0.p, 1);
+	out.Write(e1.p, 1);
+	out.Write(indices[0], 3);
+	for (int i = 1; i < 16; i++)
+		out.Write(indices[i], 4);
+}
+
+void BlockCompression::DecodeBC1(const unsigned char* block, unsigned char* rgba)
+{
+	unsigned short c0 = (unsigned short)(block[0] | (block[1] << 8));
+	unsigned short c1 = (unsigned short)(block[2] | (block[3] << 8));
+	unsigned int indices;
+	memcpy(&indices, block + 4, 4);
+
+	int palette[4][4];
+	Unpack565(c0, palette[0]);
+	Unpack565(c1, palette[1]);
+	palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+	for (int c = 0; c < 3; c++)
+	{
+		if (c0 > c1)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			// 3-color mode with transparent black
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	if (c0 <= c1)
+		palette[3][3] = 0;
+
+	for (int p = 0; p < 16; p++)
+		for (int c = 0; c < 4; c++)
+			rgba[p * 4 + c] = (unsigned char)palette[(indices >> (p * 2)) & 3][c];
+}
+
+void BlockCompression::DecodeBC4(const unsigned char* block, int channel, unsigned char* rgba)
+{
+	int values[8];
+	values[0] = block[0];
+	values[1] = block[1];
+	if (values[0] > values[1])
+	{
+		for (int i = 2; i < 8; i++)
+			values[i] = ((8 - i) * values[0] + (i - 1) * values[1]) / 7;
+	}
+	else
+	{
+		for (int i = 2; i < 6; i++)
+			values[i] = ((6 - i) * values[0] + (i - 1) * values[1]) / 5;
+		values[6] = 0;
+		values[7] = 255;
+	}
+
+	unsigned long long indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= (unsigned long long)block[2 + i] << (i * 8);
+
+	for (int p = 0; p < 16; p++)
+		rgba[p * 4 + channel] = (unsigned char)values[(indices >> (p * 3)) & 7];
+}
+
+void BlockCompression::DecodeBC5(const unsigned char* block, unsigned char* rgba)
+{
+	DecodeBC4(block, 0, rgba);
+	DecodeBC4(block + 8, 1, rgba);
+	for (int p = 0; p < 16; p++)
+	{
+		rgba[p * 4 + 2] = 0;
+		rgba[p * 4 + 3] = 255;
+	}
+}
+
+// --------------------------------------------------------
+// Only mode 6 is understood, since that's all the encoder
+// writes - anything else decodes to magenta
+// --------------------------------------------------------
+void BlockCompression::DecodeBC7(const unsigned char* block, unsigned char* rgba)
+{
+	BitReader in = { block, 0 };
+	if (in.Read(7) != (1u << 6))
+	{
+		for (int p = 0; p < 16; p++)
+		{
+			rgba[p * 4 + 0] = 255;
+			rgba[p * 4 + 1] = 0;
+			rgba[p * 4 + 2] = 255;
+			rgba[p * 4 + 3] = 255;
+		}
+		return;
+	}
+
+	int e[2][4];
+	for (int c = 0; c < 4; c++)
+	{
+		e[0][c] = in.Read(7) << 1;
+		e[1][c] = in.Read(7) << 1;
+	}
+	int p0 = in.Read(1);
+	int p1 = in.Read(1);
+	for (int c = 0; c < 4; c++)
+	{
+		e[0][c] |= p0;
+		e[1][c] |= p1;
+	}
+
+	for (int p = 0; p < 16; p++)
+	{
+		int index = in.Read(p == 0 ? 3 : 4);
+		for (int c = 0; c < 4; c++)
+			rgba[p * 4 + c] = (unsigned char)(((64 - Weights4[index]) * e[0][c] + Weights4[index] * e[1][c] + 32) >> 6);
+	}
+}
+
+int BlockCompression::BytesPerBlock(BlockFormat format)
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t BlockCompression::CompressedSize(int width, int height, BlockFormat format)
+{
+	size_t blocksWide = (width + 3) / 4;
+	size_t blocksHigh = (height + 3) / 4;
+	return blocksWide * blocksHigh * BytesPerBlock(format);
+}
+
+std::vector<unsigned char> BlockCompression::Compress(const unsigned char* rgba, int width, int height, BlockFormat format)
+{
+	std::vector<unsigned char> output(CompressedSize(width, height, format));
+	int blockBytes = BytesPerBlock(format);
+	unsigned char* out = output.data();
+
+	for (int by = 0; by < height; by += 4)
+	{
+		for (int bx = 0; bx < width; bx += 4, out += blockBytes)
+		{
+			// Gather the block, repeating edge texels past the image
+			unsigned char texels[64];
+			for (int y = 0; y < 4; y++)
+			{
+				int sy = by + y < height ? by + y : height - 1;
+				for (int x = 0; x < 4; x++)
+				{
+					int sx = bx + x < width ? bx + x : width - 1;
+					memcpy(texels + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+				}
+			}
+
+			switch (format)
+			{
+			case BlockFormat::BC1: EncodeBC1(texels, out); break;
+			case BlockFormat::BC4: EncodeBC4(texels, 0, out); break;
+			case BlockFormat::BC5: EncodeBC5(texels, out); break;
+			case BlockFormat::BC7: EncodeBC7(texels, out); break;
+			}
+		}
+	}
+
+	return output;
+}
+
+std::vector<unsigned char> BlockCompression::Decompress(const unsigned char* blocks, int width, int height, BlockFormat format)
+{
+	std::vector<unsigned char> output((size_t)width * height * 4, 255);
+	int blockBytes = BytesPerBlock(format);
+
+	for (int by = 0; by < height; by += 4)
+	{
+		for (int bx = 0; bx < width; bx += 4, blocks += blockBytes)
+		{
+			unsigned char texels[64];
+			memset(texels, 255, sizeof(texels));
+			switch (format)
+			{
+			case BlockFormat::BC1: DecodeBC1(blocks, texels); break;
+			case BlockFormat::BC4: DecodeBC4(blocks, 0, texels); break;
+			case BlockFormat::BC5: DecodeBC5(blocks, texels); break;
+			case BlockFormat::BC7: DecodeBC7(blocks, texels); break;
+			}
+
+			for (int y = 0; y < 4 && by + y < height; y++)
+				for (int x = 0; x < 4 && bx + x < width; x++)
+					memcpy(output.data() + ((size_t)(by + y) * width + bx + x) * 4, texels + (y * 4 + x) * 4, 4);
+		}
+	}
+
+	return output;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+enum class BlockFormat {
+	BC1,	// RGB, 4 bits per pixel
+	BC4,	// One channel (red), 4 bits per pixel
+	BC5,	// Two channels (red + green), 8 bits per pixel
+	BC7		// RGBA, 8 bits per pixel, much better quality than BC1
+};
+
+// --------------------------------------------------------
+// CPU encoders for the block-compressed formats the texture
+// cooker writes. Every block covers 4x4 texels, given as
+// 16 RGBA8 pixels in row order.
+//
+// The encoders favor speed over the last bit of quality:
+// - BC1 and BC7 fit endpoints along the block's principal
+//   axis (BC7 only uses mode 6, a single RGBA line with
+//   16 levels, then refines it with a least-squares pass)
+// - BC4/BC5 use the channel's min and max in 8-level mode
+// --------------------------------------------------------
+namespace BlockCompression
+{
+	void EncodeBC1(const unsigned char* rgba, unsigned char* block);
+	void EncodeBC4(const unsigned char* rgba, int channel, unsigned char* block);
+	void EncodeBC5(const unsigned char* rgba, unsigned char* block);
+	void EncodeBC7(const unsigned char* rgba, unsigned char* block);
+
+	// Decoders, used to measure encoding error
+	void DecodeBC1(const unsigned char* block, unsigned char* rgba);
+	void DecodeBC4(const unsigned char* block, int channel, unsigned char* rgba);
+	void DecodeBC5(const unsigned char* block, unsigned char* rgba);
+	void DecodeBC7(const unsigned char* block, unsigned char* rgba);
+
+	int BytesPerBlock(BlockFormat format);
+	size_t CompressedSize(int width, int height, BlockFormat format);
+
+	// Compresses a whole RGBA8 image, padding partial blocks by clamping
+	std::vector<unsigned char> Compress(const unsigned char* rgba, int width, int height, BlockFormat format);
+	std::vector<unsigned char> Decompress(const unsigned char* blocks, int width, int height, BlockFormat format);
+}
@@ -1,8 +1,12 @@
+// Must match MAX_BLUR_TAPS in BufferStructs.h
+#define MAX_BLUR_TAPS 32
+
 cbuffer externalData : register(b0)
 {
-    float pixelWidth;
-    float pixelHeight;
-    int blurRadius;
+    float2 texelStep; // One texel along the blur direction, in UVs
+    int tapCount;
+    float padding;
+    float4 taps[MAX_BLUR_TAPS]; // x = offset in texels, y = weight
 }
 
 struct VertexToPixel
@@ -14,27 +18,26 @@ struct VertexToPixel
 Texture2D Pixels : register(t0);
 SamplerState ClampSampler : register(s0);
 
+// --------------------------------------------------------
+// One direction of a separable Gaussian blur
+// 
+// Each tap sits between two texels so the linear sampler
+// blends them with the right weights in a single read.
+// A single tap with no offset is a plain (bilinear) copy,
+// which is how the downsample and upsample steps run.
+// --------------------------------------------------------
 float4 main(VertexToPixel input) : SV_TARGET
 {
-    // Track the total color and number of samples
-    float3 color = float3(0, 0, 0);
-    int sampleCount = 0;
+    // Center is read once
+    float3 color = Pixels.Sample(ClampSampler, input.uv).rgb * taps[0].y;
     
-    // Loop through the "box"
-    for (int x = -blurRadius; x <= blurRadius; x++)
+    // Every other tap is mirrored on both sides
+    for (int i = 1; i < tapCount; i++)
     {
-        for (int y = -blurRadius; y <= blurRadius; y++)
-        {
-            // Calculate the uv for this sample
-            float2 uv = input.uv;
-            uv += float2(x * pixelWidth, y * pixelHeight);
-            
-            // Add this color to the running total
-            color += Pixels.Sample(ClampSampler, uv).rgb;
-            sampleCount++;
-        }
+        float2 offset = texelStep * taps[i].x;
+        color += Pixels.Sample(ClampSampler, input.uv + offset).rgb * taps[i].y;
+        color += Pixels.Sample(ClampSampler, input.uv - offset).rgb * taps[i].y;
     }
     
-    // Return the average
-    return float4(color / sampleCount, 1);
-}
\ No newline at end of file
+    return float4(color, 1);
+}
@@ -0,0 +1,53 @@
+// Must match MAX_BLUR_TAPS in BufferStructs.h
+#define MAX_BLUR_TAPS 32
+
+cbuffer externalData : register(b0)
+{
+    float2 texelSize; // One source texel in UVs
+    int pixelSize;
+    int tapCount;
+    float4 taps[MAX_BLUR_TAPS]; // x = offset in texels, y = weight
+}
+
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+Texture2D Pixels : register(t0);
+SamplerState ClampSampler : register(s0);
+
+// --------------------------------------------------------
+// Blur and pixelation in one pass
+// 
+// Every pixel in a block wants the blurred color at the
+// block's center, so the separable kernel is evaluated as
+// its 2D product right there. The same linear-sampling taps
+// as BlurPS.hlsl are used on both axes, so each read still
+// blends a 2x2 group of texels.
+// --------------------------------------------------------
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    // Center of this pixel's block
+    float2 blockSize = pixelSize * texelSize;
+    float2 center = (floor(input.uv / blockSize) + 0.5f) * blockSize;
+    
+    float3 color = float3(0, 0, 0);
+    for (int y = 1 - tapCount; y < tapCount; y++)
+    {
+        float4 tapY = taps[abs(y)];
+        float offsetY = y < 0 ? -tapY.x : tapY.x;
+        
+        for (int x = 1 - tapCount; x < tapCount; x++)
+        {
+            float4 tapX = taps[abs(x)];
+            float offsetX = x < 0 ? -tapX.x : tapX.x;
+            
+            float2 uv = center + float2(offsetX, offsetY) * texelSize;
+            color += Pixels.Sample(ClampSampler, uv).rgb * (tapX.y * tapY.y);
+        }
+    }
+    
+    return float4(color, 1);
+}
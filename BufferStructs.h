@@ -27,7 +27,44 @@ struct PixelShaderExternalData {
 	Light lights[5];
 };
 
+// Must match MAX_ATLAS_SHADOWS in ShadowAtlas.hlsli
+#define MAX_ATLAS_SHADOWS 12
+
+// One shadow view inside the shadow atlas
+struct AtlasShadowData {
+	DirectX::XMFLOAT4X4 viewProjection;
+	DirectX::XMFLOAT4 atlasRect;	// xy = uv offset, zw = uv size
+};
+
+struct ShadowAtlasExternalData {
+	AtlasShadowData shadows[MAX_ATLAS_SHADOWS];
+};
+
+// Must match MAX_BLUR_TAPS in BlurPS.hlsl
+#define MAX_BLUR_TAPS 32
+
+struct BlurExternalData {
+	DirectX::XMFLOAT2 texelStep;	// One texel along the blur direction, in UVs
+	int tapCount;
+	float padding;
+	DirectX::XMFLOAT4 taps[MAX_BLUR_TAPS];	// x = offset in texels, y = weight
+};
+
+struct BlurPixelateExternalData {
+	DirectX::XMFLOAT2 texelSize;	// One source texel in UVs
+	int pixelSize;
+	int tapCount;
+	DirectX::XMFLOAT4 taps[MAX_BLUR_TAPS];	// Same taps as BlurExternalData
+};
+
 struct SkyBoxExternalData {
 	DirectX::XMFLOAT4X4 viewMatrix;
 	DirectX::XMFLOAT4X4 projectionMatrix;
 };
+
+struct IBLExternalData {
+	DirectX::XMFLOAT4 irradianceSH[9];	// From IBLBaker, rgb used
+	float specularMipCount;
+	float intensity;
+	DirectX::XMFLOAT2 padding;
+};
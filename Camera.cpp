@@ -19,6 +19,8 @@ Camera::Camera(DirectX::XMFLOAT3 position,
 	// set position of camera
 	transform = std::make_shared<Transform>();
 	transform->SetPosition(position);
+	stepStartPosition = position;
+	stepEndPosition = position;
 
 	// update view and projection matrix
 	UpdateViewMatrix();
@@ -65,8 +67,13 @@ void Camera::UpdateProjectionMatrix(float _aspectRatio)
 
 void Camera::UpdateViewMatrix()
 {
-	// get position and forward vector of camera from transform
-	DirectX::XMFLOAT3 position = transform->GetPosition();
+	viewPosition = transform->GetPosition();
+	BuildViewMatrix(viewPosition);
+}
+
+void Camera::BuildViewMatrix(DirectX::XMFLOAT3 position)
+{
+	// get forward vector of camera from transform
 	DirectX::XMFLOAT3 forwardVec = transform->GetForward();
 
 	// create view matrix
@@ -81,6 +88,17 @@ void Camera::UpdateViewMatrix()
 
 void Camera::Update(float dt)
 {
+	UpdateMovement(dt);
+	UpdateLook();
+
+	// Update View Matrix
+	UpdateViewMatrix();
+}
+
+void Camera::UpdateMovement(float dt)
+{
+	stepStartPosition = transform->GetPosition();
+
 	// set a speed according to deltaTime and camera speed
 	float speed = dt * cameraSpeed;
 
@@ -92,6 +110,11 @@ void Camera::Update(float dt)
 	if (Input::KeyDown(' ')) { transform->MoveAbsolute(0, speed, 0); }
 	if (Input::KeyDown('X')) {transform->MoveAbsolute(0, -speed, 0);}
 
+	stepEndPosition = transform->GetPosition();
+}
+
+void Camera::UpdateLook()
+{
 	// Mouse Controls
 	if (Input::MouseLeftDown()) {
 
@@ -108,9 +131,28 @@ void Camera::Update(float dt)
 		if (rotation.x < -DirectX::XM_PIDIV2) rotation.x = -DirectX::XM_PIDIV2;
 		transform->SetRotation(rotation);
 	}
+}
 
-	// Update View Matrix
-	UpdateViewMatrix();
+void Camera::InterpolateView(float alpha)
+{
+	// Moved since the last step by something else: no sliding over from where it was
+	DirectX::XMFLOAT3 position = transform->GetPosition();
+	if (position.x != stepEndPosition.x || position.y != stepEndPosition.y || position.z != stepEndPosition.z)
+	{
+		stepStartPosition = position;
+		stepEndPosition = position;
+	}
+
+	DirectX::XMStoreFloat3(&viewPosition, DirectX::XMVectorLerp(
+		DirectX::XMLoadFloat3(&stepStartPosition),
+		DirectX::XMLoadFloat3(&position),
+		alpha));
+	BuildViewMatrix(viewPosition);
+}
+
+DirectX::XMFLOAT3 Camera::GetViewPosition()
+{
+	return viewPosition;
 }
 
 DirectX::XMFLOAT4X4 Camera::GetView()
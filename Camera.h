@@ -29,6 +29,17 @@ public:
 	void UpdateViewMatrix();
 	void Update(float dt);
 
+	// Update() in two halves, for a fixed step simulation:
+	// mouse look once per frame, key movement once per step
+	void UpdateLook();
+	void UpdateMovement(float dt);
+
+	// Puts the view part way between where the last movement
+	// step started (alpha 0) and ended (alpha 1). A camera moved
+	// any other way (teleported) snaps straight there.
+	void InterpolateView(float alpha);
+	DirectX::XMFLOAT3 GetViewPosition();
+
 	// getters
 	DirectX::XMFLOAT4X4 GetView();
 	DirectX::XMFLOAT4X4 GetProjection();
@@ -58,6 +69,8 @@ public:
 	void SetMouseLookSpeed(float speed);
 
 private:
+	void BuildViewMatrix(DirectX::XMFLOAT3 position);
+
 	// Camera core variables
 	std::shared_ptr<Transform> transform;
 	DirectX::XMFLOAT4X4 viewMatrix;
@@ -72,5 +85,10 @@ private:
 	float mouseLookSpeed;
 	float orthographicWidth;
 	ProjectionType projectionType;
+
+	// Where the view is, and the last movement step it's between
+	DirectX::XMFLOAT3 viewPosition;
+	DirectX::XMFLOAT3 stepStartPosition;
+	DirectX::XMFLOAT3 stepEndPosition;
 };
 
@@ -0,0 +1,65 @@
+#pragma once
+#include <DirectXMath.h>
+#include "Transform.h"
+#include "World.h"
+
+// Components the game puts on entities in its World; the
+// systems that use them are in GameSystems.h. Transform is
+// a component as is.
+
+#define ENTITY_STATIC 0x1		// Never moves, so its shadow can be cached
+#define ENTITY_OCCLUDER 0x2		// Rasterized on the CPU to hide whatever is behind it
+
+// Something to draw, by index into the game's meshes and materials
+struct MeshRenderer {
+	int mesh;
+	int material;
+	unsigned int flags;		// ENTITY_ flags
+};
+
+// Turns at a constant rate
+struct Spin {
+	DirectX::XMFLOAT3 rate;		// Pitch, yaw, roll in radians per second
+};
+
+// Swings back and forth: origin + amplitude * sin(time * speed)
+struct Sway {
+	DirectX::XMFLOAT3 origin;
+	DirectX::XMFLOAT3 amplitude;
+	float speed;				// Radians per second
+};
+
+// Where the Transform was when the last simulation step
+// started, so rendering can blend towards where it is now
+struct PreviousTransform {
+	TransformState state;
+	unsigned int version;		// The Transform's version then; unchanged means it didn't move
+};
+
+// Moves one of the game's lights along with the entity
+struct LightAttachment {
+	int light;					// Index into the lights
+	DirectX::XMFLOAT3 offset;	// From the entity's position
+};
+
+// --------------------------------------------------------
+// One thing to draw this frame, gathered from the World by
+// the render system so the renderer, shadows and texture
+// streaming all walk one flat list
+//
+// Its matrices and bounds are where it is this frame, part
+// way between the last two simulation steps, which may not
+// be where its Transform is. Nothing points back into the
+// World, so the list can be drawn while the World updates.
+// --------------------------------------------------------
+struct Renderable {
+	EntityHandle entity;
+	unsigned int version;		// Its Transform's version, to spot movement
+	int mesh;
+	int material;
+	unsigned int flags;			// ENTITY_ flags
+	DirectX::XMFLOAT3 center;	// World space bounding sphere
+	float radius;
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTrans;
+};
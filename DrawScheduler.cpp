@@ -0,0 +1,89 @@
+#include "DrawScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+DrawScheduler::DrawScheduler() :
+	cameraPosition(0, 0, 0),
+	depthPrepass(false)
+{
+}
+
+DrawScheduler::~DrawScheduler()
+{
+}
+
+void DrawScheduler::Begin(DirectX::XMFLOAT3 _cameraPosition, bool _depthPrepass)
+{
+	cameraPosition = _cameraPosition;
+	depthPrepass = _depthPrepass;
+	drawList.clear();
+	transparentList.clear();
+	passes.clear();
+}
+
+void DrawScheduler::Add(int entityIndex, DirectX::XMFLOAT3 center, float radius, bool transparent)
+{
+	float dx = center.x - cameraPosition.x;
+	float dy = center.y - cameraPosition.y;
+	float dz = center.z - cameraPosition.z;
+
+	// Big objects (like the floor) start closer than their center
+	DrawItem item = {};
+	item.entityIndex = entityIndex;
+	item.distance = sqrtf(dx * dx + dy * dy + dz * dz) - radius;
+	(transparent ? transparentList : drawList).push_back(item);
+}
+
+void DrawScheduler::Finish()
+{
+	// Front to back, index breaks ties so the order is stable frame to frame
+	std::sort(drawList.begin(), drawList.end(), [](const DrawItem& a, const DrawItem& b) {
+		if (a.distance != b.distance) return a.distance < b.distance;
+		return a.entityIndex < b.entityIndex;
+	});
+
+	// Back to front, with the same tie break
+	std::sort(transparentList.begin(), transparentList.end(), [](const DrawItem& a, const DrawItem& b) {
+		if (a.distance != b.distance) return a.distance > b.distance;
+		return a.entityIndex < b.entityIndex;
+	});
+
+	if (depthPrepass)
+	{
+		passes.push_back({ "Depth Pre-Pass", true, DepthTest::LessWrite, false });
+		passes.push_back({ "Main (Depth Equal)", false, DepthTest::EqualNoWrite, false });
+	}
+	else
+	{
+		passes.push_back({ "Main", false, DepthTest::LessWrite, false });
+	}
+
+	// Never in the pre-pass: they'd hide the opaque surfaces they blend over
+	if (!transparentList.empty())
+		passes.push_back({ "Transparent", false, DepthTest::LessNoWrite, true });
+}
+
+const std::vector<DrawItem>& DrawScheduler::GetDrawList()
+{
+	return drawList;
+}
+
+const std::vector<DrawItem>& DrawScheduler::GetTransparentList()
+{
+	return transparentList;
+}
+
+const std::vector<DrawItem>& DrawScheduler::GetItems(const ScheduledPass& pass)
+{
+	return pass.transparent ? transparentList : drawList;
+}
+
+const std::vector<ScheduledPass>& DrawScheduler::GetPasses()
+{
+	return passes;
+}
+
+bool DrawScheduler::UsesDepthPrepass()
+{
+	return depthPrepass;
+}
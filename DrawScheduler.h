@@ -0,0 +1,63 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+// One entity to draw, with its sort key
+struct DrawItem {
+	int entityIndex;
+	float distance;		// Camera to the nearest point of the bounding sphere
+};
+
+// How a pass uses the depth buffer
+enum class DepthTest {
+	LessWrite,			// Normal depth testing and writing
+	EqualNoWrite,		// Only the surface the pre-pass kept
+	LessNoWrite			// Tested against the opaque depth, but never hides what's behind
+};
+
+// A pass over the whole draw list
+struct ScheduledPass {
+	const char* name;
+	bool depthOnly;		// No pixel shader, just fill the depth buffer
+	DepthTest depthTest;
+	bool transparent;	// Draws the transparent list instead of the opaque one
+};
+
+// --------------------------------------------------------
+// Orders a frame's opaque draws and decides which passes
+// run over them
+//
+// - Draws are sorted front-to-back so early-Z rejects as
+//   many hidden fragments as possible
+// - Transparent draws go last, back-to-front, so each one
+//   blends over everything behind it
+// - With the pre-pass on, a depth-only pass comes first and
+//   the shaded pass only touches pixels with EQUAL depth,
+//   so every pixel is shaded once
+//
+// No device access, so ordering can be checked on its own
+// --------------------------------------------------------
+class DrawScheduler
+{
+public:
+	DrawScheduler();
+	~DrawScheduler();
+
+	void Begin(DirectX::XMFLOAT3 _cameraPosition, bool _depthPrepass);
+	void Add(int entityIndex, DirectX::XMFLOAT3 center, float radius, bool transparent = false);
+	void Finish();
+
+	const std::vector<DrawItem>& GetDrawList();
+	const std::vector<DrawItem>& GetTransparentList();
+	const std::vector<DrawItem>& GetItems(const ScheduledPass& pass);
+	const std::vector<ScheduledPass>& GetPasses();
+	bool UsesDepthPrepass();
+
+private:
+	DirectX::XMFLOAT3 cameraPosition;
+	bool depthPrepass;
+
+	std::vector<DrawItem> drawList;
+	std::vector<DrawItem> transparentList;
+	std::vector<ScheduledPass> passes;
+};
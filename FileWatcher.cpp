@@ -0,0 +1,265 @@
+#include "FileWatcher.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#endif
+
+#if defined(_WIN32)
+namespace
+{
+	// One outstanding ReadDirectoryChangesW per directory
+	struct DirectoryRead {
+		HANDLE directory;
+		OVERLAPPED overlapped;
+		DWORD buffer[4096];		// DWORD aligned, as the API needs
+	};
+
+	bool BeginRead(DirectoryRead& read)
+	{
+		return ReadDirectoryChangesW(read.directory, read.buffer, sizeof(read.buffer), FALSE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+			0, &read.overlapped, 0) != 0;
+	}
+
+	std::string Narrow(const wchar_t* text, int length)
+	{
+		int size = WideCharToMultiByte(CP_UTF8, 0, text, length, 0, 0, 0, 0);
+		std::string result(size, '\0');
+		WideCharToMultiByte(CP_UTF8, 0, text, length, &result[0], size, 0, 0);
+		return result;
+	}
+}
+#endif
+
+FileWatcher::FileWatcher(int settleMs) :
+	quitting(false),
+	settleTime(settleMs)
+{
+#if defined(_WIN32)
+	stopEvent = CreateEventW(0, TRUE, FALSE, 0);
+#elif defined(__linux__)
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+
+#if defined(_WIN32)
+	for (void* handle : handles)
+		CloseHandle(handle);
+	CloseHandle(stopEvent);
+#elif defined(__linux__)
+	if (inotifyFd >= 0)
+		close(inotifyFd);
+#endif
+}
+
+bool FileWatcher::Watch(const std::string& directory)
+{
+	// The thread only knows the directories it started with
+	Stop();
+
+	bool watching = false;
+#if defined(_WIN32)
+	HANDLE handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0, OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, 0);
+	if (handle != INVALID_HANDLE_VALUE && handles.size() < MAXIMUM_WAIT_OBJECTS - 1)
+	{
+		handles.push_back(handle);
+		watching = true;
+	}
+	else if (handle != INVALID_HANDLE_VALUE)
+		CloseHandle(handle);
+#elif defined(__linux__)
+	int wd = inotifyFd < 0 ? -1 : inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE);
+	if (wd >= 0)
+	{
+		watchDirectories[wd] = directory;
+		watching = true;
+	}
+#else
+	// Remember what's there now, so only later changes are reported
+	std::error_code ec;
+	for (auto& entry : std::filesystem::directory_iterator(directory, ec))
+		modifiedTimes[entry.path().string()] = entry.last_write_time(ec).time_since_epoch().count();
+	watching = !ec;
+#endif
+
+	if (watching)
+		directories.push_back(directory);
+	if (!directories.empty())
+		Start();
+	return watching;
+}
+
+std::vector<std::string> FileWatcher::PollChanges()
+{
+	std::vector<std::string> settled;
+	auto now = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	for (auto it = pending.begin(); it != pending.end();)
+	{
+		if (now - it->second >= settleTime)
+		{
+			settled.push_back(it->first);
+			it = pending.erase(it);
+		}
+		else
+			++it;
+	}
+	return settled;
+}
+
+int FileWatcher::GetDirectoryCount()
+{
+	return (int)directories.size();
+}
+
+void FileWatcher::Start()
+{
+	quitting = false;
+#if defined(_WIN32)
+	ResetEvent(stopEvent);
+#endif
+	thread = std::thread(&FileWatcher::WatchLoop, this);
+}
+
+void FileWatcher::Stop()
+{
+	if (!thread.joinable())
+		return;
+
+	quitting = true;
+#if defined(_WIN32)
+	SetEvent(stopEvent);
+#endif
+	thread.join();
+}
+
+// Restarts the settle clock for a file
+void FileWatcher::Changed(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	pending[path] = std::chrono::steady_clock::now();
+}
+
+#if defined(_WIN32)
+
+void FileWatcher::WatchLoop()
+{
+	std::vector<DirectoryRead> reads(handles.size());
+	std::vector<HANDLE> waits;
+	for (size_t i = 0; i < handles.size(); i++)
+	{
+		reads[i] = {};
+		reads[i].directory = handles[i];
+		reads[i].overlapped.hEvent = CreateEventW(0, TRUE, FALSE, 0);
+		BeginRead(reads[i]);
+		waits.push_back(reads[i].overlapped.hEvent);
+	}
+	waits.push_back(stopEvent);
+
+	while (!quitting)
+	{
+		DWORD result = WaitForMultipleObjects((DWORD)waits.size(), waits.data(), FALSE, INFINITE);
+		DWORD index = result - WAIT_OBJECT_0;
+		if (index >= reads.size())
+			break; // Stop event (or a failed wait)
+
+		DirectoryRead& read = reads[index];
+		DWORD bytes = 0;
+		if (GetOverlappedResult(read.directory, &read.overlapped, &bytes, FALSE) && bytes > 0)
+		{
+			// Zero bytes means the buffer overflowed and the details were lost
+			const unsigned char* cursor = (const unsigned char*)read.buffer;
+			while (true)
+			{
+				const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)cursor;
+				if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+					Changed(directories[index] + "\\" + Narrow(info->FileName, (int)(info->FileNameLength / sizeof(wchar_t))));
+
+				if (info->NextEntryOffset == 0)
+					break;
+				cursor += info->NextEntryOffset;
+			}
+		}
+
+		ResetEvent(read.overlapped.hEvent);
+		BeginRead(read);
+	}
+
+	// Wait for the cancelled reads before their buffers go away
+	for (DirectoryRead& read : reads)
+	{
+		DWORD bytes = 0;
+		CancelIo(read.directory);
+		GetOverlappedResult(read.directory, &read.overlapped, &bytes, TRUE);
+		CloseHandle(read.overlapped.hEvent);
+	}
+}
+
+#elif defined(__linux__)
+
+void FileWatcher::WatchLoop()
+{
+	alignas(inotify_event) char buffer[4096];
+	while (!quitting)
+	{
+		// Wake up now and then to check for quitting
+		pollfd fd = { inotifyFd, POLLIN, 0 };
+		if (poll(&fd, 1, 100) <= 0)
+			continue;
+
+		ssize_t length;
+		while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* cursor = buffer; cursor < buffer + length;)
+			{
+				const inotify_event* event = (const inotify_event*)cursor;
+				auto dir = watchDirectories.find(event->wd);
+				if (event->len > 0 && dir != watchDirectories.end())
+					Changed(dir->second + "/" + event->name);
+				cursor += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+}
+
+#else
+
+void FileWatcher::WatchLoop()
+{
+	while (!quitting)
+	{
+		// Check about once a second
+		for (int i = 0; i < 20 && !quitting; i++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		for (const std::string& directory : directories)
+		{
+			std::error_code ec;
+			for (auto& entry : std::filesystem::directory_iterator(directory, ec))
+			{
+				long long time = entry.last_write_time(ec).time_since_epoch().count();
+				long long& known = modifiedTimes[entry.path().string()];
+				if (known != time)
+				{
+					known = time;
+					Changed(entry.path().string());
+				}
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// Reports files that change in a set of directories
+//
+// - A background thread waits on the OS: ReadDirectoryChangesW
+//   on Windows, inotify on Linux, and a once-a-second scan of
+//   modification times anywhere else
+// - Editors tend to save in several writes (or write a temp
+//   file and rename it), so a file is only reported once it
+//   has gone quiet for the settle time; repeated changes to
+//   it in the meantime are folded into one
+// - PollChanges() hands out what's settled, on any thread
+//
+// Directories are watched on their own, not recursively.
+// --------------------------------------------------------
+class FileWatcher
+{
+public:
+	FileWatcher(int settleMs = 150);
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// False if the directory can't be watched
+	bool Watch(const std::string& directory);
+
+	// Full paths (directory + separator + file name) of files
+	// that changed and have since settled
+	std::vector<std::string> PollChanges();
+
+	int GetDirectoryCount();
+
+private:
+	void Start();
+	void Stop();
+	void WatchLoop();
+	void Changed(const std::string& path);
+
+	std::vector<std::string> directories;
+	std::thread thread;
+	std::atomic<bool> quitting;
+
+	// Written by the watch thread
+	std::mutex pendingMutex;
+	std::unordered_map<std::string, std::chrono::steady_clock::time_point> pending;
+	std::chrono::milliseconds settleTime;
+
+	// Platform state
+#if defined(_WIN32)
+	std::vector<void*> handles;		// Directory handles
+	void* stopEvent;
+#elif defined(__linux__)
+	int inotifyFd;
+	std::unordered_map<int, std::string> watchDirectories;
+#else
+	std::unordered_map<std::string, long long> modifiedTimes;
+#endif
+};
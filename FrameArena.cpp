@@ -0,0 +1,106 @@
+#include "FrameArena.h"
+#include <new>
+
+FrameArena::FrameArena(size_t bytesPerFrame) :
+	current(0),
+	stats()
+{
+	for (Frame& frame : frames)
+	{
+		frame.memory = (unsigned char*)::operator new(bytesPerFrame, std::align_val_t(alignof(std::max_align_t)));
+		frame.capacity = bytesPerFrame;
+		frame.offset = 0;
+		frame.allocations = 0;
+		frame.overflowBytes = 0;
+	}
+	stats.capacity = bytesPerFrame;
+}
+
+FrameArena::~FrameArena()
+{
+	for (Frame& frame : frames)
+	{
+		frame.capacity = 0;
+		Reset(frame);
+		::operator delete(frame.memory, std::align_val_t(alignof(std::max_align_t)));
+	}
+}
+
+// --------------------------------------------------------
+// Closes out the current frame's stats, then switches to the
+// other buffer and empties it
+// --------------------------------------------------------
+void FrameArena::BeginFrame()
+{
+	Frame& finished = frames[current];
+	stats.usedBytes = finished.offset.load() + finished.overflowBytes;
+	stats.allocations = finished.allocations.load();
+	stats.overflowAllocations = (int)finished.overflow.size();
+	if (stats.usedBytes > stats.peakBytes)
+		stats.peakBytes = stats.usedBytes;
+
+	current ^= 1;
+	Reset(frames[current]);
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	Frame& frame = frames[current];
+	frame.allocations++;
+
+	// Claim [start, end) unless another thread got there first
+	size_t offset = frame.offset.load(std::memory_order_relaxed);
+	size_t start, end;
+	do
+	{
+		start = (offset + alignment - 1) & ~(alignment - 1);
+		end = start + bytes;
+		if (end > frame.capacity)
+		{
+			// Out of room - the heap, until the next reset
+			if (alignment < alignof(std::max_align_t))
+				alignment = alignof(std::max_align_t);
+			void* memory = ::operator new(bytes, std::align_val_t(alignment));
+			std::lock_guard<std::mutex> lock(overflowMutex);
+			frame.overflow.push_back({ memory, alignment });
+			frame.overflowBytes += bytes;
+			return memory;
+		}
+	} while (!frame.offset.compare_exchange_weak(offset, end, std::memory_order_relaxed));
+
+	return frame.memory + start;
+}
+
+FrameArenaStats FrameArena::GetStats()
+{
+	return stats;
+}
+
+// --------------------------------------------------------
+// Frees the heap fallbacks and, if there were any, grows
+// the buffer to fit everything that frame wanted
+// --------------------------------------------------------
+void FrameArena::Reset(Frame& frame)
+{
+	size_t wanted = frame.offset.load() + frame.overflowBytes;
+	for (auto& o : frame.overflow)
+		::operator delete(o.memory, std::align_val_t(o.alignment));
+
+	if (!frame.overflow.empty() && frame.capacity > 0)
+	{
+		size_t capacity = frame.capacity;
+		while (capacity < wanted)
+			capacity *= 2;
+
+		::operator delete(frame.memory, std::align_val_t(alignof(std::max_align_t)));
+		frame.memory = (unsigned char*)::operator new(capacity, std::align_val_t(alignof(std::max_align_t)));
+		frame.capacity = capacity;
+		stats.capacity = capacity;
+		stats.grows++;
+	}
+
+	frame.overflow.clear();
+	frame.overflowBytes = 0;
+	frame.offset = 0;
+	frame.allocations = 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct FrameArenaStats {
+	size_t capacity;			// Per frame buffer
+	size_t usedBytes;			// Last finished frame, overflow included
+	size_t peakBytes;
+	int allocations;			// Last finished frame
+	int overflowAllocations;	// Last finished frame, went to the heap
+	int grows;					// Times a buffer was enlarged after overflowing
+};
+
+// --------------------------------------------------------
+// Bump allocator for data that only lives for a frame
+//
+// - Allocate() just moves an offset forward (atomically, so
+//   thread pool jobs can use it too); nothing is ever freed
+//   on its own
+// - Two buffers, swapped by BeginFrame(), so last frame's
+//   data stays valid through this one (for anything still
+//   reading it) before its buffer is reused
+// - Running out falls back to the heap for the rest of the
+//   frame, and the buffer grows the next time it's reset
+//
+// FrameAllocator wraps it for standard containers.
+// --------------------------------------------------------
+class FrameArena
+{
+public:
+	FrameArena(size_t bytesPerFrame = 256 * 1024);
+	~FrameArena();
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Once per frame, before anything allocates. Everything
+	// from two frames ago is gone afterwards.
+	void BeginFrame();
+
+	void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+	FrameArenaStats GetStats();
+
+private:
+	struct Overflow {
+		void* memory;
+		size_t alignment;
+	};
+
+	struct Frame {
+		unsigned char* memory;
+		size_t capacity;
+		std::atomic<size_t> offset;
+		std::atomic<int> allocations;
+		std::vector<Overflow> overflow;
+		size_t overflowBytes;
+	};
+
+	void Reset(Frame& frame);
+
+	Frame frames[2];
+	int current;
+	std::mutex overflowMutex;
+	FrameArenaStats stats;
+};
+
+// --------------------------------------------------------
+// STL allocator on a FrameArena, e.g. FrameVector<int> v{
+// FrameAllocator<int>(&arena) }. deallocate() does nothing;
+// the memory comes back when the arena resets. Without an
+// arena it's a plain heap allocator.
+// --------------------------------------------------------
+template <typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator(FrameArena* arena = 0) : arena(arena) {}
+
+	template <typename U>
+	FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t count)
+	{
+		if (!arena)
+			return std::allocator<T>().allocate(count);
+		return (T*)arena->Allocate(count * sizeof(T), alignof(T));
+	}
+
+	void deallocate(T* pointer, size_t count)
+	{
+		if (!arena)
+			std::allocator<T>().deallocate(pointer, count);
+	}
+
+	template <typename U>
+	bool operator==(const FrameAllocator<U>& other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const FrameAllocator<U>& other) const { return arena != other.arena; }
+
+	FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
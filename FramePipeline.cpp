@@ -0,0 +1,133 @@
+#include "FramePipeline.h"
+#include "Profiler.h"
+#include <chrono>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+}
+
+FramePipeline::FramePipeline() :
+	snapshots(),
+	current(0),
+	target(1),
+	hasCurrent(false),
+	inFlight(false),
+	pipelined(false),
+	frameCount(0),
+	state(Idle),
+	updateMs(0),
+	waitMs(0)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+	Finish();
+	if (thread.joinable())
+	{
+		state.store(Quit, std::memory_order_release);
+		state.notify_one();
+		thread.join();
+	}
+}
+
+void FramePipeline::SetUpdate(UpdateFunction _update)
+{
+	update = _update;
+}
+
+void FramePipeline::SetPipelined(bool _pipelined)
+{
+	pipelined = _pipelined;
+}
+
+bool FramePipeline::IsPipelined()
+{
+	return pipelined;
+}
+
+void FramePipeline::Finish()
+{
+	waitMs = 0;
+	if (!inFlight)
+		return;
+
+	PROFILE_SCOPE("Wait for update");
+	Clock::time_point start = Clock::now();
+	int s;
+	while ((s = state.load(std::memory_order_acquire)) == Requested)
+		state.wait(Requested, std::memory_order_acquire);
+	waitMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	// Everything the update wrote is visible from here on
+	current = target;
+	hasCurrent = true;
+	inFlight = false;
+	state.store(Idle, std::memory_order_relaxed);
+}
+
+void FramePipeline::Start()
+{
+	int next = 1 - current;
+
+	// Nothing to draw yet, or no pipelining: update right here
+	if (!pipelined || !hasCurrent)
+	{
+		RunUpdate(next);
+		current = next;
+		hasCurrent = true;
+		return;
+	}
+
+	if (!thread.joinable())
+		thread = std::thread(&FramePipeline::UpdateLoop, this);
+
+	target = next;
+	inFlight = true;
+	state.store(Requested, std::memory_order_release);
+	state.notify_one();
+}
+
+RenderSnapshot& FramePipeline::GetCurrent()
+{
+	return snapshots[current];
+}
+
+FramePipelineStats FramePipeline::GetStats()
+{
+	FramePipelineStats stats = {};
+	stats.pipelined = pipelined;
+	stats.updateMs = updateMs;
+	stats.waitMs = waitMs;
+	return stats;
+}
+
+void FramePipeline::UpdateLoop()
+{
+	PROFILE_THREAD("Update");
+	while (true)
+	{
+		int s;
+		while ((s = state.load(std::memory_order_acquire)) != Requested && s != Quit)
+			state.wait(s, std::memory_order_acquire);
+		if (s == Quit)
+			return;
+
+		RunUpdate(target);
+		state.store(Done, std::memory_order_release);
+		state.notify_one();
+	}
+}
+
+void FramePipeline::RunUpdate(int index)
+{
+	PROFILE_SCOPE("Frame update");
+	Clock::time_point start = Clock::now();
+
+	RenderSnapshot& snapshot = snapshots[index];
+	snapshot.frame = frameCount++;
+	update(snapshot);
+
+	updateMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <thread>
+#include "RenderSnapshot.h"
+
+// How the last frame went through the pipeline
+struct FramePipelineStats {
+	bool pipelined;
+	double updateMs;	// Building the last snapshot, on whichever thread did it
+	double waitMs;		// The main thread blocked in Finish() for it
+};
+
+// --------------------------------------------------------
+// Runs a frame's update as a separate stage from rendering
+//
+// The update fills in a RenderSnapshot; there are two, so
+// with pipelining on the update thread can fill one for the
+// next frame while the main thread draws the other. The
+// handoff is a single atomic state (idle, requested, done)
+// that each side waits on, with no locks.
+//
+// Once per frame, on the main thread:
+// - Finish() waits for the update started last frame and
+//   makes its snapshot the current one
+// - Start() begins the next update: on the update thread
+//   when pipelined (returning straight away), otherwise
+//   right here, its snapshot becoming current at once
+//
+// Between Finish() and Start() the update is idle, so that's
+// when the main thread may change anything the update reads.
+// Pipelining shows each update a frame later, in exchange
+// for running it alongside the renderer.
+// --------------------------------------------------------
+class FramePipeline
+{
+public:
+	typedef std::function<void(RenderSnapshot& snapshot)> UpdateFunction;
+
+	FramePipeline();
+	~FramePipeline();
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+
+	// Set before the first Start()
+	void SetUpdate(UpdateFunction _update);
+
+	// Takes effect from the next Start()
+	void SetPipelined(bool _pipelined);
+	bool IsPipelined();
+
+	void Finish();
+	void Start();
+
+	// The snapshot to draw; no update writes to it until it's replaced
+	RenderSnapshot& GetCurrent();
+
+	FramePipelineStats GetStats();
+
+private:
+	enum State {
+		Idle,
+		Requested,
+		Done,
+		Quit
+	};
+
+	void UpdateLoop();
+	void RunUpdate(int index);
+
+	UpdateFunction update;
+	RenderSnapshot snapshots[2];
+	int current;		// Index of the snapshot being drawn
+	int target;			// Index the update thread is filling
+	bool hasCurrent;	// The first snapshot is always built on the main thread
+	bool inFlight;
+	bool pipelined;
+	unsigned long long frameCount;
+
+	std::atomic<int> state;
+	std::thread thread;
+
+	double updateMs;
+	double waitMs;
+};
@@ -0,0 +1,274 @@
+#include "FrameStats.h"
+#include <algorithm>
+
+namespace
+{
+	// Nearest-rank percentile of already sorted values
+	float Percentile(const std::vector<float>& sorted, float p)
+	{
+		if (sorted.empty())
+			return 0;
+		size_t rank = (size_t)(p * (sorted.size() - 1) + 0.5f);
+		return sorted[rank];
+	}
+}
+
+FrameStats::FrameStats() :
+	frameOpen(false),
+	currentPhase(FramePhase::Other),
+	phaseMs(),
+	historyNext(0),
+	historyCount(0),
+	frameIndex(0),
+	hitchFactor(2.0f),
+	hitchMinimumMs(8.0f),
+	hitchCount(0)
+{
+	for (auto& h : history)
+		h.resize(HistorySize, 0.0f);
+}
+
+FrameStats::~FrameStats()
+{
+	StopCsvLog();
+}
+
+void FrameStats::BeginFrame(FramePhase firstPhase)
+{
+	Clock::time_point now = Clock::now();
+	if (frameOpen)
+		FinishFrame(now);
+
+	frameOpen = true;
+	frameStart = now;
+	phaseStart = now;
+	currentPhase = firstPhase;
+	for (float& ms : phaseMs)
+		ms = 0;
+}
+
+void FrameStats::SetPhase(FramePhase phase)
+{
+	if (!frameOpen || phase == currentPhase)
+		return;
+
+	Clock::time_point now = Clock::now();
+	phaseMs[(int)currentPhase] += std::chrono::duration<float, std::milli>(now - phaseStart).count();
+	phaseStart = now;
+	currentPhase = phase;
+}
+
+// --------------------------------------------------------
+// Adds the frame to the history and checks it against the
+// median of the frames before it, so one spike can't raise
+// its own bar
+// --------------------------------------------------------
+void FrameStats::FinishFrame(Clock::time_point now)
+{
+	phaseMs[(int)currentPhase] += std::chrono::duration<float, std::milli>(now - phaseStart).count();
+	float totalMs = std::chrono::duration<float, std::milli>(now - frameStart).count();
+
+	// Judge against a history with some weight to it
+	bool hitch = false;
+	if (historyCount >= 30)
+	{
+		float median = Median(FramePhase::Count);
+		if (totalMs > hitchMinimumMs && totalMs > median * hitchFactor)
+		{
+			FrameHitch h = {};
+			h.frame = frameIndex;
+			h.ms = totalMs;
+			h.medianMs = median;
+			float worstGrowth = -1.0f;
+			for (int p = 0; p < PhaseCount; p++)
+			{
+				float growth = phaseMs[p] - Median((FramePhase)p);
+				if (growth > worstGrowth)
+				{
+					worstGrowth = growth;
+					h.worstPhase = (FramePhase)p;
+					h.worstPhaseMs = phaseMs[p];
+				}
+			}
+
+			if (hitches.size() == MaxHitches)
+				hitches.erase(hitches.begin());
+			hitches.push_back(h);
+			hitchCount++;
+			hitch = true;
+		}
+	}
+
+	for (int p = 0; p < PhaseCount; p++)
+		history[p][historyNext] = phaseMs[p];
+	history[PhaseCount][historyNext] = totalMs;
+
+	if (csvLog.is_open())
+	{
+		csvLog << frameIndex << ",";
+		WriteCsvRow(csvLog, historyNext, hitch);
+	}
+
+	historyNext = (historyNext + 1) % HistorySize;
+	historyCount = std::min(historyCount + 1, (int)HistorySize);
+	frameIndex++;
+}
+
+FrameTimeSummary FrameStats::GetSummary(FramePhase phase)
+{
+	FrameTimeSummary summary = {};
+	if (historyCount == 0)
+		return summary;
+
+	const std::vector<float>& values = history[(int)phase];
+	std::vector<float> sorted(historyCount);
+	double sum = 0;
+	for (int i = 0; i < historyCount; i++)
+	{
+		sorted[i] = values[i];
+		sum += values[i];
+	}
+	std::sort(sorted.begin(), sorted.end());
+
+	summary.mean = (float)(sum / historyCount);
+	summary.p50 = Percentile(sorted, 0.50f);
+	summary.p95 = Percentile(sorted, 0.95f);
+	summary.p99 = Percentile(sorted, 0.99f);
+	summary.max = sorted.back();
+	return summary;
+}
+
+float FrameStats::Median(FramePhase phase)
+{
+	const std::vector<float>& values = history[(int)phase];
+	std::vector<float> copy(values.begin(), values.begin() + historyCount);
+	std::nth_element(copy.begin(), copy.begin() + copy.size() / 2, copy.end());
+	return copy[copy.size() / 2];
+}
+
+const float* FrameStats::GetHistory(FramePhase phase)
+{
+	return history[(int)phase].data();
+}
+
+int FrameStats::GetHistoryOffset()
+{
+	return historyCount < HistorySize ? 0 : historyNext;
+}
+
+int FrameStats::GetHistoryCount()
+{
+	return historyCount;
+}
+
+std::vector<float> FrameStats::BuildHistogram(float bucketMs, int bucketCount)
+{
+	std::vector<float> buckets(std::max(bucketCount, 1), 0.0f);
+	const std::vector<float>& totals = history[PhaseCount];
+	for (int i = 0; i < historyCount; i++)
+	{
+		int bucket = (int)(totals[i] / bucketMs);
+		buckets[std::min(bucket, (int)buckets.size() - 1)] += 1.0f;
+	}
+	return buckets;
+}
+
+void FrameStats::SetHitchThreshold(float factor, float minimumMs)
+{
+	hitchFactor = factor;
+	hitchMinimumMs = minimumMs;
+}
+
+float FrameStats::GetHitchFactor()
+{
+	return hitchFactor;
+}
+
+float FrameStats::GetHitchMinimumMs()
+{
+	return hitchMinimumMs;
+}
+
+const std::vector<FrameHitch>& FrameStats::GetHitches()
+{
+	return hitches;
+}
+
+unsigned long long FrameStats::GetHitchCount()
+{
+	return hitchCount;
+}
+
+bool FrameStats::WriteCsv(const std::string& path)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	WriteCsvHeader(out);
+
+	// Hitches are only remembered by frame number
+	unsigned long long first = frameIndex - historyCount;
+	for (int i = 0; i < historyCount; i++)
+	{
+		int index = (GetHistoryOffset() + i) % HistorySize;
+		unsigned long long frame = first + i;
+		bool hitch = std::any_of(hitches.begin(), hitches.end(), [&](const FrameHitch& h) { return h.frame == frame; });
+		out << frame << ",";
+		WriteCsvRow(out, index, hitch);
+	}
+	return (bool)out;
+}
+
+bool FrameStats::StartCsvLog(const std::string& path)
+{
+	StopCsvLog();
+	csvLog.open(path);
+	if (!csvLog)
+		return false;
+
+	WriteCsvHeader(csvLog);
+	return true;
+}
+
+void FrameStats::StopCsvLog()
+{
+	if (csvLog.is_open())
+		csvLog.close();
+}
+
+bool FrameStats::IsLoggingCsv()
+{
+	return csvLog.is_open();
+}
+
+void FrameStats::WriteCsvHeader(std::ostream& out)
+{
+	out << "frame,total_ms";
+	for (int p = 0; p < PhaseCount; p++)
+		out << "," << GetPhaseName((FramePhase)p) << "_ms";
+	out << ",hitch\n";
+}
+
+void FrameStats::WriteCsvRow(std::ostream& out, int historyIndex, bool hitch)
+{
+	out << history[PhaseCount][historyIndex];
+	for (int p = 0; p < PhaseCount; p++)
+		out << "," << history[p][historyIndex];
+	out << "," << (hitch ? 1 : 0) << "\n";
+}
+
+const char* FrameStats::GetPhaseName(FramePhase phase)
+{
+	switch (phase)
+	{
+	case FramePhase::Update: return "Update";
+	case FramePhase::Shadows: return "Shadows";
+	case FramePhase::Scene: return "Scene";
+	case FramePhase::PostProcess: return "Post";
+	case FramePhase::UI: return "UI";
+	case FramePhase::Present: return "Present";
+	case FramePhase::Other: return "Other";
+	default: return "Frame";
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Where a frame's CPU time goes; every moment of a frame is
+// charged to exactly one of these
+enum class FramePhase {
+	Update,
+	Shadows,
+	Scene,
+	PostProcess,
+	UI,
+	Present,
+	Other,		// Between frames: messages, input
+	Count
+};
+
+// Rolling distribution of one phase (or the whole frame)
+struct FrameTimeSummary {
+	float mean;
+	float p50;
+	float p95;
+	float p99;
+	float max;
+};
+
+// A frame that took much longer than the ones around it
+struct FrameHitch {
+	unsigned long long frame;
+	float ms;
+	float medianMs;				// Typical frame when it happened
+	FramePhase worstPhase;		// Phase that grew the most over its median
+	float worstPhaseMs;
+};
+
+// --------------------------------------------------------
+// Per-frame CPU timings, split by phase
+//
+// BeginFrame() closes the previous frame and opens the next;
+// SetPhase() charges the time from then on to another phase.
+// The last HistorySize frames are kept for percentiles, the
+// graph and the histogram, and frames well over the rolling
+// median are remembered as hitches. Frames can also stream
+// to a CSV file as they finish.
+// --------------------------------------------------------
+class FrameStats
+{
+public:
+	static const int HistorySize = 600;
+	static const int MaxHitches = 16;
+
+	FrameStats();
+	~FrameStats();
+
+	void BeginFrame(FramePhase firstPhase);
+	void SetPhase(FramePhase phase);
+
+	// Over the kept history; Count means the whole frame
+	FrameTimeSummary GetSummary(FramePhase phase = FramePhase::Count);
+
+	// Ring buffer of frame times (ms), oldest at GetHistoryOffset()
+	const float* GetHistory(FramePhase phase = FramePhase::Count);
+	int GetHistoryOffset();
+	int GetHistoryCount();
+
+	// Frames per bucket of bucketMs, the last bucket catching the rest
+	std::vector<float> BuildHistogram(float bucketMs, int bucketCount);
+
+	// Hitch: over factor x the rolling median and over minimumMs
+	void SetHitchThreshold(float factor, float minimumMs);
+	float GetHitchFactor();
+	float GetHitchMinimumMs();
+	const std::vector<FrameHitch>& GetHitches();	// Newest last
+	unsigned long long GetHitchCount();
+
+	// The kept history, oldest first
+	bool WriteCsv(const std::string& path);
+
+	// Every frame from now on, as it finishes
+	bool StartCsvLog(const std::string& path);
+	void StopCsvLog();
+	bool IsLoggingCsv();
+
+	static const char* GetPhaseName(FramePhase phase);
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	void FinishFrame(Clock::time_point now);
+	void WriteCsvHeader(std::ostream& out);
+	void WriteCsvRow(std::ostream& out, int historyIndex, bool hitch);
+	float Median(FramePhase phase);
+
+	static const int PhaseCount = (int)FramePhase::Count;
+
+	// Phase times of the open frame
+	bool frameOpen;
+	Clock::time_point frameStart;
+	Clock::time_point phaseStart;
+	FramePhase currentPhase;
+	float phaseMs[PhaseCount];
+
+	// History per phase, plus the whole frame in the last slot
+	std::vector<float> history[PhaseCount + 1];
+	int historyNext;
+	int historyCount;
+	unsigned long long frameIndex;
+
+	float hitchFactor;
+	float hitchMinimumMs;
+	std::vector<FrameHitch> hitches;
+	unsigned long long hitchCount;
+
+	std::ofstream csvLog;
+};
@@ -6,11 +6,16 @@
 #include "Window.h"
 #include "Mesh.h"
 #include <memory>
+#include <cstring>
+#include <cmath>
 #include "BufferStructs.h"
 #include "Material.h"
+#include "DDSTextureLoader.h"
+#include "IBLBaker.h"
+#include <fstream>
+#include <filesystem>
 
 #include <DirectXMath.h>
-#include "WICTextureLoader.h"
 
 
 #include "ImGui/imgui.h"
@@ -40,6 +45,9 @@ float direction = 1;
 // --------------------------------------------------------
 Game::Game()
 {
+	PROFILE_SCOPE("Startup");
+	startupTime = std::chrono::high_resolution_clock::now();
+	startupStageTime = startupTime;
 
 	// Initialize ImGui itself & platform/renderer backends
 	IMGUI_CHECKVERSION();
@@ -49,6 +57,7 @@ Game::Game()
 
 	// Pick a style
 	ImGui::StyleColorsDark();
+	EndStartupStage("ImGui");
 
 
 	// LoadAssets and Entities
@@ -64,13 +73,17 @@ Game::Game()
 		// Essentially: "What kind of shape should the GPU draw with our vertices?"
 		Graphics::Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-		ID3DBlob* vertexShaderBlob;
-		D3DReadFileToBlob(FixPath(L"VertexShader.cso").c_str(), &vertexShaderBlob);
+		// The cache already loaded this shader for the materials and kept its bytecode
+		// (only needed here, so the reference is handed straight back)
+		VertexShaderHandle vertexShaderHandle = shaders.LoadVertexShader(L"VertexShader.cso");
+		Microsoft::WRL::ComPtr<ID3DBlob> vertexShaderBlob = resources.GetBytecode(vertexShaderHandle);
+		resources.Release(vertexShaderHandle);
 		// Create an input layout 
 		//  - This describes the layout of data sent to a vertex shader
 		//  - In other words, it describes how to interpret data (numbers) in a vertex buffer
 		//  - Doing this NOW because it requires a vertex shader's byte code to verify against!
 		//  - Luckily, we already have that loaded (the vertex shader blob above)
+		if (vertexShaderBlob)
 		{
 			D3D11_INPUT_ELEMENT_DESC inputElements[4] = {};
 
@@ -109,50 +122,27 @@ Game::Game()
 		// have the same layout, so we can just set this once at startup.
 		Graphics::Context->IASetInputLayout(inputLayout.Get());
 	}
-
-	// Create the cameras
-	std::shared_ptr camera1 = std::make_shared<Camera>(
-		XMFLOAT3(0.0f, 5.0f, -20.0f), // position (not origin)
-		5.0f, // Camera Speed
-		0.002f, // Look Speed,
-		XM_PIDIV4, // FOV (In Radians)
-		Window::AspectRatio(), // Aspect Ratio
-		0.01f, // Near Clip Distance
-		100.0f, // Far Clip Distance
-		ProjectionType::PERSPECTIVE // Which Projection Type?
-	);
-
-	std::shared_ptr camera2 = std::make_shared<Camera>(
-		XMFLOAT3(-5.0f, 5.0f, -10.0f), // position (not origin)
-		5.0f, // Camera Speed
-		0.002f, // Look Speed,
-		XM_PIDIV2, // FOV (In Radians)
-		Window::AspectRatio(), // Aspect Ratio
-		0.01f, // Near Clip Distance
-		100.0f, // Far Clip Distance
-		ProjectionType::PERSPECTIVE // Which Projection Type?
-	);
-
-	std::shared_ptr camera3 = std::make_shared<Camera>(
-		XMFLOAT3(5.0f, 0.0f, -5.0f), // position (not origin)
-		5.0f, // Camera Speed
-		0.002f, // Look Speed,
-		XM_PI/6, // FOV (In Radians)
-		Window::AspectRatio(), // Aspect Ratio
-		0.01f, // Near Clip Distance
-		100.0f, // Far Clip Distance
-		ProjectionType::ORTHOGRAPHIC // Which Projection Type?,
-	);
-
-	camera3->SetOrthoGraphicWidth(25);
-
-	cameras.push_back(camera1);
-	cameras.push_back(camera2);
-	cameras.push_back(camera3);
-
-	activeCameraIndex = 0;
+	EndStartupStage("Input layout");
 
 	CreateShadowMapResources();
+	CreateShadowAtlasResources();
+	EndStartupStage("Shadow resources");
+
+	// Shader sources sit two folders up from the executable, with the assets
+	hotReloader.Watch(FixPath("../.."));
+	hotReloader.Watch(FixPath("../../Assets/Meshes"));
+	hotReloader.Watch(FixPath("../../Assets/Textures"));
+	EndStartupStage("File watching");
+
+	// Where startup went
+	ShaderLibraryStats shaderStats = shaders.GetStats();
+	printf("Startup:");
+	for (auto& stage : startupStages)
+		printf(" %s %.1f ms,", stage.first.c_str(), stage.second);
+	printf(" total %.1f ms\n", std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupTime).count());
+	printf("Shaders: %d preloaded on %u threads in %.1f ms (read %.1f ms, create %.1f ms of thread time), %.1f ms waited, %d loaded on demand, %d failed\n",
+		shaderStats.preloaded, shaderStats.threads, shaderStats.preloadMs, shaderStats.readMs, shaderStats.createMs,
+		shaderStats.waitMs, shaderStats.loadedOnMainThread, shaderStats.failed);
 }
 
 
@@ -164,6 +154,12 @@ Game::Game()
 // --------------------------------------------------------
 Game::~Game()
 {
+	// Nothing's torn down under an update still running
+	pipeline.Finish();
+
+	// Hand back every cache reference while the cache is still here
+	ReleaseResources();
+
 	// ImGui clean up
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
@@ -174,6 +170,8 @@ Game::~Game()
 
 void Game::LoadAssetsAndCreateEntities()
 {
+	PROFILE_SCOPE("Load assets");
+
 	// create sampler
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState;
 	D3D11_SAMPLER_DESC sampDesc = {};
@@ -185,287 +183,196 @@ void Game::LoadAssetsAndCreateEntities()
 	sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
 	Graphics::Device->CreateSamplerState(&sampDesc, samplerState.GetAddressOf());
 
-	// Textures with Normals
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> 
-		cobblestoneASRV,
-		cobblestoneNSRV,
-		cobblestoneRSRV,
-		cobblestoneMSRV,
-		floorASRV,
-		floorNSRV,
-		floorRSRV,
-		floorMSRV,
-		paintASRV,
-		paintNSRV,
-		paintRSRV,
-		paintMSRV,
-		roughASRV,
-		roughNSRV,
-		roughRSRV,
-		roughMSRV,
-		scratchASRV,
-		scratchNSRV,
-		scratchRSRV,
-		scratchMSRV,
-		bronzeASRV,
-		bronzeNSRV,
-		bronzeRSRV,
-		bronzeMSRV,
-		woodASRV,
-		woodNSRV,
-		woodRSRV,
-		woodMSRV,
-		flatNormalsSRV;
-
-	// Albedos
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/cobblestone_albedo.png").c_str(), 0, cobblestoneASRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/floor_albedo.png").c_str(), 0, floorASRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/paint_albedo.png").c_str(), 0, paintASRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/rough_albedo.png").c_str(), 0, roughASRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/scratched_albedo.png").c_str(), 0, scratchASRV.GetAddressOf());
+	// Placeholders, bound until the real textures finish loading
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholderAlbedo = CreateSolidColorTexture(128, 128, 128, 255);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholderNormals = CreateSolidColorTexture(128, 128, 255, 255);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholderRoughness = CreateSolidColorTexture(255, 255, 255, 255);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholderMetal = CreateSolidColorTexture(0, 0, 0, 255);
 
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/bronze_albedo.png").c_str(), 0, bronzeASRV.GetAddressOf());
+	// Scene contents come from Assets/Scenes (see SceneFile.h)
+	if (!LoadSceneDesc("Default"))
+		scene = SceneDesc();
+	EndStartupStage("Scene file");
 
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/wood_albedo.png").c_str(), 0, woodASRV.GetAddressOf());
+	// Shaders load on the library's threads while the meshes load here
+	PreloadShaders();
 
+	// create meshes (the cache hands back the same mesh for a repeated path)
+	for (auto& desc : scene.meshes)
+	{
+		MeshHandle handle = resources.LoadMesh(desc.path, desc.name);
+		std::shared_ptr<Mesh> mesh = resources.Get(handle);
+		if (!mesh)
+		{
+			// Entities refer to meshes by index, so something has to fill the slot
+			printf("Couldn't load mesh %s (%s), using a placeholder\n", desc.name, desc.path);
+			mesh = CreatePlaceholderMesh(desc.name);
+		}
+		meshes.push_back(mesh);
+		meshHandles.push_back(handle);
+	}
+	EndStartupStage("Meshes");
 
-	// Normals
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/cobblestone_normals.png").c_str(), 0, cobblestoneNSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/floor_normals.png").c_str(), 0, floorNSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/paint_normals.png").c_str(), 0, paintNSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/rough_normals.png").c_str(), 0, roughNSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/scratched_normals.png").c_str(), 0, scratchNSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/bronze_normals.png").c_str(), 0, bronzeNSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/wood_normals.png").c_str(), 0, woodNSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/flat_normals.png").c_str(), 0, flatNormalsSRV.GetAddressOf());
-
-	// Roughness
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/cobblestone_roughness.png").c_str(), 0, cobblestoneRSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/floor_roughness.png").c_str(), 0, floorRSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/paint_roughness.png").c_str(), 0, paintRSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/rough_roughness.png").c_str(), 0, roughRSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/scratched_roughness.png").c_str(), 0, scratchRSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/bronze_roughness.png").c_str(), 0, bronzeRSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/wood_roughness.png").c_str(), 0, woodRSRV.GetAddressOf());
-
-	// Metalness
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/cobblestone_metal.png").c_str(), 0, cobblestoneMSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/floor_metal.png").c_str(), 0, floorMSRV.GetAddressOf());
+	// Shared by every material
+	ormPS = LoadPixelShader(L"PixelShaderORM.cso");
 
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/paint_metal.png").c_str(), 0, paintMSRV.GetAddressOf());
+	// Shadow Vertex Shader
+	shadowVS = LoadVertexShader(L"ShadowVS.cso");
 
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/rough_metal.png").c_str(), 0, roughMSRV.GetAddressOf());
+	// create materials, each starting out on placeholders...
+	for (auto& desc : scene.materials)
+	{
+		std::shared_ptr<Material> mat = std::make_shared<Material>(
+			desc.name,
+			XMFLOAT3(desc.colorTint[0], desc.colorTint[1], desc.colorTint[2]),
+			LoadPixelShader(std::wstring(desc.pixelShader, desc.pixelShader + strlen(desc.pixelShader))),
+			LoadVertexShader(std::wstring(desc.vertexShader, desc.vertexShader + strlen(desc.vertexShader))),
+			desc.roughness,
+			XMFLOAT2(desc.uvScale[0], desc.uvScale[1]),
+			XMFLOAT2(desc.uvOffset[0], desc.uvOffset[1]));
+		mat->AddTextureSRV(0, placeholderAlbedo);
+		mat->AddTextureSRV(1, placeholderNormals);
+		mat->AddTextureSRV(2, placeholderRoughness);
+		mat->AddTextureSRV(3, placeholderMetal);
+		mat->AddSampler(0, samplerState);
+		materials.push_back(mat);
+
+		// ...and swaps in the real textures as the loader threads finish them
+		if (desc.textures[0][0]) LoadTextureAsync(desc.textures[0], mat, 0);
+		if (desc.textures[1][0]) LoadTextureAsync(desc.textures[1], mat, 1);
+
+		// Roughness and metalness (packed into one texture when cooked)
+		LoadOrmAsync(desc.textures[2], desc.textures[3], mat);
+	}
 
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/scratched_metal.png").c_str(), 0, scratchMSRV.GetAddressOf());
+	// create sky, from the cooked cube map (with mips) if there is one
+	const SceneSettings& settings = scene.settings;
+	if (settings.skyMesh >= 0)
+	{
+		std::shared_ptr<Mesh> skyMesh = meshes[settings.skyMesh];
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> skyVShader = LoadVertexShader(std::wstring(settings.skyVertexShader, settings.skyVertexShader + strlen(settings.skyVertexShader)));
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> skyPShader = LoadPixelShader(std::wstring(settings.skyPixelShader, settings.skyPixelShader + strlen(settings.skyPixelShader)));
+		std::string cubemap = std::string("../../Assets/Cooked/") + settings.skyCubemap;
+		if (settings.skyCubemap[0] && std::ifstream(FixPath(cubemap)).good())
+		{
+			sky = std::make_shared<Sky>(FixPath(std::wstring(cubemap.begin(), cubemap.end())).c_str(), skyMesh, skyVShader, skyPShader, samplerState);
+		}
+		else
+		{
+			std::wstring faces[6];
+			for (int i = 0; i < 6; i++)
+			{
+				std::string face = std::string("../../Assets/Textures/") + settings.skyFaces[i];
+				faces[i] = FixPath(std::wstring(face.begin(), face.end()));
+			}
+			sky = std::make_shared<Sky>(
+				faces[0].c_str(),
+				faces[1].c_str(),
+				faces[2].c_str(),
+				faces[3].c_str(),
+				faces[4].c_str(),
+				faces[5].c_str(),
+				skyMesh,
+				skyVShader,
+				skyPShader,
+				samplerState
+			);
+		}
+	}
 
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/bronze_metal.png").c_str(), 0, bronzeMSRV.GetAddressOf());
+	EndStartupStage("Materials and sky");
 
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(),
-		FixPath(L"../../Assets/Textures/wood_metal.png").c_str(), 0, woodMSRV.GetAddressOf());
+	BakeImageBasedLighting();
+	EndStartupStage("Image based lighting");
 
-	// load shaders
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> basicVShader = LoadVertexShader(L"VertexShader.cso");
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> basicPShader = LoadPixelShader(L"PixelShader.cso");
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> skyVShader = LoadVertexShader(L"SkyVS.cso");
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> skyPShader = LoadPixelShader(L"SkyPS.cso");
+	// create entities
+	std::vector<EntityHandle> sceneEntities;
+	for (auto& desc : scene.entities)
+	{
+		Transform transform;
+		transform.SetPosition(desc.position[0], desc.position[1], desc.position[2]);
+		transform.SetRotation(desc.rotation[0], desc.rotation[1], desc.rotation[2]);
+		transform.SetScale(desc.scale[0], desc.scale[1], desc.scale[2]);
+
+		// Static entities never move, so their shadows can be cached,
+		// and occluders are big enough to hide things behind them
+		MeshRenderer renderer = { desc.mesh, desc.material, 0 };
+		if (desc.flags & SCENE_ENTITY_STATIC) renderer.flags |= ENTITY_STATIC;
+		if (desc.flags & SCENE_ENTITY_OCCLUDER) renderer.flags |= ENTITY_OCCLUDER;
+
+		EntityHandle entity = world.Create(transform, renderer, PreviousTransform{ transform.GetState(), transform.GetVersion() });
+		sceneEntities.push_back(entity);
+
+		if (desc.spin[0] != 0 || desc.spin[1] != 0 || desc.spin[2] != 0)
+			world.Add(entity, Spin{ XMFLOAT3(desc.spin[0], desc.spin[1], desc.spin[2]) });
+
+		if (desc.sway[0] != 0 || desc.sway[1] != 0 || desc.sway[2] != 0)
+			world.Add(entity, Sway{
+				XMFLOAT3(desc.position[0], desc.position[1], desc.position[2]),
+				XMFLOAT3(desc.sway[0], desc.sway[1], desc.sway[2]),
+				desc.swaySpeed });
+	}
+	occlusionCuller = std::make_shared<OcclusionCuller>(&threadPool);
+	occlusionCuller->SetFrameArena(&frameArena);
+	renderGraph.SetFrameArena(&frameArena);
 
-	// Shadow Vertex Shader
-	shadowVS = LoadVertexShader(L"ShadowVS.cso");
+	// Lights 
+	ambientColor = XMFLOAT3(settings.ambientColor[0], settings.ambientColor[1], settings.ambientColor[2]);
+	for (auto& desc : scene.lights)
+	{
+		Light light = {};
+		light.type = desc.type;
+		light.direction = XMFLOAT3(desc.direction[0], desc.direction[1], desc.direction[2]);
+		light.position = XMFLOAT3(desc.position[0], desc.position[1], desc.position[2]);
+		light.color = XMFLOAT3(desc.color[0], desc.color[1], desc.color[2]);
+		light.intensity = desc.intensity;
+		light.range = desc.range;
+		light.spotInnerAngle = desc.spotInnerAngle;
+		light.spotOuterAngle = desc.spotOuterAngle;
+
+		// Carried along by an entity from then on
+		if (desc.attachEntity >= 0 && desc.attachEntity < (int)sceneEntities.size())
+			world.Add(sceneEntities[desc.attachEntity], LightAttachment{
+				(int)lights.size(),
+				XMFLOAT3(desc.attachOffset[0], desc.attachOffset[1], desc.attachOffset[2]) });
+		lights.push_back(light);
+	}
 
-	//Microsoft::WRL::ComPtr<ID3D11PixelShader> fancyPixelShader = LoadPixelShader(L"CustomPS.cso");
-	//Microsoft::WRL::ComPtr<ID3D11PixelShader> normalPreviewPS = LoadPixelShader(L"DebugNormalsPS.cso");
-	//Microsoft::WRL::ComPtr<ID3D11PixelShader> uvPreviewPS = LoadPixelShader(L"DebugUVsPS.cso");
-	//Microsoft::WRL::ComPtr<ID3D11PixelShader> twoTexPShader = LoadPixelShader(L"TwoTexturePS.cso");
-
-
-	// create materials from shaders
-	std::shared_ptr<Material> cobblestoneMat = std::make_shared<Material>("Cobblestone", XMFLOAT3(1, 1, 1), basicPShader, basicVShader, 0.0f);
-	cobblestoneMat->AddTextureSRV(0, cobblestoneASRV);
-	cobblestoneMat->AddTextureSRV(1, cobblestoneNSRV);
-	cobblestoneMat->AddTextureSRV(2, cobblestoneRSRV);
-	cobblestoneMat->AddTextureSRV(3, cobblestoneMSRV);
-	cobblestoneMat->AddSampler(0, samplerState);
-
-	std::shared_ptr<Material> floorMat = std::make_shared<Material>("Floor", XMFLOAT3(1, 1, 1), basicPShader, basicVShader, 0.0f);
-	floorMat->AddTextureSRV(0, floorASRV);
-	floorMat->AddTextureSRV(1, floorNSRV);
-	floorMat->AddTextureSRV(2, floorRSRV);
-	floorMat->AddTextureSRV(3, floorMSRV);
-	floorMat->AddSampler(0, samplerState);
-
-	std::shared_ptr<Material> paintMat = std::make_shared<Material>("Paint", XMFLOAT3(1, 1, 1), basicPShader, basicVShader, 0.0f);
-	paintMat->AddTextureSRV(0, paintASRV);
-	paintMat->AddTextureSRV(1, paintNSRV);
-	paintMat->AddTextureSRV(2, paintRSRV);
-	paintMat->AddTextureSRV(3, paintMSRV);
-	paintMat->AddSampler(0, samplerState);
-
-	std::shared_ptr<Material> roughMat = std::make_shared<Material>("Rough", XMFLOAT3(1, 1, 1), basicPShader, basicVShader, 0.0f);
-	roughMat->AddTextureSRV(0, roughASRV);
-	roughMat->AddTextureSRV(1, roughNSRV);
-	roughMat->AddTextureSRV(2, roughRSRV);
-	roughMat->AddTextureSRV(3, cobblestoneMSRV);
-	roughMat->AddSampler(0, samplerState);
-
-	std::shared_ptr<Material> scratchedMat = std::make_shared<Material>("Scratched", XMFLOAT3(1, 1, 1), basicPShader, basicVShader, 0.0f);
-	scratchedMat->AddTextureSRV(0, scratchASRV);
-	scratchedMat->AddTextureSRV(1, scratchNSRV);
-	scratchedMat->AddTextureSRV(2, scratchRSRV);
-	scratchedMat->AddTextureSRV(3, scratchMSRV);
-	scratchedMat->AddSampler(0, samplerState);
-
-	std::shared_ptr<Material> bronzeMat = std::make_shared<Material>("Bronze", XMFLOAT3(1, 1, 1), basicPShader, basicVShader, 0.0f);
-	bronzeMat->AddTextureSRV(0, bronzeASRV);
-	bronzeMat->AddTextureSRV(1, bronzeNSRV);
-	bronzeMat->AddTextureSRV(2, bronzeRSRV);
-	bronzeMat->AddTextureSRV(3, bronzeMSRV);
-	bronzeMat->AddSampler(0, samplerState);
-
-	std::shared_ptr<Material> woodMat = std::make_shared<Material>("Wood", XMFLOAT3(1, 1, 1), basicPShader, basicVShader, 0.0f);
-	woodMat->AddTextureSRV(0, woodASRV);
-	woodMat->AddTextureSRV(1, woodNSRV);
-	woodMat->AddTextureSRV(2, woodRSRV);
-	woodMat->AddTextureSRV(3, woodMSRV);
-	woodMat->AddSampler(0, samplerState);
-
-	//std::shared_ptr<Material> fancyMat = std::make_shared<Material>("Fancy",XMFLOAT3(1, 1, 1), basicPShader, basicVShader, 1.0f);
-
-	// create meshes
-	std::shared_ptr<Mesh> cubeMesh = std::make_shared<Mesh>(FixPath("../../Assets/Meshes/cube.obj").c_str(), "Cube");
-	std::shared_ptr<Mesh> cylinderMesh = std::make_shared<Mesh>(FixPath("../../Assets/Meshes/cylinder.obj").c_str(), "Cylinder");
-	std::shared_ptr<Mesh> helixMesh = std::make_shared<Mesh>(FixPath("../../Assets/Meshes/helix.obj").c_str(), "Helix");
-	std::shared_ptr<Mesh> quadMesh = std::make_shared<Mesh>(FixPath("../../Assets/Meshes/quad.obj").c_str(), "Quad");
-	std::shared_ptr<Mesh> quad2SideMesh = std::make_shared<Mesh>(FixPath("../../Assets/Meshes/quad_double_sided.obj").c_str(), "2 Sided Quad");
-	std::shared_ptr<Mesh> sphereMesh = std::make_shared<Mesh>(FixPath("../../Assets/Meshes/sphere.obj").c_str(), "Sphere");
-	std::shared_ptr<Mesh> torusMesh = std::make_shared<Mesh>(FixPath("../../Assets/Meshes/torus.obj").c_str(), "Torus");
-
-	// add meshes to the vector 
-	meshes.insert(meshes.end(), { cubeMesh, cylinderMesh, helixMesh, quadMesh, quad2SideMesh, sphereMesh, torusMesh });
-
-	// create sky
-	sky = std::make_shared<Sky>(
-		FixPath(L"../../Assets/Textures/right.png").c_str(),
-		FixPath(L"../../Assets/Textures/left.png").c_str(),
-		FixPath(L"../../Assets/Textures/up.png").c_str(),
-		FixPath(L"../../Assets/Textures/down.png").c_str(),
-		FixPath(L"../../Assets/Textures/front.png").c_str(),
-		FixPath(L"../../Assets/Textures/back.png").c_str(),
-		cubeMesh,
-		skyVShader,
-		skyPShader,
-		samplerState
-	);
+	// Animation runs every simulation step; light attachment and
+	// the render list every Update(), between the last two steps
+	GameSystems::RegisterSimulation(systems);
+	GameSystems::RegisterFrame(frameSystems, lights, meshes, renderables, interpolationAlpha);
+	pipeline.SetUpdate([this](RenderSnapshot& snapshot) { BuildSnapshot(snapshot); });
+	pipeline.SetPipelined(pipelineEnabled);
 
-	// create entities
-	entities.push_back(std::make_shared<Entity>(cubeMesh, cobblestoneMat));
-	entities.push_back(std::make_shared<Entity>(helixMesh, floorMat));
-	entities.push_back(std::make_shared<Entity>(sphereMesh, paintMat));
-	entities.push_back(std::make_shared<Entity>(cubeMesh, woodMat));
-
-	// Adjust transforms
-	entities[0]->GetTransform()->MoveAbsolute(-3, 0, 0);
-	entities[1]->GetTransform()->MoveAbsolute(0, 0, 0);
-	entities[2]->GetTransform()->MoveAbsolute(3, 0, 0);
-	entities[3]->GetTransform()->MoveAbsolute(0, -3, 0);
-	entities[3]->GetTransform()->Scale(10, 1, 10);
+	// Create the cameras, making sure there's always one to look through
+	for (auto& desc : scene.cameras)
+	{
+		std::shared_ptr<Camera> camera = std::make_shared<Camera>(
+			XMFLOAT3(desc.position[0], desc.position[1], desc.position[2]),
+			desc.moveSpeed,
+			desc.lookSpeed,
+			desc.fieldOfView,
+			Window::AspectRatio(),
+			desc.nearClip,
+			desc.farClip,
+			desc.projection == SCENE_CAMERA_ORTHOGRAPHIC ? ProjectionType::ORTHOGRAPHIC : ProjectionType::PERSPECTIVE
+		);
+		if (desc.projection == SCENE_CAMERA_ORTHOGRAPHIC)
+			camera->SetOrthoGraphicWidth(desc.orthoWidth);
+		cameras.push_back(camera);
+	}
+	if (cameras.empty())
+		cameras.push_back(std::make_shared<Camera>(XMFLOAT3(0.0f, 5.0f, -20.0f), 5.0f, 0.002f, XM_PIDIV4, Window::AspectRatio()));
 
-	// Lights 
-	// Initialize Directional Light
-	Light directionalLight1 = {};
-	directionalLight1.type = LIGHT_TYPE_DIRECTIONAL;
-	directionalLight1.direction = XMFLOAT3(0.0f, -0.7071f, 0.7071f);
-	directionalLight1.color = XMFLOAT3(1.0f, 1.0f, 1.0f);
-	directionalLight1.intensity = 1.0f;
-
-	Light directionalLight2 = {};
-	directionalLight2.type = LIGHT_TYPE_DIRECTIONAL;
-	directionalLight2.direction = XMFLOAT3(-1.0f, 0.0f, 0.0f);
-	directionalLight2.color = XMFLOAT3(0.0f, 1.0f, 0);
-	directionalLight2.intensity = 1.0f;
-
-	Light directionalLight3 = {};
-	directionalLight3.type = LIGHT_TYPE_DIRECTIONAL;
-	directionalLight3.direction = XMFLOAT3(0.0f, -1.0f, 0.0f);
-	directionalLight3.color = XMFLOAT3(0.0f, 0, 1.0f);
-	directionalLight3.intensity = 1.0f;
-
-	Light pointLight1 = {};
-	pointLight1.type = LIGHT_TYPE_POINT;
-	pointLight1.color = XMFLOAT3(1.0f, 1.0f, 1.0f);
-	pointLight1.intensity = 1.0f;
-	pointLight1.range = 10.0f;
-	pointLight1.position = XMFLOAT3(0.0f, 3.0f, 0);
-
-	Light spotLight1 = {};
-	spotLight1.type = LIGHT_TYPE_SPOT;
-	spotLight1.direction = XMFLOAT3(0.0f, -1.0f, 0.0f);
-	spotLight1.color = XMFLOAT3(0.0f, 0, 1.0f);
-	spotLight1.intensity = 2.0f;
-	spotLight1.position = XMFLOAT3(0, 1.5f, 0);
-	spotLight1.range = 10.0f;
-	spotLight1.spotOuterAngle = XMConvertToRadians(30.0f);
-	spotLight1.spotInnerAngle = XMConvertToRadians(20.0f);
-
-	lights.push_back(directionalLight1);
-	lights.push_back(directionalLight2);
-	lights.push_back(directionalLight3);
-	lights.push_back(pointLight1);
-	lights.push_back(spotLight1);
+	activeCameraIndex = settings.activeCamera >= 0 && settings.activeCamera < (int)cameras.size() ? settings.activeCamera : 0;
 
 	// Load Post Process Shaders
 	blurPS = LoadPixelShader(L"BlurPS.cso");
+	blurPixelatePS = LoadPixelShader(L"BlurPixelatePS.cso");
 	pixelPS = LoadPixelShader(L"PixelationPS.cso");
 	ppVS = LoadVertexShader(L"FullscreenVS.cso");
 
-	// Create post process resources
-	ResizePostProcessResources();
-
 	// Sampler state for post processing
 	D3D11_SAMPLER_DESC ppSampDesc = {};
 	ppSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
@@ -474,6 +381,21 @@ void Game::LoadAssetsAndCreateEntities()
 	ppSampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
 	ppSampDesc.MaxLOD = D3D11_FLOAT32_MAX;
 	Graphics::Device->CreateSamplerState(&ppSampDesc, ppSampler.GetAddressOf());
+
+	// Main pass after a depth pre-pass only shades the surface that won
+	D3D11_DEPTH_STENCIL_DESC equalDesc = {};
+	equalDesc.DepthEnable = true;
+	equalDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	equalDesc.DepthFunc = D3D11_COMPARISON_EQUAL;
+	Graphics::Device->CreateDepthStencilState(&equalDesc, depthEqualState.GetAddressOf());
+
+	// Transparent draws test against the opaque depth without writing their own
+	D3D11_DEPTH_STENCIL_DESC readOnlyDesc = {};
+	readOnlyDesc.DepthEnable = true;
+	readOnlyDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	readOnlyDesc.DepthFunc = D3D11_COMPARISON_LESS;
+	Graphics::Device->CreateDepthStencilState(&readOnlyDesc, depthReadOnlyState.GetAddressOf());
+	EndStartupStage("Entities, lights and post process");
 }
 
 
@@ -490,7 +412,36 @@ void Game::OnResize()
 		}
 	}
 
-	ResizePostProcessResources();
+	// Post process targets are pooled by the render graph and recreated at the new size
+	graphExecutor.ReleaseAll();
+}
+
+
+// --------------------------------------------------------
+// Recording remembers where the active camera is, and a
+// replay puts it back there before the first logged frame
+// --------------------------------------------------------
+void Game::StartInputRecording(const std::string& path)
+{
+	std::shared_ptr<Transform> transform = cameras[activeCameraIndex]->GetTransform();
+	InputLogStart start = {};
+	start.cameraPosition = transform->GetPosition();
+	start.cameraRotation = transform->GetPitchYawRoll();
+	InputRecorder::StartRecording(path, start);
+}
+
+void Game::StartInputReplay(const std::string& path, float fixedTimestep)
+{
+	InputLogStart start = {};
+	if (!InputRecorder::StartReplay(path, fixedTimestep, start))
+		return;
+
+	std::shared_ptr<Transform> transform = cameras[activeCameraIndex]->GetTransform();
+	transform->SetPosition(start.cameraPosition);
+	transform->SetRotation(start.cameraRotation);
+
+	// Steps line up with the replayed clock, as they did when recording
+	simulationTime = -1;
 }
 
 
@@ -499,24 +450,169 @@ void Game::OnResize()
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
+	PROFILE_SCOPE("Update");
+
+	// Closes last frame's timings; building the UI is charged to the UI
+	frameStats.BeginFrame(FramePhase::UI);
+
+	// Last frame's scratch data is still readable, the frame before's is gone
+	frameArena.BeginFrame();
+
+	// Last frame's update is done with the World from here until Start()
+	pipeline.Finish();
+
 	RefreshUI(deltaTime);
 	BuildUI();
+	frameStats.SetPhase(FramePhase::Update);
+
+	// Pick up edited shaders, meshes and textures before anything uses them this frame
+	if (hotReloadEnabled)
+	{
+		PROFILE_SCOPE("Hot reload");
+		ApplyHotReload(hotReloader.Update());
+	}
+
+	// Swap in whatever textures finished decoding, a few per
+	// frame so a burst of uploads can't cause a hitch
+	textureLoader.ProcessCompleted(textureUploadsPerFrame);
+	if (timeToAllTexturesMs < 0 && textureLoader.IsIdle())
+		timeToAllTexturesMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupTime).count();
+
 	// Example input checking: Quit if the escape key is pressed
 	if (Input::KeyDown(VK_ESCAPE))
 		Window::Quit();
 
-	for (int i = 0; i < 3; i++) {
-		entities[i]->GetTransform()->Rotate(0, deltaTime, 0);
+	// Camera movement here; animation and what to draw where in
+	// the update stage, alongside Draw() when pipelined
+	pendingUpdate.deltaTime = deltaTime;
+	pendingUpdate.totalTime = totalTime;
+	pendingUpdate.inputTime = std::chrono::high_resolution_clock::now();
+	StepSimulation(deltaTime, totalTime);
+	pipeline.Start();
+
+	globalPsData.time = totalTime;
+
+}
+
+
+// --------------------------------------------------------
+// Plans how far the simulation (animation and the camera)
+// moves on, in fixed steps, however long frames take
+//
+// - Frame time goes into an accumulator and whole steps come
+//   out of it, so motion is the same at any frame rate and a
+//   heavy render frame just means more steps next Update()
+// - Past maxStepsPerFrame the rest of the time is dropped:
+//   the simulation falls behind the clock instead of taking
+//   ever more steps for ever slower frames
+// - Rendering is somewhere between the last two steps, and
+//   the frame systems blend matrices by interpolationAlpha
+// - Mouse look follows the mouse every frame, not per step
+//
+// With fixed steps off, each frame is one step of deltaTime.
+// The camera moves right away, since it reads input; the
+// World's steps are left for BuildSnapshot to take.
+// --------------------------------------------------------
+void Game::StepSimulation(float deltaTime, float totalTime)
+{
+	PROFILE_SCOPE("Simulation");
+	std::shared_ptr<Camera> camera = cameras[activeCameraIndex];
+	camera->UpdateLook();
+
+	// Start stepping from this frame
+	if (simulationTime < 0)
+	{
+		simulationTime = totalTime - deltaTime;
+		simulationAccumulator = 0;
 	}
 
-	entities[0]->GetTransform()->SetPosition(sin(totalTime) - 3, 0, 0);
-	entities[1]->GetTransform()->SetPosition(sin(totalTime), 0, 0);
-	entities[2]->GetTransform()->SetPosition(sin(totalTime) + 3, 0, 0);
+	pendingUpdate.startTime = simulationTime;
+	if (!fixedStepEnabled)
+	{
+		pendingUpdate.steps = 1;
+		pendingUpdate.startTime = totalTime - deltaTime;
+		pendingUpdate.stepLength = deltaTime;
+		camera->UpdateMovement(deltaTime);
+		simulationTime = totalTime;
+		stepsLastFrame = 1;
+		interpolationAlpha = 1.0f;
+	}
+	else
+	{
+		double step = 1.0 / simulationRate;
+		simulationAccumulator += deltaTime;
 
+		int steps = 0;
+		while (simulationAccumulator >= step && steps < maxStepsPerFrame)
+		{
+			simulationTime += step;
+			camera->UpdateMovement((float)step);
+			simulationAccumulator -= step;
+			steps++;
+		}
 
-	cameras[activeCameraIndex]->Update(deltaTime);
-	globalPsData.time = totalTime;
+		// Too far behind to catch up: keep the part of a step, drop the rest
+		if (simulationAccumulator >= step)
+		{
+			double dropped = simulationAccumulator - fmod(simulationAccumulator, step);
+			droppedSimulationMs += dropped * 1000.0;
+			simulationAccumulator -= dropped;
+		}
+
+		pendingUpdate.steps = steps;
+		pendingUpdate.stepLength = step;
+		stepsLastFrame = steps;
+		interpolationAlpha = (float)(simulationAccumulator / step);
+	}
 
+	camera->InterpolateView(interpolationAlpha);
+	pendingUpdate.camera = CaptureCamera();
+}
+
+
+// --------------------------------------------------------
+// The update stage: carries out the steps StepSimulation
+// planned, gathers what to draw and copies it all into the
+// snapshot. Runs on the pipeline's thread when pipelined,
+// so it reads only the World, the lights, the meshes and
+// pendingUpdate, none of which change until Finish().
+// --------------------------------------------------------
+void Game::BuildSnapshot(RenderSnapshot& snapshot)
+{
+	double time = pendingUpdate.startTime;
+	for (int i = 0; i < pendingUpdate.steps; i++)
+	{
+		time += pendingUpdate.stepLength;
+		systems.Run((float)pendingUpdate.stepLength, (float)time);
+	}
+	frameSystems.Run(pendingUpdate.deltaTime, pendingUpdate.totalTime);
+
+	// Swapped rather than copied, so both lists keep their capacity
+	std::swap(snapshot.renderables, renderables);
+	snapshot.lights = lights;
+
+	snapshot.deltaTime = pendingUpdate.deltaTime;
+	snapshot.totalTime = pendingUpdate.totalTime;
+	snapshot.inputTime = pendingUpdate.inputTime;
+	snapshot.camera = pendingUpdate.camera;
+}
+
+
+// --------------------------------------------------------
+// The active camera as it'll be drawn this frame
+// --------------------------------------------------------
+SnapshotCamera Game::CaptureCamera()
+{
+	std::shared_ptr<Camera> camera = cameras[activeCameraIndex];
+	SnapshotCamera captured = {};
+	captured.view = camera->GetView();
+	captured.projection = camera->GetProjection();
+	captured.position = camera->GetViewPosition();
+	captured.perspective = camera->GetProjectionType() == ProjectionType::PERSPECTIVE;
+	captured.fieldOfView = camera->GetFieldOfView();
+	captured.orthographicWidth = camera->GetOrthoGraphicWidth();
+	captured.nearClip = camera->GetNearClip();
+	return captured;
 }
 
 
@@ -525,6 +621,11 @@ void Game::Update(float deltaTime, float totalTime)
 // --------------------------------------------------------
 void Game::Draw(float deltaTime, float totalTime)
 {
+	PROFILE_SCOPE("Draw");
+
+	// Stream cooked texture mips in and out for what's on screen
+	textureStreamer.Update(pipeline.GetCurrent(), materials, Window::Width(), Window::Height());
+
 	// Frame START
 	// - These things should happen ONCE PER FRAME
 	// - At the beginning of Game::Draw() before drawing *anything*
@@ -536,149 +637,411 @@ void Game::Draw(float deltaTime, float totalTime)
 
 	//  --- Pre render --------------
 
-	// Clear Render Target
-	const float rtClearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-	Graphics::Context->ClearRenderTargetView(blurRTV.Get(), rtClearColor);
-	Graphics::Context->ClearRenderTargetView(pixelRTV.Get(), rtClearColor);
-
 	// Then Render Shadow Map to use for future render step
+	frameStats.SetPhase(FramePhase::Shadows);
 	RenderShadowMap();
+	RenderShadowAtlas();
 
 	// set shadow map and sampler for upcoming draws
 	Graphics::Context->PSSetShaderResources(4, 1, shadowSRV.GetAddressOf());
+	Graphics::Context->PSSetShaderResources(5, 1, atlasSRV.GetAddressOf());
+	Graphics::FillAndBindNextConstantBuffer(&atlasData, sizeof(ShadowAtlasExternalData), D3D11_PIXEL_SHADER, 1);
 	Graphics::Context->PSSetSamplers(1, 1, shadowSampler.GetAddressOf());
 
-	// Change the render target to render directly into our post-process texture
-	Graphics::Context->OMSetRenderTargets(1, blurRTV.GetAddressOf(), Graphics::DepthBufferDSV.Get());
+	// and the sky's light, for ambient
+	iblData.intensity = iblEnabled && specularIBL ? iblIntensity : 0.0f;
+	Graphics::Context->PSSetShaderResources(6, 1, specularIBL.GetAddressOf());
+	Graphics::Context->PSSetShaderResources(7, 1, brdfLookup.GetAddressOf());
+	Graphics::FillAndBindNextConstantBuffer(&iblData, sizeof(IBLExternalData), D3D11_PIXEL_SHADER, 2);
+	Graphics::Context->PSSetSamplers(2, 1, iblSampler.GetAddressOf());
+
+	// --- Render Graph -------------
+	// Scene and post processing, with targets handed out by the graph
+	frameStats.SetPhase(FramePhase::Scene);
+	BuildRenderGraph();
+	if (renderGraph.Compile())
+	{
+		graphExecutor.Execute(renderGraph);
+		renderGraphErrorLogged = false;
+	}
+	else if (!renderGraphErrorLogged)
+	{
+		// Once per failure, not every frame it keeps failing
+		printf("Render graph failed to compile, nothing drawn: %s\n", renderGraph.GetError().c_str());
+		renderGraphErrorLogged = true;
+	}
 
-	// --- Render -------------------
-	VertexShaderExternalData vsData = {};
-	PixelShaderExternalData psData = {};
+	// Back to the screen for the UI
+	Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
 
-	psData.camPos = cameras[activeCameraIndex]->GetTransform()->GetPosition();
-	psData.ambientColor = ambientColor;
-	memcpy(&psData.lights, &lights[0], sizeof(Light) * (int)lights.size());
+	// unbinding shadow map as shader resource
+	ID3D11ShaderResourceView* nullSRVs[16] = {};
+	Graphics::Context->PSSetShaderResources(0, 16, nullSRVs);
 	
+	// Frame END
+	// - These should happen exactly ONCE PER FRAME
+	// - At the very end of the frame (after drawing *everything*)
+	{
+		frameStats.SetPhase(FramePhase::UI);
+		{
+			PROFILE_SCOPE("ImGui render");
+			ImGui::Render(); // Turns this frames UI into renderable triangles
+			ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData()); // Draws it to the screen
+		}
 
-	// For each entity
-	for (auto& entity : entities) {
-		
+		// Present at the end of the frame
+		PROFILE_SCOPE("Present");
+		frameStats.SetPhase(FramePhase::Present);
+		bool vsync = Graphics::VsyncState();
+		Graphics::SwapChain->Present(
+			vsync ? 1 : 0,
+			vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
 
-		// set the world, view, and projection matrices
-		vsData.world = entity->GetTransform()->GetWorldMatrix();
-		vsData.worldInvTrans = entity->GetTransform()->GetWorldInverseTransposeMatrix();
-		vsData.viewMatrix = cameras[activeCameraIndex]->GetView();
-		vsData.projectionMatrix = cameras[activeCameraIndex]->GetProjection();
-		vsData.lightViewMatrix = lightViewMatrix;
-		vsData.lightProjMatrix = lightProjectionMatrix;
+		// Re-bind back buffer and depth buffer after presenting
+		Graphics::Context->OMSetRenderTargets(
+			1,
+			Graphics::BackBufferRTV.GetAddressOf(),
+			Graphics::DepthBufferDSV.Get());
 
-		Graphics::FillAndBindNextConstantBuffer(&vsData, sizeof(VertexShaderExternalData), D3D11_VERTEX_SHADER, 0);
+		if (timeToFirstFrameMs < 0)
+			timeToFirstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupTime).count();
+	}
 
-		// set data
-		psData.colorTint = entity->GetMaterial()->GetColorTint();
-		psData.time = globalPsData.time;
-		psData.uvOffset = entity->GetMaterial()->GetUVOffset();
-		psData.uvScale = entity->GetMaterial()->GetUVScale();
-		psData.roughness = entity->GetMaterial()->GetRoughness();
+	// Whatever happens until the next Update (messages, input)
+	frameStats.SetPhase(FramePhase::Other);
+}
 
-		// Draw entity
-		Graphics::FillAndBindNextConstantBuffer(&psData, sizeof(PixelShaderExternalData), D3D11_PIXEL_SHADER, 0);
+// --------------------------------------------------------
+// Everything lit and shaded, plus the sky. The render graph
+// has already bound the scene color target and depth buffer.
+// --------------------------------------------------------
+void Game::RenderScene()
+{
+	RenderSnapshot& frame = pipeline.GetCurrent();
+	VertexShaderExternalData vsData = {};
+	PixelShaderExternalData psData = {};
 
-		
+	psData.camPos = frame.camera.position;
+	psData.ambientColor = ambientColor;
+	// Scene files are held to MaxLights, but the buffer's size is what matters here
+	size_t maxLights = sizeof(psData.lights) / sizeof(Light);
+	size_t lightCount = frame.lights.size() < maxLights ? frame.lights.size() : maxLights;
+	if (lightCount > 0)
+		memcpy(&psData.lights, frame.lights.data(), sizeof(Light) * lightCount);
+
+	// Rasterize occluders on the CPU so hidden entities can be skipped
+	if (occlusionCullingEnabled)
+	{
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&frame.camera.view), XMLoadFloat4x4(&frame.camera.projection)));
 
-	
-		entity->Draw();
+		occlusionCuller->BeginFrame(viewProjection);
+		for (const Renderable& r : frame.renderables)
+		{
+			if (!(r.flags & ENTITY_OCCLUDER))
+				continue;
+			std::shared_ptr<Mesh>& mesh = meshes[r.mesh];
+			occlusionCuller->AddOccluder(mesh->GetPositions(), mesh->GetIndices(), r.world);
+		}
+		occlusionCuller->RasterizeOccluders();
 	}
 
-	// draw sky after everything
-	sky->Draw(cameras[activeCameraIndex]);
-
-	// --- Post Render -------------------
-	
-	// Turning off Vertex and Index buffers to do fullscreen triangle trick
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-	ID3D11Buffer* nothing = 0;
-	Graphics::Context->IASetIndexBuffer(0, DXGI_FORMAT_R32_UINT, 0);
-	Graphics::Context->IASetVertexBuffers(0, 1, &nothing, &stride, &offset);
+	// Build the draw list: skip anything fully behind an occluder, then sort front-to-back
+	drawScheduler.Begin(psData.camPos, depthPrepassEnabled);
+	for (int i = 0; i < (int)frame.renderables.size(); i++)
+	{
+		const Renderable& r = frame.renderables[i];
+		Mesh* mesh = meshes[r.mesh].get();
+		if (occlusionCullingEnabled && !(r.flags & ENTITY_OCCLUDER) && occlusionCuller->IsOccluded(
+			mesh->GetBoundsMin(),
+			mesh->GetBoundsMax(),
+			r.world))
+			continue;
+
+		drawScheduler.Add(i, r.center, r.radius);
+	}
+	drawScheduler.Finish();
 
-	// --- Blur Pass ---------------------
+	for (auto& pass : drawScheduler.GetPasses())
+	{
+		ID3D11DepthStencilState* depthState = 0;
+		if (pass.depthTest == DepthTest::EqualNoWrite) depthState = depthEqualState.Get();
+		if (pass.depthTest == DepthTest::LessNoWrite) depthState = depthReadOnlyState.Get();
+		Graphics::Context->OMSetDepthStencilState(depthState, 0);
 
-	// Now render to next Post Process Render Target
-	Graphics::Context->OMSetRenderTargets(1, pixelRTV.GetAddressOf(), 0);
+		// Depth only: reuse the shadow vertex shader with the camera's matrices
+		if (pass.depthOnly)
+		{
+			struct DepthVSData {
+				XMFLOAT4X4 world;
+				XMFLOAT4X4 view;
+				XMFLOAT4X4 proj;
+			};
+
+			DepthVSData depthData = {};
+			depthData.view = frame.camera.view;
+			depthData.proj = frame.camera.projection;
+
+			Graphics::Context->VSSetShader(shadowVS.Get(), 0, 0);
+			Graphics::Context->PSSetShader(0, 0, 0);
+			for (auto& item : drawScheduler.GetItems(pass))
+			{
+				const Renderable& r = frame.renderables[item.entityIndex];
+				depthData.world = r.world;
+				Graphics::FillAndBindNextConstantBuffer(&depthData, sizeof(DepthVSData), D3D11_VERTEX_SHADER, 0);
+				meshes[r.mesh]->Draw();
+			}
+			continue;
+		}
 
-	// Set up shaders
-	Graphics::Context->VSSetShader(ppVS.Get(), 0, 0);
-	Graphics::Context->PSSetShader(blurPS.Get(), 0, 0);
+		// For each entity
+		for (auto& item : drawScheduler.GetItems(pass)) {
+			const Renderable& r = frame.renderables[item.entityIndex];
+			Material* material = materials[r.material].get();
+
+			// set the world, view, and projection matrices
+			vsData.world = r.world;
+			vsData.worldInvTrans = r.worldInvTrans;
+			vsData.viewMatrix = frame.camera.view;
+			vsData.projectionMatrix = frame.camera.projection;
+			vsData.lightViewMatrix = lightViewMatrix;
+			vsData.lightProjMatrix = lightProjectionMatrix;
+
+			Graphics::FillAndBindNextConstantBuffer(&vsData, sizeof(VertexShaderExternalData), D3D11_VERTEX_SHADER, 0);
+
+			// set data
+			psData.colorTint = material->GetColorTint();
+			psData.time = globalPsData.time;
+			psData.uvOffset = material->GetUVOffset();
+			psData.uvScale = material->GetUVScale();
+			psData.roughness = material->GetRoughness();
+
+			// Draw entity
+			Graphics::FillAndBindNextConstantBuffer(&psData, sizeof(PixelShaderExternalData), D3D11_PIXEL_SHADER, 0);
+
+			// set shaders to the current entity
+			material->BindTexturesAndSamplers();
+			Graphics::Context->VSSetShader(material->GetVertexShader().Get(), 0, 0);
+			Graphics::Context->PSSetShader(material->GetPixelShader().Get(), 0, 0);
+			meshes[r.mesh]->Draw();
+		}
+	}
+	Graphics::Context->OMSetDepthStencilState(0, 0);
 
-	// Bind resources
-	Graphics::Context->PSSetShaderResources(0, 1, blurSRV.GetAddressOf());
-	Graphics::Context->PSSetSamplers(0, 1, ppSampler.GetAddressOf());
+	// draw sky after everything
+	if (sky)
+		sky->Draw(frame.camera.view, frame.camera.projection);
+}
 
-	struct BlurData {
-		float pixelWidth;
-		float pixelHeight;
-		int blurDistance;
-	};
+// --------------------------------------------------------
+// Declares this frame's passes. Nothing is drawn here -
+// the graph works out lifetimes, aliasing and binding.
+// --------------------------------------------------------
+void Game::BuildRenderGraph()
+{
+	PROFILE_SCOPE("Build render graph");
+	renderGraph.Reset();
 
-	BlurData blurData = {};
-	blurData.pixelHeight = 1.0f / Window::Height();
-	blurData.pixelWidth = 1.0f / Window::Width();
-	blurData.blurDistance = blurDistance;
+	// A frame whose graph didn't compile never executed, so its imports are still bound
+	graphExecutor.ClearImported();
 
-	Graphics::FillAndBindNextConstantBuffer(&blurData, sizeof(BlurData), D3D11_PIXEL_SHADER, 0);
+	int width = Window::Width();
+	int height = Window::Height();
+	RGTextureDesc fullDesc = { width, height, RGFormat::RGBA8_UNORM };
+	RGTextureDesc halfDesc = { (width + 1) / 2, (height + 1) / 2, RGFormat::RGBA8_UNORM };
 
-	Graphics::Context->Draw(3, 0);
+	RGHandle backBuffer = renderGraph.ImportTexture("Back Buffer", fullDesc);
+	graphExecutor.BindImported(backBuffer, Graphics::BackBufferRTV.Get(), 0);
 
-	// --- Pixelation Pass ---------------
+	// --- Scene ---------------------
+	RGHandle sceneColor = renderGraph.CreateTexture("Scene Color", fullDesc);
 
-	// Now Render to Back Buffer
-	Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
+	RenderGraphPass scenePass = renderGraph.CreatePass("Scene");
+	scenePass.writes = { sceneColor };
+	scenePass.clearTargets = true;
+	scenePass.useDepthBuffer = true;
+	scenePass.execute = [this]() {
+		RenderScene();
 
-	// set Pixel Shader for this particlar post Process
-	Graphics::Context->PSSetShader(pixelPS.Get(), 0, 0);
+		// Every pass after the scene is post processing
+		frameStats.SetPhase(FramePhase::PostProcess);
+	};
+	renderGraph.AddPass(std::move(scenePass));
 
-	// Bind Resources
-	Graphics::Context->PSSetShaderResources(0, 1, pixelSRV.GetAddressOf());
+	// --- Post process --------------
+	postProcessPlan = PostProcessPlanner::Plan(GetPostProcessSettings());
+	if (postProcessPlan.path == PostProcessPath::FusedBlurPixelate)
+	{
+		AddBlurPixelatePass(sceneColor, backBuffer, width, height);
+		return;
+	}
 
-	struct PixelationData {
-		int pixelSize;
-		float pixelWidth;
-		float pixelHeight;
+	bool downsample = postProcessPlan.path == PostProcessPath::DownsampledBlurThenPixelate;
+	RGHandle blurred = AddBlurPasses(sceneColor, fullDesc, halfDesc, downsample);
+
+	// --- Pixelation ----------------
+	RenderGraphPass pixelPass = renderGraph.CreatePass("Pixelation");
+	pixelPass.reads = { blurred };
+	pixelPass.writes = { backBuffer };
+	pixelPass.execute = [this, width, height]() {
+		struct PixelationData {
+			int pixelSize;
+			float pixelWidth;
+			float pixelHeight;
+		};
+
+		PixelationData pixelData = {};
+		pixelData.pixelSize = pixelSize;
+		pixelData.pixelWidth = 1.0f / width;
+		pixelData.pixelHeight = 1.0f / height;
+
+		Graphics::Context->VSSetShader(ppVS.Get(), 0, 0);
+		Graphics::Context->PSSetShader(pixelPS.Get(), 0, 0);
+		Graphics::Context->PSSetSamplers(0, 1, ppSampler.GetAddressOf());
+		Graphics::FillAndBindNextConstantBuffer(&pixelData, sizeof(PixelationData), D3D11_PIXEL_SHADER, 0);
+		DrawFullscreenTriangle();
 	};
+	renderGraph.AddPass(std::move(pixelPass));
+}
 
-	PixelationData pixelData = {};
-	pixelData.pixelSize = pixelSize;
-	pixelData.pixelWidth = 1.0f / Window::Width();
-	pixelData.pixelHeight = 1.0f / Window::Height();
+// --------------------------------------------------------
+// Adds the blur passes reading source and returns the
+// blurred texture (source itself when there's no blur)
+// --------------------------------------------------------
+RGHandle Game::AddBlurPasses(RGHandle source, RGTextureDesc fullDesc, RGTextureDesc halfDesc, bool downsample)
+{
+	if (blurDistance <= 0)
+	{
+		blurTapsPerPixel = 0;
+		return source;
+	}
 
-	Graphics::FillAndBindNextConstantBuffer(&pixelData, sizeof(PixelationData), D3D11_PIXEL_SHADER, 0);
+	RGHandle result = renderGraph.CreateTexture("Blur Result", fullDesc);
+	if (downsample)
+	{
+		// Big radius: blur a quarter of the pixels with half the taps
+		static const GaussianBlur::Tap copyTap = { 0.0f, 1.0f };
+		const std::vector<GaussianBlur::Tap>& taps = GetBlurTaps(GaussianBlur::DownsampledRadius(blurDistance));
+		RGHandle half = renderGraph.CreateTexture("Blur Half", halfDesc);
+		RGHandle halfHorizontal = renderGraph.CreateTexture("Blur Half Horizontal", halfDesc);
+		RGHandle halfVertical = renderGraph.CreateTexture("Blur Half Vertical", halfDesc);
+
+		AddBlurPass("Blur Downsample", source, half, &copyTap, 1, XMFLOAT2(0, 0));
+		AddBlurPass("Blur Horizontal (Half)", half, halfHorizontal, taps.data(), (int)taps.size(), XMFLOAT2(1.0f / halfDesc.width, 0));
+		AddBlurPass("Blur Vertical (Half)", halfHorizontal, halfVertical, taps.data(), (int)taps.size(), XMFLOAT2(0, 1.0f / halfDesc.height));
+		AddBlurPass("Blur Upsample", halfVertical, result, &copyTap, 1, XMFLOAT2(0, 0));
+		blurTapsPerPixel = GaussianBlur::LinearTapCount(GaussianBlur::DownsampledRadius(blurDistance));
+	}
+	else
+	{
+		const std::vector<GaussianBlur::Tap>& taps = GetBlurTaps(blurDistance);
+		RGHandle horizontal = renderGraph.CreateTexture("Blur Horizontal", fullDesc);
 
-	Graphics::Context->Draw(3, 0);
+		AddBlurPass("Blur Horizontal", source, horizontal, taps.data(), (int)taps.size(), XMFLOAT2(1.0f / fullDesc.width, 0));
+		AddBlurPass("Blur Vertical", horizontal, result, taps.data(), (int)taps.size(), XMFLOAT2(0, 1.0f / fullDesc.height));
+		blurTapsPerPixel = GaussianBlur::LinearTapCount(blurDistance);
+	}
 
-	// unbinding shadow map as shader resource
-	ID3D11ShaderResourceView* nullSRVs[16] = {};
-	Graphics::Context->PSSetShaderResources(0, 16, nullSRVs);
-	
-	// Frame END
-	// - These should happen exactly ONCE PER FRAME
-	// - At the very end of the frame (after drawing *everything*)
-	{
-		ImGui::Render(); // Turns this frames UI into renderable triangles
-		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData()); // Draws it to the screen
+	return result;
+}
 
-		// Present at the end of the frame
-		bool vsync = Graphics::VsyncState();
-		Graphics::SwapChain->Present(
-			vsync ? 1 : 0,
-			vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
+// --------------------------------------------------------
+// Blurs and pixelates in one pass straight into target,
+// skipping the intermediate blur textures entirely
+// --------------------------------------------------------
+void Game::AddBlurPixelatePass(RGHandle source, RGHandle target, int width, int height)
+{
+	// Lives in blurTaps until the radius changes, so the pass only needs a pointer
+	const GaussianBlur::Tap* taps = GetBlurTaps(blurDistance).data();
+	int tapCount = (int)blurTaps.size();
+	int directionalTaps = 2 * tapCount - 1;
+	blurTapsPerPixel = directionalTaps * directionalTaps;
+
+	RenderGraphPass pass = renderGraph.CreatePass("Blur + Pixelation");
+	pass.reads = { source };
+	pass.writes = { target };
+	pass.execute = [this, taps, tapCount, width, height]() {
+		BlurPixelateExternalData data = {};
+		data.texelSize = XMFLOAT2(1.0f / width, 1.0f / height);
+		data.pixelSize = pixelSize;
+		data.tapCount = tapCount;
+		for (int i = 0; i < data.tapCount && i < MAX_BLUR_TAPS; i++)
+			data.taps[i] = XMFLOAT4(taps[i].offset, taps[i].weight, 0, 0);
+
+		Graphics::Context->VSSetShader(ppVS.Get(), 0, 0);
+		Graphics::Context->PSSetShader(blurPixelatePS.Get(), 0, 0);
+		Graphics::Context->PSSetSamplers(0, 1, ppSampler.GetAddressOf());
+		Graphics::FillAndBindNextConstantBuffer(&data, sizeof(BlurPixelateExternalData), D3D11_PIXEL_SHADER, 0);
+		DrawFullscreenTriangle();
+	};
+	renderGraph.AddPass(std::move(pass));
+}
 
-		// Re-bind back buffer and depth buffer after presenting
-		Graphics::Context->OMSetRenderTargets(
-			1,
-			Graphics::BackBufferRTV.GetAddressOf(),
-			Graphics::DepthBufferDSV.Get());
+// --------------------------------------------------------
+// Linear taps for a blur radius, only recomputed when the
+// radius changes. Passes point into this, so it has to
+// stay put until the graph has executed.
+// --------------------------------------------------------
+const std::vector<GaussianBlur::Tap>& Game::GetBlurTaps(int radius)
+{
+	if (radius != blurTapsRadius)
+	{
+		blurTaps = GaussianBlur::ComputeLinearTaps(radius);
+		blurTapsRadius = radius;
 	}
+	return blurTaps;
+}
+
+PostProcessSettings Game::GetPostProcessSettings()
+{
+	PostProcessSettings settings = {};
+	settings.width = Window::Width();
+	settings.height = Window::Height();
+	settings.blurRadius = blurDistance;
+	settings.blurDownsampleEnabled = blurDownsampleEnabled;
+	settings.blurDownsampleRadius = blurDownsampleRadius;
+	settings.pixelSize = pixelSize;
+	settings.fusionEnabled = postFusionEnabled;
+	return settings;
+}
+
+// --------------------------------------------------------
+// One blur direction. taps has to outlive the frame (a
+// static, or blurTaps) since the pass only keeps the
+// pointer - that keeps the capture small enough for
+// std::function to hold without allocating.
+// --------------------------------------------------------
+void Game::AddBlurPass(const char* name, RGHandle source, RGHandle target, const GaussianBlur::Tap* taps, int tapCount, DirectX::XMFLOAT2 texelStep)
+{
+	RenderGraphPass pass = renderGraph.CreatePass(name);
+	pass.reads = { source };
+	pass.writes = { target };
+	pass.execute = [this, taps, tapCount, texelStep]() {
+		BlurExternalData blurData = {};
+		blurData.texelStep = texelStep;
+		blurData.tapCount = tapCount < MAX_BLUR_TAPS ? tapCount : MAX_BLUR_TAPS;
+		for (int i = 0; i < blurData.tapCount; i++)
+			blurData.taps[i] = XMFLOAT4(taps[i].offset, taps[i].weight, 0, 0);
+
+		Graphics::Context->VSSetShader(ppVS.Get(), 0, 0);
+		Graphics::Context->PSSetShader(blurPS.Get(), 0, 0);
+		Graphics::Context->PSSetSamplers(0, 1, ppSampler.GetAddressOf());
+		Graphics::FillAndBindNextConstantBuffer(&blurData, sizeof(BlurExternalData), D3D11_PIXEL_SHADER, 0);
+		DrawFullscreenTriangle();
+	};
+	renderGraph.AddPass(std::move(pass));
+}
+
+void Game::DrawFullscreenTriangle()
+{
+	// Turning off Vertex and Index buffers to do fullscreen triangle trick
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
+	ID3D11Buffer* nothing = 0;
+	Graphics::Context->IASetIndexBuffer(0, DXGI_FORMAT_R32_UINT, 0);
+	Graphics::Context->IASetVertexBuffers(0, 1, &nothing, &stride, &offset);
+
+	Graphics::Context->Draw(3, 0);
 }
 
 void Game::RefreshUI(float deltaTime) {
@@ -700,6 +1063,8 @@ void Game::RefreshUI(float deltaTime) {
 
 void Game::BuildUI()
 {
+	PROFILE_SCOPE("Build UI");
+
 	// Title of Window
 	ImGui::Begin("Julian's Awesome First Window :D");
 
@@ -711,6 +1076,34 @@ void Game::BuildUI()
 
 			// FPS Display
 			ImGui::Text("Framerate: %f fps", ImGui::GetIO().Framerate);
+			ImGui::Checkbox("Frame Stats Overlay", &frameStatsOverlay);
+
+			// Input recording and replay, for repeatable benchmark runs
+			InputRecorderStats inputStats = InputRecorder::GetStats();
+			if (InputRecorder::IsRecording())
+			{
+				ImGui::Text("Recording input: %d frames", inputStats.recordedFrames);
+				if (ImGui::Button("Stop Recording"))
+					InputRecorder::StopRecording();
+			}
+			else if (InputRecorder::IsReplaying())
+			{
+				ImGui::Text("Replaying input: frame %d of %d", inputStats.replayFrame, inputStats.replayFrameCount);
+				if (ImGui::Button("Stop Replay"))
+					InputRecorder::StopReplay();
+			}
+			else
+			{
+				std::string inputLogPath = FixPath("InputRecording.inputlog");
+				if (ImGui::Button("Record Input"))
+					StartInputRecording(inputLogPath);
+				ImGui::SameLine();
+				if (ImGui::Button("Replay Input"))
+					StartInputReplay(inputLogPath, inputReplayTimestep);
+				ImGui::SliderFloat("Replay Timestep", &inputReplayTimestep, 0.0f, 0.05f, inputReplayTimestep <= 0 ? "Recorded" : "%.4f s");
+			}
+			if (!InputRecorder::GetLastResult().empty())
+				ImGui::Text("%s", InputRecorder::GetLastResult().c_str());
 
 			// Window Resolution Display
 			ImGui::Text("Window Client Size: %dx%d", Window::Width(), Window::Height());
@@ -722,15 +1115,121 @@ void Game::BuildUI()
 			ImGui::TreePop();
 
 			// Shadow Map
+			ShadowCacheStats shadowStats = shadowCache.GetStats();
+			ImGui::Checkbox("Cache Static Shadows", &shadowCachingEnabled);
+			ImGui::Text("Shadow Casters: %d static, %d dynamic", shadowStats.staticCasters, shadowStats.dynamicCasters);
+			ImGui::Text("Shadow Cache Hits: %d  Redraws: %d", shadowStats.cacheHits, shadowStats.redraws);
+			ImGui::Text("Static Layer Rebuilt: %s (%s)", shadowStats.staticLayerRebuilt ? "Yes" : "No", shadowStats.rebuildReason);
+			ImGui::Text("Total Static Rebuilds: %d", shadowStats.totalRebuilds);
 			ImGui::Text("Shadow Map:");
 			ImGui::Image(shadowSRV.Get(), ImVec2(512, 512));
 
-			// SRVs
-			ImGui::Text("Blur Shader Resource:");
-			ImGui::Image(blurSRV.Get(), ImVec2((float)Window::Width() / 2, (float)Window::Height() / 2));
+			// Shadow Atlas
+			ShadowAtlasStats atlasStats = shadowAtlas.GetStats();
+			ImGui::Checkbox("Point/Spot Light Shadows", &atlasShadowsEnabled);
+			ImGui::Text("Atlas Lights: %d of %d (%d downsized, %d evicted)",
+				atlasStats.allocatedLights, atlasStats.requestedLights, atlasStats.downsizedLights, atlasStats.evictedLights);
+			ImGui::Text("Atlas Tiles: %d (%d redrawn)  Repacked: %s", atlasStats.tiles, atlasStats.dirtyTiles, atlasStats.repacked ? "Yes" : "No");
+			ImGui::Text("Atlas Usage: %.1f%%", 100.0f * atlasStats.usedPixels / ((float)shadowAtlas.GetAtlasSize() * shadowAtlas.GetAtlasSize()));
+			ImGui::Text("Shadow Atlas:");
+			ImGui::Image(atlasSRV.Get(), ImVec2(512, 512));
+
+			// Occlusion Culling
+			OcclusionStats occlusionStats = occlusionCuller->GetStats();
+			ImGui::Checkbox("CPU Occlusion Culling", &occlusionCullingEnabled);
+			ImGui::Text("Occluders: %d (%d triangles, %d binned)", occlusionStats.occluders, occlusionStats.triangles, occlusionStats.binnedTriangles);
+			ImGui::Text("Occlusion Culled: %d of %d", occlusionStats.culled, occlusionStats.tested);
+			ImGui::Text("Rasterize: %.3f ms  HiZ: %.3f ms (%u threads)", occlusionStats.rasterizeMs, occlusionStats.hiZMs, threadPool.GetThreadCount());
+
+			// Per-frame scratch memory
+			FrameArenaStats arenaStats = frameArena.GetStats();
+			ImGui::Text("Frame Arena: %.1f of %.0f KB (peak %.1f KB), %d allocations, %d on the heap",
+				arenaStats.usedBytes / 1024.0f, arenaStats.capacity / 1024.0f, arenaStats.peakBytes / 1024.0f,
+				arenaStats.allocations, arenaStats.overflowAllocations);
+
+			// Draw Order
+			ImGui::Checkbox("Depth Pre-Pass", &depthPrepassEnabled);
+			for (auto& pass : drawScheduler.GetPasses())
+				ImGui::BulletText("%s: %d draws", pass.name, (int)drawScheduler.GetItems(pass).size());
+
+			// Render Graph
+			RenderGraphStats graphStats = renderGraph.GetStats();
+			if (!renderGraph.GetError().empty())
+				ImGui::TextColored(ImVec4(1, 0.3f, 0.3f, 1), "Render Graph Error: %s", renderGraph.GetError().c_str());
+			ImGui::Text("Render Graph: %d passes (%d culled)", graphStats.passes, graphStats.culledPasses);
+			ImGui::Text("Transient Targets: %d -> %d textures (%.1f MB -> %.1f MB)",
+				graphStats.transientTextures, graphStats.physicalTextures,
+				graphStats.transientBytes / (1024.0f * 1024.0f), graphStats.physicalBytes / (1024.0f * 1024.0f));
+			for (int passIndex : renderGraph.GetExecutionOrder())
+				ImGui::BulletText("%s", renderGraph.GetPass(passIndex).name);
+
+			for (int i = 0; i < graphExecutor.GetTextureCount(); i++)
+			{
+				RGTextureDesc desc = graphExecutor.GetDesc(i);
+				ImGui::Text("Pooled Target %d (%dx%d):", i, desc.width, desc.height);
+				ImGui::Image(graphExecutor.GetSRV(i), ImVec2((float)Window::Width() / 2, (float)Window::Height() / 2));
+			}
+
+			// Texture Loading
+			TextureLoaderStats textureStats = textureLoader.GetStats();
+			ImGui::Text("Textures: %d of %d loaded (%d failed, %d pending) on %u threads",
+				textureStats.uploaded, textureStats.requested, textureStats.failed, textureStats.pending, textureLoader.GetThreadCount());
+			ImGui::Text("Decode: %.1f MB in %.1f ms of thread time (%.1f MB/s per thread)",
+				textureStats.bytesDecoded / (1024.0f * 1024.0f), textureStats.decodeMs,
+				textureStats.decodeMs > 0 ? textureStats.bytesDecoded / (1024.0 * 1024.0) / (textureStats.decodeMs / 1000.0) : 0.0);
+			ImGui::Text("Upload: %.1f ms  Load Wall Time: %.1f ms", textureStats.uploadMs, textureStats.elapsedMs);
+			ImGui::Text("Time To First Frame: %.1f ms  All Textures: %.1f ms", timeToFirstFrameMs, timeToAllTexturesMs);
+			if (ImGui::TreeNode("Startup Stages")) {
+				for (auto& stage : startupStages)
+					ImGui::Text("%s: %.1f ms", stage.first.c_str(), stage.second);
+				ShaderLibraryStats shaderStats = shaders.GetStats();
+				ImGui::Text("Shaders: %d preloaded on %u threads in %.1f ms, %.1f ms waited, %d on demand, %d failed",
+					shaderStats.preloaded, shaderStats.threads, shaderStats.preloadMs, shaderStats.waitMs, shaderStats.loadedOnMainThread, shaderStats.failed);
+				ImGui::TreePop();
+			}
+			ImGui::SliderInt("Texture Uploads Per Frame", &textureUploadsPerFrame, 1, 32);
+
+			// Resource Cache
+			ResourceCacheStats resourceStats = resources.GetStats();
+			const char* classNames[4] = { "Meshes", "Textures", "Pixel Shaders", "Vertex Shaders" };
+			ResourceClassStats classStats[4] = { resourceStats.meshes, resourceStats.textures, resourceStats.pixelShaders, resourceStats.vertexShaders };
+			for (int c = 0; c < 4; c++)
+			{
+				ImGui::Text("%s: %d loaded (%.2f MB), %d loads, %d cache hits", classNames[c],
+					classStats[c].count, classStats[c].bytes / (1024.0f * 1024.0f), classStats[c].loads, classStats[c].hits);
+			}
 
-			ImGui::Text("Pixelation Shader Resource:");
-			ImGui::Image(pixelSRV.Get(), ImVec2((float)Window::Width() / 2, (float)Window::Height() / 2));
+			// Hot Reload
+			HotReloadStats reloadStats = hotReloader.GetStats();
+			ImGui::Checkbox("Hot Reload", &hotReloadEnabled);
+			ImGui::SameLine();
+			ImGui::Text("Watching %d folders, %d reloads, %d failed%s%s", reloadStats.directories, reloadStats.reloads, reloadStats.failures,
+				reloadStats.lastChange.empty() ? "" : ", last: ", reloadStats.lastChange.c_str());
+			if (!reloadStats.lastError.empty())
+				ImGui::TextWrapped("%s", reloadStats.lastError.c_str());
+
+			// Texture Streaming
+			ResidencyStats residency = textureStreamer.GetStats();
+			int budgetMB = (int)(textureStreamer.GetBudget() / (1024 * 1024));
+			if (ImGui::SliderInt("Texture Budget (MB)", &budgetMB, 1, 128))
+				textureStreamer.SetBudget((size_t)budgetMB * 1024 * 1024);
+			float mipBias = textureStreamer.GetMipBias();
+			if (ImGui::SliderFloat("Streaming Mip Bias", &mipBias, -2.0f, 4.0f))
+				textureStreamer.SetMipBias(mipBias);
+			ImGui::Text("Streamed Textures: %d  Resident: %.1f MB  Wanted: %.1f MB",
+				residency.textures, residency.residentBytes / (1024.0f * 1024.0f), residency.wantedBytes / (1024.0f * 1024.0f));
+			ImGui::Text("Degraded: %d  Streaming In: %d  Total Stream-Ins: %d  Evictions: %d",
+				residency.degraded, residency.streamingIn, residency.totalStreamIns, residency.totalEvictions);
+			if (ImGui::TreeNode("Streamed Texture List")) {
+				for (int i = 0; i < textureStreamer.GetTextureCount(); i++)
+				{
+					StreamedTextureInfo info = textureStreamer.GetTextureInfo(i);
+					std::string name = info.path.substr(info.path.find_last_of("/\\") + 1);
+					ImGui::BulletText("%s: mip %d (%d px), needs %d, target %d%s", name.c_str(), info.residentMip,
+						info.width >> info.residentMip, info.neededMip, info.targetMip, info.streaming ? " (streaming)" : "");
+				}
+				ImGui::TreePop();
+			}
 		}
 		if (ImGui::TreeNode("Meshes")) {
 			for (int i = 0; i < meshes.size(); i++) {
@@ -751,33 +1250,50 @@ void Game::BuildUI()
 		}
 
 		if (ImGui::TreeNode("Scene Entities")) {
-			for (int i = 0; i < entities.size(); i++) {
-				ImGui::PushID(entities[i].get());
+			int i = 0;
+			world.Each<Transform, MeshRenderer>([&](EntityHandle entity, Transform& transform, MeshRenderer& renderer) {
+				ImGui::PushID((int)entity.index);
+				std::shared_ptr<Material> material = materials[renderer.material];
 
 				// Entity ID
 				if (ImGui::TreeNode("Entity Node", "Entity %d", i)) {
-					XMFLOAT3 pos = entities[i]->GetTransform()->GetPosition();
-					XMFLOAT3 rot = entities[i]->GetTransform()->GetPitchYawRoll();
-					XMFLOAT3 sca = entities[i]->GetTransform()->GetScale();
-
-					if (ImGui::DragFloat3("Position", &pos.x, 0.01f)) entities[i]->GetTransform()->SetPosition(pos);
-					if (ImGui::DragFloat3("Rotation (Radians)", &rot.x, 0.01f)) entities[i]->GetTransform()->SetRotation(rot);
-					if (ImGui::DragFloat3("Scale", &sca.x, 0.01f)) entities[i]->GetTransform()->SetScale(sca);
+					XMFLOAT3 pos = transform.GetPosition();
+					XMFLOAT3 rot = transform.GetPitchYawRoll();
+					XMFLOAT3 sca = transform.GetScale();
+
+					if (ImGui::DragFloat3("Position", &pos.x, 0.01f)) transform.SetPosition(pos);
+					if (ImGui::DragFloat3("Rotation (Radians)", &rot.x, 0.01f)) transform.SetRotation(rot);
+					if (ImGui::DragFloat3("Scale", &sca.x, 0.01f)) transform.SetScale(sca);
+
+					ImGui::CheckboxFlags("Static", &renderer.flags, ENTITY_STATIC);
+					ImGui::CheckboxFlags("Occluder", &renderer.flags, ENTITY_OCCLUDER);
+
+					// Animation components, when it has them
+					if (Spin* spin = world.Get<Spin>(entity))
+						ImGui::DragFloat3("Spin (Radians/s)", &spin->rate.x, 0.01f);
+					if (Sway* sway = world.Get<Sway>(entity)) {
+						ImGui::DragFloat3("Sway Origin", &sway->origin.x, 0.01f);
+						ImGui::DragFloat3("Sway Amplitude", &sway->amplitude.x, 0.01f);
+						ImGui::DragFloat("Sway Speed", &sway->speed, 0.01f);
+					}
+					if (LightAttachment* attachment = world.Get<LightAttachment>(entity))
+						ImGui::Text("Carries light %d", attachment->light);
 
-					if (ImGui::TreeNode("Material Node", "Material: %s", entities[i]->GetMaterial()->GetName())) {
+					if (ImGui::TreeNode("Material Node", "Material: %s", material->GetName())) {
 						// Color tint editing
-						XMFLOAT3 tint = entities[i]->GetMaterial()->GetColorTint();
+						XMFLOAT3 tint = material->GetColorTint();
 						if (ImGui::ColorEdit3("Color Tint", &tint.x))
-							entities[i]->GetMaterial()->SetColorTint(tint);
+							material->SetColorTint(tint);
 
 						// UV manipulations
-						XMFLOAT2 uvScale = entities[i]->GetMaterial()->GetUVScale();
-						XMFLOAT2 uvOffset = entities[i]->GetMaterial()->GetUVOffset();
-						if (ImGui::DragFloat2("UV Scale", &uvScale.x, 0.25f)) entities[i]->GetMaterial()->SetUVScale(uvScale);
-						if (ImGui::DragFloat2("UV Offset", &uvOffset.x, 0.05f)) entities[i]->GetMaterial()->SetUVOffset(uvOffset);
+						XMFLOAT2 uvScale = material->GetUVScale();
+						XMFLOAT2 uvOffset = material->GetUVOffset();
+						if (ImGui::DragFloat2("UV Scale", &uvScale.x, 0.25f)) material->SetUVScale(uvScale);
+						if (ImGui::DragFloat2("UV Offset", &uvOffset.x, 0.05f)) material->SetUVOffset(uvOffset);
 
 						// Textures
-						for (auto& it : entities[i]->GetMaterial()->GetTextureSRVMap())
+						ImGui::Text("Roughness/Metalness: %s", material->IsPackedOrm() ? "Packed ORM (t2)" : "Separate (t2, t3)");
+						for (auto& it : material->GetTextureSRVMap())
 						{
 							ImGui::Text("Texture %d", it.first);
 							ImGui::Image(it.second.Get(), ImVec2(256, 256));
@@ -788,10 +1304,57 @@ void Game::BuildUI()
 					ImGui::TreePop();
 				}
 				ImGui::PopID();
+				i++;
+			});
+			ImGui::TreePop();
+		}
+
+		// Fixed step simulation and interpolated rendering
+		if (ImGui::TreeNode("Simulation")) {
+			ImGui::Checkbox("Fixed Timestep", &fixedStepEnabled);
+			ImGui::SliderFloat("Steps Per Second", &simulationRate, 10.0f, 240.0f, "%.0f");
+			ImGui::SliderInt("Max Steps Per Frame", &maxStepsPerFrame, 1, 16);
+			ImGui::Text("%d steps last frame, drawn %.2f of the way through the last", stepsLastFrame, interpolationAlpha);
+			ImGui::Text("Simulation time: %.2f s, %.0f ms dropped to keep up", simulationTime, droppedSimulationMs);
+
+			// Updating the next frame while this one draws
+			if (ImGui::Checkbox("Pipelined Update", &pipelineEnabled))
+				pipeline.SetPipelined(pipelineEnabled);
+			FramePipelineStats pipelineStats = pipeline.GetStats();
+			ImGui::Text("Update: %.3f ms, %.3f ms waited for it", pipelineStats.updateMs, pipelineStats.waitMs);
+			ImGui::TreePop();
+		}
+
+		// The ECS behind the entities, and its systems
+		if (ImGui::TreeNode("Systems")) {
+			WorldStats worldStats = world.GetStats();
+			ImGui::Text("World: %d entities in %d archetypes, %d chunks (%.0f KB)",
+				worldStats.entities, worldStats.archetypes, worldStats.chunks, worldStats.chunkBytes / 1024.0);
+
+			bool parallelSystems = systems.IsParallel();
+			if (ImGui::Checkbox("Run Independent Systems in Parallel", &parallelSystems))
+			{
+				systems.SetParallel(parallelSystems);
+				frameSystems.SetParallel(parallelSystems);
 			}
+
+			ImGui::Text("Last step: %d batches, %.3f ms total", systems.GetBatchCount(), systems.GetLastRunMs());
+			for (auto& system : systems.GetStats())
+				ImGui::Text("  [%d] %-18s %.3f ms", system.batch, system.name.c_str(), system.ms);
+			ImGui::Text("Per frame: %d batches, %.3f ms total", frameSystems.GetBatchCount(), frameSystems.GetLastRunMs());
+			for (auto& system : frameSystems.GetStats())
+				ImGui::Text("  [%d] %-18s %.3f ms", system.batch, system.name.c_str(), system.ms);
 			ImGui::TreePop();
 		}
 
+#if PROFILER_ENABLED
+		// Where the CPU time goes, scope by scope
+		if (ImGui::TreeNode("CPU Profiler")) {
+			BuildProfilerUI();
+			ImGui::TreePop();
+		}
+#endif
+
 		// Lights
 		if (ImGui::TreeNode("Lights")) {
 
@@ -801,6 +1364,21 @@ void Game::BuildUI()
 				ImGui::TreePop();
 			}
 
+			// Light from the sky itself
+			if (ImGui::TreeNode("Image Based Lighting")) {
+				if (specularIBL)
+				{
+					ImGui::Checkbox("Enabled", &iblEnabled);
+					ImGui::SliderFloat("Intensity", &iblIntensity, 0.0f, 4.0f);
+					ImGui::Text("%s in %.1f ms, %d specular mips", iblCached ? "Loaded from cache" : "Baked", iblBakeMs, (int)iblData.specularMipCount);
+				}
+				else
+				{
+					ImGui::Text("Not available (no sky faces)");
+				}
+				ImGui::TreePop();
+			}
+
 			// Each Light Color and Intensity control
 			for (int i = 0; i < lights.size(); i++) {
 				ImGui::PushID(i);
@@ -820,9 +1398,32 @@ void Game::BuildUI()
 
 		// Post Process
 		if (ImGui::TreeNode("Post Process")) {
-			ImGui::SliderInt("BlurRadius", &blurDistance, 0, 5);
+			ImGui::SliderInt("BlurRadius", &blurDistance, 0, 32);
+			ImGui::Checkbox("Downsample Large Blurs", &blurDownsampleEnabled);
+			ImGui::SliderInt("Downsample Above Radius", &blurDownsampleRadius, 1, 32);
+			ImGui::Text("Blur Reads Per Pixel: %d (box blur would be %d)", blurTapsPerPixel, GaussianBlur::BoxTapCount(blurDistance));
 			ImGui::SliderInt("PixelSize", &pixelSize, 1, 16);
 
+			// Fusion
+			ImGui::Checkbox("Fuse Blur + Pixelation", &postFusionEnabled);
+			ImGui::Text("Path: %s (%s)", PostProcessPlanner::PathName(postProcessPlan.path), postProcessPlan.reason);
+			for (auto& p : postProcessPlan.passes)
+			{
+				ImGui::BulletText("%s: %d reads/pixel, %.2f MB read, %.2f MB written",
+					p.name, p.samplesPerPixel, p.bytesRead / (1024.0f * 1024.0f), p.bytesWritten / (1024.0f * 1024.0f));
+			}
+
+			// Same settings both ways, for comparison
+			PostProcessSettings settings = GetPostProcessSettings();
+			PostProcessPlan fused = PostProcessPlanner::PlanFused(settings);
+			PostProcessPlan separate = PostProcessPlanner::PlanSeparate(settings);
+			ImGui::Text("Bandwidth: %.2f MB fused vs %.2f MB separate",
+				fused.totalBytes / (1024.0f * 1024.0f), separate.totalBytes / (1024.0f * 1024.0f));
+			ImGui::Text("Reads per pixel: %d fused vs %d separate", fused.samplesPerPixel, separate.samplesPerPixel);
+			ImGui::Text("Estimated cost: %.2f MB fused vs %.2f MB separate",
+				fused.estimatedCost / (1024.0f * 1024.0f), separate.estimatedCost / (1024.0f * 1024.0f));
+			ImGui::Text("Passes: %d fused vs %d separate", (int)fused.passes.size(), (int)separate.passes.size());
+
 			ImGui::TreePop();
 		}
 
@@ -864,7 +1465,193 @@ void Game::BuildUI()
 
 	ImGui::End();
 
+	if (frameStatsOverlay)
+		BuildFrameStatsUI();
+}
+
+// --------------------------------------------------------
+// Frame pacing overlay: the rolling distribution of each
+// phase, recent frame times up against the hitch line, a
+// histogram and the last few hitches
+// --------------------------------------------------------
+void Game::BuildFrameStatsUI()
+{
+	ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowBgAlpha(0.85f);
+	if (!ImGui::Begin("Frame Stats", &frameStatsOverlay))
+	{
+		ImGui::End();
+		return;
+	}
+
+	FrameTimeSummary frame = frameStats.GetSummary();
+	ImGui::Text("Last %d frames: p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+		frameStats.GetHistoryCount(), frame.p50, frame.p99, frame.max);
+
+	// Each phase, then the whole frame
+	if (ImGui::BeginTable("Phases", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit))
+	{
+		const char* headers[] = { "Phase", "Mean", "p50", "p95", "p99", "Max" };
+		for (const char* header : headers)
+			ImGui::TableSetupColumn(header);
+		ImGui::TableHeadersRow();
+
+		for (int p = 0; p <= (int)FramePhase::Count; p++)
+		{
+			FrameTimeSummary s = frameStats.GetSummary((FramePhase)p);
+			float values[] = { s.mean, s.p50, s.p95, s.p99, s.max };
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%s", FrameStats::GetPhaseName((FramePhase)p));
+			for (float ms : values)
+			{
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f", ms);
+			}
+		}
+		ImGui::EndTable();
+	}
+
+	// The graph tops out a little over the hitch line
+	float hitchLineMs = frame.p50 * frameStats.GetHitchFactor();
+	if (hitchLineMs < frameStats.GetHitchMinimumMs())
+		hitchLineMs = frameStats.GetHitchMinimumMs();
+	char overlay[64];
+	snprintf(overlay, sizeof(overlay), "Hitch above %.1f ms", hitchLineMs);
+	ImGui::PlotLines("Frame Times", frameStats.GetHistory(), frameStats.GetHistoryCount(), frameStats.GetHistoryOffset(),
+		overlay, 0.0f, hitchLineMs * 1.5f, ImVec2(0, 80));
+
+	ImGui::SliderFloat("Bucket Size (ms)", &frameStatsBucketMs, 0.25f, 5.0f, "%.2f");
+	std::vector<float> histogram = frameStats.BuildHistogram(frameStatsBucketMs, 40);
+	snprintf(overlay, sizeof(overlay), "Last bucket: %.1f ms and up", frameStatsBucketMs * (histogram.size() - 1));
+	ImGui::PlotHistogram("Histogram", histogram.data(), (int)histogram.size(), 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 80));
+
+	// Hitches
+	float hitchFactor = frameStats.GetHitchFactor();
+	float hitchMinimumMs = frameStats.GetHitchMinimumMs();
+	bool thresholdChanged = ImGui::SliderFloat("Hitch Factor (x median)", &hitchFactor, 1.2f, 5.0f, "%.1f");
+	thresholdChanged |= ImGui::SliderFloat("Hitch Minimum (ms)", &hitchMinimumMs, 1.0f, 50.0f, "%.1f");
+	if (thresholdChanged)
+		frameStats.SetHitchThreshold(hitchFactor, hitchMinimumMs);
+
+	const std::vector<FrameHitch>& hitches = frameStats.GetHitches();
+	ImGui::Text("Hitches: %llu since startup", frameStats.GetHitchCount());
+	for (int i = (int)hitches.size() - 1; i >= 0; i--)
+	{
+		const FrameHitch& h = hitches[i];
+		ImGui::Text("  Frame %llu: %.2f ms (median %.2f), %s took %.2f ms",
+			h.frame, h.ms, h.medianMs, FrameStats::GetPhaseName(h.worstPhase), h.worstPhaseMs);
+	}
+
+	// CSV, next to the executable
+	if (ImGui::Button("Dump History to CSV"))
+	{
+		std::string path = FixPath("FrameStats.csv");
+		frameStatsCsvResult = (frameStats.WriteCsv(path) ? "Wrote " : "Couldn't write ") + path;
+	}
+	ImGui::SameLine();
+	bool logging = frameStats.IsLoggingCsv();
+	if (ImGui::Checkbox("Log Every Frame", &logging))
+	{
+		std::string path = FixPath("FrameStatsLog.csv");
+		if (!logging)
+			frameStats.StopCsvLog();
+		else
+			frameStatsCsvResult = (frameStats.StartCsvLog(path) ? "Logging to " : "Couldn't write ") + path;
+	}
+	if (!frameStatsCsvResult.empty())
+		ImGui::Text("%s", frameStatsCsvResult.c_str());
+
+	ImGui::End();
+}
+
+#if PROFILER_ENABLED
+// --------------------------------------------------------
+// The profiler's last frame as a flame graph: one lane per
+// thread, one row per nesting depth, time left to right.
+// Hover a scope for its name and duration.
+// --------------------------------------------------------
+void Game::BuildProfilerUI()
+{
+	const Profiler::Frame& frame = Profiler::GetLastFrame();
+	Profiler::Stats stats = Profiler::GetStats();
+	double frameMs = Profiler::TicksToMs(frame.end - frame.start);
+
+	ImGui::Text("Frame %llu: %.3f ms, %d scopes on %d threads",
+		(unsigned long long)frame.index, frameMs, stats.eventsLastFrame, stats.threads);
+	ImGui::Text("Gathering: %.3f ms, %llu scopes dropped", stats.gatherMs, (unsigned long long)stats.droppedEvents);
+
+	bool paused = Profiler::IsPaused();
+	if (ImGui::Checkbox("Pause", &paused))
+		Profiler::SetPaused(paused);
+	ImGui::SameLine();
+	ImGui::SliderFloat("View (ms)", &profilerViewMs, 0.0f, 50.0f, profilerViewMs <= 0 ? "Whole frame" : "%.1f");
+
+	// Chrome trace export, for chrome://tracing or ui.perfetto.dev
+	ImGui::SliderInt("Trace Frames", &profilerTraceFrames, 1, 60);
+	if (Profiler::IsCapturing())
+		ImGui::Text("Capturing...");
+	else if (ImGui::Button("Capture Trace"))
+		Profiler::CaptureTrace(FixPath("ProfileTrace.json"), profilerTraceFrames);
+	ImGui::SameLine();
+	if (ImGui::Button("Write Startup Trace"))
+		Profiler::WriteStartupTrace(FixPath("StartupTrace.json"));
+	if (!Profiler::GetLastTraceResult().empty())
+		ImGui::Text("%s", Profiler::GetLastTraceResult().c_str());
+
+	double viewMs = profilerViewMs > 0 ? profilerViewMs : frameMs;
+	if (viewMs <= 0)
+		return;
+
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	float width = ImGui::GetContentRegionAvail().x;
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	ImVec2 mouse = ImGui::GetIO().MousePos;
+
+	for (const Profiler::ThreadFrame& thread : frame.threads)
+	{
+		int maxDepth = 0;
+		for (const Profiler::Event& e : thread.events)
+			if (e.depth > maxDepth)
+				maxDepth = e.depth;
+
+		ImGui::Text("%s", thread.name.c_str());
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImVec2 size(width, rowHeight * (maxDepth + 1));
+		ImGui::Dummy(size);
+		drawList->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), IM_COL32(30, 30, 30, 255));
+
+		for (const Profiler::Event& e : thread.events)
+		{
+			// Scopes from other threads can straddle the frame's edges
+			double startMs = e.start > frame.start ? Profiler::TicksToMs(e.start - frame.start) : -Profiler::TicksToMs(frame.start - e.start);
+			double endMs = startMs + Profiler::TicksToMs(e.end - e.start);
+			if (endMs < 0 || startMs > viewMs)
+				continue;
+
+			float x0 = origin.x + (float)((startMs < 0 ? 0 : startMs) / viewMs) * width;
+			float x1 = origin.x + (float)((endMs > viewMs ? viewMs : endMs) / viewMs) * width;
+			if (x1 < x0 + 1.0f)
+				x1 = x0 + 1.0f;
+			float y0 = origin.y + e.depth * rowHeight;
+			float y1 = y0 + rowHeight - 1.0f;
+
+			// Same name, same color, frame to frame
+			unsigned int hash = 2166136261u;
+			for (const char* c = e.name; *c; c++)
+				hash = (hash ^ (unsigned char)*c) * 16777619u;
+			ImU32 fill = ImColor::HSV((hash % 360) / 360.0f, 0.5f, 0.7f);
+			drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), fill);
+
+			if (ImGui::CalcTextSize(e.name).x < x1 - x0 - 4.0f)
+				drawList->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32(0, 0, 0, 255), e.name);
+
+			if (mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1)
+				ImGui::SetTooltip("%s\n%.3f ms", e.name, endMs - startMs);
+		}
+	}
 }
+#endif
 
 void Game::CreateShadowMapResources()
 {
@@ -881,9 +1668,11 @@ void Game::CreateShadowMapResources()
 	shadowDesc.SampleDesc.Count = 1;
 	shadowDesc.SampleDesc.Quality = 0;
 	shadowDesc.Usage = D3D11_USAGE_DEFAULT;
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowTexture;
 	Graphics::Device->CreateTexture2D(&shadowDesc, 0, shadowTexture.GetAddressOf());
 
+	// Identical texture for the cached static layer
+	Graphics::Device->CreateTexture2D(&shadowDesc, 0, staticShadowTexture.GetAddressOf());
+
 	// Create the depth/stencil view
 	D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
 	shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
@@ -893,6 +1682,10 @@ void Game::CreateShadowMapResources()
 		shadowTexture.Get(),
 		&shadowDSDesc,
 		shadowDSV.GetAddressOf());
+	Graphics::Device->CreateDepthStencilView(
+		staticShadowTexture.Get(),
+		&shadowDSDesc,
+		staticShadowDSV.GetAddressOf());
 
 	// Create the SRV for the shadow map
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
@@ -924,10 +1717,26 @@ void Game::CreateShadowMapResources()
 	shadowSampDesc.BorderColor[0] = 1.0f; // Only need the first component
 	Graphics::Device->CreateSamplerState(&shadowSampDesc, &shadowSampler);
 
+	// New textures hold nothing yet
+	shadowCache.Invalidate();
+
+	// No snapshot exists yet, so start from the scene's own lights
+	UpdateShadowLightMatrices(lights);
+}
+
+// --------------------------------------------------------
+// Follows the first light, which is the directional one;
+// with no lights the matrices are left as they were
+// --------------------------------------------------------
+void Game::UpdateShadowLightMatrices(const std::vector<Light>& frameLights)
+{
+	if (frameLights.empty())
+		return;
+
 	// Creating Light View Matrix
 	XMMATRIX lightView = XMMatrixLookToLH(
-		XMLoadFloat3(&lights[0].direction) * XMVectorReplicate(-30.0f), // Position: Backing up 30 units from origin
-		XMLoadFloat3(&lights[0].direction), // Direction: first light's direction
+		XMLoadFloat3(&frameLights[0].direction) * XMVectorReplicate(-30.0f), // Position: Backing up 30 units from origin
+		XMLoadFloat3(&frameLights[0].direction), // Direction: first light's direction
 		XMVectorSet(0, 1, 0, 0)				// Up: World Up Vector
 	);
 	XMStoreFloat4x4(&lightViewMatrix, lightView);
@@ -944,11 +1753,16 @@ void Game::CreateShadowMapResources()
 
 void Game::RenderShadowMap()
 {
-	// Clear Shadow Map
-	Graphics::Context->ClearDepthStencilView(shadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+	PROFILE_SCOPE("Shadow map");
+	RenderSnapshot& frame = pipeline.GetCurrent();
 
-	// Set up the output merger stage
-	Graphics::Context->OMSetRenderTargets(0, 0, shadowDSV.Get());
+	// Light may have moved since last frame
+	UpdateShadowLightMatrices(frame.lights);
+
+	// Figure out if the cached static layer is still good
+	if (!shadowCachingEnabled)
+		shadowCache.Invalidate();
+	bool rebuildStatic = shadowCache.BeginFrame(frame.renderables, lightViewMatrix, lightProjectionMatrix);
 
 	// Enable rasterizer State
 	Graphics::Context->RSSetState(shadowRasterizer.Get());
@@ -978,14 +1792,33 @@ void Game::RenderShadowMap()
 	vsData.view = lightViewMatrix;
 	vsData.proj = lightProjectionMatrix;
 
-	// Loop and draw entities
-	// Loop and draw all entities
-	for (auto& e : entities)
+	// Re-render the static layer only when something in it changed
+	if (rebuildStatic)
+	{
+		Graphics::Context->ClearDepthStencilView(staticShadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+		Graphics::Context->OMSetRenderTargets(0, 0, staticShadowDSV.Get());
+
+		for (int e : shadowCache.GetStaticCasters())
+		{
+			vsData.world = frame.renderables[e].world;
+			Graphics::FillAndBindNextConstantBuffer(&vsData, sizeof(ShadowVSData), D3D11_VERTEX_SHADER, 0);
+
+			meshes[frame.renderables[e].mesh]->Draw();
+		}
+	}
+
+	// Start this frame's shadow map from the cached static layer
+	Graphics::Context->OMSetRenderTargets(0, 0, 0);
+	Graphics::Context->CopyResource(shadowTexture.Get(), staticShadowTexture.Get());
+
+	// Composite dynamic casters on top
+	Graphics::Context->OMSetRenderTargets(0, 0, shadowDSV.Get());
+	for (int e : shadowCache.GetDynamicCasters())
 	{
-		vsData.world = e->GetTransform()->GetWorldMatrix();
+		vsData.world = frame.renderables[e].world;
 		Graphics::FillAndBindNextConstantBuffer(&vsData, sizeof(ShadowVSData), D3D11_VERTEX_SHADER, 0);
 
-		e->GetMesh()->Draw();
+		meshes[frame.renderables[e].mesh]->Draw();
 	}
 
 	// reset the pipeline
@@ -1002,103 +1835,691 @@ void Game::RenderShadowMap()
 	Graphics::Context->RSSetState(0);
 }
 
+void Game::CreateShadowAtlasResources()
+{
+	int atlasSize = shadowAtlas.GetAtlasSize();
+
+	// One big depth texture shared by every point and spot light
+	D3D11_TEXTURE2D_DESC atlasDesc = {};
+	atlasDesc.Width = static_cast<UINT>(atlasSize);
+	atlasDesc.Height = static_cast<UINT>(atlasSize);
+	atlasDesc.ArraySize = 1;
+	atlasDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+	atlasDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	atlasDesc.MipLevels = 1;
+	atlasDesc.SampleDesc.Count = 1;
+	atlasDesc.Usage = D3D11_USAGE_DEFAULT;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> atlasTexture;
+	Graphics::Device->CreateTexture2D(&atlasDesc, 0, atlasTexture.GetAddressOf());
+
+	D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+	dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
+	dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	Graphics::Device->CreateDepthStencilView(atlasTexture.Get(), &dsvDesc, atlasDSV.GetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+	Graphics::Device->CreateShaderResourceView(atlasTexture.Get(), &srvDesc, atlasSRV.GetAddressOf());
+
+	// Perspective shadows need depth clipping, unlike the directional map
+	D3D11_RASTERIZER_DESC rastDesc = {};
+	rastDesc.FillMode = D3D11_FILL_SOLID;
+	rastDesc.CullMode = D3D11_CULL_BACK;
+	rastDesc.DepthClipEnable = true;
+	rastDesc.DepthBias = 1000;
+	rastDesc.SlopeScaledDepthBias = 1.0f;
+	Graphics::Device->CreateRasterizerState(&rastDesc, atlasRasterizer.GetAddressOf());
+
+	// Clearing a single tile means drawing over it, so always pass the depth test
+	D3D11_DEPTH_STENCIL_DESC clearDepthDesc = {};
+	clearDepthDesc.DepthEnable = true;
+	clearDepthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	clearDepthDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+	Graphics::Device->CreateDepthStencilState(&clearDepthDesc, atlasClearDepthState.GetAddressOf());
+
+	atlasClearPS = LoadPixelShader(L"ShadowClearPS.cso");
+
+	// Fresh texture, so every tile needs drawing
+	shadowAtlas.MarkAllDirty();
+	atlasLightSnapshot.clear();
+}
+
+// --------------------------------------------------------
+// Decides which lights get atlas space this frame and
+// which of their tiles are out of date
+// --------------------------------------------------------
+void Game::UpdateShadowAtlas()
+{
+	RenderSnapshot& frame = pipeline.GetCurrent();
+	const SnapshotCamera& camera = frame.camera;
+	XMFLOAT3 cameraPos = camera.position;
+
+	// Ask for space for every point and spot light
+	FrameVector<ShadowAtlasRequest> requests{ FrameAllocator<ShadowAtlasRequest>(&frameArena) };
+	requests.reserve(frame.lights.size());
+	for (int i = 0; i < (int)frame.lights.size(); i++)
+	{
+		frame.lights[i].shadowIndex = -1;
+		if (!atlasShadowsEnabled || frame.lights[i].type == LIGHT_TYPE_DIRECTIONAL)
+			continue;
+
+		XMVECTOR toLight = XMLoadFloat3(&frame.lights[i].position) - XMLoadFloat3(&cameraPos);
+		float distance = XMVectorGetX(XMVector3Length(toLight));
+
+		// Rough fraction of the screen the light's range can touch
+		float halfScreen = camera.perspective ?
+			distance * tanf(camera.fieldOfView * 0.5f) :
+			camera.orthographicWidth * 0.5f;
+		float coverage = 1.0f;
+		if (distance > frame.lights[i].range && halfScreen > 0.0001f)
+			coverage = frame.lights[i].range / halfScreen;
+
+		ShadowAtlasRequest request = {};
+		request.lightIndex = i;
+		request.faceCount = frame.lights[i].type == LIGHT_TYPE_POINT ? 6 : 1;
+		request.position = frame.lights[i].position;
+		request.range = frame.lights[i].range;
+		request.screenCoverage = coverage;
+		request.distance = distance;
+		requests.push_back(request);
+	}
+	shadowAtlas.Update(requests.data(), (int)requests.size());
+
+	// Lights that changed since their tiles were drawn
+	for (int i = 0; i < (int)frame.lights.size(); i++)
+	{
+		if (i >= (int)atlasLightSnapshot.size())
+		{
+			shadowAtlas.MarkLightDirty(i);
+			continue;
+		}
+
+		Light& now = frame.lights[i];
+		Light& then = atlasLightSnapshot[i];
+		if (now.type != then.type || now.range != then.range || now.spotOuterAngle != then.spotOuterAngle ||
+			memcmp(&now.position, &then.position, sizeof(XMFLOAT3)) != 0 ||
+			memcmp(&now.direction, &then.direction, sizeof(XMFLOAT3)) != 0)
+			shadowAtlas.MarkLightDirty(i);
+	}
+	atlasLightSnapshot = frame.lights;
+
+	// Casters that moved dirty the lights around both where they were and where they
+	// are; between steps, a caster's bounds can move with no new version
+	for (const Renderable& r : frame.renderables)
+	{
+		unsigned int version = r.version;
+		auto it = atlasCasters.find(r.entity);
+		if (it != atlasCasters.end())
+		{
+			if (it->second.version == version && memcmp(&it->second.center, &r.center, sizeof(XMFLOAT3)) == 0)
+				continue;
+			shadowAtlas.NotifyCasterChanged(it->second.center, it->second.radius);
+		}
+
+		AtlasCaster caster = {};
+		caster.version = version;
+		caster.center = r.center;
+		caster.radius = r.radius;
+		shadowAtlas.NotifyCasterChanged(caster.center, caster.radius);
+		atlasCasters[r.entity] = caster;
+	}
+
+	// Fill in the shader's view of the atlas
+	const std::vector<ShadowAtlasTile>& tiles = shadowAtlas.GetTiles();
+	float atlasSize = (float)shadowAtlas.GetAtlasSize();
+	for (int i = 0; i < (int)tiles.size() && i < MAX_ATLAS_SHADOWS; i++)
+	{
+		XMFLOAT4X4 view, proj;
+		CalculateAtlasTileMatrices(frame.lights[tiles[i].lightIndex], tiles[i].face, view, proj);
+		XMStoreFloat4x4(&atlasData.shadows[i].viewProjection, XMLoadFloat4x4(&view) * XMLoadFloat4x4(&proj));
+		atlasData.shadows[i].atlasRect = XMFLOAT4(
+			tiles[i].x / atlasSize,
+			tiles[i].y / atlasSize,
+			tiles[i].size / atlasSize,
+			tiles[i].size / atlasSize);
+	}
+
+	for (int i = 0; i < (int)frame.lights.size(); i++)
+		frame.lights[i].shadowIndex = shadowAtlas.FindFirstTile(i);
+}
+
+// --------------------------------------------------------
+// Re-renders only the atlas tiles that are dirty
+// --------------------------------------------------------
+void Game::RenderShadowAtlas()
+{
+	PROFILE_SCOPE("Shadow atlas");
+	RenderSnapshot& frame = pipeline.GetCurrent();
+	UpdateShadowAtlas();
+
+	Graphics::Context->RSSetState(atlasRasterizer.Get());
+	Graphics::Context->OMSetRenderTargets(0, 0, atlasDSV.Get());
+
+	struct ShadowVSData {
+		XMFLOAT4X4 world;
+		XMFLOAT4X4 view;
+		XMFLOAT4X4 proj;
+	};
+
+	for (auto& tile : shadowAtlas.GetTiles())
+	{
+		if (!tile.dirty)
+			continue;
+
+		// Only touch this tile's part of the atlas
+		D3D11_VIEWPORT viewport = {};
+		viewport.TopLeftX = (float)tile.x;
+		viewport.TopLeftY = (float)tile.y;
+		viewport.Width = (float)tile.size;
+		viewport.Height = (float)tile.size;
+		viewport.MaxDepth = 1.0f;
+		Graphics::Context->RSSetViewports(1, &viewport);
+
+		// Clear the tile with a fullscreen triangle (ClearDepthStencilView would wipe the whole atlas)
+		Graphics::Context->OMSetDepthStencilState(atlasClearDepthState.Get(), 0);
+		Graphics::Context->VSSetShader(ppVS.Get(), 0, 0);
+		Graphics::Context->PSSetShader(atlasClearPS.Get(), 0, 0);
+		Graphics::Context->Draw(3, 0);
+
+		// Then draw the casters within the light's reach
+		Graphics::Context->OMSetDepthStencilState(0, 0);
+		Graphics::Context->VSSetShader(shadowVS.Get(), 0, 0);
+		Graphics::Context->PSSetShader(0, 0, 0);
+
+		Light& light = frame.lights[tile.lightIndex];
+		ShadowVSData vsData = {};
+		CalculateAtlasTileMatrices(light, tile.face, vsData.view, vsData.proj);
+
+		for (const Renderable& r : frame.renderables)
+		{
+			AtlasCaster& caster = atlasCasters[r.entity];
+			float dx = caster.center.x - light.position.x;
+			float dy = caster.center.y - light.position.y;
+			float dz = caster.center.z - light.position.z;
+			float reach = caster.radius + light.range;
+			if (dx * dx + dy * dy + dz * dz > reach * reach)
+				continue;
+
+			vsData.world = r.world;
+			Graphics::FillAndBindNextConstantBuffer(&vsData, sizeof(ShadowVSData), D3D11_VERTEX_SHADER, 0);
+
+			meshes[r.mesh]->Draw();
+		}
+	}
+	shadowAtlas.ClearDirtyFlags();
+
+	// reset the pipeline
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)Window::Width();
+	viewport.Height = (float)Window::Height();
+	viewport.MaxDepth = 1.0f;
+	Graphics::Context->RSSetViewports(1, &viewport);
+	Graphics::Context->OMSetRenderTargets(
+		1,
+		Graphics::BackBufferRTV.GetAddressOf(),
+		Graphics::DepthBufferDSV.Get()
+	);
+	Graphics::Context->RSSetState(0);
+}
+
+// --------------------------------------------------------
+// View and projection for one face of a light's shadow.
+// Point light faces go +X, -X, +Y, -Y, +Z, -Z to match
+// PointShadowFace() in ShadowAtlas.hlsli
+// --------------------------------------------------------
+void Game::CalculateAtlasTileMatrices(const Light& light, int face, XMFLOAT4X4& view, XMFLOAT4X4& proj)
+{
+	static const XMFLOAT3 faceDirections[6] = {
+		XMFLOAT3(1, 0, 0), XMFLOAT3(-1, 0, 0),
+		XMFLOAT3(0, 1, 0), XMFLOAT3(0, -1, 0),
+		XMFLOAT3(0, 0, 1), XMFLOAT3(0, 0, -1) };
+	static const XMFLOAT3 faceUps[6] = {
+		XMFLOAT3(0, 1, 0), XMFLOAT3(0, 1, 0),
+		XMFLOAT3(0, 0, -1), XMFLOAT3(0, 0, 1),
+		XMFLOAT3(0, 1, 0), XMFLOAT3(0, 1, 0) };
+
+	XMVECTOR direction;
+	XMVECTOR up;
+	float fov;
+	if (light.type == LIGHT_TYPE_POINT)
+	{
+		direction = XMLoadFloat3(&faceDirections[face]);
+		up = XMLoadFloat3(&faceUps[face]);
+		fov = XM_PIDIV2;
+	}
+	else
+	{
+		// Spot light: one view down the cone, slightly wider than it
+		direction = XMVector3Normalize(XMLoadFloat3(&light.direction));
+		up = fabsf(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+		fov = light.spotOuterAngle * 2.0f + XMConvertToRadians(5.0f);
+		if (fov > XM_PI * 0.9f) fov = XM_PI * 0.9f;
+	}
+
+	XMStoreFloat4x4(&view, XMMatrixLookToLH(XMLoadFloat3(&light.position), direction, up));
+	XMStoreFloat4x4(&proj, XMMatrixPerspectiveFovLH(fov, 1.0f, 0.05f, light.range));
+}
+
+// --------------------------------------------------------
+// Points everything still using a reloaded shader at the new
+// one, and decodes changed textures, swapping them into
+// material slots once they're uploaded. Meshes were already
+// rebuilt in place by the cache.
+// --------------------------------------------------------
+void Game::ApplyHotReload(const HotReloadResults& results)
+{
+	for (auto& swap : results.pixelShaders)
+	{
+		auto replace = [&](Microsoft::WRL::ComPtr<ID3D11PixelShader>& shader) {
+			if (shader == swap.before)
+				shader = swap.after;
+		};
+
+		for (auto& mat : materials)
+			if (mat->GetPixelShader() == swap.before)
+				mat->SetPixelShader(swap.after);
+		if (sky && sky->GetPixelShader() == swap.before)
+			sky->SetPixelShader(swap.after);
+		replace(ormPS);
+		replace(blurPS);
+		replace(blurPixelatePS);
+		replace(pixelPS);
+		replace(atlasClearPS);
+	}
+
+	for (auto& swap : results.vertexShaders)
+	{
+		auto replace = [&](Microsoft::WRL::ComPtr<ID3D11VertexShader>& shader) {
+			if (shader == swap.before)
+				shader = swap.after;
+		};
+
+		for (auto& mat : materials)
+			if (mat->GetVertexShader() == swap.before)
+				mat->SetVertexShader(swap.after);
+		if (sky && sky->GetVertexShader() == swap.before)
+			sky->SetVertexShader(swap.after);
+		replace(shadowVS);
+		replace(ppVS);
+	}
+
+	for (auto& path : results.textures)
+	{
+		textureLoader.Request(path,
+			[this](const TextureLoadResult& result) {
+				ResourceSwap<ID3D11ShaderResourceView> swap;
+				if (!result.succeeded || !resources.ReplaceTexture(result.path, CreateTextureFromImage(result.image), swap))
+					return;
+
+				for (auto& mat : materials)
+					for (auto& slot : mat->GetTextureSRVMap())
+						if (slot.second == swap.before)
+							slot.second = swap.after;
+			});
+	}
+}
+
+// --------------------------------------------------------
+// Starts loading every shader the scene and the renderer
+// will ask for, so they're ready (or close) by the time
+// LoadPixelShader()/LoadVertexShader() want them
+// --------------------------------------------------------
+void Game::PreloadShaders()
+{
+	PROFILE_SCOPE("Preload shaders");
+	std::vector<std::wstring> pixelShaders = {
+		L"PixelShaderORM.cso", L"BlurPS.cso", L"BlurPixelatePS.cso", L"PixelationPS.cso", L"ShadowClearPS.cso" };
+	std::vector<std::wstring> vertexShaders = {
+		L"VertexShader.cso", L"ShadowVS.cso", L"FullscreenVS.cso" };
+
+	auto wide = [](const char* name) { return std::wstring(name, name + strlen(name)); };
+	for (auto& desc : scene.materials)
+	{
+		pixelShaders.push_back(wide(desc.pixelShader));
+		vertexShaders.push_back(wide(desc.vertexShader));
+	}
+	if (scene.settings.skyMesh >= 0)
+	{
+		pixelShaders.push_back(wide(scene.settings.skyPixelShader));
+		vertexShaders.push_back(wide(scene.settings.skyVertexShader));
+	}
+
+	// Repeats are dropped by the library
+	shaders.Preload(pixelShaders, vertexShaders);
+}
+
+// --------------------------------------------------------
+// Records how long the startup stage just finished took
+// --------------------------------------------------------
+void Game::EndStartupStage(const char* name)
+{
+	auto now = std::chrono::high_resolution_clock::now();
+	startupStages.push_back({ name, std::chrono::duration<double, std::milli>(now - startupStageTime).count() });
+	startupStageTime = now;
+}
+
+// --------------------------------------------------------
+// Bakes the sky's diffuse and specular light (and the BRDF
+// lookup) into Assets/Cooked, unless what's there is already
+// from the same faces and settings, then loads it all. The
+// faces are the PNGs, not the cooked cube map, so the bake
+// works from full precision.
+// --------------------------------------------------------
+void Game::BakeImageBasedLighting()
+{
+	PROFILE_SCOPE("Image based lighting");
+	const SceneSettings& settings = scene.settings;
+	if (!sky || !settings.skyFaces[0][0])
+		return;
+
+	std::vector<std::string> faces;
+	for (int i = 0; i < 6; i++)
+		faces.push_back(FixPath(std::string("../../Assets/Textures/") + settings.skyFaces[i]));
+
+	std::string cookedDir = FixPath("../../Assets/Cooked/");
+	std::string specularPath = cookedDir + "sky_specular.dds";
+	std::string irradiancePath = cookedDir + "sky_irradiance.sh";
+	std::string lutPath = cookedDir + "brdf_lut.dds";
+	std::error_code error;
+	std::filesystem::create_directories(cookedDir, error);
+
+	IBLSettings bakeSettings = IBLBaker::DefaultSettings();
+	IBLResult environment = IBLBaker::BakeEnvironment(faces, specularPath, irradiancePath, bakeSettings, threadPool);
+	IBLResult lut = IBLBaker::BakeBrdfLut(lutPath, bakeSettings, threadPool);
+	iblBakeMs = environment.ms + lut.ms;
+	iblCached = environment.upToDate && lut.upToDate;
+	printf("IBL %s in %.1f ms\n", iblCached ? "loaded from cache" : "baked", iblBakeMs);
+	if (!environment.succeeded || !lut.succeeded)
+	{
+		printf("IBL bake failed: %s\n", environment.succeeded ? lut.error.c_str() : environment.error.c_str());
+		return;
+	}
+
+	IrradianceSH sh;
+	if (!IBLBaker::LoadIrradiance(irradiancePath, sh))
+		return;
+	for (int i = 0; i < 9; i++)
+		iblData.irradianceSH[i] = XMFLOAT4(sh.coefficients[i][0], sh.coefficients[i][1], sh.coefficients[i][2], 0);
+
+	std::wstring specularFile(specularPath.begin(), specularPath.end());
+	std::wstring lutFile(lutPath.begin(), lutPath.end());
+	if (FAILED(CreateDDSTextureFromFile(Graphics::Device.Get(), specularFile.c_str(), 0, specularIBL.GetAddressOf())) ||
+		FAILED(CreateDDSTextureFromFile(Graphics::Device.Get(), lutFile.c_str(), 0, brdfLookup.GetAddressOf())))
+	{
+		specularIBL.Reset();
+		brdfLookup.Reset();
+		return;
+	}
+	iblData.specularMipCount = (float)bakeSettings.specularMips;
+
+	// Clamped, so the lookup table's edges don't wrap
+	D3D11_SAMPLER_DESC sampDesc = {};
+	sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	Graphics::Device->CreateSamplerState(&sampDesc, iblSampler.GetAddressOf());
+}
+
+// --------------------------------------------------------
+// Reads Assets/Scenes/<name>.scene into the scene description.
+// The cooked Assets/Cooked/<name>.sceneb (Tools/ConvertScene)
+// is used instead when it was made from the same text, or
+// when it's shipped without the text at all.
+// --------------------------------------------------------
+bool Game::LoadSceneDesc(const std::string& name)
+{
+	PROFILE_SCOPE("Load scene file");
+	std::string textPath = FixPath("../../Assets/Scenes/" + name + ".scene");
+	std::string binaryPath = FixPath("../../Assets/Cooked/" + name + ".sceneb");
+	std::string error;
+
+	uint64_t sourceHash = SceneFile::HashFile(textPath);
+	uint64_t cookedHash = SceneFile::ReadBinarySourceHash(binaryPath);
+	if (cookedHash != 0 && (sourceHash == 0 || cookedHash == sourceHash))
+	{
+		if (SceneFile::LoadBinary(binaryPath, scene, &error))
+			return true;
+		printf("%s: %s\n", binaryPath.c_str(), error.c_str());
+	}
+
+	if (SceneFile::LoadText(textPath, scene, &error))
+		return true;
+	printf("%s: %s\n", textPath.c_str(), error.c_str());
+	return false;
+}
+
+// --------------------------------------------------------
+// Queues a texture on the loader threads and swaps it into
+// the material's slot once it's ready. Cooked DDS files in
+// Assets/Cooked (see Tools/CookTextures.cpp) are used when
+// present, otherwise the PNG in Assets/Textures is decoded.
+// The material keeps its placeholder if loading fails.
+// --------------------------------------------------------
+void Game::LoadTextureAsync(const std::string& fileName, std::shared_ptr<Material> material, unsigned int index)
+{
+	std::string path = FixPath("../../Assets/Textures/" + fileName);
+	std::string cookedPath = FixPath("../../Assets/Cooked/" + fileName.substr(0, fileName.find_last_of('.')) + ".dds");
+	if (std::ifstream(cookedPath).good())
+		path = cookedPath;
+
+	textureLoader.Request(path,
+		[this, material, index](const TextureLoadResult& result) {
+			TextureHandle handle;
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv = UploadTexture(result, handle);
+			if (srv)
+			{
+				material->SetTextureSRV(index, srv);
+				SetMaterialTexture(material, index, handle);
+				textureStreamer.Bind(result.path, material, index);
+			}
+		});
+}
+
+// --------------------------------------------------------
+// Loads a material's <prefix>_orm.dds (occlusion, roughness
+// and metalness in one BC7 texture) if the cooker made one
+// from <prefix>_roughness and <prefix>_metal, switching the
+// material to the packed pixel shader once it arrives.
+// Without it, falls back to separate roughness and
+// metalness textures in t2 and t3.
+// --------------------------------------------------------
+void Game::LoadOrmAsync(const std::string& roughnessFile, const std::string& metalnessFile, std::shared_ptr<Material> material)
+{
+	std::string prefix = roughnessFile.substr(0, roughnessFile.rfind("_roughness"));
+	std::string ormPath = FixPath("../../Assets/Cooked/" + prefix + "_orm.dds");
+	bool cookedPair = roughnessFile.find("_roughness") != std::string::npos && metalnessFile.rfind(prefix + "_metal.", 0) == 0;
+	if (!ormPS || !cookedPair || !std::ifstream(ormPath).good())
+	{
+		if (!roughnessFile.empty()) LoadTextureAsync(roughnessFile, material, 2);
+		if (!metalnessFile.empty()) LoadTextureAsync(metalnessFile, material, 3);
+		return;
+	}
+
+	textureLoader.Request(ormPath,
+		[this, material](const TextureLoadResult& result) {
+			TextureHandle handle;
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv = UploadTexture(result, handle);
+			if (srv)
+			{
+				material->SetPackedOrm(srv, ormPS);
+				SetMaterialTexture(material, 2, handle);
+				SetMaterialTexture(material, 3, TextureHandle());
+				textureStreamer.Bind(result.path, material, 2);
+			}
+		});
+}
+
+// --------------------------------------------------------
+// Turns a finished load into a GPU texture. Materials
+// sharing a file share its texture too, so each path is
+// only uploaded once. Cooked textures go to the streamer,
+// which swaps them out as their mips come and go.
+//
+// handle is the cache reference for the texture (invalid
+// for streamed ones), which the caller now owns.
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Game::UploadTexture(const TextureLoadResult& result, TextureHandle& handle)
+{
+	PROFILE_SCOPE("Upload texture");
+	if (!result.succeeded)
+		return nullptr;
+
+	if (!result.fileData.empty())
+	{
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> streamed = textureStreamer.Create(result.path, result.fileData);
+		if (streamed)
+			return streamed;
+	}
+
+	handle = resources.FindTexture(result.path);
+	if (handle.IsValid())
+		return resources.Get(handle);
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	if (!result.fileData.empty())
+		CreateDDSTextureFromMemory(Graphics::Device.Get(), result.fileData.data(), result.fileData.size(), 0, srv.GetAddressOf());
+	else
+		srv = CreateTextureFromImage(result.image);
+	handle = resources.AddTexture(result.path, srv);
+	return resources.Get(handle);
+}
+
+// --------------------------------------------------------
+// Records the cache reference behind a material's texture
+// slot, dropping the one it replaces
+// --------------------------------------------------------
+void Game::SetMaterialTexture(std::shared_ptr<Material> material, unsigned int index, TextureHandle handle)
+{
+	resources.Release(material->SetTextureHandle(index, handle));
+}
+
+// --------------------------------------------------------
+// Uploads decoded RGBA8 pixels and builds the mip chain
+// on the GPU, like CreateWICTextureFromFile does
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Game::CreateTextureFromImage(const DecodedImage& image)
+{
+	D3D11_TEXTURE2D_DESC texDesc = {};
+	texDesc.Width = image.width;
+	texDesc.Height = image.height;
+	texDesc.MipLevels = 0; // Full chain
+	texDesc.ArraySize = 1;
+	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Usage = D3D11_USAGE_DEFAULT;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET; // Render target for GenerateMips
+	texDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	Graphics::Device->CreateTexture2D(&texDesc, 0, texture.GetAddressOf());
+	if (!texture)
+		return srv;
+
+	Graphics::Context->UpdateSubresource(texture.Get(), 0, 0, image.pixels.data(), image.width * 4, 0);
+	Graphics::Device->CreateShaderResourceView(texture.Get(), 0, srv.GetAddressOf());
+	Graphics::Context->GenerateMips(srv.Get());
+	return srv;
+}
+
+// --------------------------------------------------------
+// A 1x1 texture of a single color
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Game::CreateSolidColorTexture(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+	unsigned char pixel[4] = { r, g, b, a };
+
+	D3D11_TEXTURE2D_DESC texDesc = {};
+	texDesc.Width = 1;
+	texDesc.Height = 1;
+	texDesc.MipLevels = 1;
+	texDesc.ArraySize = 1;
+	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = pixel;
+	data.SysMemPitch = 4;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	Graphics::Device->CreateTexture2D(&texDesc, &data, texture.GetAddressOf());
+	if (texture)
+		Graphics::Device->CreateShaderResourceView(texture.Get(), 0, srv.GetAddressOf());
+	return srv;
+}
 
+// --------------------------------------------------------
+// Shaders come from the resource cache, so each .cso is
+// read and created once however many times it's asked for
+// --------------------------------------------------------
 Microsoft::WRL::ComPtr<ID3D11PixelShader> Game::LoadPixelShader(const std::wstring& fileName)
 {
-	// Read the file to a blob
-	ID3DBlob* pixelShaderBlob;
-	D3DReadFileToBlob(FixPath(fileName).c_str(), &pixelShaderBlob);
-
-	// Create the shader and return it
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
-	Graphics::Device->CreatePixelShader(
-		pixelShaderBlob->GetBufferPointer(),	// Pointer to blob's contents
-		pixelShaderBlob->GetBufferSize(),		// How big is that data?
-		0,										// No classes in this shader
-		pixelShader.GetAddressOf());			// Address of the ID3D11PixelShader pointer
-
-	return pixelShader;
+	PixelShaderHandle handle = shaders.LoadPixelShader(fileName);
+	pixelShaderHandles.push_back(handle);
+	return resources.Get(handle);
 }
 
 Microsoft::WRL::ComPtr<ID3D11VertexShader> Game::LoadVertexShader(const std::wstring& fileName)
 {
-	// Read the file to a blob
-	ID3DBlob* vertexShaderBlob;
-	D3DReadFileToBlob(FixPath(fileName).c_str(), &vertexShaderBlob);
-
-	// Create the shader and return it
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader;
-	Graphics::Device->CreateVertexShader(
-		vertexShaderBlob->GetBufferPointer(),	// Pointer to blob's contents
-		vertexShaderBlob->GetBufferSize(),		// How big is that data?
-		0,										// No classes in this shader
-		vertexShader.GetAddressOf());			// Address of the ID3D11PixelShader pointer
-
-	return vertexShader;
+	VertexShaderHandle handle = shaders.LoadVertexShader(fileName);
+	vertexShaderHandles.push_back(handle);
+	return resources.Get(handle);
 }
 
-void Game::ResizePostProcessResources()
+// --------------------------------------------------------
+// A unit cube standing in for a mesh that didn't load
+// --------------------------------------------------------
+std::shared_ptr<Mesh> Game::CreatePlaceholderMesh(const char* name)
 {
-	// Reset
-	blurSRV.Reset();
-	blurRTV.Reset();
-	pixelSRV.Reset();
-	pixelRTV.Reset();
-
-	// Describe the render target
-	D3D11_TEXTURE2D_DESC textureDesc = {};
-	textureDesc.Width = (unsigned int)(Window::Width());
-	textureDesc.Height = (unsigned int)(Window::Height());
-	textureDesc.ArraySize = 1;
-	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE; // Will render to it and sample from it!
-	textureDesc.CPUAccessFlags = 0;
-	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	textureDesc.MipLevels = 1;
-	textureDesc.MiscFlags = 0;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Usage = D3D11_USAGE_DEFAULT;
-
-	// Create Textures
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> blurTexture;
-	Graphics::Device->CreateTexture2D(&textureDesc, 0, blurTexture.GetAddressOf());
-
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> pixelTexture;
-	Graphics::Device->CreateTexture2D(&textureDesc, 0, pixelTexture.GetAddressOf());
-
-	// Create the Render Target View
-	D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
-	rtvDesc.Format = textureDesc.Format;
-	rtvDesc.Texture2D.MipSlice = 0;
-	rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-
-	// Blur RTV
-	Graphics::Device->CreateRenderTargetView(
-		blurTexture.Get(),
-		&rtvDesc,
-		blurRTV.ReleaseAndGetAddressOf());
-
-	// Pixelation RTV
-	Graphics::Device->CreateRenderTargetView(
-		pixelTexture.Get(),
-		&rtvDesc,
-		pixelRTV.ReleaseAndGetAddressOf());
-
-
-	// Create the Shader Resource View
-	// By passing it a null description for the SRV, we
-	// get a "default" SRV that has access to the entire resource
-
-	// Blur SRV
-	Graphics::Device->CreateShaderResourceView(
-		blurTexture.Get(),
-		0,
-		blurSRV.ReleaseAndGetAddressOf());
+	Vertex vertices[8] = {};
+	for (int i = 0; i < 8; i++)
+	{
+		XMFLOAT3 corner((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f);
+		XMStoreFloat3(&vertices[i].Normal, XMVector3Normalize(XMLoadFloat3(&corner)));
+		vertices[i].Position = corner;
+		vertices[i].Tangent = XMFLOAT3(1, 0, 0);
+	}
 
-	// Pixel SRV
-	Graphics::Device->CreateShaderResourceView(
-		pixelTexture.Get(),
-		0,
-		pixelSRV.ReleaseAndGetAddressOf());
+	// Clockwise from outside, two triangles per face
+	unsigned int indices[36] = {
+		0, 2, 3, 0, 3, 1,	// -Z
+		4, 5, 7, 4, 7, 6,	// +Z
+		0, 4, 6, 0, 6, 2,	// -X
+		1, 3, 7, 1, 7, 5,	// +X
+		0, 1, 5, 0, 5, 4,	// -Y
+		2, 6, 7, 2, 7, 3	// +Y
+	};
+	return std::make_shared<Mesh>(vertices, indices, 8, 36, name);
+}
+
+// --------------------------------------------------------
+// Drops every cache reference the game and its materials
+// hold. Anything still sharing the objects keeps them alive.
+// --------------------------------------------------------
+void Game::ReleaseResources()
+{
+	for (MeshHandle handle : meshHandles)
+		resources.Release(handle);
+	for (PixelShaderHandle handle : pixelShaderHandles)
+		resources.Release(handle);
+	for (VertexShaderHandle handle : vertexShaderHandles)
+		resources.Release(handle);
+	for (auto& material : materials)
+		for (auto& slot : material->GetTextureHandleMap())
+			resources.Release(slot.second);
+
+	meshHandles.clear();
+	pixelShaderHandles.clear();
+	vertexShaderHandles.clear();
+	for (auto& material : materials)
+		material->GetTextureHandleMap().clear();
 }
 
+
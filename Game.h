@@ -6,11 +6,36 @@
 #include<memory>
 #include "Mesh.h"
 #include "BufferStructs.h"
-#include "Entity.h"
+#include "World.h"
+#include "SystemScheduler.h"
+#include "GameSystems.h"
 #include "Camera.h"
 #include <string>
 #include "Lights.h"
 #include "Sky.h"
+#include "ShadowCache.h"
+#include "ShadowAtlas.h"
+#include "ThreadPool.h"
+#include "FrameArena.h"
+#include "OcclusionCuller.h"
+#include "DrawScheduler.h"
+#include "GaussianBlur.h"
+#include "RenderGraph.h"
+#include "RenderGraphExecutor.h"
+#include "PostProcessPlanner.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+#include "ResourceCache.h"
+#include "HotReloader.h"
+#include "ShaderLibrary.h"
+#include "Material.h"
+#include "SceneFile.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "InputRecorder.h"
+#include "FramePipeline.h"
+#include <chrono>
+#include <unordered_map>
 
 class Game
 {
@@ -26,18 +51,46 @@ public:
 	void Draw(float deltaTime, float totalTime);
 	void OnResize();
 
+	// Input recording and replay from the active camera's
+	// point of view (see InputRecorder.h)
+	void StartInputRecording(const std::string& path);
+	void StartInputReplay(const std::string& path, float fixedTimestep);
+
 private:
 
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
 	void LoadAssetsAndCreateEntities();
+	void StepSimulation(float deltaTime, float totalTime);
+	void BuildSnapshot(RenderSnapshot& snapshot);
+	SnapshotCamera CaptureCamera();
 	void RefreshUI(float deltaTime);
 	void BuildUI();
 
 	void CreateShadowMapResources();
+	void UpdateShadowLightMatrices(const std::vector<Light>& frameLights);
 	void RenderShadowMap();
 
+	void CreateShadowAtlasResources();
+	void UpdateShadowAtlas();
+	void RenderShadowAtlas();
+	void CalculateAtlasTileMatrices(const Light& light, int face, DirectX::XMFLOAT4X4& view, DirectX::XMFLOAT4X4& proj);
+
+	bool LoadSceneDesc(const std::string& name);
+	void PreloadShaders();
+	void EndStartupStage(const char* name);
+	void BakeImageBasedLighting();
+	void ApplyHotReload(const HotReloadResults& results);
+	void LoadTextureAsync(const std::string& fileName, std::shared_ptr<Material> material, unsigned int index);
+	void LoadOrmAsync(const std::string& roughnessFile, const std::string& metalnessFile, std::shared_ptr<Material> material);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> UploadTexture(const TextureLoadResult& result, TextureHandle& handle);
+	void SetMaterialTexture(std::shared_ptr<Material> material, unsigned int index, TextureHandle handle);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateTextureFromImage(const DecodedImage& image);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateSolidColorTexture(unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> LoadPixelShader(const std::wstring& fileName);
 	Microsoft::WRL::ComPtr<ID3D11VertexShader> LoadVertexShader(const std::wstring& fileName);
+	std::shared_ptr<Mesh> CreatePlaceholderMesh(const char* name);
+	void ReleaseResources();
 
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
@@ -54,11 +107,22 @@ private:
 	// demo array for ImGui Combo (dropdown select)
 	const char* flavors[6] = {"Vanilla", "Chocolate", "Strawberry", "Neopolitan", "Mint", "Rocky Road"};
 
+	// What the scene file described; meshes and materials keep
+	// pointers to its names, so it lives as long as they do
+	SceneDesc scene;
+
 	// array of Mesh Objects
 	std::vector<std::shared_ptr<Mesh>> meshes;
 
-	// array of Entity Objects
-	std::vector <std::shared_ptr<Entity>> entities;
+	// Every material in the scene, used by an entity or not
+	std::vector<std::shared_ptr<Material>> materials;
+
+	// Every entity and its components (see Components.h)
+	World world;
+
+	// What the render system last gathered, until it's
+	// swapped into a snapshot (see BuildSnapshot)
+	std::vector<Renderable> renderables;
 
 	// Buffer Struct to be mapped and modified by the UI
 	VertexShaderExternalData globalVsData = {};
@@ -76,39 +140,185 @@ private:
 	// Sky box
 	std::shared_ptr<Sky> sky;
 
+	// Every mesh, shader and (non-streamed) texture, loaded once
+	ResourceCache resources;
+
+	// The cache references held here, dropped in ReleaseResources().
+	// Materials hold their own texture references.
+	std::vector<MeshHandle> meshHandles;			// Same order as meshes
+	std::vector<PixelShaderHandle> pixelShaderHandles;
+	std::vector<VertexShaderHandle> vertexShaderHandles;
+
+	// Reloads what's in the cache when its file changes
+	HotReloader hotReloader{ resources };
+	bool hotReloadEnabled = true;
+
+	// Reads and creates shaders ahead of time, into the cache
+	ShaderLibrary shaders{ resources };
+
+	// Worker threads shared by CPU-side systems
+	ThreadPool threadPool;
+
+	// Systems over the world (see GameSystems.h): the simulation
+	// once per fixed step, the rest once per rendered frame
+	SystemScheduler systems{ world, threadPool };
+	SystemScheduler frameSystems{ world, threadPool };
+
+	// Fixed step simulation (see StepSimulation)
+	bool fixedStepEnabled = true;
+	float simulationRate = 60.0f;		// Steps per second
+	int maxStepsPerFrame = 8;			// Past this, time is dropped rather than caught up
+	double simulationAccumulator = 0;	// Time not yet simulated
+	double simulationTime = -1;			// Below 0 until lined up with the frame clock
+	float interpolationAlpha = 1.0f;	// Where frames are drawn, from the last step's start (0) to its end (1)
+	int stepsLastFrame = 0;
+	double droppedSimulationMs = 0;
+
+	// What StepSimulation planned for the update stage to carry out
+	struct PendingUpdate {
+		int steps;
+		double stepLength;
+		double startTime;	// simulationTime before the first step
+		float deltaTime;
+		float totalTime;
+		std::chrono::high_resolution_clock::time_point inputTime;
+		SnapshotCamera camera;
+	};
+	PendingUpdate pendingUpdate = {};
+
+	// Update and render stages, optionally on two threads, handing
+	// over snapshots (see FramePipeline.h). Declared after everything
+	// the update reads, so its thread is stopped before they go.
+	FramePipeline pipeline;
+	bool pipelineEnabled = true;
+
+	// Scratch memory for containers that only live for a frame
+	FrameArena frameArena;
+
+	// Textures decode in the background while placeholders are bound
+	TextureLoader textureLoader;
+	int textureUploadsPerFrame = 4;
+	TextureStreamer textureStreamer{ textureLoader, 64 * 1024 * 1024 };	// Cooked textures, kept within a budget
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> ormPS;	// Pixel shader variant for packed ORM materials
+
+	// Image-based ambient light from the sky (see IBLBaker)
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> specularIBL;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> brdfLookup;
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> iblSampler;
+	IBLExternalData iblData = {};
+	bool iblEnabled = true;
+	float iblIntensity = 1.0f;
+	double iblBakeMs = 0;
+	bool iblCached = false;
+	std::chrono::high_resolution_clock::time_point startupTime;
+	std::chrono::high_resolution_clock::time_point startupStageTime;
+	std::vector<std::pair<std::string, double>> startupStages;	// Name, ms
+	double timeToFirstFrameMs = -1;
+	double timeToAllTexturesMs = -1;
+
+	// CPU occlusion culling
+	std::shared_ptr<OcclusionCuller> occlusionCuller;
+	bool occlusionCullingEnabled = true;
+
+	// Draw ordering and the optional depth pre-pass
+	DrawScheduler drawScheduler;
+	bool depthPrepassEnabled = true;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthEqualState;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthReadOnlyState;
+
 	// Shadow Map Data
 	float shadowMapResolution = 1024;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowTexture;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowDSV;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowSRV;
+
+	// Cached layer holding only static casters, copied into
+	// the shadow map each frame before dynamic casters are drawn
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> staticShadowTexture;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> staticShadowDSV;
+	ShadowCache shadowCache;
+	bool shadowCachingEnabled = true;
+
+	// Shadow Atlas for point and spot lights
+	ShadowAtlas shadowAtlas;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> atlasDSV;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> atlasSRV;
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> atlasRasterizer;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> atlasClearDepthState;
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> atlasClearPS;
+	ShadowAtlasExternalData atlasData = {};
+	bool atlasShadowsEnabled = true;
+
+	// What the atlas last saw, to find lights and casters that changed
+	struct AtlasCaster {
+		unsigned int version;
+		DirectX::XMFLOAT3 center;
+		float radius;
+	};
+	std::vector<Light> atlasLightSnapshot;
+	std::unordered_map<EntityHandle, AtlasCaster> atlasCasters;
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> shadowRasterizer;
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> shadowSampler;
-	DirectX::XMFLOAT4X4 lightViewMatrix;
-	DirectX::XMFLOAT4X4 lightProjectionMatrix;
+	DirectX::XMFLOAT4X4 lightViewMatrix = {};
+	DirectX::XMFLOAT4X4 lightProjectionMatrix = {};
 	Microsoft::WRL::ComPtr<ID3D11VertexShader> shadowVS;
 
 	// Resources that are shared among all post processes
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> ppSampler;
 	Microsoft::WRL::ComPtr<ID3D11VertexShader> ppVS;
 
-	// Resources that are tied to a particular post process
+	// Render targets for the scene and post processes come from the graph
+	RenderGraph renderGraph;
+	RenderGraphExecutor graphExecutor;
+	bool renderGraphErrorLogged = false;
 
-	// Blur
+	// Shaders tied to a particular post process
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> blurPS;
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> blurRTV; // For rendering
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> blurSRV; // For sampling
-
-	// Pixelation
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelPS;
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> pixelRTV; // For rendering
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pixelSRV; // For sampling
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> blurPixelatePS; // Both at once
 
 	// Blur Data
 	int blurDistance = 0;
+	bool blurDownsampleEnabled = true;
+	int blurDownsampleRadius = 8; // Larger radii blur at half resolution
+	int blurTapsPerPixel = 0;
+	std::vector<GaussianBlur::Tap> blurTaps;	// For blurTapsRadius, see GetBlurTaps()
+	int blurTapsRadius = -1;
+
+	// Fusing blur and pixelation into one pass
+	bool postFusionEnabled = true;
+	PostProcessPlan postProcessPlan;
+	PostProcessSettings GetPostProcessSettings();
 
 	// Pixelation Data
 	int pixelSize = 1;
 
-	// post Process helper
-	void ResizePostProcessResources();
+	// Frame structure
+	void RenderScene();
+	void BuildRenderGraph();
+
+	// post Process helpers
+	RGHandle AddBlurPasses(RGHandle source, RGTextureDesc fullDesc, RGTextureDesc halfDesc, bool downsample);
+	void AddBlurPixelatePass(RGHandle source, RGHandle target, int width, int height);
+	void AddBlurPass(const char* name, RGHandle source, RGHandle target, const GaussianBlur::Tap* taps, int tapCount, DirectX::XMFLOAT2 texelStep);
+	const std::vector<GaussianBlur::Tap>& GetBlurTaps(int radius);
+	void DrawFullscreenTriangle();
+
+	// Frame pacing, per phase
+	FrameStats frameStats;
+	void BuildFrameStatsUI();
+	bool frameStatsOverlay = false;
+	float frameStatsBucketMs = 1.0f;
+	std::string frameStatsCsvResult;
+
+	// 0 replays the recorded frame timing
+	float inputReplayTimestep = 0;
+
+#if PROFILER_ENABLED
+	// CPU profiler view
+	void BuildProfilerUI();
+	float profilerViewMs = 0; // 0 fits the whole frame
+	int profilerTraceFrames = 5;
+#endif
 };
 
@@ -0,0 +1,123 @@
+#include "GameSystems.h"
+#include <cmath>
+
+using namespace DirectX;
+
+void GameSystems::RecordPreviousTransforms(World& world)
+{
+	world.Each<Transform, PreviousTransform>([](EntityHandle, Transform& transform, PreviousTransform& previous) {
+		previous.state = transform.GetState();
+		previous.version = transform.GetVersion();
+	});
+}
+
+void GameSystems::Animate(World& world, float deltaTime, float totalTime)
+{
+	world.Each<Transform, const Spin>([&](EntityHandle, Transform& transform, const Spin& spin) {
+		transform.Rotate(spin.rate.x * deltaTime, spin.rate.y * deltaTime, spin.rate.z * deltaTime);
+	});
+
+	world.Each<Transform, const Sway>([&](EntityHandle, Transform& transform, const Sway& sway) {
+		float s = sinf(totalTime * sway.speed);
+		transform.SetPosition(
+			sway.origin.x + sway.amplitude.x * s,
+			sway.origin.y + sway.amplitude.y * s,
+			sway.origin.z + sway.amplitude.z * s);
+	});
+}
+
+void GameSystems::UpdateTransforms(World& world)
+{
+	world.Each<Transform>([](EntityHandle, Transform& transform) {
+		transform.GetWorldMatrix();
+	});
+}
+
+void GameSystems::AttachLights(World& world, std::vector<Light>& lights, float interpolation)
+{
+	world.Each<Transform, const PreviousTransform, const LightAttachment>([&](EntityHandle, Transform& transform, const PreviousTransform& previous, const LightAttachment& attachment) {
+		if (attachment.light < 0 || attachment.light >= (int)lights.size())
+			return;
+
+		XMFLOAT3 position = transform.GetPosition();
+		if (interpolation < 1.0f && previous.version != transform.GetVersion())
+			XMStoreFloat3(&position, XMVectorLerp(XMLoadFloat3(&previous.state.position), XMLoadFloat3(&position), interpolation));
+		Light& light = lights[attachment.light];
+		light.position = XMFLOAT3(position.x + attachment.offset.x, position.y + attachment.offset.y, position.z + attachment.offset.z);
+	});
+}
+
+void GameSystems::GatherRenderables(World& world, const std::vector<std::shared_ptr<Mesh>>& meshes, std::vector<Renderable>& renderables, float interpolation)
+{
+	renderables.clear();
+	world.Each<Transform, const PreviousTransform, const MeshRenderer>([&](EntityHandle entity, Transform& transform, const PreviousTransform& previous, const MeshRenderer& renderer) {
+		Mesh* mesh = meshes[renderer.mesh].get();
+
+		Renderable r = {};
+		r.entity = entity;
+		r.version = transform.GetVersion();
+		r.mesh = renderer.mesh;
+		r.material = renderer.material;
+		r.flags = renderer.flags;
+		transform.GetWorldBoundingSphere(mesh->GetBoundsCenter(), mesh->GetBoundingRadius(), r.center, r.radius);
+
+		// Only what moved in the last step needs blending; the rest
+		// uses the matrices its Transform already has
+		if (interpolation < 1.0f && previous.version != transform.GetVersion())
+		{
+			transform.GetInterpolatedMatrices(previous.state, interpolation, r.world, r.worldInvTrans);
+			XMFLOAT3 localCenter = mesh->GetBoundsCenter();
+			XMStoreFloat3(&r.center, XMVector3TransformCoord(XMLoadFloat3(&localCenter), XMLoadFloat4x4(&r.world)));
+		}
+		else
+		{
+			r.world = transform.GetWorldMatrix();
+			r.worldInvTrans = transform.GetWorldInverseTransposeMatrix();
+		}
+		renderables.push_back(r);
+	});
+}
+
+// --------------------------------------------------------
+// Recording, animation and the matrix update all touch
+// Transforms, so they run one after the other
+// --------------------------------------------------------
+void GameSystems::RegisterSimulation(SystemScheduler& scheduler)
+{
+	scheduler.Add("Previous transforms",
+		World::MaskOf<Transform>(),
+		World::MaskOf<PreviousTransform>(),
+		[](World& world, float, float) { RecordPreviousTransforms(world); });
+
+	scheduler.Add("Animation",
+		World::MaskOf<Spin, Sway>(),
+		World::MaskOf<Transform>(),
+		[](World& world, float deltaTime, float totalTime) { Animate(world, deltaTime, totalTime); });
+
+	scheduler.Add("Transforms",
+		0,
+		World::MaskOf<Transform>(),
+		[](World& world, float, float) { UpdateTransforms(world); });
+}
+
+// --------------------------------------------------------
+// Light attachment and the render list only read Transforms
+// and run side by side
+// --------------------------------------------------------
+void GameSystems::RegisterFrame(
+	SystemScheduler& scheduler,
+	std::vector<Light>& lights,
+	const std::vector<std::shared_ptr<Mesh>>& meshes,
+	std::vector<Renderable>& renderables,
+	const float& interpolation)
+{
+	scheduler.Add("Light attachment",
+		World::MaskOf<Transform, PreviousTransform, LightAttachment>(),
+		0,
+		[&lights, &interpolation](World& world, float, float) { AttachLights(world, lights, interpolation); });
+
+	scheduler.Add("Render list",
+		World::MaskOf<Transform, PreviousTransform, MeshRenderer>(),
+		0,
+		[&meshes, &renderables, &interpolation](World& world, float, float) { GatherRenderables(world, meshes, renderables, interpolation); });
+}
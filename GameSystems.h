@@ -0,0 +1,49 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Components.h"
+#include "Lights.h"
+#include "Mesh.h"
+#include "SystemScheduler.h"
+
+// --------------------------------------------------------
+// The game's systems over its World
+//
+// Simulation systems run once per fixed step, frame systems
+// once per rendered frame, blending between the last two
+// steps. Each one only reads and writes what it's registered
+// with, so the scheduler can run independent ones side by
+// side. Lights, meshes and the render list live outside the
+// World and each belongs to a single system.
+// --------------------------------------------------------
+namespace GameSystems
+{
+	// Remembers where each Transform is before the step moves it
+	void RecordPreviousTransforms(World& world);
+
+	// Spin and Sway move Transforms
+	void Animate(World& world, float deltaTime, float totalTime);
+
+	// Brings every changed Transform's matrices up to date, so
+	// later systems (and the renderer) only ever read them
+	void UpdateTransforms(World& world);
+
+	// Moves attached lights to their entities, interpolation of
+	// the way from where they were (0) to where they are (1)
+	void AttachLights(World& world, std::vector<Light>& lights, float interpolation);
+
+	// Fills the list of things to draw, with world matrices and
+	// bounds, interpolated the same way
+	void GatherRenderables(World& world, const std::vector<std::shared_ptr<Mesh>>& meshes, std::vector<Renderable>& renderables, float interpolation);
+
+	// Adds the per step systems, in order, with their read/write sets
+	void RegisterSimulation(SystemScheduler& scheduler);
+
+	// Adds the per frame systems; interpolation is read when they run
+	void RegisterFrame(
+		SystemScheduler& scheduler,
+		std::vector<Light>& lights,
+		const std::vector<std::shared_ptr<Mesh>>& meshes,
+		std::vector<Renderable>& renderables,
+		const float& interpolation);
+}
@@ -0,0 +1,237 @@
+#include "GaussianBlur.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GAUSSIAN_BLUR_SSE2
+#endif
+
+namespace
+{
+	// Pixel reads with the clamp addressing the post process sampler uses
+	inline int Clamp(int i, int count)
+	{
+		return i < 0 ? 0 : (i >= count ? count - 1 : i);
+	}
+
+	inline void Lerp4(const float* a, const float* b, float t, float* out)
+	{
+		for (int c = 0; c < 4; c++)
+			out[c] = a[c] + (b[c] - a[c]) * t;
+	}
+}
+
+std::vector<float> GaussianBlur::ComputeWeights(int radius)
+{
+	std::vector<float> weights(radius + 1);
+	if (radius <= 0)
+	{
+		weights[0] = 1.0f;
+		return weights;
+	}
+
+	// Kernel ends two standard deviations out
+	float sigma = radius / 2.0f;
+	float total = 0.0f;
+	for (int i = 0; i <= radius; i++)
+	{
+		weights[i] = expf(-(i * i) / (2.0f * sigma * sigma));
+		total += i == 0 ? weights[i] : weights[i] * 2.0f;
+	}
+
+	for (auto& w : weights)
+		w /= total;
+
+	return weights;
+}
+
+std::vector<GaussianBlur::Tap> GaussianBlur::ComputeLinearTaps(int radius)
+{
+	std::vector<float> weights = ComputeWeights(radius);
+	std::vector<Tap> taps;
+	taps.push_back({ 0.0f, weights[0] });
+
+	// Sampling between texels i and i+1 at the right spot
+	// returns their weighted sum in a single read
+	for (int i = 1; i <= radius; i += 2)
+	{
+		float w0 = weights[i];
+		float w1 = i + 1 <= radius ? weights[i + 1] : 0.0f;
+		float w = w0 + w1;
+		taps.push_back({ (i * w0 + (i + 1) * w1) / w, w });
+	}
+
+	return taps;
+}
+
+int GaussianBlur::BoxTapCount(int radius)
+{
+	return (2 * radius + 1) * (2 * radius + 1);
+}
+
+int GaussianBlur::SeparableTapCount(int radius)
+{
+	return 2 * (2 * radius + 1);
+}
+
+int GaussianBlur::LinearTapCount(int radius)
+{
+	int taps = (int)ComputeLinearTaps(radius).size();
+	return 2 * (2 * taps - 1);
+}
+
+int GaussianBlur::DownsampledRadius(int radius)
+{
+	return (radius + 1) / 2;
+}
+
+void GaussianBlur::BoxBlur(const float* src, float* dst, int width, int height, int radius)
+{
+	float scale = 1.0f / BoxTapCount(radius);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			float sum[4] = {};
+			for (int by = -radius; by <= radius; by++)
+			{
+				const float* row = src + Clamp(y + by, height) * width * 4;
+				for (int bx = -radius; bx <= radius; bx++)
+				{
+					const float* p = row + Clamp(x + bx, width) * 4;
+					for (int c = 0; c < 4; c++) sum[c] += p[c];
+				}
+			}
+
+			float* out = dst + (y * width + x) * 4;
+			for (int c = 0; c < 4; c++) out[c] = sum[c] * scale;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// A bilinear read at (i + offset) is just texels floor and
+// floor+1 mixed by the fraction, so every tap turns into a
+// pair of integer offsets and a blend factor up front.
+// With SSE2 each RGBA pixel is one register.
+// --------------------------------------------------------
+void GaussianBlur::BlurPass(const float* src, float* dst, int width, int height, const std::vector<Tap>& taps, bool horizontal)
+{
+	struct Read { int first; float t; float weight; };
+	std::vector<Read> reads;
+	for (size_t i = 1; i < taps.size(); i++)
+	{
+		int whole = (int)floorf(taps[i].offset);
+		float frac = taps[i].offset - whole;
+
+		// +offset lands between whole and whole+1, -offset between -whole-1 and -whole
+		reads.push_back({ whole, frac, taps[i].weight });
+		reads.push_back({ -whole - 1, 1.0f - frac, taps[i].weight });
+	}
+
+	// Walk along the blur direction; lines are the other axis
+	int length = horizontal ? width : height;
+	int lines = horizontal ? height : width;
+	int step = horizontal ? 4 : width * 4;
+	int lineStep = horizontal ? width * 4 : 4;
+
+	for (int line = 0; line < lines; line++)
+	{
+		const float* in = src + line * lineStep;
+		float* out = dst + line * lineStep;
+
+		for (int i = 0; i < length; i++)
+		{
+#ifdef GAUSSIAN_BLUR_SSE2
+			__m128 sum = _mm_mul_ps(_mm_loadu_ps(in + i * step), _mm_set1_ps(taps[0].weight));
+			for (auto& r : reads)
+			{
+				__m128 a = _mm_loadu_ps(in + Clamp(i + r.first, length) * step);
+				__m128 b = _mm_loadu_ps(in + Clamp(i + r.first + 1, length) * step);
+				__m128 sample = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(r.t)));
+				sum = _mm_add_ps(sum, _mm_mul_ps(sample, _mm_set1_ps(r.weight)));
+			}
+			_mm_storeu_ps(out + i * step, sum);
+#else
+			float sum[4];
+			const float* center = in + i * step;
+			for (int c = 0; c < 4; c++) sum[c] = center[c] * taps[0].weight;
+			for (auto& r : reads)
+			{
+				float sample[4];
+				Lerp4(
+					in + Clamp(i + r.first, length) * step,
+					in + Clamp(i + r.first + 1, length) * step,
+					r.t, sample);
+				for (int c = 0; c < 4; c++) sum[c] += sample[c] * r.weight;
+			}
+			for (int c = 0; c < 4; c++) out[i * step + c] = sum[c];
+#endif
+		}
+	}
+}
+
+void GaussianBlur::Blur(const float* src, float* dst, float* scratch, int width, int height, int radius)
+{
+	std::vector<Tap> taps = ComputeLinearTaps(radius);
+	BlurPass(src, scratch, width, height, taps, true);
+	BlurPass(scratch, dst, width, height, taps, false);
+}
+
+void GaussianBlur::Downsample(const float* src, int width, int height, float* dst)
+{
+	int halfWidth = (width + 1) / 2;
+	int halfHeight = (height + 1) / 2;
+	for (int y = 0; y < halfHeight; y++)
+	{
+		const float* row0 = src + Clamp(y * 2, height) * width * 4;
+		const float* row1 = src + Clamp(y * 2 + 1, height) * width * 4;
+		for (int x = 0; x < halfWidth; x++)
+		{
+			int x0 = Clamp(x * 2, width) * 4;
+			int x1 = Clamp(x * 2 + 1, width) * 4;
+			float* out = dst + (y * halfWidth + x) * 4;
+			for (int c = 0; c < 4; c++)
+				out[c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+		}
+	}
+}
+
+void GaussianBlur::Upsample(const float* src, int width, int height, float* dst)
+{
+	int halfWidth = (width + 1) / 2;
+	int halfHeight = (height + 1) / 2;
+	for (int y = 0; y < height; y++)
+	{
+		// Full res pixel center in half res texel space
+		float v = (y + 0.5f) * 0.5f - 0.5f;
+		int y0 = (int)floorf(v);
+		float ty = v - y0;
+		const float* row0 = src + Clamp(y0, halfHeight) * halfWidth * 4;
+		const float* row1 = src + Clamp(y0 + 1, halfHeight) * halfWidth * 4;
+
+		for (int x = 0; x < width; x++)
+		{
+			float u = (x + 0.5f) * 0.5f - 0.5f;
+			int x0 = (int)floorf(u);
+			float tx = u - x0;
+
+			float top[4], bottom[4];
+			Lerp4(row0 + Clamp(x0, halfWidth) * 4, row0 + Clamp(x0 + 1, halfWidth) * 4, tx, top);
+			Lerp4(row1 + Clamp(x0, halfWidth) * 4, row1 + Clamp(x0 + 1, halfWidth) * 4, tx, bottom);
+			Lerp4(top, bottom, ty, dst + (y * width + x) * 4);
+		}
+	}
+}
+
+void GaussianBlur::BlurDownsampled(const float* src, float* dst, int width, int height, int radius)
+{
+	int halfWidth = (width + 1) / 2;
+	int halfHeight = (height + 1) / 2;
+	std::vector<float> half(halfWidth * halfHeight * 4);
+	std::vector<float> scratch(half.size());
+
+	Downsample(src, width, height, half.data());
+	Blur(half.data(), half.data(), scratch.data(), halfWidth, halfHeight, DownsampledRadius(radius));
+	Upsample(half.data(), width, height, dst);
+}
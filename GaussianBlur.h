@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+
+// --------------------------------------------------------
+// Separable Gaussian blur: kernel setup shared with the
+// GPU passes, plus a CPU reference of every filter
+//
+// Images on the CPU side are RGBA floats (4 per pixel),
+// sampled the way the GPU would: clamped, with bilinear
+// filtering between texel centers
+// --------------------------------------------------------
+namespace GaussianBlur
+{
+	// One bilinear read: sampled at +offset and -offset texels (tap 0 is the center, read once)
+	struct Tap {
+		float offset;
+		float weight;
+	};
+
+	// Weights for offsets 0..radius, normalized so the whole kernel sums to 1
+	std::vector<float> ComputeWeights(int radius);
+
+	// Folds neighbouring weights into single bilinear taps, roughly halving the reads
+	std::vector<Tap> ComputeLinearTaps(int radius);
+
+	// Texture reads per pixel for each way of blurring
+	int BoxTapCount(int radius);
+	int SeparableTapCount(int radius);
+	int LinearTapCount(int radius);
+
+	// Radius to use at half resolution for the same visual blur
+	int DownsampledRadius(int radius);
+
+	// --- CPU reference filters ---
+
+	// The original (2r+1)^2 box blur
+	void BoxBlur(const float* src, float* dst, int width, int height, int radius);
+
+	// One direction of the separable blur
+	void BlurPass(const float* src, float* dst, int width, int height, const std::vector<Tap>& taps, bool horizontal);
+
+	// Both passes at full resolution. scratch holds one image.
+	void Blur(const float* src, float* dst, float* scratch, int width, int height, int radius);
+
+	// Half resolution (rounded up) with a 2x2 bilinear read, and back up again
+	void Downsample(const float* src, int width, int height, float* dst);
+	void Upsample(const float* src, int width, int height, float* dst);
+
+	// Downsample, blur with DownsampledRadius(), upsample - what the GPU does for large radii
+	void BlurDownsampled(const float* src, float* dst, int width, int height, int radius);
+}
@@ -0,0 +1,169 @@
+#include "HotReloader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <d3dcompiler.h>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+namespace
+{
+	std::string Lowercase(std::string text)
+	{
+		std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char)tolower(c); });
+		return text;
+	}
+
+	// Lowercase file names of a shader source and everything it
+	// #includes from the same directory, all the way down
+	void CollectIncludes(const std::filesystem::path& directory, const std::string& fileName, std::unordered_set<std::string>& files)
+	{
+		if (!files.insert(Lowercase(fileName)).second)
+			return;
+
+		std::ifstream file(directory / fileName);
+		std::string line;
+		while (std::getline(file, line))
+		{
+			size_t include = line.find("#include");
+			size_t open = line.find('"', include);
+			size_t close = line.find('"', open + 1);
+			if (include != std::string::npos && open != std::string::npos && close != std::string::npos)
+				CollectIncludes(directory, line.substr(open + 1, close - open - 1), files);
+		}
+	}
+}
+
+HotReloader::HotReloader(ResourceCache& cache) :
+	cache(cache),
+	stats()
+{
+}
+
+bool HotReloader::Watch(const std::string& directory)
+{
+	bool watching = watcher.Watch(directory);
+	stats.directories = watcher.GetDirectoryCount();
+	return watching;
+}
+
+HotReloadResults HotReloader::Update()
+{
+	HotReloadResults results;
+	for (const std::string& path : watcher.PollChanges())
+	{
+		std::filesystem::path file(path);
+		std::string extension = Lowercase(file.extension().string());
+		stats.lastChange = file.filename().string();
+
+		if (extension == ".hlsl" || extension == ".hlsli")
+			ReloadShaders(path, results);
+		else if (extension == ".obj" && cache.HasMesh(path))
+		{
+			if (cache.ReloadMesh(path))
+			{
+				results.meshes++;
+				stats.reloads++;
+			}
+			else
+			{
+				// The old mesh stays; an export in progress usually lands on the next change
+				stats.failures++;
+				stats.lastError = "Couldn't load " + file.filename().string() + ", kept the previous mesh";
+				printf("Hot reload: %s\n", stats.lastError.c_str());
+			}
+		}
+		else if (extension == ".png" || extension == ".jpg")
+		{
+			if (cache.HasTexture(path))
+				results.textures.push_back(path);
+		}
+	}
+	return results;
+}
+
+HotReloadStats HotReloader::GetStats()
+{
+	return stats;
+}
+
+// --------------------------------------------------------
+// Finds the loaded shaders built from (or including) the
+// changed file and compiles them again
+// --------------------------------------------------------
+void HotReloader::ReloadShaders(const std::string& changedPath, HotReloadResults& results)
+{
+	std::filesystem::path changed(changedPath);
+	std::filesystem::path sourceDirectory = changed.parent_path();
+	std::string changedName = Lowercase(changed.filename().string());
+
+	auto needsReload = [&](const std::string& csoPath, std::string& sourcePath) {
+		std::string sourceName = std::filesystem::path(csoPath).stem().string() + ".hlsl";
+		if (!std::filesystem::exists(sourceDirectory / sourceName))
+			return false;
+
+		std::unordered_set<std::string> files;
+		CollectIncludes(sourceDirectory, sourceName, files);
+		sourcePath = (sourceDirectory / sourceName).string();
+		return files.count(changedName) > 0;
+	};
+
+	std::string sourcePath;
+	for (const std::string& csoPath : cache.GetPixelShaderPaths())
+	{
+		if (!needsReload(csoPath, sourcePath))
+			continue;
+
+		ResourceSwap<ID3D11PixelShader> swap;
+		if (cache.ReplacePixelShader(csoPath, CompileShader(sourcePath, "ps_5_0"), swap))
+		{
+			results.pixelShaders.push_back(swap);
+			stats.reloads++;
+		}
+		else
+			stats.failures++;
+	}
+
+	for (const std::string& csoPath : cache.GetVertexShaderPaths())
+	{
+		if (!needsReload(csoPath, sourcePath))
+			continue;
+
+		ResourceSwap<ID3D11VertexShader> swap;
+		if (cache.ReplaceVertexShader(csoPath, CompileShader(sourcePath, "vs_5_0"), swap))
+		{
+			results.vertexShaders.push_back(swap);
+			stats.reloads++;
+		}
+		else
+			stats.failures++;
+	}
+}
+
+// --------------------------------------------------------
+// Same settings the project builds its shaders with
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3DBlob> HotReloader::CompileShader(const std::string& sourcePath, const char* target)
+{
+	UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined(DEBUG) || defined(_DEBUG)
+	flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+
+	Microsoft::WRL::ComPtr<ID3DBlob> bytecode;
+	Microsoft::WRL::ComPtr<ID3DBlob> errors;
+	std::wstring widePath = std::filesystem::path(sourcePath).wstring();
+	HRESULT hr = D3DCompileFromFile(widePath.c_str(), 0, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"main", target, flags, 0, bytecode.GetAddressOf(), errors.GetAddressOf());
+
+	if (FAILED(hr))
+	{
+		stats.lastError = errors ? std::string((const char*)errors->GetBufferPointer(), errors->GetBufferSize()) : "Couldn't read " + sourcePath;
+		printf("Hot reload: %s\n", stats.lastError.c_str());
+		return nullptr;
+	}
+
+	stats.lastError.clear();
+	return bytecode;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <string>
+#include <vector>
+#include "FileWatcher.h"
+#include "ResourceCache.h"
+
+// What one Update() reloaded
+struct HotReloadResults {
+	std::vector<ResourceSwap<ID3D11PixelShader>> pixelShaders;
+	std::vector<ResourceSwap<ID3D11VertexShader>> vertexShaders;
+	std::vector<std::string> textures;	// Loaded textures whose files changed, for the caller to decode and swap
+	int meshes = 0;						// Rebuilt in place, nothing else to do
+};
+
+struct HotReloadStats {
+	int directories;
+	int reloads;
+	int failures;
+	std::string lastChange;		// File name
+	std::string lastError;		// Compiler output for shaders, or the mesh that wouldn't load
+};
+
+// --------------------------------------------------------
+// Reloads resources in the ResourceCache when their files
+// change on disk
+//
+// - .hlsl: every loaded shader whose source (the .hlsl next
+//   to the changed file, named like its .cso) is, or
+//   #includes, the changed file is compiled again
+// - .obj: the mesh is rebuilt in place
+// - .png: reported back, since decoding goes through the
+//   texture loader
+//
+// Nothing happens between calls, so calling Update() at the
+// start of a frame means every swap lands between frames.
+// A shader that fails to compile keeps its old version.
+// --------------------------------------------------------
+class HotReloader
+{
+public:
+	HotReloader(ResourceCache& cache);
+
+	bool Watch(const std::string& directory);
+	HotReloadResults Update();
+	HotReloadStats GetStats();
+
+private:
+	void ReloadShaders(const std::string& changedPath, HotReloadResults& results);
+	Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(const std::string& sourcePath, const char* target);
+
+	ResourceCache& cache;
+	FileWatcher watcher;
+	HotReloadStats stats;
+};
@@ -0,0 +1,58 @@
+#ifndef __GGP_IBL__
+#define __GGP_IBL__
+
+// Image-based ambient light, baked from the sky by IBLBaker
+cbuffer IBLData : register(b2)
+{
+    float4 irradianceSH[9]; // Already convolved with the cosine lobe and divided by pi
+    float specularMipCount;
+    float iblIntensity;
+    float2 iblPad;
+}
+
+TextureCube SpecularIBL : register(t6); // GGX prefiltered, roughness 0 to 1 across the mips
+Texture2D BrdfLookup : register(t7); // Split-sum scale and bias, x = N.V, y = roughness
+SamplerState ClampSampler : register(s2);
+
+// Diffuse irradiance from the 9 SH coefficients
+float3 IrradianceSH(float3 n)
+{
+    return max(
+        irradianceSH[0].rgb * 0.282095f +
+        irradianceSH[1].rgb * 0.488603f * n.y +
+        irradianceSH[2].rgb * 0.488603f * n.z +
+        irradianceSH[3].rgb * 0.488603f * n.x +
+        irradianceSH[4].rgb * 1.092548f * n.x * n.y +
+        irradianceSH[5].rgb * 1.092548f * n.y * n.z +
+        irradianceSH[6].rgb * 0.315392f * (3.0f * n.z * n.z - 1.0f) +
+        irradianceSH[7].rgb * 1.092548f * n.x * n.z +
+        irradianceSH[8].rgb * 0.546274f * (n.x * n.x - n.y * n.y), 0.0f);
+}
+
+// Fresnel for light from every direction at once, which rough
+// surfaces don't reflect as strongly at grazing angles
+float3 F_SchlickRoughness(float NdotV, float3 f0, float roughness)
+{
+    return f0 + (max(1.0f - roughness, f0) - f0) * pow(1.0f - NdotV, 5.0f);
+}
+
+// Diffuse and specular light from the environment
+float3 AmbientIBL(float3 normal, float3 worldPosition, float3 cameraPosition, float roughness, float metalness, float3 surfaceColor, float3 specularColor)
+{
+    float3 toCamera = normalize(cameraPosition - worldPosition);
+    float NdotV = saturate(dot(normal, toCamera));
+    float3 F = F_SchlickRoughness(NdotV, specularColor, roughness);
+
+    // Metals have no diffuse
+    float3 kd = (1.0f - F) * (1.0f - metalness);
+    float3 diffuse = kd * IrradianceSH(normal) * surfaceColor;
+
+    float3 reflected = reflect(-toCamera, normal);
+    float3 prefiltered = SpecularIBL.SampleLevel(ClampSampler, reflected, roughness * (specularMipCount - 1)).rgb;
+    float2 brdf = BrdfLookup.SampleLevel(ClampSampler, float2(NdotV, roughness), 0).rg;
+    float3 specular = prefiltered * (specularColor * brdf.x + brdf.y);
+
+    return (diffuse + specular) * iblIntensity;
+}
+
+#endif
@@ -0,0 +1,704 @@
+#include "IBLBaker.h"
+#include "TextureCooker.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define IBL_SSE2
+#endif
+
+namespace
+{
+	const float Pi = 3.14159265f;
+
+	// DXGI formats of the baked textures
+	const uint32_t FormatRGBA16Float = 10;	// DXGI_FORMAT_R16G16B16A16_FLOAT
+	const uint32_t FormatRG16Float = 34;	// DXGI_FORMAT_R16G16_FLOAT
+
+	uint32_t FourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+	}
+
+	// Header of the irradiance (.sh) file
+	struct IrradianceHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t hash;
+	};
+
+	// RGBA accumulator: one SSE register, or four floats without SSE2
+#ifdef IBL_SSE2
+	typedef __m128 Color;
+	inline Color Zero() { return _mm_setzero_ps(); }
+	inline Color Load(const float* p) { return _mm_loadu_ps(p); }
+	inline void Store(float* p, Color c) { _mm_storeu_ps(p, c); }
+	inline Color Add(Color a, Color b) { return _mm_add_ps(a, b); }
+	inline Color Scale(Color a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+	inline Color Lerp(Color a, Color b, float t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t))); }
+#else
+	struct Color { float v[4]; };
+	inline Color Zero() { return { { 0, 0, 0, 0 } }; }
+	inline Color Load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	inline void Store(float* p, Color c) { memcpy(p, c.v, sizeof(c.v)); }
+	inline Color Add(Color a, Color b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+	inline Color Scale(Color a, float s) { return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+	inline Color Lerp(Color a, Color b, float t) { return Add(a, Scale(Add(b, Scale(a, -1.0f)), t)); }
+#endif
+
+	void Normalize(float v[3])
+	{
+		float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		v[0] /= length;
+		v[1] /= length;
+		v[2] /= length;
+	}
+
+	void Cross(const float a[3], const float b[3], float out[3])
+	{
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	// Inverse of CubeDirection: which face, and where on it
+	void CubeFace(const float d[3], int& face, float& u, float& v)
+	{
+		float ax = std::fabs(d[0]), ay = std::fabs(d[1]), az = std::fabs(d[2]);
+		if (ax >= ay && ax >= az)
+		{
+			face = d[0] > 0 ? 0 : 1;
+			u = (d[0] > 0 ? -d[2] : d[2]) / ax;
+			v = -d[1] / ax;
+		}
+		else if (ay >= az)
+		{
+			face = d[1] > 0 ? 2 : 3;
+			u = d[0] / ay;
+			v = (d[1] > 0 ? d[2] : -d[2]) / ay;
+		}
+		else
+		{
+			face = d[2] > 0 ? 4 : 5;
+			u = (d[2] > 0 ? d[0] : -d[0]) / az;
+			v = -d[1] / az;
+		}
+	}
+
+	// Bilinear within one face, clamped at its edges
+	Color SampleLevel(const CubeLevel& level, const float direction[3])
+	{
+		int face;
+		float u, v;
+		CubeFace(direction, face, u, v);
+
+		int size = level.size;
+		float x = (u * 0.5f + 0.5f) * size - 0.5f;
+		float y = (v * 0.5f + 0.5f) * size - 0.5f;
+		x = std::min(std::max(x, 0.0f), (float)(size - 1));
+		y = std::min(std::max(y, 0.0f), (float)(size - 1));
+
+		int x0 = (int)x, y0 = (int)y;
+		int x1 = std::min(x0 + 1, size - 1), y1 = std::min(y0 + 1, size - 1);
+		float fx = x - x0, fy = y - y0;
+
+		const float* texels = &level.texels[(size_t)face * size * size * 4];
+		Color top = Lerp(Load(&texels[((size_t)y0 * size + x0) * 4]), Load(&texels[((size_t)y0 * size + x1) * 4]), fx);
+		Color bottom = Lerp(Load(&texels[((size_t)y1 * size + x0) * 4]), Load(&texels[((size_t)y1 * size + x1) * 4]), fx);
+		return Lerp(top, bottom, fy);
+	}
+
+	// Trilinear across the chain
+	Color SampleChain(const std::vector<CubeLevel>& chain, const float direction[3], float mip)
+	{
+		mip = std::min(std::max(mip, 0.0f), (float)(chain.size() - 1));
+		int m0 = (int)mip;
+		int m1 = std::min(m0 + 1, (int)chain.size() - 1);
+		Color a = SampleLevel(chain[m0], direction);
+		return m1 == m0 ? a : Lerp(a, SampleLevel(chain[m1], direction), mip - m0);
+	}
+
+	// Solid angle of a cube map texel centered at (u, v)
+	float TexelSolidAngle(float u, float v, int size)
+	{
+		float texel = 2.0f / size;
+		float d = 1.0f + u * u + v * v;
+		return texel * texel / (d * std::sqrt(d));
+	}
+
+	// Low-discrepancy point set for importance sampling
+	void Hammersley(unsigned int i, unsigned int count, float& x, float& y)
+	{
+		unsigned int bits = i;
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+		x = (float)i / count;
+		y = bits * 2.3283064365386963e-10f;
+	}
+
+	// Half vector around +Z for a GGX lobe of the given alpha (roughness squared)
+	void ImportanceSampleGGX(float x, float y, float alpha, float h[3])
+	{
+		float phi = 2.0f * Pi * x;
+		float cosTheta = std::sqrt((1.0f - y) / (1.0f + (alpha * alpha - 1.0f) * y));
+		float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		h[0] = sinTheta * std::cos(phi);
+		h[1] = sinTheta * std::sin(phi);
+		h[2] = cosTheta;
+	}
+
+	bool ReadFile(const std::string& path, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file)
+			return false;
+		bytes.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)bytes.data(), bytes.size());
+		return (bool)file;
+	}
+
+	// 64-bit FNV-1a over the sources, the settings and the baker version
+	uint64_t HashInputs(const std::vector<std::string>& paths, const int* settings, int settingCount)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		auto add = [&hash](const unsigned char* data, size_t size) {
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= data[i];
+				hash *= 1099511628211ull;
+			}
+		};
+
+		for (auto& path : paths)
+		{
+			std::vector<unsigned char> bytes;
+			if (!ReadFile(path, bytes))
+				return 0;
+			add(bytes.data(), bytes.size());
+		}
+		add((const unsigned char*)settings, sizeof(int) * settingCount);
+		add((const unsigned char*)&IBLBaker::Version, sizeof(IBLBaker::Version));
+		return hash;
+	}
+
+	double MsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+IBLSettings IBLBaker::DefaultSettings()
+{
+	IBLSettings settings = {};
+	settings.specularSize = 256;
+	settings.specularMips = 8;
+	settings.specularSamples = 128;
+	settings.irradianceSize = 64;
+	settings.lutSize = 128;
+	settings.lutSamples = 512;
+	return settings;
+}
+
+void IBLBaker::CubeDirection(int face, float u, float v, float direction[3])
+{
+	switch (face)
+	{
+	case 0: direction[0] = 1; direction[1] = -v; direction[2] = -u; break;	// +X
+	case 1: direction[0] = -1; direction[1] = -v; direction[2] = u; break;	// -X
+	case 2: direction[0] = u; direction[1] = 1; direction[2] = v; break;	// +Y
+	case 3: direction[0] = u; direction[1] = -1; direction[2] = -v; break;	// -Y
+	case 4: direction[0] = u; direction[1] = -v; direction[2] = 1; break;	// +Z
+	default: direction[0] = -u; direction[1] = -v; direction[2] = -1; break;	// -Z
+	}
+	Normalize(direction);
+}
+
+// --------------------------------------------------------
+// Averages each face down to 'size' (linearizing first, so
+// bright and dark texels mix the way light does), then box
+// filters the rest of the chain
+// --------------------------------------------------------
+std::vector<CubeLevel> IBLBaker::BuildSourceChain(const std::vector<DecodedImage>& faces, int size, ThreadPool& pool)
+{
+	float toLinear[256];
+	for (int i = 0; i < 256; i++)
+		toLinear[i] = std::pow(i / 255.0f, 2.2f);
+
+	int faceSize = faces[0].width;
+	while (size > faceSize || faceSize % size != 0)
+		size /= 2;
+	int factor = faceSize / size;
+	float weight = 1.0f / (factor * factor);
+
+	std::vector<CubeLevel> chain(1);
+	chain[0].size = size;
+	chain[0].texels.resize((size_t)6 * size * size * 4);
+
+	pool.ParallelFor(6 * size, [&](int row) {
+		int face = row / size;
+		int y = row % size;
+		const unsigned char* pixels = faces[face].pixels.data();
+		float* out = &chain[0].texels[((size_t)face * size * size + (size_t)y * size) * 4];
+		for (int x = 0; x < size; x++)
+		{
+			float sum[3] = {};
+			for (int sy = 0; sy < factor; sy++)
+			{
+				const unsigned char* source = &pixels[(((size_t)y * factor + sy) * faceSize + (size_t)x * factor) * 4];
+				for (int sx = 0; sx < factor; sx++, source += 4)
+				{
+					sum[0] += toLinear[source[0]];
+					sum[1] += toLinear[source[1]];
+					sum[2] += toLinear[source[2]];
+				}
+			}
+			out[x * 4 + 0] = sum[0] * weight;
+			out[x * 4 + 1] = sum[1] * weight;
+			out[x * 4 + 2] = sum[2] * weight;
+			out[x * 4 + 3] = 1.0f;
+		}
+	});
+
+	while (chain.back().size > 1)
+	{
+		const CubeLevel& source = chain.back();
+		CubeLevel level;
+		level.size = source.size / 2;
+		level.texels.resize((size_t)6 * level.size * level.size * 4);
+
+		int s = source.size;
+		int d = level.size;
+		pool.ParallelFor(6 * d, [&](int row) {
+			int face = row / d;
+			int y = row % d;
+			const float* top = &source.texels[((size_t)face * s * s + (size_t)y * 2 * s) * 4];
+			const float* bottom = top + (size_t)s * 4;
+			float* out = &level.texels[((size_t)face * d * d + (size_t)y * d) * 4];
+			for (int x = 0; x < d; x++)
+			{
+				Color sum = Add(Add(Load(&top[x * 8]), Load(&top[x * 8 + 4])), Add(Load(&bottom[x * 8]), Load(&bottom[x * 8 + 4])));
+				Store(&out[x * 4], Scale(sum, 0.25f));
+			}
+		});
+		chain.push_back(std::move(level));
+	}
+	return chain;
+}
+
+// --------------------------------------------------------
+// Projects radiance onto the first 9 SH basis functions,
+// weighting each texel by the solid angle it covers, then
+// convolves with the cosine lobe (pi, 2pi/3, pi/4 per band)
+// and divides by pi for Lambert
+// --------------------------------------------------------
+IrradianceSH IBLBaker::ProjectIrradiance(const CubeLevel& level, ThreadPool& pool)
+{
+	int size = level.size;
+
+	// Per-row sums, added up in order afterwards so the result
+	// doesn't depend on how the rows were split across threads
+	std::vector<float> rowSums((size_t)6 * size * 9 * 4);
+	pool.ParallelFor(6 * size, [&](int row) {
+		int face = row / size;
+		int y = row % size;
+		Color sums[9];
+		for (Color& c : sums)
+			c = Zero();
+
+		const float* texels = &level.texels[((size_t)face * size * size + (size_t)y * size) * 4];
+		float v = (y + 0.5f) / size * 2.0f - 1.0f;
+		for (int x = 0; x < size; x++)
+		{
+			float u = (x + 0.5f) / size * 2.0f - 1.0f;
+			float d[3];
+			CubeDirection(face, u, v, d);
+
+			Color radiance = Scale(Load(&texels[x * 4]), TexelSolidAngle(u, v, size));
+			float basis[9] = {
+				0.282095f,
+				0.488603f * d[1],
+				0.488603f * d[2],
+				0.488603f * d[0],
+				1.092548f * d[0] * d[1],
+				1.092548f * d[1] * d[2],
+				0.315392f * (3.0f * d[2] * d[2] - 1.0f),
+				1.092548f * d[0] * d[2],
+				0.546274f * (d[0] * d[0] - d[1] * d[1])
+			};
+			for (int i = 0; i < 9; i++)
+				sums[i] = Add(sums[i], Scale(radiance, basis[i]));
+		}
+
+		for (int i = 0; i < 9; i++)
+			Store(&rowSums[((size_t)row * 9 + i) * 4], sums[i]);
+	});
+
+	IrradianceSH sh = {};
+	for (int row = 0; row < 6 * size; row++)
+		for (int i = 0; i < 9; i++)
+			for (int c = 0; c < 3; c++)
+				sh.coefficients[i][c] += rowSums[((size_t)row * 9 + i) * 4 + c];
+
+	// Cosine lobe / pi
+	const float band[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+	for (int i = 0; i < 9; i++)
+		for (int c = 0; c < 3; c++)
+			sh.coefficients[i][c] *= band[i];
+	return sh;
+}
+
+void IBLBaker::EvaluateIrradiance(const IrradianceSH& sh, const float d[3], float rgb[3])
+{
+	float basis[9] = {
+		0.282095f,
+		0.488603f * d[1],
+		0.488603f * d[2],
+		0.488603f * d[0],
+		1.092548f * d[0] * d[1],
+		1.092548f * d[1] * d[2],
+		0.315392f * (3.0f * d[2] * d[2] - 1.0f),
+		1.092548f * d[0] * d[2],
+		0.546274f * (d[0] * d[0] - d[1] * d[1])
+	};
+	for (int c = 0; c < 3; c++)
+	{
+		rgb[c] = 0;
+		for (int i = 0; i < 9; i++)
+			rgb[c] += sh.coefficients[i][c] * basis[i];
+	}
+}
+
+// --------------------------------------------------------
+// GGX prefiltering with N = V = R (the usual split-sum
+// assumption). Every texel of a level uses the same samples
+// in tangent space, so they're worked out once per level,
+// along with the source mip each one should read: wide,
+// unlikely samples read coarser mips so they cover their
+// share of the sphere instead of aliasing.
+// --------------------------------------------------------
+std::vector<CubeLevel> IBLBaker::PrefilterSpecular(const std::vector<CubeLevel>& source, int mipCount, int samples, ThreadPool& pool)
+{
+	struct Sample {
+		float l[3];		// Light direction in tangent space
+		float weight;	// N.L
+		float mip;		// Source level to read
+	};
+
+	mipCount = std::min(mipCount, (int)source.size());
+	std::vector<CubeLevel> levels(mipCount);
+	levels[0] = source[0];
+
+	int sourceSize = source[0].size;
+	float texelSolidAngle = 4.0f * Pi / (6.0f * sourceSize * sourceSize);
+
+	for (int mip = 1; mip < mipCount; mip++)
+	{
+		float roughness = (float)mip / (mipCount - 1);
+		float alpha = roughness * roughness;
+
+		std::vector<Sample> lobe;
+		for (int i = 0; i < samples; i++)
+		{
+			float x, y, h[3];
+			Hammersley(i, samples, x, y);
+			ImportanceSampleGGX(x, y, alpha, h);
+
+			// Reflect V = (0, 0, 1) about H
+			Sample s;
+			s.l[0] = 2.0f * h[2] * h[0];
+			s.l[1] = 2.0f * h[2] * h[1];
+			s.l[2] = 2.0f * h[2] * h[2] - 1.0f;
+			if (s.l[2] <= 0)
+				continue;
+
+			// pdf = D * N.H / (4 * V.H), which is D / 4 when N = V
+			float a2 = alpha * alpha;
+			float denom = h[2] * h[2] * (a2 - 1.0f) + 1.0f;
+			float pdf = a2 / (Pi * denom * denom) / 4.0f;
+			float sampleSolidAngle = 1.0f / (samples * pdf + 0.0001f);
+			s.mip = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+			s.weight = s.l[2];
+			lobe.push_back(s);
+		}
+
+		CubeLevel& level = levels[mip];
+		level.size = std::max(sourceSize >> mip, 1);
+		level.texels.resize((size_t)6 * level.size * level.size * 4);
+
+		int size = level.size;
+		pool.ParallelFor(6 * size, [&](int row) {
+			int face = row / size;
+			int y = row % size;
+			float v = (y + 0.5f) / size * 2.0f - 1.0f;
+			float* out = &level.texels[((size_t)face * size * size + (size_t)y * size) * 4];
+			for (int x = 0; x < size; x++)
+			{
+				float u = (x + 0.5f) / size * 2.0f - 1.0f;
+				float n[3];
+				CubeDirection(face, u, v, n);
+
+				// Tangent frame around the normal
+				float up[3] = { 0, 0, 1 };
+				if (std::fabs(n[2]) > 0.999f)
+				{
+					up[0] = 1;
+					up[2] = 0;
+				}
+				float t[3], b[3];
+				Cross(up, n, t);
+				Normalize(t);
+				Cross(n, t, b);
+
+				Color sum = Zero();
+				float totalWeight = 0;
+				for (const Sample& s : lobe)
+				{
+					float l[3] = {
+						t[0] * s.l[0] + b[0] * s.l[1] + n[0] * s.l[2],
+						t[1] * s.l[0] + b[1] * s.l[1] + n[1] * s.l[2],
+						t[2] * s.l[0] + b[2] * s.l[1] + n[2] * s.l[2]
+					};
+					sum = Add(sum, Scale(SampleChain(source, l, s.mip), s.weight));
+					totalWeight += s.weight;
+				}
+				Store(&out[x * 4], Scale(sum, 1.0f / totalWeight));
+				out[x * 4 + 3] = 1.0f;
+			}
+		});
+	}
+	return levels;
+}
+
+// --------------------------------------------------------
+// Split-sum BRDF: for each N.V and roughness, the scale and
+// bias to F0 that the integral of the specular BRDF comes to
+// under uniform white light (Karis, "Real Shading in Unreal
+// Engine 4"), with k = alpha / 2 for image-based lighting
+// --------------------------------------------------------
+std::vector<float> IBLBaker::IntegrateBrdf(int size, int samples, ThreadPool& pool)
+{
+	std::vector<float> lut((size_t)size * size * 2);
+	pool.ParallelFor(size, [&](int y) {
+		float roughness = (y + 0.5f) / size;
+		float alpha = roughness * roughness;
+		float k = alpha / 2.0f;
+
+		for (int x = 0; x < size; x++)
+		{
+			float NdotV = (x + 0.5f) / size;
+			float view[3] = { std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV };
+
+			float scale = 0, bias = 0;
+			for (int i = 0; i < samples; i++)
+			{
+				float u, v, h[3];
+				Hammersley(i, samples, u, v);
+				ImportanceSampleGGX(u, v, alpha, h);
+
+				float VdotH = view[0] * h[0] + view[1] * h[1] + view[2] * h[2];
+				float NdotL = 2.0f * VdotH * h[2] - NdotV;
+				float NdotH = h[2];
+				if (NdotL <= 0 || VdotH <= 0)
+					continue;
+
+				float G = (NdotV / (NdotV * (1.0f - k) + k)) * (NdotL / (NdotL * (1.0f - k) + k));
+				float visibility = G * VdotH / (NdotH * NdotV);
+				float fresnel = std::pow(1.0f - VdotH, 5.0f);
+				scale += (1.0f - fresnel) * visibility;
+				bias += fresnel * visibility;
+			}
+
+			lut[((size_t)y * size + x) * 2 + 0] = scale / samples;
+			lut[((size_t)y * size + x) * 2 + 1] = bias / samples;
+		}
+	});
+	return lut;
+}
+
+IBLResult IBLBaker::BakeEnvironment(const std::vector<std::string>& facePaths, const std::string& specularPath, const std::string& irradiancePath,
+	const IBLSettings& settings, ThreadPool& pool, bool force)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	IBLResult result = {};
+
+	int key[4] = { settings.specularSize, settings.specularMips, settings.specularSamples, settings.irradianceSize };
+	uint64_t hash = HashInputs(facePaths, key, 4);
+	if (hash == 0 || facePaths.size() != 6)
+	{
+		result.error = "Couldn't read the sky faces";
+		return result;
+	}
+
+	IrradianceSH cached;
+	std::ifstream shFile(irradiancePath, std::ios::binary);
+	IrradianceHeader header = {};
+	shFile.read((char*)&header, sizeof(header));
+	if (!force && shFile && header.hash == hash && LoadIrradiance(irradiancePath, cached) && TextureCooker::IsUpToDate(specularPath, hash))
+	{
+		result.succeeded = true;
+		result.upToDate = true;
+		result.ms = MsSince(start);
+		return result;
+	}
+	shFile.close();
+
+	// Decode all six faces at once
+	std::vector<DecodedImage> faces(6);
+	std::vector<std::string> errors(6);
+	std::vector<char> decoded(6);
+	pool.ParallelFor(6, [&](int i) { decoded[i] = PngDecoder::DecodeFile(facePaths[i], faces[i], &errors[i]); });
+	for (int i = 0; i < 6; i++)
+	{
+		if (!decoded[i])
+		{
+			result.error = facePaths[i] + ": " + errors[i];
+			return result;
+		}
+		if (faces[i].width != faces[0].width || faces[i].height != faces[0].width)
+		{
+			result.error = "Sky faces must be square and the same size";
+			return result;
+		}
+	}
+
+	std::vector<CubeLevel> chain = BuildSourceChain(faces, settings.specularSize, pool);
+	faces.clear();
+
+	// Irradiance from whichever level is small enough
+	size_t irradianceLevel = 0;
+	while (irradianceLevel + 1 < chain.size() && chain[irradianceLevel].size > settings.irradianceSize)
+		irradianceLevel++;
+	IrradianceSH sh = ProjectIrradiance(chain[irradianceLevel], pool);
+
+	std::vector<CubeLevel> specular = PrefilterSpecular(chain, settings.specularMips, settings.specularSamples, pool);
+
+	// Half floats, each face's chain in turn
+	std::vector<std::vector<std::vector<unsigned char>>> slices(6, std::vector<std::vector<unsigned char>>(specular.size()));
+	for (int face = 0; face < 6; face++)
+	{
+		for (size_t mip = 0; mip < specular.size(); mip++)
+		{
+			size_t texels = (size_t)specular[mip].size * specular[mip].size;
+			const float* source = &specular[mip].texels[face * texels * 4];
+			std::vector<unsigned char>& bytes = slices[face][mip];
+			bytes.resize(texels * 4 * sizeof(uint16_t));
+			uint16_t* halves = (uint16_t*)bytes.data();
+			for (size_t i = 0; i < texels * 4; i++)
+				halves[i] = FloatToHalf(source[i]);
+		}
+	}
+
+	if (!TextureCooker::WriteDds(specularPath, specular[0].size, specular[0].size, FormatRGBA16Float, true, hash, slices))
+	{
+		result.error = "Couldn't write " + specularPath;
+		return result;
+	}
+
+	std::ofstream out(irradiancePath, std::ios::binary);
+	header.magic = FourCC('S', 'H', '9', ' ');
+	header.version = Version;
+	header.hash = hash;
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)&sh, sizeof(sh));
+	if (!out)
+	{
+		result.error = "Couldn't write " + irradiancePath;
+		return result;
+	}
+
+	result.succeeded = true;
+	result.ms = MsSince(start);
+	return result;
+}
+
+IBLResult IBLBaker::BakeBrdfLut(const std::string& lutPath, const IBLSettings& settings, ThreadPool& pool, bool force)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	IBLResult result = {};
+
+	int key[2] = { settings.lutSize, settings.lutSamples };
+	uint64_t hash = HashInputs({}, key, 2);
+	if (!force && TextureCooker::IsUpToDate(lutPath, hash))
+	{
+		result.succeeded = true;
+		result.upToDate = true;
+		result.ms = MsSince(start);
+		return result;
+	}
+
+	std::vector<float> lut = IntegrateBrdf(settings.lutSize, settings.lutSamples, pool);
+	std::vector<std::vector<std::vector<unsigned char>>> slices(1, std::vector<std::vector<unsigned char>>(1));
+	slices[0][0].resize(lut.size() * sizeof(uint16_t));
+	uint16_t* halves = (uint16_t*)slices[0][0].data();
+	for (size_t i = 0; i < lut.size(); i++)
+		halves[i] = FloatToHalf(lut[i]);
+
+	if (!TextureCooker::WriteDds(lutPath, settings.lutSize, settings.lutSize, FormatRG16Float, false, hash, slices))
+	{
+		result.error = "Couldn't write " + lutPath;
+		return result;
+	}
+
+	result.succeeded = true;
+	result.ms = MsSince(start);
+	return result;
+}
+
+bool IBLBaker::LoadIrradiance(const std::string& path, IrradianceSH& sh)
+{
+	std::ifstream file(path, std::ios::binary);
+	IrradianceHeader header = {};
+	file.read((char*)&header, sizeof(header));
+	if (!file || header.magic != FourCC('S', 'H', '9', ' ') || header.version != Version)
+		return false;
+
+	file.read((char*)&sh, sizeof(sh));
+	return (bool)file;
+}
+
+// --------------------------------------------------------
+// Round to nearest; too large clamps to the largest finite
+// half, too small flushes to (signed) zero
+// --------------------------------------------------------
+uint16_t IBLBaker::FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t rawExponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+	if (rawExponent == 0xFF)
+		return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0)); // Inf or NaN
+
+	int exponent = (int)rawExponent - 127 + 15;
+	if (exponent >= 31)
+		return (uint16_t)(sign | 0x7BFF);
+
+	if (exponent <= 0)
+	{
+		// Denormal half
+		if (exponent < -10)
+			return (uint16_t)sign;
+		mantissa |= 0x800000;
+		uint32_t shift = 14 - exponent;
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			half++;
+		return (uint16_t)(sign | half);
+	}
+
+	// A carry out of the mantissa correctly bumps the exponent
+	uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)
+		half++;
+	return (uint16_t)half;
+}
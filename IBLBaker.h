@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "PngDecoder.h"
+#include "ThreadPool.h"
+
+// One mip level of a cube map, linear float RGBA (alpha unused),
+// the six faces one after another in +X, -X, +Y, -Y, +Z, -Z order
+struct CubeLevel {
+	int size;
+	std::vector<float> texels;
+};
+
+// Diffuse irradiance as 9 spherical harmonic coefficients,
+// already convolved with the cosine lobe and divided by pi,
+// so albedo * Evaluate(n) is the diffuse ambient light.
+// Padded to float4s to drop straight into a constant buffer.
+struct IrradianceSH {
+	float coefficients[9][4];
+};
+
+struct IBLSettings {
+	int specularSize;		// Mip 0 of the prefiltered cube (the sky faces are box filtered down to it)
+	int specularMips;		// Roughness 0 to 1, spread evenly over these
+	int specularSamples;	// GGX samples per texel
+	int irradianceSize;		// Face size the SH projection reads
+	int lutSize;
+	int lutSamples;
+};
+
+struct IBLResult {
+	bool succeeded;
+	bool upToDate;			// Skipped - the cache matched the sources
+	std::string error;
+	double ms;
+};
+
+// --------------------------------------------------------
+// Image-based lighting, baked on the CPU from the six sky faces
+//
+// - Irradiance: the sky projected onto 9 SH coefficients (a
+//   few dozen ALU ops in the shader, no texture at all)
+// - Specular: the sky prefiltered with a GGX lobe per mip,
+//   rougher surfaces reading lower mips (importance sampled,
+//   reading coarser source mips for wide samples so a few
+//   hundred samples don't alias)
+// - BRDF LUT: the split-sum scale and bias for F0, indexed
+//   by N.V and roughness, the same for any environment
+//
+// Work is spread over a ThreadPool and the inner loops use
+// SSE2 where available. Results are written to disk (float
+// DDS files and a small .sh file) stamped with a hash of the
+// sources and settings, and skipped when nothing changed.
+// Pure CPU and platform independent.
+// --------------------------------------------------------
+namespace IBLBaker
+{
+	// Bump whenever baked output changes, to invalidate old files
+	const unsigned int Version = 1;
+
+	IBLSettings DefaultSettings();
+
+	// sRGB faces -> linear chain from 'size' down to 1x1
+	std::vector<CubeLevel> BuildSourceChain(const std::vector<DecodedImage>& faces, int size, ThreadPool& pool);
+
+	IrradianceSH ProjectIrradiance(const CubeLevel& level, ThreadPool& pool);
+	void EvaluateIrradiance(const IrradianceSH& sh, const float direction[3], float rgb[3]);
+
+	// Level 0 is the (unfiltered) source, the rest are rougher
+	std::vector<CubeLevel> PrefilterSpecular(const std::vector<CubeLevel>& source, int mipCount, int samples, ThreadPool& pool);
+
+	// Two floats (scale, bias) per texel; x is N.V, y is roughness
+	std::vector<float> IntegrateBrdf(int size, int samples, ThreadPool& pool);
+
+	// Face is 0-5, u and v run -1 to 1 across it (v down)
+	void CubeDirection(int face, float u, float v, float direction[3]);
+
+	IBLResult BakeEnvironment(const std::vector<std::string>& facePaths, const std::string& specularPath, const std::string& irradiancePath,
+		const IBLSettings& settings, ThreadPool& pool, bool force = false);
+	IBLResult BakeBrdfLut(const std::string& lutPath, const IBLSettings& settings, ThreadPool& pool, bool force = false);
+
+	bool LoadIrradiance(const std::string& path, IrradianceSH& sh);
+
+	uint16_t FloatToHalf(float value);
+}
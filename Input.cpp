@@ -94,6 +94,9 @@ namespace Input
 		bool keyboardCaptured = false;
 		bool mouseCaptured = false;
 
+		// Replaying recorded input instead of reading the OS
+		bool playback = false;
+
 		// The window's handle (id) from the OS, so
 		// we can get the cursor's position
 		HWND hWnd = 0;
@@ -150,6 +153,10 @@ void Input::ShutDown()
 // ----------------------------------------------------------
 void Input::Update()
 {
+	// A replay sets the state through SetFrameState() instead
+	if (playback)
+		return;
+
 	// Copy the old keys so we have last frame's data
 	memcpy(prevKbState, kbState, sizeof(unsigned char) * 256);
 
@@ -266,6 +273,8 @@ void Input::SetWheelDelta(float delta)
 // ---------------------------------------------------------------
 void Input::SetKeyboardCapture(bool captured)
 {
+	if (playback)
+		return;
 	keyboardCaptured = captured;
 }
 
@@ -277,6 +286,8 @@ void Input::SetKeyboardCapture(bool captured)
 // ---------------------------------------------------------------
 void Input::SetMouseCapture(bool captured)
 {
+	if (playback)
+		return;
 	mouseCaptured = captured;
 }
 
@@ -401,3 +412,60 @@ bool Input::MouseRightRelease() { return !(kbState[VK_RBUTTON] & 0x80) && prevKb
 
 bool Input::MouseMiddlePress() { return kbState[VK_MBUTTON] & 0x80 && !(prevKbState[VK_MBUTTON] & 0x80) && !mouseCaptured; }
 bool Input::MouseMiddleRelease() { return !(kbState[VK_MBUTTON] & 0x80) && prevKbState[VK_MBUTTON] & 0x80 && !mouseCaptured; }
+
+
+// ----------------------------------------------------------
+//  Copies out everything the game could read this frame.
+//  Call it after the game has updated, once captures for
+//  the frame are settled.
+// ----------------------------------------------------------
+void Input::GetFrameState(FrameState& state)
+{
+	memset(state.keys, 0, sizeof(state.keys));
+	for (int i = 0; i < 256; i++)
+		if (kbState[i] & 0x80)
+			state.keys[i / 8] |= 1 << (i % 8);
+
+	state.mouseX = mouseX;
+	state.mouseY = mouseY;
+	state.mouseXDelta = mouseXDelta;
+	state.mouseYDelta = mouseYDelta;
+	state.rawMouseXDelta = rawMouseXDelta;
+	state.rawMouseYDelta = rawMouseYDelta;
+	state.wheelDelta = wheelDelta;
+	state.keyboardCaptured = keyboardCaptured;
+	state.mouseCaptured = mouseCaptured;
+}
+
+// ----------------------------------------------------------
+//  Stands in for Update() during a replay: last frame's keys
+//  become the previous state and the recorded frame becomes
+//  the current one
+// ----------------------------------------------------------
+void Input::SetFrameState(const FrameState& state)
+{
+	memcpy(prevKbState, kbState, sizeof(unsigned char) * 256);
+	for (int i = 0; i < 256; i++)
+		kbState[i] = (state.keys[i / 8] & (1 << (i % 8))) ? 0x80 : 0;
+
+	prevMouseX = mouseX;
+	prevMouseY = mouseY;
+	mouseX = state.mouseX;
+	mouseY = state.mouseY;
+	mouseXDelta = state.mouseXDelta;
+	mouseYDelta = state.mouseYDelta;
+	rawMouseXDelta = state.rawMouseXDelta;
+	rawMouseYDelta = state.rawMouseYDelta;
+	wheelDelta = state.wheelDelta;
+	keyboardCaptured = state.keyboardCaptured;
+	mouseCaptured = state.mouseCaptured;
+}
+
+// ----------------------------------------------------------
+//  While playback is on, Update() and the capture setters
+//  leave the state alone, so only SetFrameState() changes it
+// ----------------------------------------------------------
+void Input::SetPlayback(bool _playback)
+{
+	playback = _playback;
+}
@@ -6,6 +6,22 @@
 
 namespace Input
 {
+	// Everything the game can read from Input in one frame,
+	// for recording and replay (see InputRecorder.h)
+	struct FrameState
+	{
+		unsigned char keys[32];		// One bit per virtual key, down or up
+		int mouseX;
+		int mouseY;
+		int mouseXDelta;
+		int mouseYDelta;
+		int rawMouseXDelta;
+		int rawMouseYDelta;
+		float wheelDelta;
+		bool keyboardCaptured;
+		bool mouseCaptured;
+	};
+
 	void Initialize(HWND windowHandle);
 	void ShutDown();
 	void Update();
@@ -50,4 +66,8 @@ namespace Input
 
 	bool MouseMiddlePress();
 	bool MouseMiddleRelease();
+
+	void GetFrameState(FrameState& state);
+	void SetFrameState(const FrameState& state);
+	void SetPlayback(bool playback);
 }
\ No newline at end of file
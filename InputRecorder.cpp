@@ -0,0 +1,308 @@
+#include "InputRecorder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	// --- Log layout --------------
+	// Header, then per frame: flags byte, deltaTime, the 32 key
+	// bytes (only when FrameKeysChanged), mouse ints and wheel
+	const char LogMagic[4] = { 'I', 'N', 'P', 'L' };
+	const unsigned int LogVersion = 1;
+
+	const unsigned char FrameKeysChanged = 0x1;
+	const unsigned char FrameKeyboardCaptured = 0x2;
+	const unsigned char FrameMouseCaptured = 0x4;
+
+	struct LogHeader {
+		char magic[4];
+		unsigned int version;
+		unsigned int frameCount;
+		float startTime;		// totalTime just before the first frame
+		InputLogStart start;
+	};
+
+	struct LoggedFrame {
+		float deltaTime;
+		Input::FrameState state;
+	};
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	bool recording = false;
+	bool replaying = false;
+
+	// The log being recorded or replayed
+	std::string logPath;
+	LogHeader header = {};
+	std::vector<LoggedFrame> frames;
+
+	// Replay progress and timing
+	int replayIndex = 0;
+	float fixedTimestep = 0;
+	float replayTotalTime = 0;
+	Clock::time_point replayStartTime;
+	Clock::time_point replayFrameTime;
+	double replayMinMs = 0;
+	double replayMaxMs = 0;
+
+	InputRecorderStats lastStats = {};
+	std::string lastResult;
+
+	template<typename T> void Write(std::ofstream& out, const T& value)
+	{
+		out.write((const char*)&value, sizeof(T));
+	}
+
+	template<typename T> bool Read(std::ifstream& in, T& value)
+	{
+		return (bool)in.read((char*)&value, sizeof(T));
+	}
+
+	// --------------------------------------------------------
+	// Adds this replay to a CSV beside the log, one row per
+	// run, so repeated benchmark runs can be compared
+	// --------------------------------------------------------
+	void AppendReplayResult(double totalMs, int frameCount)
+	{
+		std::string path = logPath + ".results.csv";
+		bool exists = (bool)std::ifstream(path);
+		std::ofstream out(path, std::ios::app);
+		if (!out)
+			return;
+		if (!exists)
+			out << "frames,total_ms,average_ms,min_ms,max_ms,fixed_timestep\n";
+		out << frameCount << "," << totalMs << "," << totalMs / frameCount << ","
+			<< replayMinMs << "," << replayMaxMs << "," << fixedTimestep << "\n";
+	}
+
+	void FinishReplay()
+	{
+		Clock::time_point now = Clock::now();
+		double totalMs = std::chrono::duration<double, std::milli>(now - replayStartTime).count();
+		int frameCount = (int)frames.size();
+
+		lastStats.lastReplayFrames = frameCount;
+		lastStats.lastReplayMs = totalMs;
+		lastStats.lastReplayMinMs = replayMinMs;
+		lastStats.lastReplayMaxMs = replayMaxMs;
+
+		char text[256];
+		snprintf(text, sizeof(text), "Replayed %d frames in %.1f ms (%.3f ms average, %.3f min, %.3f max)",
+			frameCount, totalMs, frameCount > 0 ? totalMs / frameCount : 0.0, replayMinMs, replayMaxMs);
+		lastResult = text;
+		printf("%s\n", text);
+
+		if (frameCount > 0)
+			AppendReplayResult(totalMs, frameCount);
+		InputRecorder::StopReplay();
+	}
+}
+
+bool InputRecorder::StartRecording(const std::string& path, const InputLogStart& start)
+{
+	StopReplay();
+
+	logPath = path;
+	header = {};
+	memcpy(header.magic, LogMagic, sizeof(LogMagic));
+	header.version = LogVersion;
+	header.start = start;
+	frames.clear();
+	recording = true;
+	lastResult = "Recording to " + path;
+	return true;
+}
+
+// --------------------------------------------------------
+// Writes the frames recorded since StartRecording()
+// --------------------------------------------------------
+bool InputRecorder::StopRecording()
+{
+	if (!recording)
+		return false;
+	recording = false;
+
+	std::ofstream out(logPath, std::ios::binary);
+	if (!out)
+	{
+		lastResult = "Couldn't write " + logPath;
+		return false;
+	}
+
+	header.frameCount = (unsigned int)frames.size();
+	Write(out, header);
+
+	const unsigned char* previousKeys = 0;
+	for (const LoggedFrame& frame : frames)
+	{
+		const Input::FrameState& s = frame.state;
+		bool keysChanged = !previousKeys || memcmp(previousKeys, s.keys, sizeof(s.keys)) != 0;
+		previousKeys = s.keys;
+
+		unsigned char flags =
+			(keysChanged ? FrameKeysChanged : 0) |
+			(s.keyboardCaptured ? FrameKeyboardCaptured : 0) |
+			(s.mouseCaptured ? FrameMouseCaptured : 0);
+		Write(out, flags);
+		Write(out, frame.deltaTime);
+		if (keysChanged)
+			out.write((const char*)s.keys, sizeof(s.keys));
+		Write(out, s.mouseX);
+		Write(out, s.mouseY);
+		Write(out, s.mouseXDelta);
+		Write(out, s.mouseYDelta);
+		Write(out, s.rawMouseXDelta);
+		Write(out, s.rawMouseYDelta);
+		Write(out, s.wheelDelta);
+	}
+
+	bool written = (bool)out;
+	char text[256];
+	snprintf(text, sizeof(text), "%s %d frames (%lld bytes) to ",
+		written ? "Wrote" : "Couldn't write", (int)frames.size(), (long long)out.tellp());
+	lastResult = text + logPath;
+	frames.clear();
+	return written;
+}
+
+bool InputRecorder::IsRecording()
+{
+	return recording;
+}
+
+// --------------------------------------------------------
+// Loads the whole log up front so replaying never touches
+// the disk, then puts Input into playback
+// --------------------------------------------------------
+bool InputRecorder::StartReplay(const std::string& path, float _fixedTimestep, InputLogStart& start)
+{
+	if (recording)
+		StopRecording();
+	StopReplay();
+
+	std::ifstream in(path, std::ios::binary);
+	LogHeader fileHeader = {};
+	if (!in || !Read(in, fileHeader) || memcmp(fileHeader.magic, LogMagic, sizeof(LogMagic)) != 0 || fileHeader.version != LogVersion)
+	{
+		lastResult = "Not an input log: " + path;
+		return false;
+	}
+
+	std::vector<LoggedFrame> loaded(fileHeader.frameCount);
+	Input::FrameState previous = {};
+	for (LoggedFrame& frame : loaded)
+	{
+		Input::FrameState& s = frame.state;
+		unsigned char flags = 0;
+		bool ok = Read(in, flags) && Read(in, frame.deltaTime);
+		if (ok && (flags & FrameKeysChanged))
+			ok = Read(in, s.keys);
+		else
+			memcpy(s.keys, previous.keys, sizeof(s.keys));
+		ok = ok &&
+			Read(in, s.mouseX) && Read(in, s.mouseY) &&
+			Read(in, s.mouseXDelta) && Read(in, s.mouseYDelta) &&
+			Read(in, s.rawMouseXDelta) && Read(in, s.rawMouseYDelta) &&
+			Read(in, s.wheelDelta);
+		if (!ok)
+		{
+			lastResult = "Input log is cut short: " + path;
+			return false;
+		}
+		s.keyboardCaptured = (flags & FrameKeyboardCaptured) != 0;
+		s.mouseCaptured = (flags & FrameMouseCaptured) != 0;
+		previous = s;
+	}
+
+	logPath = path;
+	header = fileHeader;
+	frames.swap(loaded);
+	start = header.start;
+
+	replayIndex = 0;
+	fixedTimestep = _fixedTimestep > 0 ? _fixedTimestep : 0;
+	replayTotalTime = header.startTime;
+	replayMinMs = 0;
+	replayMaxMs = 0;
+	replaying = true;
+	Input::SetPlayback(true);
+	lastResult = "Replaying " + path;
+	return true;
+}
+
+void InputRecorder::StopReplay()
+{
+	if (!replaying)
+		return;
+	replaying = false;
+	frames.clear();
+	Input::SetPlayback(false);
+}
+
+bool InputRecorder::IsReplaying()
+{
+	return replaying;
+}
+
+void InputRecorder::BeginFrame(float& deltaTime, float& totalTime)
+{
+	if (!replaying)
+		return;
+
+	// Wall time of the frame that just finished
+	Clock::time_point now = Clock::now();
+	if (replayIndex == 0)
+		replayStartTime = now;
+	else
+	{
+		double ms = std::chrono::duration<double, std::milli>(now - replayFrameTime).count();
+		replayMinMs = replayIndex == 1 || ms < replayMinMs ? ms : replayMinMs;
+		replayMaxMs = ms > replayMaxMs ? ms : replayMaxMs;
+	}
+	replayFrameTime = now;
+
+	if (replayIndex >= (int)frames.size())
+	{
+		FinishReplay();
+		return;
+	}
+
+	const LoggedFrame& frame = frames[replayIndex++];
+	Input::SetFrameState(frame.state);
+	deltaTime = fixedTimestep > 0 ? fixedTimestep : frame.deltaTime;
+	replayTotalTime += deltaTime;
+	totalTime = replayTotalTime;
+}
+
+void InputRecorder::EndFrame(float deltaTime, float totalTime)
+{
+	if (!recording)
+		return;
+
+	if (frames.empty())
+		header.startTime = totalTime - deltaTime;
+
+	LoggedFrame frame = {};
+	frame.deltaTime = deltaTime;
+	Input::GetFrameState(frame.state);
+	frames.push_back(frame);
+}
+
+InputRecorderStats InputRecorder::GetStats()
+{
+	InputRecorderStats stats = lastStats;
+	stats.recordedFrames = recording ? (int)frames.size() : 0;
+	stats.replayFrame = replaying ? replayIndex : 0;
+	stats.replayFrameCount = replaying ? (int)frames.size() : 0;
+	stats.fixedTimestep = fixedTimestep;
+	return stats;
+}
+
+const std::string& InputRecorder::GetLastResult()
+{
+	return lastResult;
+}
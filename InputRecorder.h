@@ -0,0 +1,57 @@
+#pragma once
+#include <DirectXMath.h>
+#include <string>
+#include "Input.h"
+
+// Where a recording started, so a replay can start there too
+struct InputLogStart {
+	DirectX::XMFLOAT3 cameraPosition;
+	DirectX::XMFLOAT3 cameraRotation;	// Pitch, yaw, roll
+};
+
+struct InputRecorderStats {
+	int recordedFrames;			// So far, while recording
+	int replayFrame;			// Next frame to play, while replaying
+	int replayFrameCount;
+	float fixedTimestep;		// 0 when replaying the recorded timing
+
+	// The last replay to finish
+	int lastReplayFrames;
+	double lastReplayMs;		// Wall time for the whole replay
+	double lastReplayMinMs;
+	double lastReplayMaxMs;
+};
+
+// --------------------------------------------------------
+// Records the game's input and frame timing, and plays it
+// back for repeatable runs
+//
+// Recording keeps each frame's Input::FrameState and the
+// deltaTime handed to Game::Update, then writes them to a
+// small binary log (keys are only stored when they change).
+// Replaying puts Input into playback and feeds the logged
+// input and timing back frame by frame, so the game sees
+// exactly the same run whatever the wall clock does, then
+// reports how long the replay really took.
+// --------------------------------------------------------
+namespace InputRecorder
+{
+	bool StartRecording(const std::string& path, const InputLogStart& start);
+	bool StopRecording();	// Writes the log
+	bool IsRecording();
+
+	// fixedTimestep > 0 plays every frame with that deltaTime
+	// instead of the recorded ones
+	bool StartReplay(const std::string& path, float fixedTimestep, InputLogStart& start);
+	void StopReplay();
+	bool IsReplaying();
+
+	// Called by the main loop around Game::Update. BeginFrame()
+	// applies the next logged frame and replaces the timing
+	// while replaying; EndFrame() logs the frame while recording.
+	void BeginFrame(float& deltaTime, float& totalTime);
+	void EndFrame(float deltaTime, float totalTime);
+
+	InputRecorderStats GetStats();
+	const std::string& GetLastResult();
+}
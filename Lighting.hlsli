@@ -29,7 +29,8 @@ struct Light
     float3 color;
     float spotInnerAngle;
     float spotOuterAngle;
-    float2 padding;
+    int shadowIndex; // First shadow atlas record, -1 for no atlas shadow
+    float padding;
 };
 
 float DiffuseTerm(float3 normal, float3 directionToLight)
@@ -174,9 +175,11 @@ float3 SpotLight(Light light, float3 normal, float3 worldPosition, float3 camera
 // Normal Mapping unpacking and tangent transformation
 
 // Sample then unpack values
+// - Only x and y are stored in cooked (BC5) normal maps, so z is always rebuilt
 float3 UnpackNormalMap(Texture2D map, SamplerState _sampler, float2 uv)
 {
-    return map.Sample(_sampler, uv).rgb * 2.0f - 1.0f;
+    float2 xy = map.Sample(_sampler, uv).rg * 2.0f - 1.0f;
+    return float3(xy, sqrt(saturate(1.0f - dot(xy, xy))));
 }
 
 // Convert from Tangent Space to Normal Space
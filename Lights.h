@@ -14,5 +14,6 @@ struct Light {
 	DirectX::XMFLOAT3 color;
 	float spotInnerAngle;
 	float spotOuterAngle;
-	DirectX::XMFLOAT2 padding; 
+	int shadowIndex;		// First shadow atlas record, -1 for no atlas shadow
+	float padding;
 };
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// --------------------------------------------------------
+// Bounded multi-producer, multi-consumer queue
+//
+// Every slot carries a sequence number saying whose turn it
+// is (a producer's or a consumer's), so pushes and pops only
+// ever race on one atomic counter each and never take a lock.
+// (Dmitry Vyukov's bounded MPMC design)
+//
+// Capacity is rounded up to a power of two. TryPush() fails
+// when the queue is full and TryPop() when it's empty;
+// neither one blocks.
+// --------------------------------------------------------
+template <typename T>
+class LockFreeQueue
+{
+public:
+	LockFreeQueue(size_t _capacity = 1024) :
+		enqueuePos(0),
+		dequeuePos(0)
+	{
+		capacity = 2;
+		while (capacity < _capacity)
+			capacity *= 2;
+		mask = capacity - 1;
+
+		cells = new Cell[capacity];
+		for (size_t i = 0; i < capacity; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	~LockFreeQueue()
+	{
+		delete[] cells;
+	}
+
+	LockFreeQueue(const LockFreeQueue&) = delete;
+	LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+	bool TryPush(T value)
+	{
+		Cell* cell;
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+
+			// Slot is free - try to claim it
+			if (diff == 0)
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			// Slot still holds something from a full lap ago
+			else if (diff < 0)
+				return false;
+			// Someone else claimed it first
+			else
+				pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+
+		cell->value = std::move(value);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPop(T& value)
+	{
+		Cell* cell;
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)(pos + 1);
+
+			// Slot has been written - try to claim it
+			if (diff == 0)
+			{
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			// Nothing written here yet
+			else if (diff < 0)
+				return false;
+			else
+				pos = dequeuePos.load(std::memory_order_relaxed);
+		}
+
+		value = std::move(cell->value);
+		cell->sequence.store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t GetCapacity()
+	{
+		return capacity;
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	// Keep the two ends on separate cache lines so producers
+	// and consumers don't fight over the same one
+	alignas(64) Cell* cells;
+	size_t capacity;
+	size_t mask;
+	alignas(64) std::atomic<size_t> enqueuePos;
+	alignas(64) std::atomic<size_t> dequeuePos;
+};
@@ -6,6 +6,10 @@
 #include "Graphics.h"
 #include "Game.h"
 #include "Input.h"
+#include "Profiler.h"
+#include "InputRecorder.h"
+#include <sstream>
+#include <string>
 
 // Annonymous namespace to hold variables
 // only accessible in this file
@@ -79,8 +83,28 @@ int WINAPI WinMain(
 	Input::Initialize(Window::Handle());
 
 	// Now the main application object itself can be initialzied
+	PROFILE_THREAD("Main");
 	game = new Game();
 
+	// Command line: "-record <log>" records input from the first frame,
+	// "-replay <log> [-timestep <seconds>]" plays it back and then quits
+	std::string recordPath;
+	std::string replayPath;
+	float replayTimestep = 0;
+	std::istringstream args(lpCmdLine ? lpCmdLine : "");
+	std::string arg;
+	while (args >> arg)
+	{
+		if (arg == "-record") args >> recordPath;
+		else if (arg == "-replay") args >> replayPath;
+		else if (arg == "-timestep") args >> replayTimestep;
+	}
+	if (!replayPath.empty())
+		game->StartInputReplay(replayPath, replayTimestep);
+	else if (!recordPath.empty())
+		game->StartInputRecording(recordPath);
+	bool quitAfterReplay = InputRecorder::IsReplaying();
+
 	// Time tracking
 	LARGE_INTEGER perfFreq{};
 	double perfSeconds = 0;
@@ -116,19 +140,26 @@ int WINAPI WinMain(
 			float deltaTime = max((float)((currentTime - previousTime) * perfSeconds), 0.0f);
 			float totalTime = (float)((currentTime - startTime) * perfSeconds);
 			previousTime = currentTime;
+			PROFILE_BEGIN_FRAME();
 
 			// Calculate basic fps
 			Window::UpdateStats(totalTime);
 
-			// Input updating
+			// Input updating, or during a replay the next
+			// recorded frame along with its timing
 			Input::Update();
+			InputRecorder::BeginFrame(deltaTime, totalTime);
+			if (quitAfterReplay && !InputRecorder::IsReplaying())
+				Window::Quit();
 
 			// Update and draw
 			game->Update(deltaTime, totalTime);
+			InputRecorder::EndFrame(deltaTime, totalTime);
 			game->Draw(deltaTime, totalTime);
 
 			// Notify Input system about end of frame
 			Input::EndOfFrame();
+			PROFILE_END_FRAME();
 
 #if defined(DEBUG) || defined(_DEBUG)
 			// Print any graphics debug messages that occurred this frame
@@ -138,6 +169,8 @@ int WINAPI WinMain(
 	}
 
 	// Clean up
+	if (InputRecorder::IsRecording())
+		InputRecorder::StopRecording();
 	delete game;
 	Input::ShutDown();
 	Graphics::ShutDown();
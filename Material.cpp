@@ -5,7 +5,7 @@ Material::Material(const char* _name, DirectX::XMFLOAT3 _colorTint, Microsoft::W
     Microsoft::WRL::ComPtr<ID3D11VertexShader> _vertexShader, float _roughness, DirectX::XMFLOAT2 _uvScale, 
     DirectX::XMFLOAT2 _uvOffset) : colorTint(_colorTint), pixelShader(_pixelShader),
     vertexShader(_vertexShader), uvScale(_uvScale), uvOffset(_uvOffset), name(_name), 
-    roughness(_roughness)
+    roughness(_roughness), packedOrm(false)
 {
 }
 
@@ -33,6 +33,11 @@ float Material::GetRoughness()
     return roughness;
 }
 
+bool Material::IsPackedOrm()
+{
+    return packedOrm;
+}
+
 DirectX::XMFLOAT3 Material::GetColorTint()
 {
     return colorTint;
@@ -101,6 +106,31 @@ void Material::AddTextureSRV(unsigned int index, Microsoft::WRL::ComPtr<ID3D11Sh
     textureSRVs.insert({ index, srv });
 }
 
+void Material::SetTextureSRV(unsigned int index, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+{
+    textureSRVs[index] = srv;
+}
+
+
+void Material::SetPackedOrm(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ormSRV, Microsoft::WRL::ComPtr<ID3D11PixelShader> ormPixelShader)
+{
+    textureSRVs[2] = ormSRV;
+    textureSRVs.erase(3); // Metalness lives in the ORM's blue channel now
+    pixelShader = ormPixelShader;
+    packedOrm = true;
+}
+
+TextureHandle Material::SetTextureHandle(unsigned int index, TextureHandle handle)
+{
+    TextureHandle previous = textureHandles[index];
+    textureHandles[index] = handle;
+    return previous;
+}
+
+std::unordered_map<unsigned int, TextureHandle>& Material::GetTextureHandleMap()
+{
+    return textureHandles;
+}
 
 void Material::AddSampler(unsigned int index, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler)
 {
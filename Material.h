@@ -3,6 +3,7 @@
 #include <wrl/client.h>
 #include <d3d11.h>
 #include <unordered_map>
+#include "ResourceCache.h"
 
 class Material
 {
@@ -22,6 +23,7 @@ public:
 	std::unordered_map<unsigned int, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>& GetTextureSRVMap();
 	std::unordered_map<unsigned int, Microsoft::WRL::ComPtr<ID3D11SamplerState>>& GetSamplerMap();
 	float GetRoughness();
+	bool IsPackedOrm();
 
 	// Setters 
 	void SetColorTint(DirectX::XMFLOAT3 _colorTint);
@@ -33,9 +35,21 @@ public:
 
 	// Texture and Sampler methods
 	void AddTextureSRV(unsigned int index, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	void SetTextureSRV(unsigned int index, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv); // Replaces what's there
 	void AddSampler(unsigned int index, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
 	void BindTexturesAndSamplers();
 
+	// Switches to one occlusion/roughness/metalness texture in t2
+	// (instead of roughness in t2 and metalness in t3), along with
+	// the pixel shader variant that reads it
+	void SetPackedOrm(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ormSRV, Microsoft::WRL::ComPtr<ID3D11PixelShader> ormPixelShader);
+
+	// The cache references behind each slot's texture (none for
+	// placeholders and streamed textures). Setting one hands back
+	// the handle it replaced, for the owner to Release().
+	TextureHandle SetTextureHandle(unsigned int index, TextureHandle handle);
+	std::unordered_map<unsigned int, TextureHandle>& GetTextureHandleMap();
+
 private:
 	DirectX::XMFLOAT3 colorTint;
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
@@ -47,9 +61,11 @@ private:
 	DirectX::XMFLOAT2 uvScale;
 	std::unordered_map<unsigned int, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
 	std::unordered_map<unsigned int, Microsoft::WRL::ComPtr<ID3D11SamplerState>> samplers;
+	std::unordered_map<unsigned int, TextureHandle> textureHandles;
 
 	// Roughness
 	float roughness;
+	bool packedOrm;
 
 };
 
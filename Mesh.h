@@ -5,6 +5,7 @@
 #include "Vertex.h"
 #include "Graphics.h"
 #include <string>
+#include <vector>
 
 class Mesh
 {
@@ -31,13 +32,23 @@ public:
 	
 	int CalculateTris();
 
+	// Local space bounds, calculated from the vertices
+	DirectX::XMFLOAT3 GetBoundsMin();
+	DirectX::XMFLOAT3 GetBoundsMax();
+	DirectX::XMFLOAT3 GetBoundsCenter();
+	float GetBoundingRadius();
+
+	// CPU copies of the geometry, for software rasterization
+	const std::vector<DirectX::XMFLOAT3>& GetPositions();
+	const std::vector<unsigned int>& GetIndices();
+
 	// Draw
 	void Draw();
 
 
 private:
 	void CreateBuffers(Vertex vertices[], unsigned int indices[], unsigned int _numVertices, unsigned int _numIndices);
-	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
+	void CalculateBounds(Vertex vertices[], unsigned int _numVertices);
 	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer; // Vertex Buffer
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer; // Index Buffer
 
@@ -45,5 +56,14 @@ private:
 	int numVertices; // Number of Vertices
 
 	const char* name;
+
+	// Bounds
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+	float boundingRadius;
+
+	// CPU geometry
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<unsigned int> cpuIndices;
 };
 
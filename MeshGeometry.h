@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// The CPU side of building a Mesh: reading an OBJ into
+// vertices and indices, and generating tangents
+//
+// No device access, so loading can be timed and checked
+// on its own (see Tools/PerfBenchmarks.cpp)
+// --------------------------------------------------------
+namespace MeshGeometry
+{
+	// False if the file can't be opened
+	bool LoadObj(const char* fileName, std::vector<Vertex>& verts, std::vector<unsigned int>& indices);
+
+	// Call BEFORE creating the vertex buffer
+	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
+}
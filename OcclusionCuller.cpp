@@ -0,0 +1,430 @@
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2
+#endif
+
+using namespace DirectX;
+
+OcclusionCuller::OcclusionCuller(ThreadPool* _threadPool, int _width, int _height) :
+	threadPool(_threadPool),
+	frameArena(0),
+	viewProjection(),
+	stats()
+{
+	// Rows are processed 4 pixels at a time
+	width = (_width + 3) & ~3;
+	height = _height;
+	tilesX = (width + TileSize - 1) / TileSize;
+	tilesY = (height + TileSize - 1) / TileSize;
+	tileBins.resize(tilesX * tilesY);
+
+	// Full pyramid down to a single texel
+	int w = width;
+	int h = height;
+	while (true)
+	{
+		hiZ.push_back(std::vector<float>(w * h, 1.0f));
+		hiZWidths.push_back(w);
+		hiZHeights.push_back(h);
+		if (w == 1 && h == 1) break;
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+void OcclusionCuller::BeginFrame(const DirectX::XMFLOAT4X4& _viewProjection)
+{
+	viewProjection = _viewProjection;
+	occluders.clear();
+	stats = {};
+
+	std::vector<float>& depth = hiZ[0];
+	std::fill(depth.begin(), depth.end(), 1.0f);
+}
+
+void OcclusionCuller::AddOccluder(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<unsigned int>& indices, const DirectX::XMFLOAT4X4& world)
+{
+	Occluder o = {};
+	o.positions = &positions;
+	o.indices = &indices;
+	o.world = world;
+	occluders.push_back(o);
+}
+
+void OcclusionCuller::RasterizeOccluders()
+{
+	PROFILE_SCOPE("Rasterize occluders");
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Transform and set up every occluder in parallel
+	triangles.resize(occluders.size());
+	threadPool->ParallelFor((int)occluders.size(), [&](int i) {
+		SetupTriangles(occluders[i], triangles[i]);
+	});
+
+	// Bin triangles into every tile their bounds touch
+	for (auto& bin : tileBins)
+		bin.clear();
+	for (size_t o = 0; o < occluders.size(); o++)
+	{
+		for (auto& tri : triangles[o])
+		{
+			for (int ty = tri.minY / TileSize; ty <= tri.maxY / TileSize; ty++)
+			{
+				for (int tx = tri.minX / TileSize; tx <= tri.maxX / TileSize; tx++)
+				{
+					tileBins[ty * tilesX + tx].push_back(&tri);
+					stats.binnedTriangles++;
+				}
+			}
+		}
+		stats.triangles += (int)triangles[o].size();
+	}
+	stats.occluders = (int)occluders.size();
+
+	// Tiles don't overlap, so each one can be rasterized without locking
+	threadPool->ParallelFor(tilesX * tilesY, [&](int tile) {
+		PROFILE_SCOPE("Rasterize tile");
+		RasterizeTile(tile);
+	});
+
+	auto rasterized = std::chrono::high_resolution_clock::now();
+	BuildHiZ();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	stats.rasterizeMs = std::chrono::duration<float, std::milli>(rasterized - start).count();
+	stats.hiZMs = std::chrono::duration<float, std::milli>(end - rasterized).count();
+}
+
+// --------------------------------------------------------
+// Projects an occluder's triangles and turns each into
+// edge functions plus a depth plane in pixel space.
+// Triangles crossing the near plane are dropped, which
+// only ever makes the occluder smaller (never wrong).
+// --------------------------------------------------------
+void OcclusionCuller::SetupTriangles(const Occluder& occluder, std::vector<Triangle>& tris)
+{
+	tris.clear();
+
+	const std::vector<XMFLOAT3>& positions = *occluder.positions;
+	const std::vector<unsigned int>& indices = *occluder.indices;
+
+	// Project all vertices once
+	XMMATRIX worldViewProj = XMMatrixMultiply(XMLoadFloat4x4(&occluder.world), XMLoadFloat4x4(&viewProjection));
+	FrameVector<XMFLOAT4> clip(positions.size(), XMFLOAT4(), FrameAllocator<XMFLOAT4>(frameArena));
+	for (size_t i = 0; i < positions.size(); i++)
+		XMStoreFloat4(&clip[i], XMVector3Transform(XMLoadFloat3(&positions[i]), worldViewProj));
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const XMFLOAT4* v[3] = { &clip[indices[i]], &clip[indices[i + 1]], &clip[indices[i + 2]] };
+
+		// Near plane, and trivially off-screen
+		bool behind = false;
+		int left = 0, right = 0, below = 0, above = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			if (v[k]->z < 0.0f || v[k]->w <= 0.0f) behind = true;
+			if (v[k]->x < -v[k]->w) left++;
+			if (v[k]->x > v[k]->w) right++;
+			if (v[k]->y < -v[k]->w) below++;
+			if (v[k]->y > v[k]->w) above++;
+		}
+		if (behind || left == 3 || right == 3 || below == 3 || above == 3)
+			continue;
+
+		// To pixels
+		float x[3], y[3], z[3];
+		for (int k = 0; k < 3; k++)
+		{
+			float invW = 1.0f / v[k]->w;
+			x[k] = (v[k]->x * invW * 0.5f + 0.5f) * width;
+			y[k] = (0.5f - v[k]->y * invW * 0.5f) * height;
+			z[k] = v[k]->z * invW;
+		}
+
+		Triangle tri = {};
+		float minX = fminf(x[0], fminf(x[1], x[2]));
+		float maxX = fmaxf(x[0], fmaxf(x[1], x[2]));
+		float minY = fminf(y[0], fminf(y[1], y[2]));
+		float maxY = fmaxf(y[0], fmaxf(y[1], y[2]));
+		tri.minX = minX < 0.0f ? 0 : (int)minX;
+		tri.minY = minY < 0.0f ? 0 : (int)minY;
+		tri.maxX = maxX > width - 1.0f ? width - 1 : (int)maxX;
+		tri.maxY = maxY > height - 1.0f ? height - 1 : (int)maxY;
+		if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+			continue;
+
+		// Edge k is the one opposite vertex k, so it doubles as that vertex's barycentric weight
+		for (int k = 0; k < 3; k++)
+		{
+			int a = (k + 1) % 3;
+			int b = (k + 2) % 3;
+			tri.edgeA[k] = y[a] - y[b];
+			tri.edgeB[k] = x[b] - x[a];
+			tri.edgeC[k] = x[a] * y[b] - y[a] * x[b];
+		}
+
+		// Either winding counts - flip so the inside is always positive
+		float area = tri.edgeA[0] * x[0] + tri.edgeB[0] * y[0] + tri.edgeC[0];
+		if (fabsf(area) < 1e-6f)
+			continue;
+		if (area < 0.0f)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				tri.edgeA[k] = -tri.edgeA[k];
+				tri.edgeB[k] = -tri.edgeB[k];
+				tri.edgeC[k] = -tri.edgeC[k];
+			}
+			area = -area;
+		}
+
+		// Depth is linear in screen space: z = sum(z[k] * edge[k] / area)
+		float invArea = 1.0f / area;
+		for (int k = 0; k < 3; k++)
+		{
+			tri.depthA += z[k] * tri.edgeA[k] * invArea;
+			tri.depthB += z[k] * tri.edgeB[k] * invArea;
+			tri.depthC += z[k] * tri.edgeC[k] * invArea;
+		}
+
+		tris.push_back(tri);
+	}
+}
+
+void OcclusionCuller::RasterizeTile(int tile)
+{
+	int x0 = (tile % tilesX) * TileSize;
+	int y0 = (tile / tilesX) * TileSize;
+	int x1 = x0 + TileSize < width ? x0 + TileSize : width;
+	int y1 = y0 + TileSize < height ? y0 + TileSize : height;
+
+	for (const Triangle* tri : tileBins[tile])
+		RasterizeTriangle(*tri, x0, y0, x1, y1);
+}
+
+// --------------------------------------------------------
+// Rasterizes the part of a triangle inside [x0,x1) x [y0,y1),
+// keeping the nearest depth. x0 and x1 are multiples of 4.
+// --------------------------------------------------------
+void OcclusionCuller::RasterizeTriangle(const Triangle& tri, int x0, int y0, int x1, int y1)
+{
+	int startX = (tri.minX > x0 ? tri.minX : x0) & ~3;
+	int endX = tri.maxX + 1 < x1 ? tri.maxX + 1 : x1;
+	int startY = tri.minY > y0 ? tri.minY : y0;
+	int endY = tri.maxY + 1 < y1 ? tri.maxY + 1 : y1;
+
+	float* depth = hiZ[0].data();
+
+#ifdef OCCLUSION_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 a0 = _mm_set1_ps(tri.edgeA[0]);
+	const __m128 a1 = _mm_set1_ps(tri.edgeA[1]);
+	const __m128 a2 = _mm_set1_ps(tri.edgeA[2]);
+	const __m128 da = _mm_set1_ps(tri.depthA);
+
+	for (int y = startY; y < endY; y++)
+	{
+		// Everything but the x term is constant along the row
+		float py = y + 0.5f;
+		__m128 row0 = _mm_set1_ps(tri.edgeB[0] * py + tri.edgeC[0]);
+		__m128 row1 = _mm_set1_ps(tri.edgeB[1] * py + tri.edgeC[1]);
+		__m128 row2 = _mm_set1_ps(tri.edgeB[2] * py + tri.edgeC[2]);
+		__m128 rowZ = _mm_set1_ps(tri.depthB * py + tri.depthC);
+
+		float* rowDepth = depth + y * width;
+		for (int x = startX; x < endX; x += 4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x), centers);
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), row0);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), row1);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), row2);
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+			if (_mm_movemask_ps(inside) == 0)
+				continue;
+
+			__m128 z = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(da, px), rowZ), zero), one);
+			__m128 old = _mm_loadu_ps(rowDepth + x);
+			__m128 nearest = _mm_min_ps(old, z);
+			_mm_storeu_ps(rowDepth + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+		}
+	}
+#else
+	for (int y = startY; y < endY; y++)
+	{
+		float py = y + 0.5f;
+		float* rowDepth = depth + y * width;
+		for (int x = startX; x < endX; x++)
+		{
+			float px = x + 0.5f;
+			if (tri.edgeA[0] * px + tri.edgeB[0] * py + tri.edgeC[0] < 0.0f ||
+				tri.edgeA[1] * px + tri.edgeB[1] * py + tri.edgeC[1] < 0.0f ||
+				tri.edgeA[2] * px + tri.edgeB[2] * py + tri.edgeC[2] < 0.0f)
+				continue;
+
+			float z = tri.depthA * px + tri.depthB * py + tri.depthC;
+			z = z < 0.0f ? 0.0f : (z > 1.0f ? 1.0f : z);
+			if (z < rowDepth[x]) rowDepth[x] = z;
+		}
+	}
+#endif
+}
+
+// --------------------------------------------------------
+// Each level keeps the farthest depth of the 2x2 texels
+// below it, so "everything here is nearer than X" holds
+// for any texel at any level
+// --------------------------------------------------------
+void OcclusionCuller::BuildHiZ()
+{
+	PROFILE_SCOPE("Build Hi-Z");
+	for (size_t level = 1; level < hiZ.size(); level++)
+	{
+		const std::vector<float>& src = hiZ[level - 1];
+		std::vector<float>& dst = hiZ[level];
+		int srcW = hiZWidths[level - 1];
+		int srcH = hiZHeights[level - 1];
+		int dstW = hiZWidths[level];
+		int dstH = hiZHeights[level];
+
+		for (int y = 0; y < dstH; y++)
+		{
+			int sy0 = y * 2;
+			int sy1 = sy0 + 1 < srcH ? sy0 + 1 : sy0;
+			for (int x = 0; x < dstW; x++)
+			{
+				int sx0 = x * 2;
+				int sx1 = sx0 + 1 < srcW ? sx0 + 1 : sx0;
+				float d = fmaxf(
+					fmaxf(src[sy0 * srcW + sx0], src[sy0 * srcW + sx1]),
+					fmaxf(src[sy1 * srcW + sx0], src[sy1 * srcW + sx1]));
+				dst[y * dstW + x] = d;
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::IsOccluded(DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax, const DirectX::XMFLOAT4X4& world)
+{
+	stats.tested++;
+
+	// Project the 8 corners of the box
+	XMMATRIX worldViewProj = XMMatrixMultiply(XMLoadFloat4x4(&world), XMLoadFloat4x4(&viewProjection));
+	float minX = 0.0f, maxX = 0.0f, minY = 0.0f, maxY = 0.0f;
+	float minZ = 1.0f;
+	bool first = true;
+	for (int i = 0; i < 8; i++)
+	{
+		XMVECTOR corner = XMVectorSet(
+			(i & 1) ? boundsMax.x : boundsMin.x,
+			(i & 2) ? boundsMax.y : boundsMin.y,
+			(i & 4) ? boundsMax.z : boundsMin.z,
+			1.0f);
+		XMFLOAT4 c;
+		XMStoreFloat4(&c, XMVector4Transform(corner, worldViewProj));
+
+		// Crossing the near plane - can't say anything useful
+		if (c.w <= 0.0f || c.z < 0.0f)
+			return false;
+
+		float sx = (c.x / c.w * 0.5f + 0.5f) * width;
+		float sy = (0.5f - c.y / c.w * 0.5f) * height;
+		float sz = c.z / c.w;
+		if (first || sx < minX) minX = sx;
+		if (first || sx > maxX) maxX = sx;
+		if (first || sy < minY) minY = sy;
+		if (first || sy > maxY) maxY = sy;
+		if (sz < minZ) minZ = sz;
+		first = false;
+	}
+
+	// Off screen is the frustum's job, not ours
+	if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+		return false;
+
+	int x0 = minX < 0.0f ? 0 : (int)minX;
+	int y0 = minY < 0.0f ? 0 : (int)minY;
+	int x1 = maxX >= width ? width - 1 : (int)maxX;
+	int y1 = maxY >= height ? height - 1 : (int)maxY;
+
+	// Go up the pyramid until the box covers at most 4x4 texels
+	int level = 0;
+	while (level + 1 < (int)hiZ.size() &&
+		((x1 >> level) - (x0 >> level) >= 4 || (y1 >> level) - (y0 >> level) >= 4))
+		level++;
+
+	// Visible if anything behind the box's nearest point could be showing
+	const std::vector<float>& depths = hiZ[level];
+	int levelWidth = hiZWidths[level];
+	for (int y = y0 >> level; y <= (y1 >> level); y++)
+		for (int x = x0 >> level; x <= (x1 >> level); x++)
+			if (depths[y * levelWidth + x] >= minZ)
+				return false;
+
+	stats.culled++;
+	return true;
+}
+
+int OcclusionCuller::GetWidth()
+{
+	return width;
+}
+
+int OcclusionCuller::GetHeight()
+{
+	return height;
+}
+
+const std::vector<float>& OcclusionCuller::GetDepthBuffer()
+{
+	return hiZ[0];
+}
+
+int OcclusionCuller::GetHiZLevelCount()
+{
+	return (int)hiZ.size();
+}
+
+float OcclusionCuller::GetHiZDepth(int level, int x, int y)
+{
+	return hiZ[level][y * hiZWidths[level] + x];
+}
+
+bool OcclusionCuller::SaveDepthImage(const char* fileName)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	file << "P5\n" << width << " " << height << "\n255\n";
+	std::vector<unsigned char> pixels(width * height);
+	for (int i = 0; i < width * height; i++)
+		pixels[i] = (unsigned char)((1.0f - hiZ[0][i]) * 255.0f + 0.5f);
+	file.write((const char*)pixels.data(), pixels.size());
+
+	return file.good();
+}
+
+OcclusionStats OcclusionCuller::GetStats()
+{
+	return stats;
+}
+
+void OcclusionCuller::SetFrameArena(FrameArena* arena)
+{
+	frameArena = arena;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "FrameArena.h"
+#include "ThreadPool.h"
+
+// What the last frame of occlusion culling did
+struct OcclusionStats {
+	int occluders;
+	int triangles;			// Occluder triangles that survived setup
+	int binnedTriangles;	// Triangle/tile pairs after binning
+	int tested;
+	int culled;
+	float rasterizeMs;		// Setup, binning and rasterization
+	float hiZMs;			// Building the depth pyramid
+};
+
+// --------------------------------------------------------
+// CPU software rasterizer for occlusion culling
+//
+// - Occluder triangles are transformed and set up in
+//   parallel, binned into screen tiles, then each tile is
+//   rasterized on its own thread with 4-wide SIMD edge
+//   functions into a small depth buffer
+// - A max-depth pyramid (HiZ) is built from the result
+// - Bounding boxes are projected and compared against the
+//   coarsest HiZ level that covers them in a few texels
+//
+// Depth follows D3D: 0 is near, 1 is far. Nothing here
+// touches the device, so it runs (and can be checked
+// against saved depth images) on any platform.
+// --------------------------------------------------------
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(ThreadPool* _threadPool, int _width = 320, int _height = 192);
+	~OcclusionCuller();
+
+	// Clears the depth buffer and forgets last frame's occluders.
+	// viewProjection is view * projection (row vector convention).
+	void BeginFrame(const DirectX::XMFLOAT4X4& viewProjection);
+
+	// Geometry is referenced, not copied - it must stay alive until RasterizeOccluders()
+	void AddOccluder(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<unsigned int>& indices, const DirectX::XMFLOAT4X4& world);
+
+	// Renders all occluders and builds the HiZ pyramid
+	void RasterizeOccluders();
+
+	// True if a local space box, moved by world, is fully hidden
+	bool IsOccluded(DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax, const DirectX::XMFLOAT4X4& world);
+
+	int GetWidth();
+	int GetHeight();
+	const std::vector<float>& GetDepthBuffer();
+	int GetHiZLevelCount();
+	float GetHiZDepth(int level, int x, int y);
+
+	// Writes the depth buffer as a binary PGM (near is white), for comparing against golden images
+	bool SaveDepthImage(const char* fileName);
+
+	OcclusionStats GetStats();
+
+	// Scratch memory for each frame's projected vertices (0 for the heap)
+	void SetFrameArena(FrameArena* arena);
+
+private:
+	struct Occluder {
+		const std::vector<DirectX::XMFLOAT3>* positions;
+		const std::vector<unsigned int>* indices;
+		DirectX::XMFLOAT4X4 world;
+	};
+
+	// A triangle ready for rasterizing: edge functions and a depth plane, all in pixels
+	struct Triangle {
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float depthA;
+		float depthB;
+		float depthC;
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+	};
+
+	void SetupTriangles(const Occluder& occluder, std::vector<Triangle>& triangles);
+	void RasterizeTile(int tile);
+	void RasterizeTriangle(const Triangle& tri, int x0, int y0, int x1, int y1);
+	void BuildHiZ();
+
+	ThreadPool* threadPool;
+	FrameArena* frameArena;
+	int width;
+	int height;
+	int tilesX;
+	int tilesY;
+	static const int TileSize = 32;
+
+	DirectX::XMFLOAT4X4 viewProjection;
+	std::vector<Occluder> occluders;
+
+	// Per-occluder triangle lists and per-tile bins pointing into them
+	std::vector<std::vector<Triangle>> triangles;
+	std::vector<std::vector<const Triangle*>> tileBins;
+
+	// Level 0 is the depth buffer itself, each level after keeps the max of 2x2 texels
+	std::vector<std::vector<float>> hiZ;
+	std::vector<int> hiZWidths;
+	std::vector<int> hiZHeights;
+
+	OcclusionStats stats;
+};
@@ -1,10 +1,16 @@
 #include "ShaderStructs.hlsli"
 #include "Lighting.hlsli"
+#include "ShadowAtlas.hlsli"
+#include "IBL.hlsli"
 
 Texture2D Albedo : register(t0); // "t" registers for textures
 Texture2D NormalMap : register(t1);
+#ifdef PACKED_ORM
+Texture2D OrmMap : register(t2); // Occlusion, roughness, metalness in r, g, b
+#else
 Texture2D RoughnessMap : register(t2);
 Texture2D MetalnessMap : register(t3);
+#endif
 Texture2D ShadowMap : register(t4);
 
 SamplerState BasicSampler : register(s0); // "s" registers for samplers
@@ -52,12 +58,23 @@ float4 main(VertexToPixel input) : SV_TARGET
     float3 surfaceColor = pow(Albedo.Sample(BasicSampler, input.uv).rgb, 2.2f);
     surfaceColor *= colorTint;
     
+#ifdef PACKED_ORM
+    // One fetch for occlusion, roughness and metalness
+    float3 orm = OrmMap.Sample(BasicSampler, input.uv).rgb;
+    float occlusion = orm.r;
+    float roughness = orm.g;
+    float metalness = orm.b;
+#else
     // Roughness Map
     float roughness = RoughnessMap.Sample(BasicSampler, input.uv).r;
     
     // Metalness Map
     float metalness = MetalnessMap.Sample(BasicSampler, input.uv).r;
     
+    // No occlusion map without packing
+    float occlusion = 1.0f;
+#endif
+    
     // Specular color determination -----------------
     // Assume albedo texture is actually holding specular color where metalness == 1
     // Note the use of lerp here - metal is generally 0 or 1, but might be in between
@@ -77,7 +94,9 @@ float4 main(VertexToPixel input) : SV_TARGET
     // Get a ratio of comparison results using SampleCmpLevelZero()
     float shadowAmount = ShadowMap.SampleCmpLevelZero(ShadowSampler, shadowUV, distToLight).r;
     
-    float3 totalLight;
+    // Ambient (flat color plus the sky's light), darkened in crevices by the occlusion map
+    float3 totalLight = (ambientColor * surfaceColor +
+        AmbientIBL(input.normal, input.worldPos, camPos, roughness, metalness, surfaceColor, specularColor)) * occlusion;
     
     // Calculating Diffuse Lighting
     for (int i = 0; i < 5; i++)
@@ -97,10 +116,12 @@ float4 main(VertexToPixel input) : SV_TARGET
                 totalLight += lightResult;
                     break;
             case LIGHT_TYPE_POINT:
-                totalLight += PointLight(light, input.normal, input.worldPos, camPos, roughness, metalness, surfaceColor, specularColor);
+                totalLight += PointLight(light, input.normal, input.worldPos, camPos, roughness, metalness, surfaceColor, specularColor) *
+                    AtlasShadowAmount(light, input.worldPos, ShadowSampler);
                 break;
             case LIGHT_TYPE_SPOT:
-                totalLight += SpotLight(light, input.normal, input.worldPos, camPos, roughness, metalness, surfaceColor, specularColor);
+                totalLight += SpotLight(light, input.normal, input.worldPos, camPos, roughness, metalness, surfaceColor, specularColor) *
+                    AtlasShadowAmount(light, input.worldPos, ShadowSampler);
                 break;
         }
        
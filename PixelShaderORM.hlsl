@@ -0,0 +1,5 @@
+// PixelShader.hlsl with roughness and metalness read from one
+// packed occlusion/roughness/metalness texture in t2 (see
+// TextureCooker::CookOrm and Material::SetPackedOrm)
+#define PACKED_ORM
+#include "PixelShader.hlsl"
@@ -16,9 +16,10 @@ SamplerState ClampSampler : register(s0);
 
 float4 main(VertexToPixel input) : SV_TARGET
 {
-    // Snap UVs to the nearest pixel block in UV Space
+    // Snap UVs to the center of this pixel's block in UV Space
+    // (matches BlurPixelatePS.hlsl so both paths pick the same spot)
     float2 blockSize = float2(pixelSize * pixelWidth, pixelSize * pixelHeight);
-    float2 snappedUV = floor(input.uv / blockSize) * blockSize;
+    float2 snappedUV = (floor(input.uv / blockSize) + 0.5f) * blockSize;
     
     // Return the average
     return Pixels.Sample(ClampSampler, snappedUV);
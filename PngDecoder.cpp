@@ -0,0 +1,492 @@
+#include "PngDecoder.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	bool Fail(std::string* error, const char* message)
+	{
+		if (error) *error = message;
+		return false;
+	}
+
+	uint32_t ReadBigEndian(const unsigned char* p)
+	{
+		return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+	}
+
+	// ----------------------------------------------------
+	// Deflate reads bits least significant first; keeping
+	// up to 64 of them buffered means a whole length/distance
+	// pair can be decoded after a single refill
+	// ----------------------------------------------------
+	struct BitReader {
+		const unsigned char* data;
+		size_t size;
+		size_t pos;
+		uint64_t bits;
+		int count;
+
+		void Refill()
+		{
+			while (count <= 56)
+			{
+				uint64_t byte = pos < size ? data[pos] : 0;
+				bits |= byte << count;
+				count += 8;
+				pos++;
+			}
+		}
+
+		unsigned int Get(int n)
+		{
+			if (count < n) Refill();
+			unsigned int value = (unsigned int)(bits & ((1ull << n) - 1));
+			bits >>= n;
+			count -= n;
+			return value;
+		}
+
+		// Read past the end of the real data?
+		bool Overrun()
+		{
+			return pos - count / 8 > size;
+		}
+	};
+
+	// ----------------------------------------------------
+	// Canonical Huffman code as a single lookup table
+	// indexed by the next maxBits bits of input. Each entry
+	// holds (symbol << 4) | codeLength, 0 for unused codes.
+	// ----------------------------------------------------
+	struct Huffman {
+		std::vector<uint16_t> table;
+		int maxBits;
+	};
+
+	bool BuildHuffman(Huffman& h, const unsigned char* lengths, int count)
+	{
+		int lengthCounts[16] = {};
+		h.maxBits = 1;
+		for (int i = 0; i < count; i++)
+		{
+			lengthCounts[lengths[i]]++;
+			if (lengths[i] > h.maxBits) h.maxBits = lengths[i];
+		}
+		lengthCounts[0] = 0;
+
+		// First code of each length
+		int nextCode[16] = {};
+		int code = 0;
+		for (int bits = 1; bits < 16; bits++)
+		{
+			code = (code + lengthCounts[bits - 1]) << 1;
+			nextCode[bits] = code;
+		}
+
+		h.table.assign((size_t)1 << h.maxBits, 0);
+		for (int symbol = 0; symbol < count; symbol++)
+		{
+			int length = lengths[symbol];
+			if (length == 0)
+				continue;
+
+			int symbolCode = nextCode[length]++;
+			if (symbolCode >= (1 << length))
+				return false; // Over-subscribed
+
+			// Codes are stored most significant bit first
+			int reversed = 0;
+			for (int b = 0; b < length; b++)
+				reversed |= ((symbolCode >> b) & 1) << (length - 1 - b);
+
+			for (int i = reversed; i < (1 << h.maxBits); i += 1 << length)
+				h.table[i] = (uint16_t)((symbol << 4) | length);
+		}
+
+		return true;
+	}
+
+	int DecodeSymbol(BitReader& in, const Huffman& h)
+	{
+		if (in.count < h.maxBits) in.Refill();
+		uint16_t entry = h.table[in.bits & ((1ull << h.maxBits) - 1)];
+		int length = entry & 15;
+		if (length == 0)
+			return -1;
+
+		in.bits >>= length;
+		in.count -= length;
+		return entry >> 4;
+	}
+
+	const int LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const int LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const int DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const int DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const int CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	bool ReadDynamicTables(BitReader& in, Huffman& literals, Huffman& distances)
+	{
+		int literalCount = in.Get(5) + 257;
+		int distanceCount = in.Get(5) + 1;
+		int codeLengthCount = in.Get(4) + 4;
+
+		unsigned char codeLengthLengths[19] = {};
+		for (int i = 0; i < codeLengthCount; i++)
+			codeLengthLengths[CodeLengthOrder[i]] = (unsigned char)in.Get(3);
+
+		Huffman codeLengths;
+		if (!BuildHuffman(codeLengths, codeLengthLengths, 19))
+			return false;
+
+		// Literal and distance lengths are one run-length coded list
+		unsigned char lengths[286 + 30] = {};
+		int total = literalCount + distanceCount;
+		for (int i = 0; i < total;)
+		{
+			int symbol = DecodeSymbol(in, codeLengths);
+			if (symbol < 0)
+				return false;
+
+			if (symbol < 16)
+			{
+				lengths[i++] = (unsigned char)symbol;
+				continue;
+			}
+
+			int repeat = 0;
+			unsigned char value = 0;
+			if (symbol == 16)
+			{
+				if (i == 0) return false;
+				value = lengths[i - 1];
+				repeat = 3 + in.Get(2);
+			}
+			else if (symbol == 17) repeat = 3 + in.Get(3);
+			else repeat = 11 + in.Get(7);
+
+			if (i + repeat > total)
+				return false;
+			while (repeat--)
+				lengths[i++] = value;
+		}
+
+		return BuildHuffman(literals, lengths, literalCount) &&
+			BuildHuffman(distances, lengths + literalCount, distanceCount);
+	}
+
+	int Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = abs(p - a);
+		int pb = abs(p - b);
+		int pc = abs(p - c);
+		if (pa <= pb && pa <= pc) return a;
+		if (pb <= pc) return b;
+		return c;
+	}
+}
+
+bool PngDecoder::Inflate(const unsigned char* data, size_t size, size_t maxSize, std::vector<unsigned char>& output, std::string* error)
+{
+	// zlib header: deflate, no preset dictionary
+	if (size < 2 || (data[0] & 15) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 32))
+		return Fail(error, "Bad zlib header");
+
+	BitReader in = { data, size, 2, 0, 0 };
+	size_t written = 0;
+
+	// Fixed codes only get built if a block needs them
+	Huffman fixedLiterals;
+	Huffman fixedDistances;
+
+	bool last = false;
+	while (!last)
+	{
+		last = in.Get(1) != 0;
+		int type = in.Get(2);
+
+		if (type == 0)
+		{
+			// Stored - skip to a byte boundary, then copy
+			in.Get(in.count & 7);
+			unsigned int length = in.Get(16);
+			unsigned int inverse = in.Get(16);
+			if ((length ^ 0xFFFF) != inverse)
+				return Fail(error, "Corrupt stored block");
+			if (written + length > maxSize)
+				return Fail(error, "Decompressed data is larger than expected");
+
+			if (written + length > output.size())
+				output.resize(written + length);
+			for (unsigned int i = 0; i < length; i++)
+				output[written++] = (unsigned char)in.Get(8);
+		}
+		else if (type == 1 || type == 2)
+		{
+			Huffman dynamicLiterals;
+			Huffman dynamicDistances;
+			const Huffman* literals = &dynamicLiterals;
+			const Huffman* distances = &dynamicDistances;
+
+			if (type == 1)
+			{
+				if (fixedLiterals.table.empty())
+				{
+					unsigned char lengths[288];
+					for (int i = 0; i < 288; i++)
+						lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+					unsigned char distanceLengths[30];
+					for (int i = 0; i < 30; i++)
+						distanceLengths[i] = 5;
+					BuildHuffman(fixedLiterals, lengths, 288);
+					BuildHuffman(fixedDistances, distanceLengths, 30);
+				}
+				literals = &fixedLiterals;
+				distances = &fixedDistances;
+			}
+			else if (!ReadDynamicTables(in, dynamicLiterals, dynamicDistances))
+				return Fail(error, "Corrupt Huffman tables");
+
+			while (true)
+			{
+				in.Refill();
+				int symbol = DecodeSymbol(in, *literals);
+				if (symbol < 0 || symbol > 285)
+					return Fail(error, "Corrupt compressed data");
+
+				// Make room for a literal or the longest match, up to maxSize
+				if (written + 258 > output.size() && output.size() < maxSize)
+				{
+					size_t grown = output.size() * 2 + 258;
+					output.resize(grown < maxSize ? grown : maxSize);
+				}
+
+				if (symbol < 256)
+				{
+					if (written >= maxSize)
+						return Fail(error, "Decompressed data is larger than expected");
+					output[written++] = (unsigned char)symbol;
+					continue;
+				}
+				if (symbol == 256)
+					break;
+
+				symbol -= 257;
+				int length = LengthBase[symbol] + in.Get(LengthExtra[symbol]);
+
+				int distanceSymbol = DecodeSymbol(in, *distances);
+				if (distanceSymbol < 0 || distanceSymbol > 29)
+					return Fail(error, "Corrupt compressed data");
+				size_t distance = DistanceBase[distanceSymbol] + in.Get(DistanceExtra[distanceSymbol]);
+				if (distance > written)
+					return Fail(error, "Match reaches before the start of the data");
+				if (written + length > maxSize)
+					return Fail(error, "Decompressed data is larger than expected");
+
+				// Byte by byte, since matches may overlap themselves
+				unsigned char* dst = output.data() + written;
+				const unsigned char* src = dst - distance;
+				for (int i = 0; i < length; i++)
+					dst[i] = src[i];
+				written += length;
+			}
+		}
+		else
+			return Fail(error, "Invalid block type");
+
+		if (in.Overrun())
+			return Fail(error, "Compressed data is truncated");
+	}
+
+	output.resize(written);
+	return true;
+}
+
+bool PngDecoder::Decode(const unsigned char* data, size_t size, DecodedImage& image, std::string* error)
+{
+	static const unsigned char Signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	if (size < 8 || memcmp(data, Signature, 8) != 0)
+		return Fail(error, "Not a PNG file");
+
+	// Walk the chunks, gathering the header, palette and image data
+	int width = 0;
+	int height = 0;
+	int bitDepth = 0;
+	int colorType = -1;
+	unsigned char palette[256][4] = {};
+	std::vector<unsigned char> compressed;
+
+	size_t pos = 8;
+	while (pos + 12 <= size)
+	{
+		uint32_t length = ReadBigEndian(data + pos);
+		const unsigned char* type = data + pos + 4;
+		const unsigned char* chunk = data + pos + 8;
+		if (length > size - pos - 12)
+			return Fail(error, "Chunk runs past the end of the file");
+
+		if (memcmp(type, "IHDR", 4) == 0 && length >= 13)
+		{
+			width = (int)ReadBigEndian(chunk);
+			height = (int)ReadBigEndian(chunk + 4);
+			bitDepth = chunk[8];
+			colorType = chunk[9];
+			if (chunk[12] != 0)
+				return Fail(error, "Interlaced PNGs aren't supported");
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+		{
+			for (uint32_t i = 0; i < length / 3 && i < 256; i++)
+			{
+				palette[i][0] = chunk[i * 3 + 0];
+				palette[i][1] = chunk[i * 3 + 1];
+				palette[i][2] = chunk[i * 3 + 2];
+				palette[i][3] = 255;
+			}
+		}
+		else if (memcmp(type, "tRNS", 4) == 0 && colorType == 3)
+		{
+			for (uint32_t i = 0; i < length && i < 256; i++)
+				palette[i][3] = chunk[i];
+		}
+		else if (memcmp(type, "IDAT", 4) == 0)
+			compressed.insert(compressed.end(), chunk, chunk + length);
+		else if (memcmp(type, "IEND", 4) == 0)
+			break;
+
+		pos += 12 + length;
+	}
+
+	int channels = 0;
+	switch (colorType)
+	{
+	case 0: channels = 1; break;
+	case 2: channels = 3; break;
+	case 3: channels = 1; break;
+	case 4: channels = 2; break;
+	case 6: channels = 4; break;
+	default: return Fail(error, "Missing or unknown IHDR");
+	}
+	if (width <= 0 || height <= 0 || width > 16384 || height > 16384)
+		return Fail(error, "Bad image size");
+	if (bitDepth != 1 && bitDepth != 2 && bitDepth != 4 && bitDepth != 8 && bitDepth != 16)
+		return Fail(error, "Bad bit depth");
+
+	// Each row is a filter byte followed by packed pixels
+	size_t bitsPerPixel = (size_t)channels * bitDepth;
+	size_t rowBytes = (width * bitsPerPixel + 7) / 8;
+	size_t filterStride = bitsPerPixel < 8 ? 1 : bitsPerPixel / 8;
+
+	size_t rawSize = (rowBytes + 1) * height;
+	std::vector<unsigned char> raw;
+	raw.resize(rawSize);
+	if (!Inflate(compressed.data(), compressed.size(), rawSize, raw, error))
+		return false;
+	if (raw.size() < rawSize)
+		return Fail(error, "Image data is truncated");
+
+	// Undo the per-row filters in place
+	std::vector<unsigned char> zeroRow(rowBytes, 0);
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char* row = raw.data() + y * (rowBytes + 1);
+		int filter = row[0];
+		row++;
+		const unsigned char* above = y > 0 ? raw.data() + (y - 1) * (rowBytes + 1) + 1 : zeroRow.data();
+
+		switch (filter)
+		{
+		case 0: break;
+		case 1:
+			for (size_t i = filterStride; i < rowBytes; i++)
+				row[i] += row[i - filterStride];
+			break;
+		case 2:
+			for (size_t i = 0; i < rowBytes; i++)
+				row[i] += above[i];
+			break;
+		case 3:
+			for (size_t i = 0; i < rowBytes; i++)
+			{
+				int left = i >= filterStride ? row[i - filterStride] : 0;
+				row[i] += (unsigned char)((left + above[i]) / 2);
+			}
+			break;
+		case 4:
+			for (size_t i = 0; i < rowBytes; i++)
+			{
+				int left = i >= filterStride ? row[i - filterStride] : 0;
+				int upLeft = i >= filterStride ? above[i - filterStride] : 0;
+				row[i] += (unsigned char)Paeth(left, above[i], upLeft);
+			}
+			break;
+		default:
+			return Fail(error, "Bad row filter");
+		}
+	}
+
+	// Expand everything to RGBA8
+	image.width = width;
+	image.height = height;
+	image.pixels.resize((size_t)width * height * 4);
+	int byteStep = bitDepth == 16 ? 2 : 1;
+	int maxValue = (1 << bitDepth) - 1;
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = raw.data() + y * (rowBytes + 1) + 1;
+		unsigned char* out = image.pixels.data() + (size_t)y * width * 4;
+
+		for (int x = 0; x < width; x++, out += 4)
+		{
+			if (bitDepth < 8)
+			{
+				// Sub-byte gray or palette index
+				size_t bit = (size_t)x * bitDepth;
+				int value = (row[bit / 8] >> (8 - bitDepth - bit % 8)) & maxValue;
+				if (colorType == 3)
+				{
+					memcpy(out, palette[value], 4);
+				}
+				else
+				{
+					unsigned char gray = (unsigned char)(value * 255 / maxValue);
+					out[0] = out[1] = out[2] = gray;
+					out[3] = 255;
+				}
+				continue;
+			}
+
+			const unsigned char* p = row + (size_t)x * channels * byteStep;
+			switch (colorType)
+			{
+			case 0: out[0] = out[1] = out[2] = p[0]; out[3] = 255; break;
+			case 2: out[0] = p[0]; out[1] = p[byteStep]; out[2] = p[2 * byteStep]; out[3] = 255; break;
+			case 3: memcpy(out, palette[p[0]], 4); break;
+			case 4: out[0] = out[1] = out[2] = p[0]; out[3] = p[byteStep]; break;
+			case 6: out[0] = p[0]; out[1] = p[byteStep]; out[2] = p[2 * byteStep]; out[3] = p[3 * byteStep]; break;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool PngDecoder::DecodeFile(const std::string& path, DecodedImage& image, std::string* error)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return Fail(error, "Couldn't open file");
+
+	std::vector<unsigned char> bytes((size_t)file.tellg());
+	file.seekg(0);
+	file.read((char*)bytes.data(), bytes.size());
+	if (!file)
+		return Fail(error, "Couldn't read file");
+
+	return Decode(bytes.data(), bytes.size(), image, error);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// An image decoded to 8-bit RGBA, rows top to bottom
+struct DecodedImage {
+	int width;
+	int height;
+	std::vector<unsigned char> pixels;
+};
+
+// --------------------------------------------------------
+// Small, dependency-free PNG decoder
+//
+// WIC only exists on Windows and isn't safe to share across
+// threads without per-thread COM setup, so texture decoding
+// on worker threads goes through this instead.
+//
+// - Non-interlaced images of every color type
+// - 1/2/4/8 bit gray and palette, 8/16 bit everything else
+//   (16 bit channels keep their high byte)
+// - Palette transparency (tRNS) is honored
+// - Gray is replicated into RGB, so .r reads the same value
+//   as a single-channel WIC texture would
+// - Chunk CRCs and the zlib checksum aren't verified
+// --------------------------------------------------------
+namespace PngDecoder
+{
+	bool Decode(const unsigned char* data, size_t size, DecodedImage& image, std::string* error = 0);
+	bool DecodeFile(const std::string& path, DecodedImage& image, std::string* error = 0);
+
+	// Raw zlib stream -> bytes (exposed for anything else that stores deflate data).
+	// Fails rather than produce more than maxSize bytes, so a corrupt
+	// stream can't ask for an unbounded amount of memory.
+	bool Inflate(const unsigned char* data, size_t size, size_t maxSize, std::vector<unsigned char>& output, std::string* error = 0);
+}
@@ -0,0 +1,120 @@
+#include "PostProcessPlanner.h"
+#include "GaussianBlur.h"
+
+namespace
+{
+	const size_t BytesPerPixel = 4;
+
+	void AddPass(PostProcessPlan& plan, const char* name, int samples, int sourceWidth, int sourceHeight, int targetWidth, int targetHeight)
+	{
+		PostProcessPassEstimate pass = {};
+		pass.name = name;
+		pass.samplesPerPixel = samples;
+		pass.bytesRead = (size_t)sourceWidth * sourceHeight * BytesPerPixel;
+		pass.bytesWritten = (size_t)targetWidth * targetHeight * BytesPerPixel;
+		plan.passes.push_back(pass);
+		plan.totalBytes += pass.bytesRead + pass.bytesWritten;
+		plan.samplesPerPixel += samples;
+		plan.estimatedCost += (size_t)samples * targetWidth * targetHeight * POST_PROCESS_SAMPLE_COST + pass.bytesRead + pass.bytesWritten;
+	}
+
+	// Reads per pixel for one direction of the linear-sampled blur
+	int DirectionalTaps(int radius)
+	{
+		return GaussianBlur::LinearTapCount(radius) / 2;
+	}
+}
+
+// --------------------------------------------------------
+// Fuses only when it's allowed, the radius fits the fused
+// shader, and the fused pass costs less than the passes it
+// replaces
+// --------------------------------------------------------
+PostProcessPlan PostProcessPlanner::Plan(const PostProcessSettings& settings)
+{
+	if (settings.blurRadius <= 0)
+	{
+		PostProcessPlan plan = {};
+		plan.path = PostProcessPath::PixelateOnly;
+		plan.reason = "No blur";
+		AddPass(plan, "Pixelation", 1, settings.width, settings.height, settings.width, settings.height);
+		return plan;
+	}
+
+	PostProcessPlan separate = PlanSeparate(settings);
+	if (!settings.fusionEnabled)
+	{
+		separate.reason = "Fusion disabled";
+		return separate;
+	}
+	if (settings.blurRadius > MAX_FUSED_BLUR_RADIUS)
+	{
+		separate.reason = "Blur radius too large to fuse";
+		return separate;
+	}
+
+	PostProcessPlan fused = PlanFused(settings);
+	if (fused.estimatedCost < separate.estimatedCost)
+	{
+		fused.reason = "Fused pass is cheaper";
+		return fused;
+	}
+
+	separate.reason = "Fused kernel reads more than the passes save";
+	return separate;
+}
+
+PostProcessPlan PostProcessPlanner::PlanFused(const PostProcessSettings& settings)
+{
+	PostProcessPlan plan = {};
+	plan.path = PostProcessPath::FusedBlurPixelate;
+	plan.reason = "Fused";
+
+	// The 2D product of the directional taps, (2N-1)^2 reads
+	int taps = DirectionalTaps(settings.blurRadius);
+	AddPass(plan, "Blur + Pixelation", taps * taps, settings.width, settings.height, settings.width, settings.height);
+	return plan;
+}
+
+PostProcessPlan PostProcessPlanner::PlanSeparate(const PostProcessSettings& settings)
+{
+	PostProcessPlan plan = {};
+	int w = settings.width;
+	int h = settings.height;
+	plan.reason = "Separate";
+
+	bool downsample = settings.blurDownsampleEnabled && settings.blurRadius > settings.blurDownsampleRadius;
+	if (downsample)
+	{
+		plan.path = PostProcessPath::DownsampledBlurThenPixelate;
+		int hw = (w + 1) / 2;
+		int hh = (h + 1) / 2;
+		int taps = DirectionalTaps(GaussianBlur::DownsampledRadius(settings.blurRadius));
+		AddPass(plan, "Blur Downsample", 1, w, h, hw, hh);
+		AddPass(plan, "Blur Horizontal (Half)", taps, hw, hh, hw, hh);
+		AddPass(plan, "Blur Vertical (Half)", taps, hw, hh, hw, hh);
+		AddPass(plan, "Blur Upsample", 1, hw, hh, w, h);
+	}
+	else
+	{
+		plan.path = PostProcessPath::SeparateBlurThenPixelate;
+		int taps = DirectionalTaps(settings.blurRadius);
+		AddPass(plan, "Blur Horizontal", taps, w, h, w, h);
+		AddPass(plan, "Blur Vertical", taps, w, h, w, h);
+	}
+	AddPass(plan, "Pixelation", 1, w, h, w, h);
+
+	return plan;
+}
+
+const char* PostProcessPlanner::PathName(PostProcessPath path)
+{
+	switch (path)
+	{
+	case PostProcessPath::PixelateOnly: return "Pixelation Only";
+	case PostProcessPath::SeparateBlurThenPixelate: return "Separate Blur + Pixelation";
+	case PostProcessPath::DownsampledBlurThenPixelate: return "Downsampled Blur + Pixelation";
+	case PostProcessPath::FusedBlurPixelate: return "Fused Blur + Pixelation";
+	default: return "Unknown";
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Largest blur the fused pass handles; its 2D kernel grows with the square of the radius
+#define MAX_FUSED_BLUR_RADIUS 8
+
+// What one texture read costs next to a byte of render target traffic
+#define POST_PROCESS_SAMPLE_COST 1
+
+struct PostProcessSettings {
+	int width;
+	int height;
+	int blurRadius;
+	bool blurDownsampleEnabled;
+	int blurDownsampleRadius;		// Larger radii blur at half resolution
+	int pixelSize;
+	bool fusionEnabled;
+};
+
+enum class PostProcessPath {
+	PixelateOnly,
+	SeparateBlurThenPixelate,
+	DownsampledBlurThenPixelate,
+	FusedBlurPixelate
+};
+
+// Rough cost of one full screen pass
+struct PostProcessPassEstimate {
+	const char* name;
+	int samplesPerPixel;
+	size_t bytesRead;
+	size_t bytesWritten;
+};
+
+struct PostProcessPlan {
+	PostProcessPath path;
+	const char* reason;			// Why this path was picked
+	std::vector<PostProcessPassEstimate> passes;
+	size_t totalBytes;
+	int samplesPerPixel;		// Summed over the passes, per output pixel
+	size_t estimatedCost;		// Every read (at POST_PROCESS_SAMPLE_COST) plus totalBytes
+};
+
+// --------------------------------------------------------
+// Picks how blur and pixelation run for a set of settings
+//
+// Both effects can fuse into a single pass that evaluates
+// the blur as a 2D kernel around each block center. That
+// saves the intermediate targets but reads (2N-1)^2 times
+// per pixel instead of 2(2N-1), so it's only picked when
+// its estimated cost is lower than the separate (or
+// downsampled) blur passes followed by pixelation.
+//
+// Bandwidth assumes every pass reads its whole source and
+// writes its whole target once (RGBA8, perfect caching).
+// --------------------------------------------------------
+namespace PostProcessPlanner
+{
+	PostProcessPlan Plan(const PostProcessSettings& settings);
+
+	// Each path on its own, whatever Plan() would pick
+	PostProcessPlan PlanFused(const PostProcessSettings& settings);
+	PostProcessPlan PlanSeparate(const PostProcessSettings& settings);
+
+	const char* PathName(PostProcessPath path);
+}
@@ -0,0 +1,338 @@
+#include "Profiler.h"
+
+#if PROFILER_ENABLED
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+
+namespace Profiler
+{
+	thread_local ThreadBuffer* threadBuffer = nullptr;
+}
+
+namespace
+{
+	// Leaves this much of a ring alone while gathering, so a thread
+	// still writing can't land on an event mid-copy
+	const uint64_t GatherSlack = 64;
+
+	// Every buffer ever made; threads that exit hand theirs back
+	// for the next new thread rather than freeing it
+	struct Registry {
+		std::mutex mutex;
+		std::vector<Profiler::ThreadBuffer*> buffers;
+		std::vector<Profiler::ThreadBuffer*> unused;
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	// Gives the buffer back when its thread ends
+	struct ThreadBufferOwner {
+		Profiler::ThreadBuffer* buffer = nullptr;
+		~ThreadBufferOwner()
+		{
+			if (!buffer)
+				return;
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.unused.push_back(buffer);
+			Profiler::threadBuffer = nullptr;
+		}
+	};
+	thread_local ThreadBufferOwner threadBufferOwner;
+
+	// Ticks to time, measured against the steady clock as we go
+	const uint64_t startTicks = Profiler::Now();
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	double ticksPerMs = 1000000.0;
+
+	// Frames (main thread only)
+	uint64_t frameIndex = 0;
+	uint64_t frameStart = 0;
+	bool gatheredStartup = false;
+	Profiler::Frame startupFrame = {};
+	Profiler::Frame lastFrame = {};
+	bool paused = false;
+	Profiler::Stats stats = {};
+
+	// Trace capture
+	std::string capturePath;
+	int captureRemaining = 0;
+	std::vector<Profiler::Frame> capturedFrames;
+	std::string lastTraceResult;
+
+	// Interned names
+	std::mutex internMutex;
+	std::unordered_set<std::string> internedNames;
+
+	void Calibrate()
+	{
+#if PROFILER_RDTSC
+		double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+		if (elapsedMs > 1.0)
+			ticksPerMs = (double)(Profiler::Now() - startTicks) / elapsedMs;
+#endif
+	}
+
+	// --------------------------------------------------------
+	// Moves whatever each thread finished since the last call
+	// into the frame. A thread that got more than a ring ahead
+	// loses its oldest events, which are counted as dropped.
+	// --------------------------------------------------------
+	void Gather(Profiler::Frame& frame)
+	{
+		using Profiler::ThreadBuffer;
+
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (ThreadBuffer* buffer : registry.buffers)
+		{
+			uint64_t written = buffer->written.load(std::memory_order_acquire);
+			uint64_t first = buffer->gathered;
+			if (written - first > ThreadBuffer::Capacity - GatherSlack)
+			{
+				uint64_t kept = written - (ThreadBuffer::Capacity - GatherSlack);
+				stats.droppedEvents += kept - first;
+				first = kept;
+			}
+			buffer->gathered = written;
+			if (first == written)
+				continue;
+
+			Profiler::ThreadFrame thread;
+			thread.id = buffer->id;
+			thread.name = buffer->name;
+			thread.events.reserve((size_t)(written - first));
+			for (uint64_t i = first; i < written; i++)
+				thread.events.push_back(buffer->events[i & (ThreadBuffer::Capacity - 1)]);
+			frame.threads.push_back(std::move(thread));
+		}
+		stats.threads = (int)registry.buffers.size();
+
+		// Main thread first, then in the order threads showed up
+		std::sort(frame.threads.begin(), frame.threads.end(),
+			[](const Profiler::ThreadFrame& a, const Profiler::ThreadFrame& b) { return a.id < b.id; });
+	}
+
+	void WriteEscaped(std::ofstream& out, const char* text)
+	{
+		for (const char* c = text; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				out << '\\';
+			if ((unsigned char)*c >= 0x20)
+				out << *c;
+		}
+	}
+
+	double TicksToTraceMicroseconds(uint64_t ticks)
+	{
+		return ticks < startTicks ? 0.0 : Profiler::TicksToMs(ticks - startTicks) * 1000.0;
+	}
+
+	// --------------------------------------------------------
+	// Chrome's trace event format: one complete ("X") event per
+	// scope, an instant marker at each frame start and a name
+	// for every thread
+	// --------------------------------------------------------
+	bool WriteTrace(const std::string& path, const std::vector<Profiler::Frame>& frames)
+	{
+		std::ofstream out(path);
+		if (!out)
+			return false;
+
+		char number[64];
+		std::map<unsigned int, std::string> threadNames;
+		bool first = true;
+		auto separator = [&]() {
+			if (!first)
+				out << ",\n";
+			first = false;
+		};
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		for (const Profiler::Frame& frame : frames)
+		{
+			separator();
+			snprintf(number, sizeof(number), "%.3f", TicksToTraceMicroseconds(frame.start));
+			out << "{\"name\":\"Frame " << frame.index << "\",\"ph\":\"i\",\"s\":\"g\",\"ts\":" << number << ",\"pid\":0,\"tid\":0}";
+
+			for (const Profiler::ThreadFrame& thread : frame.threads)
+			{
+				threadNames[thread.id] = thread.name;
+				for (const Profiler::Event& e : thread.events)
+				{
+					separator();
+					out << "{\"name\":\"";
+					WriteEscaped(out, e.name);
+					snprintf(number, sizeof(number), "%.3f", TicksToTraceMicroseconds(e.start));
+					out << "\",\"ph\":\"X\",\"ts\":" << number;
+					snprintf(number, sizeof(number), "%.3f", Profiler::TicksToMs(e.end - e.start) * 1000.0);
+					out << ",\"dur\":" << number << ",\"pid\":0,\"tid\":" << thread.id << "}";
+				}
+			}
+		}
+
+		for (auto& thread : threadNames)
+		{
+			separator();
+			out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread.first << ",\"args\":{\"name\":\"";
+			WriteEscaped(out, thread.second.c_str());
+			out << "\"}}";
+		}
+		out << "\n]}\n";
+		return (bool)out;
+	}
+}
+
+Profiler::ThreadBuffer* Profiler::AcquireThreadBuffer()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	ThreadBuffer* buffer = 0;
+	if (!registry.unused.empty())
+	{
+		// Whatever the last owner left ungathered still gets picked up
+		buffer = registry.unused.back();
+		registry.unused.pop_back();
+	}
+	else
+	{
+		buffer = new ThreadBuffer();
+		buffer->written = 0;
+		buffer->gathered = 0;
+		buffer->id = (unsigned int)registry.buffers.size();
+		registry.buffers.push_back(buffer);
+	}
+	buffer->depth = 0;
+	snprintf(buffer->name, sizeof(buffer->name), "Thread %u", buffer->id);
+
+	threadBuffer = buffer;
+	threadBufferOwner.buffer = buffer;
+	return buffer;
+}
+
+double Profiler::TicksToMs(uint64_t ticks)
+{
+	return (double)ticks / ticksPerMs;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+	snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+}
+
+const char* Profiler::Intern(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(internMutex);
+	return internedNames.insert(name).first->c_str();
+}
+
+void Profiler::BeginFrame()
+{
+	// Anything recorded before the first frame is startup work
+	if (!gatheredStartup)
+	{
+		Calibrate();
+		Gather(startupFrame);
+		startupFrame.start = Now();
+		for (auto& thread : startupFrame.threads)
+			for (auto& e : thread.events)
+				startupFrame.start = std::min(startupFrame.start, e.start);
+		startupFrame.end = Now();
+		gatheredStartup = true;
+	}
+
+	frameStart = Now();
+}
+
+void Profiler::EndFrame()
+{
+	uint64_t frameEnd = Now();
+	Calibrate();
+
+	Frame frame;
+	frame.index = frameIndex++;
+	frame.start = frameStart;
+	frame.end = frameEnd;
+	Gather(frame);
+
+	stats.eventsLastFrame = 0;
+	for (auto& thread : frame.threads)
+		stats.eventsLastFrame += (int)thread.events.size();
+
+	if (captureRemaining > 0)
+	{
+		capturedFrames.push_back(frame);
+		if (--captureRemaining == 0)
+		{
+			bool written = WriteTrace(capturePath, capturedFrames);
+			lastTraceResult = (written ? "Wrote " : "Couldn't write ") + capturePath;
+			capturedFrames.clear();
+		}
+	}
+
+	if (!paused)
+		lastFrame = std::move(frame);
+
+	stats.gatherMs = TicksToMs(Now() - frameEnd);
+}
+
+const Profiler::Frame& Profiler::GetLastFrame()
+{
+	return lastFrame;
+}
+
+void Profiler::SetPaused(bool _paused)
+{
+	paused = _paused;
+}
+
+bool Profiler::IsPaused()
+{
+	return paused;
+}
+
+void Profiler::CaptureTrace(const std::string& path, int frameCount)
+{
+	capturePath = path;
+	captureRemaining = std::max(frameCount, 1);
+	capturedFrames.clear();
+	lastTraceResult = "Capturing...";
+}
+
+bool Profiler::IsCapturing()
+{
+	return captureRemaining > 0;
+}
+
+const std::string& Profiler::GetLastTraceResult()
+{
+	return lastTraceResult;
+}
+
+bool Profiler::WriteStartupTrace(const std::string& path)
+{
+	bool written = WriteTrace(path, std::vector<Frame>{ startupFrame });
+	lastTraceResult = (written ? "Wrote " : "Couldn't write ") + path;
+	return written;
+}
+
+Profiler::Stats Profiler::GetStats()
+{
+	return stats;
+}
+
+#endif
@@ -0,0 +1,187 @@
+#pragma once
+
+// --------------------------------------------------------
+// Hierarchical CPU profiler
+//
+// PROFILE_SCOPE("Name") times the enclosing block and
+// records it into a ring buffer owned by the calling thread,
+// so instrumented code never takes a lock. Once a frame the
+// main thread gathers every thread's new scopes into a frame
+// the UI can draw as a flame graph, and a few frames at a
+// time can be written out as a Chrome trace (chrome://tracing
+// or ui.perfetto.dev).
+//
+// Defining PROFILER_DISABLED turns every macro below into
+// nothing and compiles the profiler itself out.
+// --------------------------------------------------------
+
+#if defined(PROFILER_DISABLED)
+#define PROFILER_ENABLED 0
+#else
+#define PROFILER_ENABLED 1
+#endif
+
+#if PROFILER_ENABLED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_RDTSC 1
+#else
+#define PROFILER_RDTSC 0
+#endif
+
+namespace Profiler
+{
+	// One finished scope, in ticks (see TicksToMs)
+	struct Event {
+		const char* name;	// Literal or Intern()ed, never freed
+		uint64_t start;
+		uint64_t end;
+		int depth;			// Scopes open around it on its thread
+	};
+
+	// Everything one thread finished during a frame, oldest first
+	struct ThreadFrame {
+		unsigned int id;	// Small, stable per thread
+		std::string name;
+		std::vector<Event> events;
+	};
+
+	struct Frame {
+		uint64_t index;
+		uint64_t start;
+		uint64_t end;
+		std::vector<ThreadFrame> threads;
+	};
+
+	struct Stats {
+		int threads;				// Threads that have recorded anything
+		int eventsLastFrame;
+		uint64_t droppedEvents;		// Overwritten before they were gathered
+		double gatherMs;			// Cost of the last EndFrame()
+	};
+
+	// Per-thread storage; Scope is the only writer
+	struct ThreadBuffer {
+		static const unsigned int Capacity = 8192;	// Power of two
+		Event events[Capacity];
+		std::atomic<uint64_t> written;	// Total ever, wraps around the array
+		uint64_t gathered;				// Read up to here by the main thread
+		int depth;
+		unsigned int id;
+		char name[32];
+	};
+
+	// Ticks are the TSC where there is one, nanoseconds otherwise
+	inline uint64_t Now()
+	{
+#if PROFILER_RDTSC
+		return __rdtsc();
+#else
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	// The calling thread's buffer, made on its first scope
+	extern thread_local ThreadBuffer* threadBuffer;
+	ThreadBuffer* AcquireThreadBuffer();
+	inline ThreadBuffer* GetThreadBuffer()
+	{
+		return threadBuffer ? threadBuffer : AcquireThreadBuffer();
+	}
+
+	double TicksToMs(uint64_t ticks);
+
+	// Names the calling thread in the flame graph and traces
+	void SetThreadName(const char* name);
+
+	// Stable copy of a name that isn't a literal (render graph
+	// passes, systems); costs a lookup, so keep it off hot loops
+	const char* Intern(const std::string& name);
+
+	// Brackets one frame on the main thread; EndFrame() gathers
+	// everything recorded since the last one
+	void BeginFrame();
+	void EndFrame();
+
+	// The last gathered frame, held while paused
+	const Frame& GetLastFrame();
+	void SetPaused(bool paused);
+	bool IsPaused();
+
+	// Writes the next frameCount frames to path once they're done
+	void CaptureTrace(const std::string& path, int frameCount);
+	bool IsCapturing();
+	const std::string& GetLastTraceResult();
+
+	// Everything recorded before the first frame (asset loading)
+	bool WriteStartupTrace(const std::string& path);
+
+	Stats GetStats();
+
+	// --------------------------------------------------------
+	// Times its own lifetime; use through PROFILE_SCOPE
+	// --------------------------------------------------------
+	class Scope
+	{
+	public:
+		Scope(const char* name) :
+			name(name),
+			buffer(GetThreadBuffer())
+		{
+			depth = buffer->depth++;
+			start = Now();
+		}
+
+		~Scope()
+		{
+			uint64_t end = Now();
+			buffer->depth--;
+
+			// Only this thread writes, so relaxed is enough to find the slot;
+			// the release publishes the event to the gathering thread
+			uint64_t index = buffer->written.load(std::memory_order_relaxed);
+			buffer->events[index & (ThreadBuffer::Capacity - 1)] = { name, start, end, depth };
+			buffer->written.store(index + 1, std::memory_order_release);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		const char* name;
+		ThreadBuffer* buffer;
+		uint64_t start;
+		int depth;
+	};
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_SCOPE_DYNAMIC(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(Profiler::Intern(name))
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#define PROFILE_BEGIN_FRAME() Profiler::BeginFrame()
+#define PROFILE_END_FRAME() Profiler::EndFrame()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_SCOPE_DYNAMIC(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD(name)
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+
+#endif
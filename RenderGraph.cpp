@@ -0,0 +1,250 @@
+#include "RenderGraph.h"
+
+RenderGraph::RenderGraph() :
+	stats(),
+	frameArena(0)
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+}
+
+void RenderGraph::SetFrameArena(FrameArena* arena)
+{
+	frameArena = arena;
+}
+
+void RenderGraph::Reset()
+{
+	textures.clear();
+	passes.clear();
+	culled.clear();
+	executionOrder.clear();
+	physicalTextures.clear();
+	error.clear();
+	stats = {};
+}
+
+RGHandle RenderGraph::CreateTexture(const char* name, RGTextureDesc desc)
+{
+	textures.push_back({ name, desc, false, -1, -1, -1 });
+	return (RGHandle)textures.size() - 1;
+}
+
+RGHandle RenderGraph::ImportTexture(const char* name, RGTextureDesc desc)
+{
+	textures.push_back({ name, desc, true, -1, -1, -1 });
+	return (RGHandle)textures.size() - 1;
+}
+
+RenderGraphPass RenderGraph::CreatePass(const char* name)
+{
+	// Built with the allocator in place; assigning a vector later wouldn't carry it over
+	FrameAllocator<RGHandle> allocator(frameArena);
+	return RenderGraphPass{ name, FrameVector<RGHandle>(allocator), FrameVector<RGHandle>(allocator) };
+}
+
+int RenderGraph::AddPass(RenderGraphPass pass)
+{
+	passes.push_back(std::move(pass));
+	return (int)passes.size() - 1;
+}
+
+bool RenderGraph::Compile()
+{
+	error.clear();
+	executionOrder.clear();
+	physicalTextures.clear();
+	stats = {};
+	stats.passes = (int)passes.size();
+
+	// Every handle has to exist, and a transient has to be written before it's read
+	FrameAllocator<int> scratch(frameArena);
+	FrameVector<bool> written(textures.size(), false, scratch);
+	for (auto& p : passes)
+	{
+		for (RGHandle h : p.reads)
+		{
+			if (h < 0 || h >= (int)textures.size())
+			{
+				error = std::string("Pass '") + p.name + "' reads an unknown texture";
+				return false;
+			}
+			if (!textures[h].imported && !written[h])
+			{
+				error = std::string("Pass '") + p.name + "' reads '" + textures[h].name + "' before anything writes it";
+				return false;
+			}
+		}
+		for (RGHandle h : p.writes)
+		{
+			if (h < 0 || h >= (int)textures.size())
+			{
+				error = std::string("Pass '") + p.name + "' writes an unknown texture";
+				return false;
+			}
+			for (RGHandle r : p.reads)
+			{
+				if (r == h)
+				{
+					error = std::string("Pass '") + p.name + "' reads and writes '" + textures[h].name + "'";
+					return false;
+				}
+			}
+			written[h] = true;
+		}
+	}
+
+	// Cull backwards: a pass survives if it writes something
+	// imported, or something a surviving later pass reads
+	culled.assign(passes.size(), true);
+	FrameVector<bool> needed(textures.size(), false, scratch);
+	for (size_t i = 0; i < textures.size(); i++)
+		needed[i] = textures[i].imported;
+
+	for (int i = (int)passes.size() - 1; i >= 0; i--)
+	{
+		bool used = false;
+		for (RGHandle h : passes[i].writes)
+			if (needed[h]) used = true;
+		if (!used)
+			continue;
+
+		culled[i] = false;
+		for (RGHandle h : passes[i].reads)
+			needed[h] = true;
+	}
+
+	for (int i = 0; i < (int)passes.size(); i++)
+	{
+		if (culled[i]) stats.culledPasses++;
+		else executionOrder.push_back(i);
+	}
+
+	// Lifetimes over the surviving passes
+	for (auto& t : textures)
+	{
+		t.firstUse = -1;
+		t.lastUse = -1;
+		t.physicalIndex = -1;
+	}
+	for (int order = 0; order < (int)executionOrder.size(); order++)
+	{
+		const RenderGraphPass& p = passes[executionOrder[order]];
+		auto touch = [&](RGHandle h) {
+			if (textures[h].firstUse < 0) textures[h].firstUse = order;
+			textures[h].lastUse = order;
+		};
+		for (RGHandle h : p.reads) touch(h);
+		for (RGHandle h : p.writes) touch(h);
+	}
+
+	// Alias: hand out physical textures as transients come alive,
+	// and take them back only after their last pass has run
+	FrameVector<int> freeUntil(scratch); // Last pass position using each physical texture
+	for (int order = 0; order < (int)executionOrder.size(); order++)
+	{
+		for (auto& t : textures)
+		{
+			if (t.imported || t.firstUse != order)
+				continue;
+
+			stats.transientTextures++;
+			stats.transientBytes += t.desc.width * t.desc.height * BytesPerPixel(t.desc.format);
+
+			// Reuse a matching texture nobody needs anymore
+			for (int p = 0; p < (int)physicalTextures.size(); p++)
+			{
+				const RGTextureDesc& d = physicalTextures[p];
+				if (freeUntil[p] < order &&
+					d.width == t.desc.width && d.height == t.desc.height && d.format == t.desc.format)
+				{
+					t.physicalIndex = p;
+					break;
+				}
+			}
+
+			if (t.physicalIndex < 0)
+			{
+				physicalTextures.push_back(t.desc);
+				freeUntil.push_back(-1);
+				t.physicalIndex = (int)physicalTextures.size() - 1;
+				stats.physicalBytes += t.desc.width * t.desc.height * BytesPerPixel(t.desc.format);
+			}
+			freeUntil[t.physicalIndex] = t.lastUse;
+		}
+	}
+	stats.physicalTextures = (int)physicalTextures.size();
+
+	return true;
+}
+
+const std::string& RenderGraph::GetError()
+{
+	return error;
+}
+
+const std::vector<int>& RenderGraph::GetExecutionOrder()
+{
+	return executionOrder;
+}
+
+const RenderGraphPass& RenderGraph::GetPass(int index)
+{
+	return passes[index];
+}
+
+bool RenderGraph::IsPassCulled(int index)
+{
+	return culled[index];
+}
+
+bool RenderGraph::IsImported(RGHandle handle)
+{
+	return textures[handle].imported;
+}
+
+int RenderGraph::GetPhysicalIndex(RGHandle handle)
+{
+	return textures[handle].physicalIndex;
+}
+
+const std::vector<RGTextureDesc>& RenderGraph::GetPhysicalTextures()
+{
+	return physicalTextures;
+}
+
+RGTextureDesc RenderGraph::GetDesc(RGHandle handle)
+{
+	return textures[handle].desc;
+}
+
+const char* RenderGraph::GetName(RGHandle handle)
+{
+	return textures[handle].name;
+}
+
+int RenderGraph::GetFirstUse(RGHandle handle)
+{
+	return textures[handle].firstUse;
+}
+
+int RenderGraph::GetLastUse(RGHandle handle)
+{
+	return textures[handle].lastUse;
+}
+
+RenderGraphStats RenderGraph::GetStats()
+{
+	return stats;
+}
+
+size_t RenderGraph::BytesPerPixel(RGFormat format)
+{
+	switch (format)
+	{
+	case RGFormat::RGBA16_FLOAT: return 8;
+	default: return 4;
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include "FrameArena.h"
+
+// Index of a texture declared in the graph
+typedef int RGHandle;
+
+enum class RGFormat {
+	RGBA8_UNORM,
+	RGBA16_FLOAT
+};
+
+struct RGTextureDesc {
+	int width;
+	int height;
+	RGFormat format;
+};
+
+// A pass reads textures as pixel shader resources (t0, t1, ...)
+// and writes textures as render targets (SV_TARGET0, 1, ...)
+//
+// Get one from RenderGraph::CreatePass() so reads and writes
+// come out of the frame arena. The name is a literal: it's
+// kept as is, and the profiler holds on to it.
+struct RenderGraphPass {
+	const char* name = "";
+	FrameVector<RGHandle> reads;
+	FrameVector<RGHandle> writes;
+	bool clearTargets = false;
+	float clearColor[4] = { 0, 0, 0, 1 };
+	bool useDepthBuffer = false;		// Also binds the main depth buffer
+	std::function<void()> execute;
+};
+
+// What Compile() worked out
+struct RenderGraphStats {
+	int passes;
+	int culledPasses;
+	int transientTextures;
+	int physicalTextures;			// After aliasing
+	size_t transientBytes;			// If every transient had its own texture
+	size_t physicalBytes;			// What's actually allocated
+};
+
+// --------------------------------------------------------
+// Declarative list of passes for a frame
+//
+// Compile() walks the passes and
+// - culls passes whose output is never used by anything
+//   that reaches an imported texture (the back buffer)
+// - finds the first and last use of every transient texture
+// - aliases transients with matching descriptions whose
+//   lifetimes don't overlap onto the same physical texture
+//
+// All of this is plain CPU work; RenderGraphExecutor does
+// the binding and drawing on the device.
+//
+// Nothing here touches the heap once the first few frames
+// have sized the member lists: they keep their capacity
+// across Reset(), and everything else is per frame scratch
+// from the FrameArena (when one is set).
+// --------------------------------------------------------
+class RenderGraph
+{
+public:
+	RenderGraph();
+	~RenderGraph();
+
+	// Per frame scratch for pass lists and Compile(); without one it all comes from the heap
+	void SetFrameArena(FrameArena* arena);
+
+	// Starts a new frame's declarations
+	void Reset();
+
+	// Texture names are literals, like pass names
+
+	// Textures owned by the graph, only valid between their first and last use
+	RGHandle CreateTexture(const char* name, RGTextureDesc desc);
+
+	// Textures owned by someone else (like the back buffer) - never culled or aliased
+	RGHandle ImportTexture(const char* name, RGTextureDesc desc);
+
+	// A pass whose lists allocate from the frame arena
+	RenderGraphPass CreatePass(const char* name);
+	int AddPass(RenderGraphPass pass);
+
+	// False (with GetError() set) when the graph is malformed
+	bool Compile();
+	const std::string& GetError();
+
+	// Results of Compile()
+	const std::vector<int>& GetExecutionOrder();		// Surviving pass indices in order
+	const RenderGraphPass& GetPass(int index);
+	bool IsPassCulled(int index);
+	bool IsImported(RGHandle handle);
+	int GetPhysicalIndex(RGHandle handle);				// -1 for imported textures
+	const std::vector<RGTextureDesc>& GetPhysicalTextures();
+	RGTextureDesc GetDesc(RGHandle handle);
+	const char* GetName(RGHandle handle);
+	int GetFirstUse(RGHandle handle);					// Position in the execution order, -1 if unused
+	int GetLastUse(RGHandle handle);
+	RenderGraphStats GetStats();
+
+	static size_t BytesPerPixel(RGFormat format);
+
+private:
+	struct Texture {
+		const char* name;
+		RGTextureDesc desc;
+		bool imported;
+		int firstUse;
+		int lastUse;
+		int physicalIndex;
+	};
+
+	std::vector<Texture> textures;
+	std::vector<RenderGraphPass> passes;
+	std::vector<bool> culled;
+	std::vector<int> executionOrder;
+	std::vector<RGTextureDesc> physicalTextures;
+	std::string error;
+	RenderGraphStats stats;
+	FrameArena* frameArena;
+};
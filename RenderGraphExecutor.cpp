@@ -0,0 +1,152 @@
+#include "RenderGraphExecutor.h"
+#include "Graphics.h"
+#include "Profiler.h"
+
+RenderGraphExecutor::RenderGraphExecutor()
+{
+}
+
+RenderGraphExecutor::~RenderGraphExecutor()
+{
+}
+
+void RenderGraphExecutor::BindImported(RGHandle handle, ID3D11RenderTargetView* rtv, ID3D11ShaderResourceView* srv)
+{
+	imported.push_back({ handle, rtv, srv });
+}
+
+void RenderGraphExecutor::ClearImported()
+{
+	imported.clear();
+}
+
+void RenderGraphExecutor::Execute(RenderGraph& graph)
+{
+	UpdatePool(graph);
+
+	for (int passIndex : graph.GetExecutionOrder())
+	{
+		const RenderGraphPass& pass = graph.GetPass(passIndex);
+		PROFILE_SCOPE(pass.name);
+
+		// Outputs
+		ID3D11RenderTargetView* rtvs[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+		int rtvCount = (int)pass.writes.size();
+		for (int i = 0; i < rtvCount; i++)
+		{
+			rtvs[i] = GetRTV(graph, pass.writes[i]);
+			if (pass.clearTargets)
+				Graphics::Context->ClearRenderTargetView(rtvs[i], pass.clearColor);
+		}
+		Graphics::Context->OMSetRenderTargets(rtvCount, rtvs, pass.useDepthBuffer ? Graphics::DepthBufferDSV.Get() : 0);
+
+		// Draw to the whole of the first output
+		if (rtvCount > 0)
+		{
+			RGTextureDesc desc = graph.GetDesc(pass.writes[0]);
+			D3D11_VIEWPORT viewport = {};
+			viewport.Width = (float)desc.width;
+			viewport.Height = (float)desc.height;
+			viewport.MaxDepth = 1.0f;
+			Graphics::Context->RSSetViewports(1, &viewport);
+		}
+
+		// Inputs
+		ID3D11ShaderResourceView* srvs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+		int srvCount = (int)pass.reads.size();
+		for (int i = 0; i < srvCount; i++)
+			srvs[i] = GetSRV(graph, pass.reads[i]);
+		if (srvCount > 0)
+			Graphics::Context->PSSetShaderResources(0, srvCount, srvs);
+
+		pass.execute();
+
+		// Unbind so these textures can be targets (or inputs) of later passes
+		ID3D11ShaderResourceView* nullSRVs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+		if (srvCount > 0)
+			Graphics::Context->PSSetShaderResources(0, srvCount, nullSRVs);
+		Graphics::Context->OMSetRenderTargets(0, 0, 0);
+	}
+
+	// Imported views only last for one execution
+	imported.clear();
+}
+
+void RenderGraphExecutor::ReleaseAll()
+{
+	pool.clear();
+}
+
+int RenderGraphExecutor::GetTextureCount()
+{
+	return (int)pool.size();
+}
+
+ID3D11ShaderResourceView* RenderGraphExecutor::GetSRV(int physicalIndex)
+{
+	return pool[physicalIndex].srv.Get();
+}
+
+RGTextureDesc RenderGraphExecutor::GetDesc(int physicalIndex)
+{
+	return pool[physicalIndex].desc;
+}
+
+// --------------------------------------------------------
+// Makes the pool match the graph's physical textures,
+// keeping any that already have the right description
+// --------------------------------------------------------
+void RenderGraphExecutor::UpdatePool(RenderGraph& graph)
+{
+	const std::vector<RGTextureDesc>& wanted = graph.GetPhysicalTextures();
+	pool.resize(wanted.size());
+
+	for (size_t i = 0; i < wanted.size(); i++)
+	{
+		PhysicalTexture& p = pool[i];
+		if (p.srv &&
+			p.desc.width == wanted[i].width &&
+			p.desc.height == wanted[i].height &&
+			p.desc.format == wanted[i].format)
+			continue;
+
+		p.desc = wanted[i];
+
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		textureDesc.Width = (unsigned int)p.desc.width;
+		textureDesc.Height = (unsigned int)p.desc.height;
+		textureDesc.ArraySize = 1;
+		textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+		textureDesc.Format = p.desc.format == RGFormat::RGBA16_FLOAT ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+		textureDesc.MipLevels = 1;
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.Usage = D3D11_USAGE_DEFAULT;
+
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+		Graphics::Device->CreateTexture2D(&textureDesc, 0, texture.GetAddressOf());
+		Graphics::Device->CreateRenderTargetView(texture.Get(), 0, p.rtv.ReleaseAndGetAddressOf());
+		Graphics::Device->CreateShaderResourceView(texture.Get(), 0, p.srv.ReleaseAndGetAddressOf());
+	}
+}
+
+ID3D11RenderTargetView* RenderGraphExecutor::GetRTV(RenderGraph& graph, RGHandle handle)
+{
+	if (graph.IsImported(handle))
+	{
+		for (auto& i : imported)
+			if (i.handle == handle) return i.rtv;
+		return 0;
+	}
+	return pool[graph.GetPhysicalIndex(handle)].rtv.Get();
+}
+
+ID3D11ShaderResourceView* RenderGraphExecutor::GetSRV(RenderGraph& graph, RGHandle handle)
+{
+	if (graph.IsImported(handle))
+	{
+		for (auto& i : imported)
+			if (i.handle == handle) return i.srv;
+		return 0;
+	}
+	return pool[graph.GetPhysicalIndex(handle)].srv.Get();
+}
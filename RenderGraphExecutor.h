@@ -0,0 +1,57 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <vector>
+#include "RenderGraph.h"
+
+// --------------------------------------------------------
+// Runs a compiled RenderGraph on the device
+//
+// - Keeps one texture per physical slot the graph asked
+//   for, recreating any whose description changed
+// - Binds each pass's render targets, inputs and viewport,
+//   clears if asked, runs the pass, then unbinds it all so
+//   the next pass can use those textures freely
+// --------------------------------------------------------
+class RenderGraphExecutor
+{
+public:
+	RenderGraphExecutor();
+	~RenderGraphExecutor();
+
+	// Views for an imported texture, valid for the next Execute()
+	void BindImported(RGHandle handle, ID3D11RenderTargetView* rtv, ID3D11ShaderResourceView* srv);
+
+	// Forgets imported views that were never executed (call as each frame's graph is built)
+	void ClearImported();
+
+	void Execute(RenderGraph& graph);
+
+	// Drops every pooled texture (they'll be recreated on demand)
+	void ReleaseAll();
+
+	// Pooled textures, for debug views
+	int GetTextureCount();
+	ID3D11ShaderResourceView* GetSRV(int physicalIndex);
+	RGTextureDesc GetDesc(int physicalIndex);
+
+private:
+	struct PhysicalTexture {
+		RGTextureDesc desc;
+		Microsoft::WRL::ComPtr<ID3D11RenderTargetView> rtv;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	};
+
+	struct ImportedViews {
+		RGHandle handle;
+		ID3D11RenderTargetView* rtv;
+		ID3D11ShaderResourceView* srv;
+	};
+
+	void UpdatePool(RenderGraph& graph);
+	ID3D11RenderTargetView* GetRTV(RenderGraph& graph, RGHandle handle);
+	ID3D11ShaderResourceView* GetSRV(RenderGraph& graph, RGHandle handle);
+
+	std::vector<PhysicalTexture> pool;
+	std::vector<ImportedViews> imported;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <DirectXMath.h>
+#include <chrono>
+#include <vector>
+#include "Components.h"
+#include "Lights.h"
+
+// The active camera as of one frame, interpolated like
+// everything else
+struct SnapshotCamera {
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+	DirectX::XMFLOAT3 position;
+	bool perspective;
+	float fieldOfView;
+	float orthographicWidth;
+	float nearClip;
+};
+
+// --------------------------------------------------------
+// Everything the renderer reads from one update, copied out
+// of the World and the camera so the next update can run
+// while this one is drawn
+//
+// The update stage fills it in and hands it over; from then
+// on only the renderer touches it (it fills in the lights'
+// shadowIndex as it hands out shadow atlas space).
+// Meshes and materials aren't copied: only the main thread
+// changes them, and never while an update is running.
+// --------------------------------------------------------
+struct RenderSnapshot {
+	unsigned long long frame;
+	float deltaTime;
+	float totalTime;
+
+	// When the frame's input was read, for measuring latency
+	std::chrono::high_resolution_clock::time_point inputTime;
+
+	SnapshotCamera camera;
+	std::vector<Renderable> renderables;
+	std::vector<Light> lights;
+};
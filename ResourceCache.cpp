@@ -0,0 +1,383 @@
+#include "ResourceCache.h"
+#include "Graphics.h"
+#include "MeshGeometry.h"
+#include "PathHelpers.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <d3dcompiler.h>
+#include <filesystem>
+
+namespace
+{
+	// Parses an OBJ and builds its tangents, without touching the device.
+	// False if the file can't be read or holds no triangles (empty, or
+	// caught half written), so nothing gets built from it.
+	bool LoadMeshGeometry(const std::string& path, std::vector<Vertex>& verts, std::vector<unsigned int>& indices)
+	{
+		if (!MeshGeometry::LoadObj(path.c_str(), verts, indices) || verts.empty() || indices.size() < 3)
+			return false;
+
+		MeshGeometry::CalculateTangents(verts.data(), (int)verts.size(), indices.data(), (int)indices.size());
+		return true;
+	}
+
+	// Bytes per 4x4 block for compressed formats, or per texel (negated) for the rest
+	int FormatSize(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_UNORM:
+		case DXGI_FORMAT_BC4_SNORM:
+			return 8;
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC5_SNORM:
+		case DXGI_FORMAT_BC6H_UF16:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return 16;
+		case DXGI_FORMAT_R8_UNORM:
+			return -1;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R32G32_FLOAT:
+			return -8;
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			return -16;
+		default:
+			return -4; // RGBA8 and friends
+		}
+	}
+}
+
+ResourceCache::ResourceCache()
+{
+}
+
+ResourceCache::~ResourceCache()
+{
+}
+
+MeshHandle ResourceCache::LoadMesh(const std::string& relativePath, const char* name)
+{
+	PROFILE_SCOPE("Load mesh");
+	std::string path = FixPath(relativePath);
+	std::string key = NormalizePath(path);
+	MeshHandle handle = meshes.Find(key);
+	if (handle.IsValid())
+		return handle;
+
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	if (!LoadMeshGeometry(path, verts, indices))
+		return {};
+
+	std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(verts.data(), indices.data(), (unsigned int)verts.size(), (unsigned int)indices.size(), name);
+
+	// GPU buffers plus the CPU copies kept for occlusion culling
+	size_t bytes =
+		(size_t)mesh->GetVertexCount() * sizeof(Vertex) +
+		(size_t)mesh->GetIndexCount() * sizeof(unsigned int) +
+		mesh->GetPositions().size() * sizeof(DirectX::XMFLOAT3) +
+		mesh->GetIndices().size() * sizeof(unsigned int);
+	return meshes.Add(key, mesh, bytes);
+}
+
+PixelShaderHandle ResourceCache::LoadPixelShader(const std::wstring& relativePath)
+{
+	std::wstring path = FixPath(relativePath);
+	std::string key = NormalizePath(WideToNarrow(path));
+	PixelShaderHandle handle = pixelShaders.Find(key);
+	if (handle.IsValid())
+		return handle;
+
+	// The ComPtr releases the blob once the shader exists
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	if (FAILED(D3DReadFileToBlob(path.c_str(), blob.GetAddressOf())))
+		return {};
+
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
+	Graphics::Device->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), 0, shader.GetAddressOf());
+	return AddPixelShader(WideToNarrow(path), shader, blob);
+}
+
+VertexShaderHandle ResourceCache::LoadVertexShader(const std::wstring& relativePath)
+{
+	std::wstring path = FixPath(relativePath);
+	std::string key = NormalizePath(WideToNarrow(path));
+	VertexShaderHandle handle = vertexShaders.Find(key);
+	if (handle.IsValid())
+		return handle;
+
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	if (FAILED(D3DReadFileToBlob(path.c_str(), blob.GetAddressOf())))
+		return {};
+
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
+	Graphics::Device->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), 0, shader.GetAddressOf());
+	return AddVertexShader(WideToNarrow(path), shader, blob);
+}
+
+TextureHandle ResourceCache::FindTexture(const std::string& fullPath)
+{
+	return textures.Find(NormalizePath(fullPath));
+}
+
+TextureHandle ResourceCache::AddTexture(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+{
+	std::string key = NormalizePath(fullPath);
+	TextureHandle handle = textures.Find(key);
+	if (handle.IsValid() || !srv)
+		return handle;
+
+	return textures.Add(key, srv, EstimateTextureBytes(srv.Get()));
+}
+
+PixelShaderHandle ResourceCache::AddPixelShader(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3D11PixelShader> shader, Microsoft::WRL::ComPtr<ID3DBlob> bytecode)
+{
+	std::string key = NormalizePath(fullPath);
+	PixelShaderHandle handle = pixelShaders.Find(key);
+	if (handle.IsValid() || !shader || !bytecode)
+		return handle;
+
+	// The blob itself isn't kept once the shader exists
+	return pixelShaders.Add(key, shader, bytecode->GetBufferSize());
+}
+
+VertexShaderHandle ResourceCache::AddVertexShader(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3D11VertexShader> shader, Microsoft::WRL::ComPtr<ID3DBlob> bytecode)
+{
+	std::string key = NormalizePath(fullPath);
+	VertexShaderHandle handle = vertexShaders.Find(key);
+	if (handle.IsValid() || !shader || !bytecode)
+		return handle;
+
+	// Bytecode stays around for input layouts, so it counts twice
+	handle = vertexShaders.Add(key, shader, bytecode->GetBufferSize() * 2);
+	if (vertexShaderBytecode.size() <= handle.index)
+		vertexShaderBytecode.resize(handle.index + 1);
+	vertexShaderBytecode[handle.index] = bytecode;
+	return handle;
+}
+
+bool ResourceCache::HasPixelShader(const std::string& fullPath)
+{
+	return pixelShaders.Peek(NormalizePath(fullPath)) != 0;
+}
+
+bool ResourceCache::HasVertexShader(const std::string& fullPath)
+{
+	return vertexShaders.Peek(NormalizePath(fullPath)) != 0;
+}
+
+std::shared_ptr<Mesh> ResourceCache::Get(MeshHandle handle)
+{
+	auto e = meshes.Resolve(handle);
+	return e ? e->resource : nullptr;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ResourceCache::Get(TextureHandle handle)
+{
+	auto e = textures.Resolve(handle);
+	return e ? e->resource : nullptr;
+}
+
+Microsoft::WRL::ComPtr<ID3D11PixelShader> ResourceCache::Get(PixelShaderHandle handle)
+{
+	auto e = pixelShaders.Resolve(handle);
+	return e ? e->resource : nullptr;
+}
+
+Microsoft::WRL::ComPtr<ID3D11VertexShader> ResourceCache::Get(VertexShaderHandle handle)
+{
+	auto e = vertexShaders.Resolve(handle);
+	return e ? e->resource : nullptr;
+}
+
+Microsoft::WRL::ComPtr<ID3DBlob> ResourceCache::GetBytecode(VertexShaderHandle handle)
+{
+	return vertexShaders.Resolve(handle) ? vertexShaderBytecode[handle.index] : nullptr;
+}
+
+void ResourceCache::Release(MeshHandle handle)
+{
+	meshes.Release(handle);
+}
+
+void ResourceCache::Release(TextureHandle handle)
+{
+	textures.Release(handle);
+}
+
+void ResourceCache::Release(PixelShaderHandle handle)
+{
+	pixelShaders.Release(handle);
+}
+
+void ResourceCache::Release(VertexShaderHandle handle)
+{
+	vertexShaders.Release(handle);
+	if (!vertexShaders.Resolve(handle) && handle.index < vertexShaderBytecode.size())
+		vertexShaderBytecode[handle.index].Reset();
+}
+
+int ResourceCache::GetRefCount(MeshHandle handle)
+{
+	auto e = meshes.Resolve(handle);
+	return e ? e->refCount : 0;
+}
+
+ResourceCacheStats ResourceCache::GetStats()
+{
+	ResourceCacheStats stats = {};
+	stats.meshes = meshes.stats;
+	stats.textures = textures.stats;
+	stats.pixelShaders = pixelShaders.stats;
+	stats.vertexShaders = vertexShaders.stats;
+	return stats;
+}
+
+// --------------------------------------------------------
+// Loads the file again into the existing Mesh object, so
+// entities pick up the new geometry without being told.
+// A file that fails to load (missing, locked, empty or cut
+// short mid-export) leaves the old mesh alone.
+// --------------------------------------------------------
+bool ResourceCache::ReloadMesh(const std::string& fullPath)
+{
+	auto e = meshes.Peek(NormalizePath(fullPath));
+	if (!e)
+		return false;
+
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	if (!LoadMeshGeometry(fullPath, verts, indices))
+		return false;
+
+	Mesh fresh(verts.data(), indices.data(), (unsigned int)verts.size(), (unsigned int)indices.size(), e->resource->GetName());
+
+	size_t bytes =
+		(size_t)fresh.GetVertexCount() * sizeof(Vertex) +
+		(size_t)fresh.GetIndexCount() * sizeof(unsigned int) +
+		fresh.GetPositions().size() * sizeof(DirectX::XMFLOAT3) +
+		fresh.GetIndices().size() * sizeof(unsigned int);
+	*e->resource = fresh;
+	meshes.Replace(*e, e->resource, bytes);
+	return true;
+}
+
+bool ResourceCache::ReplacePixelShader(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3DBlob> bytecode, ResourceSwap<ID3D11PixelShader>& swap)
+{
+	auto e = pixelShaders.Peek(NormalizePath(fullPath));
+	if (!e || !bytecode)
+		return false;
+
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
+	Graphics::Device->CreatePixelShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), 0, shader.GetAddressOf());
+	if (!shader)
+		return false;
+
+	swap.before = e->resource;
+	swap.after = shader;
+	pixelShaders.Replace(*e, shader, bytecode->GetBufferSize());
+	return true;
+}
+
+bool ResourceCache::ReplaceVertexShader(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3DBlob> bytecode, ResourceSwap<ID3D11VertexShader>& swap)
+{
+	auto e = vertexShaders.Peek(NormalizePath(fullPath));
+	if (!e || !bytecode)
+		return false;
+
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
+	Graphics::Device->CreateVertexShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), 0, shader.GetAddressOf());
+	if (!shader)
+		return false;
+
+	swap.before = e->resource;
+	swap.after = shader;
+	vertexShaders.Replace(*e, shader, bytecode->GetBufferSize() * 2);
+	vertexShaderBytecode[e - vertexShaders.entries.data()] = bytecode;
+	return true;
+}
+
+bool ResourceCache::ReplaceTexture(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ResourceSwap<ID3D11ShaderResourceView>& swap)
+{
+	auto e = textures.Peek(NormalizePath(fullPath));
+	if (!e || !srv)
+		return false;
+
+	swap.before = e->resource;
+	swap.after = srv;
+	textures.Replace(*e, srv, EstimateTextureBytes(srv.Get()));
+	return true;
+}
+
+bool ResourceCache::HasMesh(const std::string& fullPath)
+{
+	return meshes.Peek(NormalizePath(fullPath)) != 0;
+}
+
+bool ResourceCache::HasTexture(const std::string& fullPath)
+{
+	return textures.Peek(NormalizePath(fullPath)) != 0;
+}
+
+std::vector<std::string> ResourceCache::GetPixelShaderPaths()
+{
+	return pixelShaders.Keys();
+}
+
+std::vector<std::string> ResourceCache::GetVertexShaderPaths()
+{
+	return vertexShaders.Keys();
+}
+
+// --------------------------------------------------------
+// Folds "a/./b", "a/x/../b", mixed slashes and case (paths
+// aren't case sensitive on Windows) into one spelling
+// --------------------------------------------------------
+std::string ResourceCache::NormalizePath(const std::string& fullPath)
+{
+	std::string normalized = std::filesystem::path(fullPath).lexically_normal().generic_string();
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return normalized;
+}
+
+// --------------------------------------------------------
+// Size of every mip and array slice of a 2D texture
+// --------------------------------------------------------
+size_t ResourceCache::EstimateTextureBytes(ID3D11ShaderResourceView* srv)
+{
+	if (!srv)
+		return 0;
+
+	Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	srv->GetResource(resource.GetAddressOf());
+	if (!resource || FAILED(resource.As(&texture)))
+		return 0;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	texture->GetDesc(&desc);
+	int formatSize = FormatSize(desc.Format);
+
+	size_t bytes = 0;
+	for (UINT mip = 0; mip < desc.MipLevels; mip++)
+	{
+		size_t w = desc.Width >> mip;
+		size_t h = desc.Height >> mip;
+		if (w == 0) w = 1;
+		if (h == 0) h = 1;
+
+		if (formatSize > 0)
+			bytes += ((w + 3) / 4) * ((h + 3) / 4) * formatSize;
+		else
+			bytes += w * h * -formatSize;
+	}
+	return bytes * desc.ArraySize;
+}
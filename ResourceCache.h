@@ -0,0 +1,239 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Mesh.h"
+
+// --------------------------------------------------------
+// Typed reference to something in the ResourceCache
+//
+// The generation catches handles that outlived their
+// resource: once a slot is freed and reused, old handles
+// to it just stop resolving.
+// --------------------------------------------------------
+template <typename T>
+struct ResourceHandle {
+	unsigned int index = 0xFFFFFFFF;
+	unsigned int generation = 0;
+
+	bool IsValid() const { return index != 0xFFFFFFFF; }
+	bool operator==(const ResourceHandle& other) const { return index == other.index && generation == other.generation; }
+};
+
+typedef ResourceHandle<Mesh> MeshHandle;
+typedef ResourceHandle<ID3D11ShaderResourceView> TextureHandle;
+typedef ResourceHandle<ID3D11PixelShader> PixelShaderHandle;
+typedef ResourceHandle<ID3D11VertexShader> VertexShaderHandle;
+
+// The object a reload replaced and its replacement, so
+// anything still holding the old one can be pointed at the new
+template <typename T>
+struct ResourceSwap {
+	Microsoft::WRL::ComPtr<T> before;
+	Microsoft::WRL::ComPtr<T> after;
+};
+
+// Per resource class
+struct ResourceClassStats {
+	int count;			// Live resources
+	size_t bytes;		// Estimated memory, CPU and GPU copies together
+	int loads;			// Times something was actually loaded
+	int hits;			// Requests answered from the cache
+};
+
+struct ResourceCacheStats {
+	ResourceClassStats meshes;
+	ResourceClassStats textures;
+	ResourceClassStats pixelShaders;
+	ResourceClassStats vertexShaders;
+};
+
+// --------------------------------------------------------
+// One place to load meshes, textures and shaders from
+//
+// - Keyed on the normalized full path (FixPath, then case,
+//   slashes and ./.. folded), so a file is loaded once no
+//   matter how its path was spelled
+// - Every Load/Find that returns a handle adds a reference;
+//   Release() drops one and frees the entry at zero (anything
+//   still holding the shared_ptr/ComPtr keeps the object
+//   itself alive)
+// - Tracks an estimate of how much memory each class uses
+//
+// Textures are usually decoded elsewhere (TextureLoader), so
+// they're added here once created rather than loaded.
+// --------------------------------------------------------
+class ResourceCache
+{
+public:
+	ResourceCache();
+	~ResourceCache();
+	ResourceCache(const ResourceCache&) = delete;
+	ResourceCache& operator=(const ResourceCache&) = delete;
+
+	// Paths are relative to the executable, like FixPath()
+	MeshHandle LoadMesh(const std::string& relativePath, const char* name);
+	PixelShaderHandle LoadPixelShader(const std::wstring& relativePath);
+	VertexShaderHandle LoadVertexShader(const std::wstring& relativePath);
+
+	// Full paths, as the texture loader reports them
+	TextureHandle FindTexture(const std::string& fullPath);
+	TextureHandle AddTexture(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+
+	// Shaders created elsewhere (see ShaderLibrary), by full path.
+	// A path that's already loaded keeps what it has.
+	PixelShaderHandle AddPixelShader(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3D11PixelShader> shader, Microsoft::WRL::ComPtr<ID3DBlob> bytecode);
+	VertexShaderHandle AddVertexShader(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3D11VertexShader> shader, Microsoft::WRL::ComPtr<ID3DBlob> bytecode);
+	bool HasPixelShader(const std::string& fullPath);
+	bool HasVertexShader(const std::string& fullPath);
+
+	std::shared_ptr<Mesh> Get(MeshHandle handle);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Get(TextureHandle handle);
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> Get(PixelShaderHandle handle);
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> Get(VertexShaderHandle handle);
+
+	// Compiled code, for input layouts
+	Microsoft::WRL::ComPtr<ID3DBlob> GetBytecode(VertexShaderHandle handle);
+
+	void Release(MeshHandle handle);
+	void Release(TextureHandle handle);
+	void Release(PixelShaderHandle handle);
+	void Release(VertexShaderHandle handle);
+
+	int GetRefCount(MeshHandle handle);
+	ResourceCacheStats GetStats();
+
+	// Hot reloading (see HotReloader), by full path. Meshes are
+	// rebuilt in place, so every shared_ptr sees the new one;
+	// shaders and textures are new objects, and the swap says
+	// what to look for. All false if the path isn't loaded.
+	bool ReloadMesh(const std::string& fullPath);
+	bool ReplacePixelShader(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3DBlob> bytecode, ResourceSwap<ID3D11PixelShader>& swap);
+	bool ReplaceVertexShader(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3DBlob> bytecode, ResourceSwap<ID3D11VertexShader>& swap);
+	bool ReplaceTexture(const std::string& fullPath, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv, ResourceSwap<ID3D11ShaderResourceView>& swap);
+	bool HasMesh(const std::string& fullPath);
+	bool HasTexture(const std::string& fullPath);
+
+	// Normalized paths of every loaded shader (compiled .cso files)
+	std::vector<std::string> GetPixelShaderPaths();
+	std::vector<std::string> GetVertexShaderPaths();
+
+	static std::string NormalizePath(const std::string& fullPath);
+	static size_t EstimateTextureBytes(ID3D11ShaderResourceView* srv);
+
+private:
+	// Slots for one resource class, reused once freed
+	template <typename Handle, typename T>
+	struct Table {
+		struct Entry {
+			std::string key;
+			T resource;
+			size_t bytes;
+			int refCount;
+			unsigned int generation;
+		};
+
+		std::vector<Entry> entries;
+		std::vector<unsigned int> freeSlots;
+		std::unordered_map<std::string, unsigned int> lookup;
+		ResourceClassStats stats = {};
+
+		Handle Find(const std::string& key)
+		{
+			auto it = lookup.find(key);
+			if (it == lookup.end())
+				return {};
+
+			Entry& e = entries[it->second];
+			e.refCount++;
+			stats.hits++;
+			return { it->second, e.generation };
+		}
+
+		Handle Add(const std::string& key, T resource, size_t bytes)
+		{
+			unsigned int index;
+			if (!freeSlots.empty())
+			{
+				index = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			else
+			{
+				index = (unsigned int)entries.size();
+				entries.push_back({});
+			}
+
+			Entry& e = entries[index];
+			e.key = key;
+			e.resource = resource;
+			e.bytes = bytes;
+			e.refCount = 1;
+			lookup[key] = index;
+
+			stats.count++;
+			stats.bytes += bytes;
+			stats.loads++;
+			return { index, e.generation };
+		}
+
+		// Like Find(), without adding a reference
+		Entry* Peek(const std::string& key)
+		{
+			auto it = lookup.find(key);
+			return it == lookup.end() ? 0 : &entries[it->second];
+		}
+
+		// Swaps in a new version, keeping handles and references
+		void Replace(Entry& e, T resource, size_t bytes)
+		{
+			stats.bytes += bytes - e.bytes;
+			stats.loads++;
+			e.resource = resource;
+			e.bytes = bytes;
+		}
+
+		std::vector<std::string> Keys()
+		{
+			std::vector<std::string> keys;
+			for (auto& it : lookup)
+				keys.push_back(it.first);
+			return keys;
+		}
+
+		Entry* Resolve(Handle handle)
+		{
+			if (!handle.IsValid() || handle.index >= entries.size())
+				return 0;
+			Entry& e = entries[handle.index];
+			return e.refCount > 0 && e.generation == handle.generation ? &e : 0;
+		}
+
+		void Release(Handle handle)
+		{
+			Entry* e = Resolve(handle);
+			if (!e || --e->refCount > 0)
+				return;
+
+			// Last reference - free the slot for reuse
+			stats.count--;
+			stats.bytes -= e->bytes;
+			lookup.erase(e->key);
+			e->key.clear();
+			e->resource = T();
+			e->generation++;
+			freeSlots.push_back(handle.index);
+		}
+	};
+
+	Table<MeshHandle, std::shared_ptr<Mesh>> meshes;
+	Table<TextureHandle, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textures;
+	Table<PixelShaderHandle, Microsoft::WRL::ComPtr<ID3D11PixelShader>> pixelShaders;
+	Table<VertexShaderHandle, Microsoft::WRL::ComPtr<ID3D11VertexShader>> vertexShaders;
+
+	// Vertex shader bytecode, same indices as vertexShaders
+	std::vector<Microsoft::WRL::ComPtr<ID3DBlob>> vertexShaderBytecode;
+};
@@ -0,0 +1,683 @@
+#include "SceneFile.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	const float DegreesToRadians = 3.14159265f / 180.0f;
+
+	// Lights.h values, repeated so this file has no DirectX dependency
+	const int LightDirectional = 0;
+	const int LightPoint = 1;
+	const int LightSpot = 2;
+
+	uint32_t FourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+	}
+
+	struct BinaryHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t meshCount;
+		uint32_t materialCount;
+		uint32_t entityCount;
+		uint32_t lightCount;
+		uint32_t cameraCount;
+		uint32_t padding;
+	};
+
+	// Splits a line on whitespace, keeping "quoted strings" together
+	std::vector<std::string> Tokenize(const std::string& line)
+	{
+		std::vector<std::string> tokens;
+		std::string current;
+		bool quoted = false;
+		bool any = false;
+		for (char c : line)
+		{
+			if (c == '"')
+			{
+				quoted = !quoted;
+				any = true;
+			}
+			else if (!quoted && (c == ' ' || c == '\t' || c == '\r'))
+			{
+				if (any)
+					tokens.push_back(current);
+				current.clear();
+				any = false;
+			}
+			else if (!quoted && c == '#')
+				break;
+			else
+			{
+				current += c;
+				any = true;
+			}
+		}
+		if (any)
+			tokens.push_back(current);
+		return tokens;
+	}
+
+	// "1,2,3" -> floats; false if the count is wrong
+	bool ParseFloats(const std::string& value, float* out, int count)
+	{
+		const char* p = value.c_str();
+		for (int i = 0; i < count; i++)
+		{
+			char* end = 0;
+			out[i] = strtof(p, &end);
+			if (end == p)
+				return false;
+			p = end;
+			if (i < count - 1)
+			{
+				if (*p != ',')
+					return false;
+				p++;
+			}
+		}
+		return *p == 0;
+	}
+
+	// Shortest plain decimal that reads back as the same float.
+	// Angles pass a lower precision, so the degree/radian
+	// round trip doesn't show up as 30.000002.
+	std::string FormatFloats(const float* values, int count, int maxPrecision = 9)
+	{
+		std::string text;
+		char buffer[32];
+		for (int i = 0; i < count; i++)
+		{
+			snprintf(buffer, sizeof(buffer), "%.*g", maxPrecision, values[i]);
+			for (int precision = 1; precision < maxPrecision; precision++)
+			{
+				char shorter[32];
+				snprintf(shorter, sizeof(shorter), "%.*g", precision, values[i]);
+				if (strtof(shorter, 0) == values[i] && !strchr(shorter, 'e'))
+				{
+					strcpy(buffer, shorter);
+					break;
+				}
+			}
+			if (i > 0)
+				text += ",";
+			text += buffer;
+		}
+		return text;
+	}
+
+	// Names with spaces (or nothing at all) need quotes
+	std::string Quote(const char* text)
+	{
+		std::string s = text;
+		if (s.empty() || s.find_first_of(" \t#=") != std::string::npos)
+			return "\"" + s + "\"";
+		return s;
+	}
+
+	int FindByName(const std::vector<SceneMeshDesc>& meshes, const std::string& name)
+	{
+		for (size_t i = 0; i < meshes.size(); i++)
+			if (name == meshes[i].name) return (int)i;
+		return -1;
+	}
+
+	int FindByName(const std::vector<SceneMaterialDesc>& materials, const std::string& name)
+	{
+		for (size_t i = 0; i < materials.size(); i++)
+			if (name == materials[i].name) return (int)i;
+		return -1;
+	}
+
+	template <typename T>
+	bool WriteArray(std::ofstream& file, const std::vector<T>& items)
+	{
+		if (!items.empty())
+			file.write((const char*)items.data(), sizeof(T) * items.size());
+		return (bool)file;
+	}
+
+	// Fixed-size strings straight from a file may be missing their terminator
+	template <size_t Size>
+	void Terminate(char (&text)[Size])
+	{
+		text[Size - 1] = 0;
+	}
+
+	template <typename T>
+	bool ReadArray(std::ifstream& file, std::vector<T>& items, uint32_t count)
+	{
+		items.resize(count);
+		if (count > 0)
+			file.read((char*)items.data(), sizeof(T) * count);
+		return (bool)file;
+	}
+}
+
+void SceneFile::CopyString(char* dest, size_t size, const std::string& source)
+{
+	size_t length = source.size() < size - 1 ? source.size() : size - 1;
+	memset(dest, 0, size);
+	memcpy(dest, source.c_str(), length);
+}
+
+bool SceneFile::LoadText(const std::string& path, SceneDesc& scene, std::string* error)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		if (error) *error = "Couldn't open " + path;
+		return false;
+	}
+
+	std::stringstream text;
+	text << file.rdbuf();
+	return ParseText(text.str(), scene, error);
+}
+
+bool SceneFile::SaveText(const std::string& path, const SceneDesc& scene)
+{
+	std::ofstream file(path, std::ios::binary);
+	file << WriteText(scene);
+	return (bool)file;
+}
+
+// --------------------------------------------------------
+// One record per line: the keyword, any positional fields,
+// then key=value pairs. Anything after # is a comment.
+// --------------------------------------------------------
+bool SceneFile::ParseText(const std::string& text, SceneDesc& scene, std::string* error)
+{
+	scene = SceneDesc();
+	scene.settings.skyMesh = -1;
+
+	std::istringstream lines(text);
+	std::string line;
+	int lineNumber = 0;
+	auto fail = [&](const std::string& message) {
+		if (error) *error = "Line " + std::to_string(lineNumber) + ": " + message;
+		return false;
+	};
+
+	while (std::getline(lines, line))
+	{
+		lineNumber++;
+		std::vector<std::string> tokens = Tokenize(line);
+		if (tokens.empty())
+			continue;
+
+		// Split into positional fields and key=value pairs
+		const std::string& keyword = tokens[0];
+		std::vector<std::string> positional;
+		std::vector<std::pair<std::string, std::string>> fields;
+		for (size_t i = 1; i < tokens.size(); i++)
+		{
+			size_t equals = tokens[i].find('=');
+			if (equals == std::string::npos)
+				positional.push_back(tokens[i]);
+			else
+				fields.push_back({ tokens[i].substr(0, equals), tokens[i].substr(equals + 1) });
+		}
+
+		if (keyword == "ambient")
+		{
+			if (positional.size() != 3 ||
+				!ParseFloats(positional[0] + "," + positional[1] + "," + positional[2], scene.settings.ambientColor, 3))
+				return fail("ambient needs three numbers");
+		}
+		else if (keyword == "active_camera")
+		{
+			if (positional.size() != 1)
+				return fail("active_camera needs an index");
+			scene.settings.activeCamera = atoi(positional[0].c_str());
+		}
+		else if (keyword == "sky")
+		{
+			for (auto& f : fields)
+			{
+				if (f.first == "mesh")
+				{
+					scene.settings.skyMesh = FindByName(scene.meshes, f.second);
+					if (scene.settings.skyMesh < 0) return fail("unknown mesh " + f.second);
+				}
+				else if (f.first == "vs") CopyString(scene.settings.skyVertexShader, SCENE_NAME_SIZE, f.second);
+				else if (f.first == "ps") CopyString(scene.settings.skyPixelShader, SCENE_NAME_SIZE, f.second);
+				else if (f.first == "cubemap") CopyString(scene.settings.skyCubemap, SCENE_PATH_SIZE, f.second);
+				else if (f.first == "faces")
+				{
+					std::istringstream faces(f.second);
+					std::string face;
+					int count = 0;
+					while (std::getline(faces, face, ',') && count < 6)
+						CopyString(scene.settings.skyFaces[count++], SCENE_PATH_SIZE, face);
+					if (count != 6) return fail("sky needs six faces");
+				}
+				else return fail("unknown sky field " + f.first);
+			}
+		}
+		else if (keyword == "mesh")
+		{
+			if (positional.size() != 2)
+				return fail("mesh needs a name and a path");
+
+			SceneMeshDesc mesh = {};
+			CopyString(mesh.name, SCENE_NAME_SIZE, positional[0]);
+			CopyString(mesh.path, SCENE_PATH_SIZE, positional[1]);
+			scene.meshes.push_back(mesh);
+		}
+		else if (keyword == "material")
+		{
+			if (positional.size() != 1)
+				return fail("material needs a name");
+
+			SceneMaterialDesc material = {};
+			CopyString(material.name, SCENE_NAME_SIZE, positional[0]);
+			CopyString(material.vertexShader, SCENE_NAME_SIZE, "VertexShader.cso");
+			CopyString(material.pixelShader, SCENE_NAME_SIZE, "PixelShader.cso");
+			material.colorTint[0] = material.colorTint[1] = material.colorTint[2] = 1.0f;
+			material.uvScale[0] = material.uvScale[1] = 1.0f;
+
+			for (auto& f : fields)
+			{
+				bool ok = true;
+				if (f.first == "vs") CopyString(material.vertexShader, SCENE_NAME_SIZE, f.second);
+				else if (f.first == "ps") CopyString(material.pixelShader, SCENE_NAME_SIZE, f.second);
+				else if (f.first == "tint") ok = ParseFloats(f.second, material.colorTint, 3);
+				else if (f.first == "roughness") ok = ParseFloats(f.second, &material.roughness, 1);
+				else if (f.first == "uv_scale") ok = ParseFloats(f.second, material.uvScale, 2);
+				else if (f.first == "uv_offset") ok = ParseFloats(f.second, material.uvOffset, 2);
+				else if (f.first == "albedo") CopyString(material.textures[0], SCENE_PATH_SIZE, f.second);
+				else if (f.first == "normals") CopyString(material.textures[1], SCENE_PATH_SIZE, f.second);
+				else if (f.first == "roughness_map") CopyString(material.textures[2], SCENE_PATH_SIZE, f.second);
+				else if (f.first == "metalness_map") CopyString(material.textures[3], SCENE_PATH_SIZE, f.second);
+				else return fail("unknown material field " + f.first);
+				if (!ok) return fail("bad value for " + f.first);
+			}
+			scene.materials.push_back(material);
+		}
+		else if (keyword == "entity")
+		{
+			if (positional.size() < 2)
+				return fail("entity needs a mesh and a material");
+
+			SceneEntityDesc entity = {};
+			entity.mesh = FindByName(scene.meshes, positional[0]);
+			entity.material = FindByName(scene.materials, positional[1]);
+			if (entity.mesh < 0) return fail("unknown mesh " + positional[0]);
+			if (entity.material < 0) return fail("unknown material " + positional[1]);
+			entity.scale[0] = entity.scale[1] = entity.scale[2] = 1.0f;
+
+			// Bare words after the names are flags
+			for (size_t i = 2; i < positional.size(); i++)
+			{
+				if (positional[i] == "static") entity.flags |= SCENE_ENTITY_STATIC;
+				else if (positional[i] == "occluder") entity.flags |= SCENE_ENTITY_OCCLUDER;
+				else return fail("unknown entity flag " + positional[i]);
+			}
+
+			for (auto& f : fields)
+			{
+				bool ok = true;
+				if (f.first == "position") ok = ParseFloats(f.second, entity.position, 3);
+				else if (f.first == "rotation")
+				{
+					ok = ParseFloats(f.second, entity.rotation, 3);
+					for (float& r : entity.rotation) r *= DegreesToRadians;
+				}
+				else if (f.first == "scale") ok = ParseFloats(f.second, entity.scale, 3);
+				else if (f.first == "spin")
+				{
+					ok = ParseFloats(f.second, entity.spin, 3);
+					for (float& s : entity.spin) s *= DegreesToRadians;
+				}
+				else if (f.first == "sway") ok = ParseFloats(f.second, entity.sway, 3);
+				else if (f.first == "sway_speed") ok = ParseFloats(f.second, &entity.swaySpeed, 1);
+				else return fail("unknown entity field " + f.first);
+				if (!ok) return fail("bad value for " + f.first);
+			}
+			scene.entities.push_back(entity);
+		}
+		else if (keyword == "light")
+		{
+			if (positional.size() != 1)
+				return fail("light needs a type");
+
+			SceneLightDesc light = {};
+			if (positional[0] == "directional") light.type = LightDirectional;
+			else if (positional[0] == "point") light.type = LightPoint;
+			else if (positional[0] == "spot") light.type = LightSpot;
+			else return fail("unknown light type " + positional[0]);
+			light.color[0] = light.color[1] = light.color[2] = 1.0f;
+			light.intensity = 1.0f;
+			light.attachEntity = -1;
+
+			for (auto& f : fields)
+			{
+				bool ok = true;
+				if (f.first == "direction") ok = ParseFloats(f.second, light.direction, 3);
+				else if (f.first == "position") ok = ParseFloats(f.second, light.position, 3);
+				else if (f.first == "color") ok = ParseFloats(f.second, light.color, 3);
+				else if (f.first == "intensity") ok = ParseFloats(f.second, &light.intensity, 1);
+				else if (f.first == "range") ok = ParseFloats(f.second, &light.range, 1);
+				else if (f.first == "inner")
+				{
+					ok = ParseFloats(f.second, &light.spotInnerAngle, 1);
+					light.spotInnerAngle *= DegreesToRadians;
+				}
+				else if (f.first == "outer")
+				{
+					ok = ParseFloats(f.second, &light.spotOuterAngle, 1);
+					light.spotOuterAngle *= DegreesToRadians;
+				}
+				else if (f.first == "attach")
+				{
+					ok = !f.second.empty() && f.second.find_first_not_of("0123456789") == std::string::npos;
+					light.attachEntity = atoi(f.second.c_str());
+				}
+				else if (f.first == "offset") ok = ParseFloats(f.second, light.attachOffset, 3);
+				else return fail("unknown light field " + f.first);
+				if (!ok) return fail("bad value for " + f.first);
+			}
+			if ((int)scene.lights.size() >= MaxLights)
+				return fail("more than " + std::to_string(MaxLights) + " lights");
+			scene.lights.push_back(light);
+		}
+		else if (keyword == "camera")
+		{
+			if (positional.size() != 1)
+				return fail("camera needs a projection");
+
+			SceneCameraDesc camera = {};
+			if (positional[0] == "perspective") camera.projection = SCENE_CAMERA_PERSPECTIVE;
+			else if (positional[0] == "orthographic") camera.projection = SCENE_CAMERA_ORTHOGRAPHIC;
+			else return fail("unknown projection " + positional[0]);
+			camera.moveSpeed = 5.0f;
+			camera.lookSpeed = 0.002f;
+			camera.fieldOfView = 45.0f * DegreesToRadians;
+			camera.nearClip = 0.01f;
+			camera.farClip = 100.0f;
+			camera.orthoWidth = 10.0f;
+
+			for (auto& f : fields)
+			{
+				bool ok = true;
+				if (f.first == "position") ok = ParseFloats(f.second, camera.position, 3);
+				else if (f.first == "move_speed") ok = ParseFloats(f.second, &camera.moveSpeed, 1);
+				else if (f.first == "look_speed") ok = ParseFloats(f.second, &camera.lookSpeed, 1);
+				else if (f.first == "fov")
+				{
+					ok = ParseFloats(f.second, &camera.fieldOfView, 1);
+					camera.fieldOfView *= DegreesToRadians;
+				}
+				else if (f.first == "near") ok = ParseFloats(f.second, &camera.nearClip, 1);
+				else if (f.first == "far") ok = ParseFloats(f.second, &camera.farClip, 1);
+				else if (f.first == "width") ok = ParseFloats(f.second, &camera.orthoWidth, 1);
+				else return fail("unknown camera field " + f.first);
+				if (!ok) return fail("bad value for " + f.first);
+			}
+			scene.cameras.push_back(camera);
+		}
+		else
+			return fail("unknown keyword " + keyword);
+	}
+
+	if (scene.settings.activeCamera < 0 || scene.settings.activeCamera >= (int)scene.cameras.size())
+		scene.settings.activeCamera = 0;
+
+	// Entities can come after the lights, so attachments are checked last
+	for (auto& l : scene.lights)
+	{
+		if (l.attachEntity >= (int)scene.entities.size())
+		{
+			if (error) *error = "Light attached to missing entity " + std::to_string(l.attachEntity);
+			return false;
+		}
+	}
+	return true;
+}
+
+std::string SceneFile::WriteText(const SceneDesc& scene)
+{
+	std::ostringstream out;
+	const float RadiansToDegrees = 1.0f / DegreesToRadians;
+	auto degrees = [&](float radians) { float d = radians * RadiansToDegrees; return FormatFloats(&d, 1, 6); };
+
+	out << "ambient " << FormatFloats(&scene.settings.ambientColor[0], 1) << " "
+		<< FormatFloats(&scene.settings.ambientColor[1], 1) << " "
+		<< FormatFloats(&scene.settings.ambientColor[2], 1) << "\n";
+	out << "active_camera " << scene.settings.activeCamera << "\n\n";
+
+	for (auto& mesh : scene.meshes)
+		out << "mesh " << Quote(mesh.name) << " " << Quote(mesh.path) << "\n";
+	out << "\n";
+
+	if (scene.settings.skyMesh >= 0 && scene.settings.skyMesh < (int)scene.meshes.size())
+	{
+		const SceneSettings& s = scene.settings;
+		out << "sky mesh=" << Quote(scene.meshes[s.skyMesh].name) << " vs=" << Quote(s.skyVertexShader) << " ps=" << Quote(s.skyPixelShader)
+			<< " cubemap=" << Quote(s.skyCubemap) << " faces=" << s.skyFaces[0];
+		for (int i = 1; i < 6; i++)
+			out << "," << s.skyFaces[i];
+		out << "\n\n";
+	}
+
+	const char* textureKeys[4] = { "albedo", "normals", "roughness_map", "metalness_map" };
+	for (auto& m : scene.materials)
+	{
+		out << "material " << Quote(m.name) << " vs=" << Quote(m.vertexShader) << " ps=" << Quote(m.pixelShader)
+			<< " tint=" << FormatFloats(m.colorTint, 3) << " roughness=" << FormatFloats(&m.roughness, 1)
+			<< " uv_scale=" << FormatFloats(m.uvScale, 2) << " uv_offset=" << FormatFloats(m.uvOffset, 2);
+		for (int t = 0; t < 4; t++)
+			if (m.textures[t][0])
+				out << " " << textureKeys[t] << "=" << Quote(m.textures[t]);
+		out << "\n";
+	}
+	out << "\n";
+
+	for (auto& e : scene.entities)
+	{
+		float rotation[3] = { e.rotation[0] * RadiansToDegrees, e.rotation[1] * RadiansToDegrees, e.rotation[2] * RadiansToDegrees };
+		out << "entity " << Quote(scene.meshes[e.mesh].name) << " " << Quote(scene.materials[e.material].name)
+			<< " position=" << FormatFloats(e.position, 3) << " rotation=" << FormatFloats(rotation, 3, 6)
+			<< " scale=" << FormatFloats(e.scale, 3);
+		if (e.flags & SCENE_ENTITY_STATIC) out << " static";
+		if (e.flags & SCENE_ENTITY_OCCLUDER) out << " occluder";
+		if (e.spin[0] != 0 || e.spin[1] != 0 || e.spin[2] != 0)
+		{
+			float spin[3] = { e.spin[0] * RadiansToDegrees, e.spin[1] * RadiansToDegrees, e.spin[2] * RadiansToDegrees };
+			out << " spin=" << FormatFloats(spin, 3, 6);
+		}
+		if (e.sway[0] != 0 || e.sway[1] != 0 || e.sway[2] != 0)
+			out << " sway=" << FormatFloats(e.sway, 3) << " sway_speed=" << FormatFloats(&e.swaySpeed, 1);
+		out << "\n";
+	}
+	out << "\n";
+
+	const char* lightTypes[3] = { "directional", "point", "spot" };
+	for (auto& l : scene.lights)
+	{
+		out << "light " << lightTypes[l.type < 0 || l.type > 2 ? 0 : l.type]
+			<< " color=" << FormatFloats(l.color, 3) << " intensity=" << FormatFloats(&l.intensity, 1);
+		if (l.type != LightPoint) out << " direction=" << FormatFloats(l.direction, 3);
+		if (l.type != LightDirectional) out << " position=" << FormatFloats(l.position, 3) << " range=" << FormatFloats(&l.range, 1);
+		if (l.type == LightSpot) out << " inner=" << degrees(l.spotInnerAngle) << " outer=" << degrees(l.spotOuterAngle);
+		if (l.attachEntity >= 0) out << " attach=" << l.attachEntity << " offset=" << FormatFloats(l.attachOffset, 3);
+		out << "\n";
+	}
+	out << "\n";
+
+	for (auto& c : scene.cameras)
+	{
+		out << "camera " << (c.projection == SCENE_CAMERA_ORTHOGRAPHIC ? "orthographic" : "perspective")
+			<< " position=" << FormatFloats(c.position, 3) << " fov=" << degrees(c.fieldOfView)
+			<< " near=" << FormatFloats(&c.nearClip, 1) << " far=" << FormatFloats(&c.farClip, 1)
+			<< " move_speed=" << FormatFloats(&c.moveSpeed, 1) << " look_speed=" << FormatFloats(&c.lookSpeed, 1);
+		if (c.projection == SCENE_CAMERA_ORTHOGRAPHIC) out << " width=" << FormatFloats(&c.orthoWidth, 1);
+		out << "\n";
+	}
+
+	return out.str();
+}
+
+// --------------------------------------------------------
+// Header, settings, then each array as one block. Every
+// record is plain data, so loading is a resize and a read
+// per array - no parsing and no per-field allocations.
+// --------------------------------------------------------
+bool SceneFile::LoadBinary(const std::string& path, SceneDesc& scene, std::string* error)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		if (error) *error = "Couldn't open " + path;
+		return false;
+	}
+
+	BinaryHeader header = {};
+	file.read((char*)&header, sizeof(header));
+	if (!file || header.magic != FourCC('S', 'C', 'N', 'B') || header.version != Version)
+	{
+		if (error) *error = "Not a version " + std::to_string(Version) + " binary scene";
+		return false;
+	}
+
+	if (header.lightCount > (uint32_t)MaxLights)
+	{
+		if (error) *error = "Binary scene has " + std::to_string(header.lightCount) + " lights, more than " + std::to_string(MaxLights);
+		return false;
+	}
+
+	// The counts decide how much gets allocated, so they have to fit in the file first
+	std::streamoff start = file.tellg();
+	file.seekg(0, std::ios::end);
+	uint64_t remaining = (uint64_t)(file.tellg() - start);
+	file.seekg(start);
+	uint64_t expected = sizeof(SceneSettings) +
+		(uint64_t)header.meshCount * sizeof(SceneMeshDesc) +
+		(uint64_t)header.materialCount * sizeof(SceneMaterialDesc) +
+		(uint64_t)header.entityCount * sizeof(SceneEntityDesc) +
+		(uint64_t)header.lightCount * sizeof(SceneLightDesc) +
+		(uint64_t)header.cameraCount * sizeof(SceneCameraDesc);
+	if (expected > remaining)
+	{
+		if (error) *error = "Binary scene is truncated";
+		return false;
+	}
+
+	file.read((char*)&scene.settings, sizeof(SceneSettings));
+	bool ok = (bool)file &&
+		ReadArray(file, scene.meshes, header.meshCount) &&
+		ReadArray(file, scene.materials, header.materialCount) &&
+		ReadArray(file, scene.entities, header.entityCount) &&
+		ReadArray(file, scene.lights, header.lightCount) &&
+		ReadArray(file, scene.cameras, header.cameraCount);
+	if (!ok)
+	{
+		if (error) *error = "Binary scene is truncated";
+		return false;
+	}
+
+	Terminate(scene.settings.skyVertexShader);
+	Terminate(scene.settings.skyPixelShader);
+	Terminate(scene.settings.skyCubemap);
+	for (auto& face : scene.settings.skyFaces)
+		Terminate(face);
+	for (auto& m : scene.meshes)
+	{
+		Terminate(m.name);
+		Terminate(m.path);
+	}
+	for (auto& m : scene.materials)
+	{
+		Terminate(m.name);
+		Terminate(m.vertexShader);
+		Terminate(m.pixelShader);
+		for (auto& texture : m.textures)
+			Terminate(texture);
+	}
+
+	// Indices are trusted by the game, so check them once here
+	for (auto& e : scene.entities)
+	{
+		if (e.mesh < 0 || e.mesh >= (int)scene.meshes.size() || e.material < 0 || e.material >= (int)scene.materials.size())
+		{
+			if (error) *error = "Entity refers to a missing mesh or material";
+			return false;
+		}
+	}
+	for (auto& l : scene.lights)
+	{
+		if (l.attachEntity >= (int)scene.entities.size())
+		{
+			if (error) *error = "Light attached to a missing entity";
+			return false;
+		}
+	}
+	if (scene.settings.skyMesh >= (int)scene.meshes.size())
+		scene.settings.skyMesh = -1;
+	if (scene.settings.activeCamera < 0 || scene.settings.activeCamera >= (int)scene.cameras.size())
+		scene.settings.activeCamera = 0;
+	return true;
+}
+
+bool SceneFile::SaveBinary(const std::string& path, const SceneDesc& scene, uint64_t sourceHash)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	BinaryHeader header = {};
+	header.magic = FourCC('S', 'C', 'N', 'B');
+	header.version = Version;
+	header.sourceHash = sourceHash;
+	header.meshCount = (uint32_t)scene.meshes.size();
+	header.materialCount = (uint32_t)scene.materials.size();
+	header.entityCount = (uint32_t)scene.entities.size();
+	header.lightCount = (uint32_t)scene.lights.size();
+	header.cameraCount = (uint32_t)scene.cameras.size();
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)&scene.settings, sizeof(SceneSettings));
+	return WriteArray(file, scene.meshes) &&
+		WriteArray(file, scene.materials) &&
+		WriteArray(file, scene.entities) &&
+		WriteArray(file, scene.lights) &&
+		WriteArray(file, scene.cameras);
+}
+
+uint64_t SceneFile::HashFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return 0;
+
+	uint64_t hash = 14695981039346656037ull;
+	char buffer[4096];
+	while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+	{
+		for (std::streamsize i = 0; i < file.gcount(); i++)
+		{
+			hash ^= (unsigned char)buffer[i];
+			hash *= 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+uint64_t SceneFile::ReadBinarySourceHash(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	BinaryHeader header = {};
+	file.read((char*)&header, sizeof(header));
+	if (!file || header.magic != FourCC('S', 'C', 'N', 'B') || header.version != Version)
+		return 0;
+	return header.sourceHash;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Fixed-size strings keep every record plain old data, so the
+// binary form can be read straight into the arrays
+#define SCENE_NAME_SIZE 32
+#define SCENE_PATH_SIZE 64
+
+#define SCENE_ENTITY_STATIC 0x1
+#define SCENE_ENTITY_OCCLUDER 0x2
+
+#define SCENE_CAMERA_PERSPECTIVE 0
+#define SCENE_CAMERA_ORTHOGRAPHIC 1
+
+struct SceneSettings {
+	float ambientColor[3];
+	int activeCamera;
+	int skyMesh;									// Index into meshes
+	char skyVertexShader[SCENE_NAME_SIZE];
+	char skyPixelShader[SCENE_NAME_SIZE];
+	char skyCubemap[SCENE_PATH_SIZE];				// Cooked DDS, used when present
+	char skyFaces[6][SCENE_PATH_SIZE];				// +X, -X, +Y, -Y, +Z, -Z
+};
+
+struct SceneMeshDesc {
+	char name[SCENE_NAME_SIZE];
+	char path[SCENE_PATH_SIZE];						// Relative to the executable
+};
+
+struct SceneMaterialDesc {
+	char name[SCENE_NAME_SIZE];
+	char vertexShader[SCENE_NAME_SIZE];
+	char pixelShader[SCENE_NAME_SIZE];
+	float colorTint[3];
+	float roughness;
+	float uvScale[2];
+	float uvOffset[2];
+	char textures[4][SCENE_PATH_SIZE];				// Albedo, normals, roughness, metalness (in Assets/Textures)
+};
+
+struct SceneEntityDesc {
+	int mesh;										// Index into meshes
+	int material;									// Index into materials
+	float position[3];
+	float rotation[3];								// Pitch, yaw, roll in radians
+	float scale[3];
+	unsigned int flags;								// SCENE_ENTITY_ flags
+	float spin[3];									// Pitch, yaw, roll in radians per second
+	float sway[3];									// Swings this far either side of position...
+	float swaySpeed;								// ...at this many radians per second
+};
+
+struct SceneLightDesc {
+	int type;										// LIGHT_TYPE_ from Lights.h
+	float direction[3];
+	float position[3];
+	float color[3];
+	float intensity;
+	float range;
+	float spotInnerAngle;							// Radians
+	float spotOuterAngle;
+	int attachEntity;								// Index into entities, followed by the light (-1 for none)
+	float attachOffset[3];							// From the entity's position
+};
+
+struct SceneCameraDesc {
+	int projection;									// SCENE_CAMERA_ type
+	float position[3];
+	float moveSpeed;
+	float lookSpeed;
+	float fieldOfView;								// Radians
+	float nearClip;
+	float farClip;
+	float orthoWidth;
+};
+
+struct SceneDesc {
+	SceneSettings settings;
+	std::vector<SceneMeshDesc> meshes;
+	std::vector<SceneMaterialDesc> materials;
+	std::vector<SceneEntityDesc> entities;
+	std::vector<SceneLightDesc> lights;
+	std::vector<SceneCameraDesc> cameras;
+};
+
+// --------------------------------------------------------
+// Scene descriptions on disk, in two forms:
+//
+// - Text (.scene) for authoring: one line per mesh, material,
+//   entity, light or camera, with key=value fields; names can
+//   be quoted, angles are in degrees and entities refer to
+//   meshes and materials by name
+// - Binary (.sceneb) for shipping: a header with the counts,
+//   then each array exactly as it sits in memory, so loading
+//   is one read per array with nothing to parse
+//
+// The binary header keeps a hash of the text it came from,
+// so a stale binary can be spotted. No D3D in here; see
+// Tools/ConvertScene.cpp for the offline conversion.
+// --------------------------------------------------------
+namespace SceneFile
+{
+	// Bump whenever the binary layout changes
+	const unsigned int Version = 2;
+
+	// As many lights as PixelShaderExternalData has room for
+	const int MaxLights = 5;
+
+	bool LoadText(const std::string& path, SceneDesc& scene, std::string* error = 0);
+	bool SaveText(const std::string& path, const SceneDesc& scene);
+	bool ParseText(const std::string& text, SceneDesc& scene, std::string* error = 0);
+	std::string WriteText(const SceneDesc& scene);
+
+	bool LoadBinary(const std::string& path, SceneDesc& scene, std::string* error = 0);
+	bool SaveBinary(const std::string& path, const SceneDesc& scene, uint64_t sourceHash = 0);
+
+	// 64-bit FNV-1a of a file's bytes (0 if it can't be read)
+	uint64_t HashFile(const std::string& path);
+
+	// The source hash a binary was written with (0 if unreadable)
+	uint64_t ReadBinarySourceHash(const std::string& path);
+
+	// Fills a fixed-size name/path field, truncating if needed
+	void CopyString(char* dest, size_t size, const std::string& source);
+}
@@ -0,0 +1,205 @@
+#include "ShaderLibrary.h"
+#include "Graphics.h"
+#include "PathHelpers.h"
+#include "Profiler.h"
+#include <d3dcompiler.h>
+
+namespace
+{
+	long long MicrosecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// Pixel and vertex shaders are kept apart, just in case
+	std::string EntryKey(const std::string& fullPath, bool vertex)
+	{
+		return (vertex ? "vs:" : "ps:") + ResourceCache::NormalizePath(fullPath);
+	}
+}
+
+ShaderLibrary::ShaderLibrary(ResourceCache& cache, unsigned int threadCount) :
+	cache(cache),
+	threadCount(threadCount),
+	nextEntry(0),
+	remaining(0),
+	readMicroseconds(0),
+	createMicroseconds(0),
+	failed(0),
+	stats()
+{
+	if (this->threadCount == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		this->threadCount = hardwareThreads > 1 ? hardwareThreads / 2 : 1;
+	}
+	stats.threads = this->threadCount;
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+	WaitForAll();
+}
+
+// --------------------------------------------------------
+// Queues every shader not already loaded or queued, and
+// starts the loader threads on them
+// --------------------------------------------------------
+void ShaderLibrary::Preload(const std::vector<std::wstring>& pixelShaders, const std::vector<std::wstring>& vertexShaders)
+{
+	// The list can't change under running workers
+	WaitForAll();
+
+	int first = (int)entries.size();
+	auto queue = [&](const std::wstring& relativePath, bool vertex) {
+		std::string path = WideToNarrow(FixPath(relativePath));
+		std::string key = EntryKey(path, vertex);
+		bool loaded = vertex ? cache.HasVertexShader(path) : cache.HasPixelShader(path);
+		if (loaded || pending.count(key))
+		{
+			stats.duplicates++;
+			return;
+		}
+
+		Entry e = {};
+		e.path = path;
+		e.vertex = vertex;
+		pending[key] = (int)entries.size();
+		entries.push_back(e);
+	};
+	for (auto& path : pixelShaders)
+		queue(path, false);
+	for (auto& path : vertexShaders)
+		queue(path, true);
+
+	int count = (int)entries.size() - first;
+	if (count == 0)
+		return;
+
+	preloadStart = std::chrono::high_resolution_clock::now();
+	remaining = count;
+	nextEntry = first;
+	for (unsigned int i = 0; i < threadCount && (int)i < count; i++)
+		workers.push_back(std::thread(&ShaderLibrary::WorkerLoop, this));
+}
+
+PixelShaderHandle ShaderLibrary::LoadPixelShader(const std::wstring& relativePath)
+{
+	stats.requested++;
+	std::string path = WideToNarrow(FixPath(relativePath));
+	int index = WaitForEntry(EntryKey(path, false));
+	if (index < 0)
+	{
+		if (!cache.HasPixelShader(path))
+			stats.loadedOnMainThread++;
+		return cache.LoadPixelShader(relativePath);
+	}
+
+	// First request hands the shader to the cache; later
+	// ones are ordinary cache hits
+	Entry& e = entries[index];
+	PixelShaderHandle handle = cache.AddPixelShader(e.path, e.pixelShader, e.bytecode);
+	e.pixelShader.Reset();
+	e.bytecode.Reset();
+	return handle;
+}
+
+VertexShaderHandle ShaderLibrary::LoadVertexShader(const std::wstring& relativePath)
+{
+	stats.requested++;
+	std::string path = WideToNarrow(FixPath(relativePath));
+	int index = WaitForEntry(EntryKey(path, true));
+	if (index < 0)
+	{
+		if (!cache.HasVertexShader(path))
+			stats.loadedOnMainThread++;
+		return cache.LoadVertexShader(relativePath);
+	}
+
+	Entry& e = entries[index];
+	VertexShaderHandle handle = cache.AddVertexShader(e.path, e.vertexShader, e.bytecode);
+	e.vertexShader.Reset();
+	e.bytecode.Reset();
+	return handle;
+}
+
+void ShaderLibrary::WaitForAll()
+{
+	for (auto& worker : workers)
+		worker.join();
+	workers.clear();
+}
+
+ShaderLibraryStats ShaderLibrary::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	ShaderLibraryStats s = stats;
+	s.failed = failed;
+	s.readMs = readMicroseconds / 1000.0;
+	s.createMs = createMicroseconds / 1000.0;
+	return s;
+}
+
+// --------------------------------------------------------
+// Index of a preloaded shader not yet handed out, once it's
+// finished (-1 if there isn't one)
+// --------------------------------------------------------
+int ShaderLibrary::WaitForEntry(const std::string& key)
+{
+	auto it = pending.find(key);
+	if (it == pending.end())
+		return -1;
+
+	int index = it->second;
+	pending.erase(it);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (!entries[index].finished)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		entryFinished.wait(lock, [&] { return entries[index].finished; });
+		stats.waitMs += MicrosecondsSince(start) / 1000.0;
+	}
+	return index;
+}
+
+void ShaderLibrary::WorkerLoop()
+{
+	PROFILE_THREAD("Shader loader");
+	int count = (int)entries.size();
+	for (int index = nextEntry++; index < count; index = nextEntry++)
+	{
+		Entry& e = entries[index];
+		PROFILE_SCOPE("Load shader");
+
+		auto start = std::chrono::high_resolution_clock::now();
+		std::wstring path = NarrowToWide(e.path);
+		if (FAILED(D3DReadFileToBlob(path.c_str(), e.bytecode.GetAddressOf())))
+			e.bytecode.Reset();
+		readMicroseconds += MicrosecondsSince(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		bool created = false;
+		if (e.bytecode && e.vertex)
+		{
+			Graphics::Device->CreateVertexShader(e.bytecode->GetBufferPointer(), e.bytecode->GetBufferSize(), 0, e.vertexShader.GetAddressOf());
+			created = e.vertexShader != nullptr;
+		}
+		else if (e.bytecode)
+		{
+			Graphics::Device->CreatePixelShader(e.bytecode->GetBufferPointer(), e.bytecode->GetBufferSize(), 0, e.pixelShader.GetAddressOf());
+			created = e.pixelShader != nullptr;
+		}
+		createMicroseconds += MicrosecondsSince(start);
+		if (!created)
+			failed++;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		e.finished = true;
+		if (created)
+			stats.preloaded++;
+		if (--remaining == 0)
+			stats.preloadMs = MicrosecondsSince(preloadStart) / 1000.0;
+		entryFinished.notify_all();
+	}
+}
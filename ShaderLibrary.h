@@ -0,0 +1,95 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ResourceCache.h"
+
+struct ShaderLibraryStats {
+	int requested;			// Load calls
+	int preloaded;			// Created on the loader threads
+	int duplicates;			// Preload entries dropped as already listed or loaded
+	int failed;
+	int loadedOnMainThread;	// Requests nothing was preloaded for
+	double readMs;			// Reading .cso files, summed across loader threads
+	double createMs;		// Creating shader objects, summed across loader threads
+	double preloadMs;		// Preload() to the last shader created
+	double waitMs;			// Main thread blocked on shaders that weren't ready yet
+	unsigned int threads;
+};
+
+// --------------------------------------------------------
+// Loads compiled shaders ahead of time
+//
+// - Preload() starts reading every listed .cso on loader
+//   threads, which also create the shader objects (the D3D11
+//   device is free-threaded, unlike the context)
+// - LoadPixelShader()/LoadVertexShader() hand out handles
+//   from the ResourceCache, waiting only if that particular
+//   shader isn't finished yet; anything that wasn't preloaded
+//   loads there and then, as before
+// - Repeated paths (however they're spelled) are loaded once,
+//   and vertex shader bytecode ends up in the cache for input
+//   layouts
+//
+// The cache itself is only touched on the calling thread.
+// --------------------------------------------------------
+class ShaderLibrary
+{
+public:
+	// 0 threads picks half the hardware threads
+	ShaderLibrary(ResourceCache& cache, unsigned int threadCount = 0);
+	~ShaderLibrary();
+	ShaderLibrary(const ShaderLibrary&) = delete;
+	ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+	// Paths are relative to the executable, like FixPath()
+	void Preload(const std::vector<std::wstring>& pixelShaders, const std::vector<std::wstring>& vertexShaders);
+
+	PixelShaderHandle LoadPixelShader(const std::wstring& relativePath);
+	VertexShaderHandle LoadVertexShader(const std::wstring& relativePath);
+
+	// Blocks until the loader threads are done
+	void WaitForAll();
+
+	ShaderLibraryStats GetStats();
+
+private:
+	struct Entry {
+		std::string path;		// Full path
+		bool vertex;
+		Microsoft::WRL::ComPtr<ID3DBlob> bytecode;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader;
+		bool finished;			// Guarded by the mutex
+	};
+
+	void WorkerLoop();
+	int WaitForEntry(const std::string& key);
+
+	ResourceCache& cache;
+	unsigned int threadCount;
+	std::vector<std::thread> workers;
+
+	// Fixed while the workers run, then handed to the cache on request
+	std::vector<Entry> entries;
+	std::unordered_map<std::string, int> pending;		// Normalized path -> entry
+	std::atomic<int> nextEntry;
+	int remaining;
+
+	std::mutex mutex;
+	std::condition_variable entryFinished;
+
+	// Stats (the atomic ones are written by loader threads)
+	std::atomic<long long> readMicroseconds;
+	std::atomic<long long> createMicroseconds;
+	std::atomic<int> failed;
+	ShaderLibraryStats stats;
+	std::chrono::high_resolution_clock::time_point preloadStart;
+};
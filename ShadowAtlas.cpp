@@ -0,0 +1,260 @@
+#include "ShadowAtlas.h"
+#include <algorithm>
+
+// Own copy of the rect packer ImGui already bundles,
+// kept static so it can't clash with imgui_draw.cpp's copy
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "ImGui/imstb_rectpack.h"
+
+ShadowAtlas::ShadowAtlas(int _atlasSize, int _minTileSize, int _maxTileSize, int _maxTiles, float _maxShadowDistance) :
+	atlasSize(_atlasSize),
+	minTileSize(_minTileSize),
+	maxTileSize(_maxTileSize),
+	maxTiles(_maxTiles),
+	maxShadowDistance(_maxShadowDistance),
+	stats()
+{
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+}
+
+int ShadowAtlas::ComputeTileSize(float screenCoverage, float distance, int currentSize)
+{
+	// Too far away (or off screen) to be worth a shadow
+	if (distance > maxShadowDistance || screenCoverage <= 0.0f)
+		return 0;
+
+	// Ideal resolution scales with how much of the screen the light touches
+	float coverage = screenCoverage > 1.0f ? 1.0f : screenCoverage;
+	float ideal = maxTileSize * coverage;
+
+	// Round up to a power of two within our limits
+	int size = minTileSize;
+	while (size < ideal && size < maxTileSize)
+		size *= 2;
+
+	// Grow right away, but only shrink once we're well under
+	// the current size so lights don't bounce between sizes
+	if (currentSize > 0 && size < currentSize && ideal > currentSize * 0.4f)
+		size = currentSize;
+
+	return size;
+}
+
+void ShadowAtlas::Update(const ShadowAtlasRequest* requests, int requestCount)
+{
+	stats = {};
+	stats.requestedLights = requestCount;
+
+	// Work out what every light would like
+	std::vector<Allocation> candidates;
+	for (int i = 0; i < requestCount; i++)
+	{
+		const ShadowAtlasRequest& r = requests[i];
+		int currentSize = 0;
+		for (auto& a : allocations)
+			if (a.lightIndex == r.lightIndex) currentSize = a.size;
+
+		int size = ComputeTileSize(r.screenCoverage, r.distance, currentSize);
+		if (size == 0)
+		{
+			stats.evictedLights++;
+			continue;
+		}
+
+		Allocation a = {};
+		a.lightIndex = r.lightIndex;
+		a.faceCount = r.faceCount;
+		a.size = size;
+		a.priority = r.screenCoverage / (1.0f + r.distance);
+		a.position = r.position;
+		a.range = r.range;
+		candidates.push_back(a);
+	}
+
+	// Most important lights first (light index breaks ties so results are deterministic)
+	std::stable_sort(candidates.begin(), candidates.end(), [](const Allocation& a, const Allocation& b) {
+		if (a.priority != b.priority) return a.priority > b.priority;
+		return a.lightIndex < b.lightIndex;
+	});
+
+	// Respect the tile limit of the shader side. A light that
+	// doesn't fit is skipped on its own; lights after it with
+	// fewer faces (a spot after a point light) may still fit.
+	int faces = 0;
+	size_t kept = 0;
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		if (faces + candidates[i].faceCount > maxTiles)
+		{
+			stats.evictedLights++;
+			continue;
+		}
+		faces += candidates[i].faceCount;
+		candidates[kept++] = candidates[i];
+	}
+	candidates.resize(kept);
+
+	// Shrink, then evict, the least important lights until everything fits
+	std::vector<ShadowAtlasTile> packedTiles;
+	while (!Pack(candidates, packedTiles))
+	{
+		bool shrunk = false;
+		for (int i = (int)candidates.size() - 1; i >= 0; i--)
+		{
+			if (candidates[i].size > minTileSize)
+			{
+				candidates[i].size /= 2;
+				stats.downsizedLights++;
+				shrunk = true;
+				break;
+			}
+		}
+
+		if (!shrunk)
+		{
+			candidates.pop_back();
+			stats.evictedLights++;
+		}
+	}
+
+	// Tiles that kept their exact spot keep their contents
+	for (auto& t : packedTiles)
+	{
+		bool moved = true;
+		for (auto& old : tiles)
+		{
+			if (old.lightIndex == t.lightIndex && old.face == t.face &&
+				old.x == t.x && old.y == t.y && old.size == t.size)
+			{
+				t.dirty = old.dirty;
+				moved = false;
+				break;
+			}
+		}
+		if (moved) stats.repacked = true;
+	}
+
+	allocations = candidates;
+	tiles = packedTiles;
+
+	// Report
+	stats.allocatedLights = (int)allocations.size();
+	stats.tiles = (int)tiles.size();
+	for (auto& t : tiles)
+	{
+		stats.usedPixels += t.size * t.size;
+		if (t.dirty) stats.dirtyTiles++;
+	}
+}
+
+void ShadowAtlas::MarkLightDirty(int lightIndex)
+{
+	for (auto& t : tiles)
+		if (t.lightIndex == lightIndex) t.dirty = true;
+}
+
+void ShadowAtlas::MarkAllDirty()
+{
+	for (auto& t : tiles)
+		t.dirty = true;
+}
+
+// --------------------------------------------------------
+// A caster moved (or changed) - any light whose range
+// overlaps its bounding sphere has to redraw its tiles
+// --------------------------------------------------------
+void ShadowAtlas::NotifyCasterChanged(DirectX::XMFLOAT3 center, float radius)
+{
+	for (auto& a : allocations)
+	{
+		float dx = center.x - a.position.x;
+		float dy = center.y - a.position.y;
+		float dz = center.z - a.position.z;
+		float reach = radius + a.range;
+		if (dx * dx + dy * dy + dz * dz <= reach * reach)
+			MarkLightDirty(a.lightIndex);
+	}
+}
+
+void ShadowAtlas::ClearDirtyFlags()
+{
+	for (auto& t : tiles)
+		t.dirty = false;
+}
+
+int ShadowAtlas::FindFirstTile(int lightIndex)
+{
+	for (size_t i = 0; i < tiles.size(); i++)
+		if (tiles[i].lightIndex == lightIndex) return (int)i;
+	return -1;
+}
+
+const std::vector<ShadowAtlasTile>& ShadowAtlas::GetTiles()
+{
+	return tiles;
+}
+
+int ShadowAtlas::GetAtlasSize()
+{
+	return atlasSize;
+}
+
+ShadowAtlasStats ShadowAtlas::GetStats()
+{
+	return stats;
+}
+
+// --------------------------------------------------------
+// Tries to fit every face of every candidate into the atlas.
+// stb_rect_pack hands rects back in their original order,
+// so each light's faces stay consecutive.
+// --------------------------------------------------------
+bool ShadowAtlas::Pack(const std::vector<Allocation>& candidates, std::vector<ShadowAtlasTile>& packedTiles)
+{
+	packedTiles.clear();
+
+	std::vector<stbrp_rect> rects;
+	for (auto& a : candidates)
+	{
+		for (int f = 0; f < a.faceCount; f++)
+		{
+			stbrp_rect r = {};
+			r.id = (int)rects.size();
+			r.w = a.size;
+			r.h = a.size;
+			rects.push_back(r);
+		}
+	}
+
+	if (rects.empty())
+		return true;
+
+	std::vector<stbrp_node> nodes(atlasSize);
+	stbrp_context context = {};
+	stbrp_init_target(&context, atlasSize, atlasSize, nodes.data(), (int)nodes.size());
+	if (!stbrp_pack_rects(&context, rects.data(), (int)rects.size()))
+		return false;
+
+	// Turn packed rects back into tiles
+	int r = 0;
+	for (auto& a : candidates)
+	{
+		for (int f = 0; f < a.faceCount; f++, r++)
+		{
+			ShadowAtlasTile t = {};
+			t.x = rects[r].x;
+			t.y = rects[r].y;
+			t.size = a.size;
+			t.lightIndex = a.lightIndex;
+			t.face = f;
+			t.dirty = true;
+			packedTiles.push_back(t);
+		}
+	}
+
+	return true;
+}
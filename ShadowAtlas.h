@@ -0,0 +1,105 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+// A shadow-casting light asking for space in the atlas
+struct ShadowAtlasRequest {
+	int lightIndex;
+	int faceCount;				// 6 for point lights, 1 for spot lights
+	DirectX::XMFLOAT3 position;	// Light's bounding sphere, used to decide
+	float range;				// which caster changes affect its tiles
+	float screenCoverage;		// Fraction of the screen the light's range covers (0-1)
+	float distance;				// Distance from the camera to the light
+};
+
+// A square region of the atlas holding one shadow view
+struct ShadowAtlasTile {
+	int x;
+	int y;
+	int size;
+	int lightIndex;
+	int face;
+	bool dirty;					// Needs to be re-rendered
+};
+
+// What the last Update() did
+struct ShadowAtlasStats {
+	int requestedLights;
+	int allocatedLights;
+	int downsizedLights;		// Shrunk below their ideal size to fit
+	int evictedLights;			// Didn't fit at all (or too far away)
+	int tiles;
+	int dirtyTiles;
+	int usedPixels;
+	bool repacked;
+};
+
+// --------------------------------------------------------
+// Allocates variable-size shadow tiles for point and spot
+// lights inside a single square depth texture
+//
+// - Tile size follows screen coverage, with a little
+//   hysteresis so lights don't flicker between sizes
+// - Lights are packed in priority order with stb_rect_pack;
+//   when things don't fit, the least important lights are
+//   halved and finally evicted
+// - Tracks which tiles are dirty so only changed lights
+//   get re-rendered
+//
+// Pure CPU, so allocation and eviction can be exercised
+// without a device
+// --------------------------------------------------------
+class ShadowAtlas
+{
+public:
+	ShadowAtlas(
+		int _atlasSize = 2048,
+		int _minTileSize = 64,
+		int _maxTileSize = 512,
+		int _maxTiles = 12,
+		float _maxShadowDistance = 50.0f);
+	~ShadowAtlas();
+
+	// Picks a power of two tile size for a light
+	int ComputeTileSize(float screenCoverage, float distance, int currentSize);
+
+	// Reallocates tiles for this frame's requests
+	void Update(const ShadowAtlasRequest* requests, int requestCount);
+
+	// Invalidation
+	void MarkLightDirty(int lightIndex);
+	void MarkAllDirty();
+	void NotifyCasterChanged(DirectX::XMFLOAT3 center, float radius);
+	void ClearDirtyFlags();
+
+	// Index of the light's first tile (faces are consecutive), or -1
+	int FindFirstTile(int lightIndex);
+
+	const std::vector<ShadowAtlasTile>& GetTiles();
+	int GetAtlasSize();
+	ShadowAtlasStats GetStats();
+
+private:
+	struct Allocation {
+		int lightIndex;
+		int faceCount;
+		int size;
+		float priority;
+		DirectX::XMFLOAT3 position;
+		float range;
+	};
+
+	bool Pack(const std::vector<Allocation>& candidates, std::vector<ShadowAtlasTile>& packedTiles);
+
+	// Settings
+	int atlasSize;
+	int minTileSize;
+	int maxTileSize;
+	int maxTiles;
+	float maxShadowDistance;
+
+	// Current state
+	std::vector<Allocation> allocations;
+	std::vector<ShadowAtlasTile> tiles;
+	ShadowAtlasStats stats;
+};
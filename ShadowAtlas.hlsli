@@ -0,0 +1,66 @@
+#ifndef __GGP_SHADOW_ATLAS__
+#define __GGP_SHADOW_ATLAS__
+
+#include "Lighting.hlsli"
+
+// Must match MAX_ATLAS_SHADOWS in BufferStructs.h
+#define MAX_ATLAS_SHADOWS 12
+
+// One shadow view inside the atlas
+struct AtlasShadow
+{
+    matrix viewProjection;
+    float4 atlasRect; // xy = uv offset, zw = uv size
+};
+
+cbuffer ShadowAtlasData : register(b1)
+{
+    AtlasShadow atlasShadows[MAX_ATLAS_SHADOWS];
+}
+
+Texture2D ShadowAtlas : register(t5);
+
+// Point lights use six consecutive records in +X, -X, +Y, -Y, +Z, -Z order
+int PointShadowFace(float3 lightToPixel)
+{
+    float3 a = abs(lightToPixel);
+    if (a.x >= a.y && a.x >= a.z)
+        return lightToPixel.x >= 0 ? 0 : 1;
+    if (a.y >= a.z)
+        return lightToPixel.y >= 0 ? 2 : 3;
+    return lightToPixel.z >= 0 ? 4 : 5;
+}
+
+// Returns how lit the pixel is (0 = fully shadowed) for point and spot lights
+float AtlasShadowAmount(Light light, float3 worldPos, SamplerComparisonState shadowSampler)
+{
+    // No tile for this light
+    if (light.shadowIndex < 0)
+        return 1.0f;
+    
+    int index = light.shadowIndex;
+    if (light.type == LIGHT_TYPE_POINT)
+        index += PointShadowFace(worldPos - light.position);
+    
+    AtlasShadow s = atlasShadows[index];
+    
+    // Project into the light's view
+    float4 shadowPos = mul(s.viewProjection, float4(worldPos, 1.0f));
+    shadowPos /= shadowPos.w;
+    
+    // Outside of the view means outside of the light
+    if (shadowPos.z < 0 || shadowPos.z > 1)
+        return 1.0f;
+    
+    // NDC to tile UVs, kept half a texel inside so we never read a neighbor
+    float2 uv = shadowPos.xy * 0.5f + 0.5f;
+    uv.y = 1 - uv.y;
+    float atlasWidth, atlasHeight;
+    ShadowAtlas.GetDimensions(atlasWidth, atlasHeight);
+    float2 halfTexel = 0.5f / (s.atlasRect.zw * atlasWidth);
+    uv = clamp(uv, halfTexel, 1 - halfTexel);
+    
+    return ShadowAtlas.SampleCmpLevelZero(shadowSampler, s.atlasRect.xy + uv * s.atlasRect.zw, shadowPos.z).r;
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "ShadowCache.h"
+#include <cstring>
+
+ShadowCache::ShadowCache() :
+	cachedLightView(),
+	cachedLightProjection(),
+	valid(false),
+	stats()
+{
+	stats.rebuildReason = "None";
+}
+
+ShadowCache::~ShadowCache()
+{
+}
+
+bool ShadowCache::BeginFrame(
+	const std::vector<Renderable>& renderables,
+	DirectX::XMFLOAT4X4 lightView,
+	DirectX::XMFLOAT4X4 lightProjection)
+{
+	staticCasters.clear();
+	dynamicCasters.clear();
+
+	// Split the casters and look for static ones that moved
+	const char* reason = valid ? 0 : "Invalidated";
+	int knownStatic = 0;
+	for (int e = 0; e < (int)renderables.size(); e++)
+	{
+		if (!(renderables[e].flags & ENTITY_STATIC))
+		{
+			dynamicCasters.push_back(e);
+			continue;
+		}
+
+		staticCasters.push_back(e);
+
+		auto it = cachedVersions.find(renderables[e].entity);
+		if (it == cachedVersions.end())
+		{
+			if (!reason) reason = "Static caster added";
+			continue;
+		}
+
+		knownStatic++;
+		if (!reason && it->second != renderables[e].version)
+			reason = "Static caster moved";
+	}
+
+	// Something that used to be static is gone (destroyed or made dynamic)
+	if (!reason && knownStatic != (int)cachedVersions.size())
+		reason = "Static caster removed";
+
+	// Any change to the light invalidates everything it sees
+	if (!reason && (
+		memcmp(&lightView, &cachedLightView, sizeof(DirectX::XMFLOAT4X4)) != 0 ||
+		memcmp(&lightProjection, &cachedLightProjection, sizeof(DirectX::XMFLOAT4X4)) != 0))
+		reason = "Light moved";
+
+	bool rebuild = reason != 0;
+	if (rebuild)
+	{
+		// Remember the state the new static layer is built from
+		cachedVersions.clear();
+		for (int e : staticCasters)
+			cachedVersions[renderables[e].entity] = renderables[e].version;
+
+		cachedLightView = lightView;
+		cachedLightProjection = lightProjection;
+		valid = true;
+		stats.totalRebuilds++;
+	}
+
+	// Fill out this frame's report
+	stats.staticCasters = (int)staticCasters.size();
+	stats.dynamicCasters = (int)dynamicCasters.size();
+	stats.cacheHits = rebuild ? 0 : stats.staticCasters;
+	stats.redraws = rebuild ? stats.staticCasters + stats.dynamicCasters : stats.dynamicCasters;
+	stats.staticLayerRebuilt = rebuild;
+	stats.rebuildReason = rebuild ? reason : "None";
+
+	return rebuild;
+}
+
+void ShadowCache::Invalidate()
+{
+	valid = false;
+}
+
+const std::vector<int>& ShadowCache::GetStaticCasters()
+{
+	return staticCasters;
+}
+
+const std::vector<int>& ShadowCache::GetDynamicCasters()
+{
+	return dynamicCasters;
+}
+
+ShadowCacheStats ShadowCache::GetStats()
+{
+	return stats;
+}
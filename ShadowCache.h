@@ -0,0 +1,62 @@
+#pragma once
+#include <DirectXMath.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Components.h"
+
+// Per-frame report of what the shadow cache did
+struct ShadowCacheStats {
+	int staticCasters;			// Entities living in the cached layer
+	int dynamicCasters;			// Entities drawn on top every frame
+	int cacheHits;				// Static casters reused without a redraw
+	int redraws;				// Casters actually drawn this frame
+	bool staticLayerRebuilt;	// Did the cached layer get re-rendered?
+	const char* rebuildReason;	// Why it was re-rendered (or "None")
+	int totalRebuilds;			// Rebuilds since startup
+};
+
+// --------------------------------------------------------
+// CPU-side bookkeeping for a cached static shadow layer
+//
+// - Splits entities into static and dynamic casters
+// - Remembers the Transform version of every static caster
+//   and the light matrices used for the last rebuild
+// - Tells the renderer when the static layer is stale
+// --------------------------------------------------------
+class ShadowCache
+{
+public:
+	ShadowCache();
+	~ShadowCache();
+
+	// Sorts casters for this frame and returns true if the
+	// static layer must be re-rendered before compositing
+	bool BeginFrame(
+		const std::vector<Renderable>& renderables,
+		DirectX::XMFLOAT4X4 lightView,
+		DirectX::XMFLOAT4X4 lightProjection);
+
+	// Forces a rebuild next frame (resource recreation, etc.)
+	void Invalidate();
+
+	// Casters sorted by the last BeginFrame(), as indices into the renderables
+	const std::vector<int>& GetStaticCasters();
+	const std::vector<int>& GetDynamicCasters();
+
+	ShadowCacheStats GetStats();
+
+private:
+	std::vector<int> staticCasters;
+	std::vector<int> dynamicCasters;
+
+	// Transform versions of static casters at the last rebuild
+	std::unordered_map<EntityHandle, unsigned int> cachedVersions;
+
+	// Light matrices at the last rebuild
+	DirectX::XMFLOAT4X4 cachedLightView;
+	DirectX::XMFLOAT4X4 cachedLightProjection;
+
+	bool valid;
+	ShadowCacheStats stats;
+};
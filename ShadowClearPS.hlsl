@@ -0,0 +1,15 @@
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+// --------------------------------------------------------
+// Resets depth to the far plane for a single shadow atlas tile
+// - Depth-stencil views can only be cleared as a whole, so
+//   a fullscreen triangle inside the tile's viewport does it
+// --------------------------------------------------------
+float main(VertexToPixel input) : SV_DEPTH
+{
+    return 1.0f;
+}
@@ -13,5 +13,8 @@ cbuffer externalData : register(b0)
 float4 main(VertexShaderInput input) : SV_POSITION
 {
     matrix wvp = mul(projection, mul(view, world));
-    return mul(wvp, float4(input.localPosition, 1.0f));
+
+    // precise so the depth pre-pass matches VertexShader.hlsl bit for bit
+    precise float4 position = mul(wvp, float4(input.localPosition, 1.0f));
+    return position;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Sky.h"
 #include "BufferStructs.h"
 #include <WICTextureLoader.h>
+#include <DDSTextureLoader.h>
 
 using namespace DirectX;
 
@@ -15,6 +16,23 @@ Sky::Sky(const wchar_t* right,
 		 Microsoft::WRL::ComPtr<ID3D11PixelShader> _skyPS,
 		 Microsoft::WRL::ComPtr<ID3D11SamplerState> _sampler) : 
 	skyMesh(_mesh), skyVS(_skyVS), skyPS(_skyPS), sampler(_sampler)
+{
+	CreateRenderStates();
+	skySRV = CreateCubemap(right, left, up, down, front, back);
+}
+
+Sky::Sky(const wchar_t* cubemapDDS,
+		 std::shared_ptr<Mesh> _mesh,
+		 Microsoft::WRL::ComPtr<ID3D11VertexShader> _skyVS,
+		 Microsoft::WRL::ComPtr<ID3D11PixelShader> _skyPS,
+		 Microsoft::WRL::ComPtr<ID3D11SamplerState> _sampler) :
+	skyMesh(_mesh), skyVS(_skyVS), skyPS(_skyPS), sampler(_sampler)
+{
+	CreateRenderStates();
+	CreateDDSTextureFromFile(Graphics::Device.Get(), cubemapDDS, 0, skySRV.GetAddressOf());
+}
+
+void Sky::CreateRenderStates()
 {
 	// Rasterizer to reverse the cull mode
 	D3D11_RASTERIZER_DESC rasterizerDesc = {};
@@ -29,12 +47,9 @@ Sky::Sky(const wchar_t* right,
 	depthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
 	depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
 	Graphics::Device->CreateDepthStencilState(&depthDesc, skyDepthState.GetAddressOf());
-
-
-	skySRV = CreateCubemap(right, left, up, down, front, back);
 }
 
-void Sky::Draw(std::shared_ptr<Camera> camera)
+void Sky::Draw(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 projection)
 {
 	// Set Rasterizer State and Depth Stencil State
 	Graphics::Context->RSSetState(skyRasterState.Get());
@@ -45,8 +60,8 @@ void Sky::Draw(std::shared_ptr<Camera> camera)
 	Graphics::Context->PSSetShader(skyPS.Get(), 0, 0);
 
 	SkyBoxExternalData skyBoxData{};
-	skyBoxData.viewMatrix = camera->GetView();
-	skyBoxData.projectionMatrix = camera->GetProjection();
+	skyBoxData.viewMatrix = view;
+	skyBoxData.projectionMatrix = projection;
 	Graphics::FillAndBindNextConstantBuffer(&skyBoxData, sizeof(SkyBoxExternalData), D3D11_VERTEX_SHADER, 0);
 
 	Graphics::Context->PSSetShaderResources(0, 1, skySRV.GetAddressOf());
@@ -60,6 +75,26 @@ void Sky::Draw(std::shared_ptr<Camera> camera)
 	Graphics::Context->OMSetDepthStencilState(0, 0);
 }
 
+Microsoft::WRL::ComPtr<ID3D11VertexShader> Sky::GetVertexShader()
+{
+	return skyVS;
+}
+
+Microsoft::WRL::ComPtr<ID3D11PixelShader> Sky::GetPixelShader()
+{
+	return skyPS;
+}
+
+void Sky::SetVertexShader(Microsoft::WRL::ComPtr<ID3D11VertexShader> _skyVS)
+{
+	skyVS = _skyVS;
+}
+
+void Sky::SetPixelShader(Microsoft::WRL::ComPtr<ID3D11PixelShader> _skyPS)
+{
+	skyPS = _skyPS;
+}
+
 // --------------------------------------------------------
 // Loads six individual textures (the six faces of a cube map), then
 // creates a blank cube map and copies each of the six textures to
@@ -23,10 +23,28 @@ public:
 		Microsoft::WRL::ComPtr<ID3D11SamplerState> _sampler
 	);
 
-	void Draw(std::shared_ptr<Camera> camera);
+	// From a cube map DDS that already has all six faces (and mips)
+	Sky(
+		const wchar_t* cubemapDDS,
+		std::shared_ptr<Mesh> _mesh,
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> _skyVS,
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> _skyPS,
+		Microsoft::WRL::ComPtr<ID3D11SamplerState> _sampler
+	);
+
+	void Draw(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 projection);
+
+	// Shaders, swappable for hot reloading
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> GetVertexShader();
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> GetPixelShader();
+	void SetVertexShader(Microsoft::WRL::ComPtr<ID3D11VertexShader> _skyVS);
+	void SetPixelShader(Microsoft::WRL::ComPtr<ID3D11PixelShader> _skyPS);
 
 private:
 
+	// Rasterizer and depth states shared by both constructors
+	void CreateRenderStates();
+
 	// Helper for creating a cubemap from 6 individual textures
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateCubemap(
 		const wchar_t* right,
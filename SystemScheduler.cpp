@@ -0,0 +1,104 @@
+#include "SystemScheduler.h"
+#include "Profiler.h"
+#include <chrono>
+
+SystemScheduler::SystemScheduler(World& world, ThreadPool& pool) :
+	world(world),
+	pool(pool),
+	batchesDirty(true),
+	parallel(true),
+	lastRunMs(0)
+{
+}
+
+void SystemScheduler::Add(const std::string& name, ComponentMask reads, ComponentMask writes, SystemFunction run)
+{
+	systems.push_back({ name, reads, writes, run });
+	stats.push_back({ name, 0, 0 });
+	batchesDirty = true;
+}
+
+void SystemScheduler::Run(float deltaTime, float totalTime)
+{
+	if (batchesDirty)
+		BuildBatches();
+
+	PROFILE_SCOPE("Systems");
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto& batch : batches)
+	{
+		auto runOne = [&](int i) {
+			PROFILE_SCOPE_DYNAMIC(systems[batch[i]].name);
+			auto systemStart = std::chrono::high_resolution_clock::now();
+			systems[batch[i]].run(world, deltaTime, totalTime);
+			stats[batch[i]].ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - systemStart).count();
+		};
+
+		// Nothing to gain from waking the pool for one system
+		if (parallel && batch.size() > 1)
+			pool.ParallelFor((int)batch.size(), runOne);
+		else
+			for (int i = 0; i < (int)batch.size(); i++)
+				runOne(i);
+	}
+	lastRunMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void SystemScheduler::SetParallel(bool _parallel)
+{
+	parallel = _parallel;
+}
+
+bool SystemScheduler::IsParallel()
+{
+	return parallel;
+}
+
+int SystemScheduler::GetBatchCount()
+{
+	if (batchesDirty)
+		BuildBatches();
+	return (int)batches.size();
+}
+
+const std::vector<SystemStats>& SystemScheduler::GetStats()
+{
+	return stats;
+}
+
+double SystemScheduler::GetLastRunMs()
+{
+	return lastRunMs;
+}
+
+// --------------------------------------------------------
+// Greedy, in order: a system joins the current batch unless
+// it conflicts with something already in it, so a system
+// never runs before one added ahead of it that it depends on
+// --------------------------------------------------------
+void SystemScheduler::BuildBatches()
+{
+	batches.clear();
+	ComponentMask batchReads = 0;
+	ComponentMask batchWrites = 0;
+	for (int i = 0; i < (int)systems.size(); i++)
+	{
+		System& system = systems[i];
+		bool conflicts =
+			(system.writes & (batchReads | batchWrites)) != 0 ||
+			(system.reads & batchWrites) != 0;
+
+		if (batches.empty() || conflicts)
+		{
+			batches.push_back({});
+			batchReads = 0;
+			batchWrites = 0;
+		}
+
+		batches.back().push_back(i);
+		batchReads |= system.reads;
+		batchWrites |= system.writes;
+		stats[i].batch = (int)batches.size() - 1;
+	}
+	batchesDirty = false;
+}
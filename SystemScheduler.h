@@ -0,0 +1,68 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+#include "World.h"
+
+// How one system did on the last Run()
+struct SystemStats {
+	std::string name;
+	int batch;			// Systems in the same batch ran side by side
+	double ms;
+};
+
+// --------------------------------------------------------
+// Runs systems over a World in the order they were added,
+// side by side where that's safe
+//
+// - Each system says which components it reads and which it
+//   writes; consecutive systems share a batch (and run on
+//   the thread pool together) until one conflicts with the
+//   batch: it writes something the batch touches, or reads
+//   something the batch writes
+// - Anything a system touches outside the World is its own
+//   business: only one system should own each such thing
+// - Systems may not change the World's structure (create,
+//   destroy, add or remove components), or call the pool's
+//   ParallelFor() themselves
+// --------------------------------------------------------
+class SystemScheduler
+{
+public:
+	typedef std::function<void(World& world, float deltaTime, float totalTime)> SystemFunction;
+
+	SystemScheduler(World& world, ThreadPool& pool);
+
+	void Add(const std::string& name, ComponentMask reads, ComponentMask writes, SystemFunction run);
+
+	void Run(float deltaTime, float totalTime);
+
+	// Lets every system run on the calling thread, one after another
+	void SetParallel(bool parallel);
+	bool IsParallel();
+
+	int GetBatchCount();
+	const std::vector<SystemStats>& GetStats();
+	double GetLastRunMs();
+
+private:
+	struct System {
+		std::string name;
+		ComponentMask reads;
+		ComponentMask writes;
+		SystemFunction run;
+	};
+
+	void BuildBatches();
+
+	World& world;
+	ThreadPool& pool;
+	std::vector<System> systems;
+	std::vector<std::vector<int>> batches;	// Indices into systems
+	bool batchesDirty;
+	bool parallel;
+
+	std::vector<SystemStats> stats;
+	double lastRunMs;
+};
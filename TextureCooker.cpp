@@ -0,0 +1,801 @@
+#include "TextureCooker.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define COOKER_SSE2
+#endif
+
+namespace
+{
+	const float Pi = 3.14159265f;
+
+	// Kaiser filter shape: half-width in destination texels and sharpness
+	const int KaiserWidth = 3;
+	const float KaiserAlpha = 4.0f;
+
+	// Source taps per destination texel for an exact 2x reduction
+	const int KaiserTaps = KaiserWidth * 4;
+
+	uint32_t FourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+	}
+
+	// Marks DDS files written by the cooker (stored in dwReserved1[0])
+	const uint32_t CookedTag = FourCC('C', 'O', 'O', 'K');
+
+	// DDS_HEADER and DDS_HEADER_DXT10, laid out by hand so the
+	// cooker doesn't need any Windows headers
+	struct DdsPixelFormat {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t masks[4];
+	};
+
+	struct DdsHeader {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[11];
+		DdsPixelFormat pixelFormat;
+		uint32_t caps;
+		uint32_t caps2;
+		uint32_t caps3;
+		uint32_t caps4;
+		uint32_t reserved2;
+	};
+
+	struct DdsHeaderDx10 {
+		uint32_t dxgiFormat;
+		uint32_t resourceDimension;
+		uint32_t miscFlag;
+		uint32_t arraySize;
+		uint32_t miscFlags2;
+	};
+
+	uint32_t DxgiFormat(BlockFormat format)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: return 71;	// DXGI_FORMAT_BC1_UNORM
+		case BlockFormat::BC4: return 80;	// DXGI_FORMAT_BC4_UNORM
+		case BlockFormat::BC5: return 83;	// DXGI_FORMAT_BC5_UNORM
+		case BlockFormat::BC7: return 98;	// DXGI_FORMAT_BC7_UNORM
+		default: return 0;
+		}
+	}
+
+	// Modified Bessel function of the first kind, order 0
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int k = 1; k < 20; k++)
+		{
+			term *= (x / (2.0f * k)) * (x / (2.0f * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// ----------------------------------------------------
+	// Weights for source texels 2x-(W*2-1) ... 2x+W*2 when
+	// producing destination texel x. Distances are measured
+	// in destination texels from the destination center.
+	// ----------------------------------------------------
+	void KaiserWeights(float weights[KaiserTaps])
+	{
+		float total = 0;
+		for (int i = 0; i < KaiserTaps; i++)
+		{
+			float d = (i - KaiserTaps / 2 + 0.5f) / 2.0f;
+			float sinc = fabsf(d) < 1e-6f ? 1.0f : sinf(Pi * d) / (Pi * d);
+			float t = d / KaiserWidth;
+			float window = fabsf(t) >= 1.0f ? 0.0f : BesselI0(KaiserAlpha * sqrtf(1.0f - t * t)) / BesselI0(KaiserAlpha);
+			weights[i] = sinc * window;
+			total += weights[i];
+		}
+
+		for (int i = 0; i < KaiserTaps; i++)
+			weights[i] /= total;
+	}
+
+	int Address(int i, int size, bool wrap)
+	{
+		if (wrap)
+			return ((i % size) + size) % size;
+		return i < 0 ? 0 : i >= size ? size - 1 : i;
+	}
+
+	unsigned char ToByte(float v)
+	{
+		int i = (int)floorf(v + 0.5f);
+		return (unsigned char)(i < 0 ? 0 : i > 255 ? 255 : i);
+	}
+
+	// Bilinear fetch of the red channel at a normalized UV
+	float SampleRed(const DecodedImage& image, float u, float v, bool wrap)
+	{
+		float x = u * image.width - 0.5f;
+		float y = v * image.height - 0.5f;
+		int x0 = (int)floorf(x);
+		int y0 = (int)floorf(y);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		auto texel = [&](int tx, int ty) {
+			tx = Address(tx, image.width, wrap);
+			ty = Address(ty, image.height, wrap);
+			return (float)image.pixels[((size_t)ty * image.width + tx) * 4];
+		};
+
+		float top = texel(x0, y0) + (texel(x0 + 1, y0) - texel(x0, y0)) * fx;
+		float bottom = texel(x0, y0 + 1) + (texel(x0 + 1, y0 + 1) - texel(x0, y0 + 1)) * fx;
+		return top + (bottom - top) * fy;
+	}
+
+	// Box filter for odd sizes and 1-pixel-wide levels
+	void BoxScalar(const MipLevel& source, MipLevel& dest)
+	{
+		for (int y = 0; y < dest.height; y++)
+		{
+			int y0 = std::min(y * 2, source.height - 1);
+			int y1 = std::min(y * 2 + 1, source.height - 1);
+			for (int x = 0; x < dest.width; x++)
+			{
+				int x0 = std::min(x * 2, source.width - 1);
+				int x1 = std::min(x * 2 + 1, source.width - 1);
+				const unsigned char* a = &source.pixels[((size_t)y0 * source.width + x0) * 4];
+				const unsigned char* b = &source.pixels[((size_t)y0 * source.width + x1) * 4];
+				const unsigned char* c = &source.pixels[((size_t)y1 * source.width + x0) * 4];
+				const unsigned char* d = &source.pixels[((size_t)y1 * source.width + x1) * 4];
+				unsigned char* out = &dest.pixels[((size_t)y * dest.width + x) * 4];
+				for (int ch = 0; ch < 4; ch++)
+					out[ch] = (unsigned char)((a[ch] + b[ch] + c[ch] + d[ch] + 2) >> 2);
+			}
+		}
+	}
+
+	void Renormalize(MipLevel& level)
+	{
+		for (size_t i = 0; i < level.pixels.size(); i += 4)
+		{
+			float x = level.pixels[i + 0] / 255.0f * 2.0f - 1.0f;
+			float y = level.pixels[i + 1] / 255.0f * 2.0f - 1.0f;
+			float z = level.pixels[i + 2] / 255.0f * 2.0f - 1.0f;
+			float length = sqrtf(x * x + y * y + z * z);
+			if (length < 1e-6f)
+			{
+				x = 0;
+				y = 0;
+				z = 1;
+				length = 1;
+			}
+			level.pixels[i + 0] = ToByte((x / length * 0.5f + 0.5f) * 255.0f);
+			level.pixels[i + 1] = ToByte((y / length * 0.5f + 0.5f) * 255.0f);
+			level.pixels[i + 2] = ToByte((z / length * 0.5f + 0.5f) * 255.0f);
+		}
+	}
+
+	bool ReadFile(const std::string& path, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file)
+			return false;
+
+		bytes.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)bytes.data(), bytes.size());
+		return (bool)file;
+	}
+
+	size_t FileSize(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		return file ? (size_t)file.tellg() : 0;
+	}
+
+	double MsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// Mips, then blocks, for every face
+	void CookFaces(const std::vector<DecodedImage>& images, const CookSettings& settings,
+		std::vector<std::vector<std::vector<unsigned char>>>& slices, CookResult& result)
+	{
+		for (auto& image : images)
+		{
+			std::vector<MipLevel> mips = TextureCooker::GenerateMips(image, settings.filter, settings.wrap, settings.kind == TextureKind::Normal);
+
+			std::vector<std::vector<unsigned char>> compressed;
+			for (auto& level : mips)
+			{
+				result.sourceBytes += level.pixels.size();
+				compressed.push_back(BlockCompression::Compress(level.pixels.data(), level.width, level.height, settings.format));
+			}
+			slices.push_back(compressed);
+		}
+	}
+}
+
+TextureKind TextureCooker::KindFromFileName(const std::string& fileName)
+{
+	std::string name = fileName;
+	std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+	if (name.find("_albedo") != std::string::npos) return TextureKind::Albedo;
+	if (name.find("_normal") != std::string::npos) return TextureKind::Normal;
+	if (name.find("_roughness") != std::string::npos) return TextureKind::Roughness;
+	if (name.find("_metal") != std::string::npos) return TextureKind::Metalness;
+	if (name.find("_occlusion") != std::string::npos) return TextureKind::Occlusion;
+	if (name.find("_orm") != std::string::npos) return TextureKind::Orm;
+	return TextureKind::Color;
+}
+
+CookSettings TextureCooker::DefaultSettings(TextureKind kind)
+{
+	CookSettings settings = {};
+	settings.kind = kind;
+	settings.filter = MipFilter::Kaiser;
+	settings.wrap = true;
+
+	switch (kind)
+	{
+	case TextureKind::Albedo: settings.format = BlockFormat::BC7; break;
+	case TextureKind::Normal: settings.format = BlockFormat::BC5; break;
+	case TextureKind::Roughness: settings.format = BlockFormat::BC4; break;
+	case TextureKind::Occlusion: settings.format = BlockFormat::BC4; break;
+	case TextureKind::Metalness:
+		// Mostly 0 or 1 - sinc ringing would only add noise
+		settings.format = BlockFormat::BC4;
+		settings.filter = MipFilter::Box;
+		break;
+	case TextureKind::Orm:
+		// Three uncorrelated channels need BC7's RGB endpoints,
+		// and the box filter keeps metalness free of ringing
+		settings.format = BlockFormat::BC7;
+		settings.filter = MipFilter::Box;
+		break;
+	default:
+		settings.format = BlockFormat::BC1;
+		settings.wrap = false;
+		break;
+	}
+
+	return settings;
+}
+
+const char* TextureCooker::KindName(TextureKind kind)
+{
+	switch (kind)
+	{
+	case TextureKind::Albedo: return "Albedo";
+	case TextureKind::Normal: return "Normal";
+	case TextureKind::Roughness: return "Roughness";
+	case TextureKind::Metalness: return "Metalness";
+	case TextureKind::Occlusion: return "Occlusion";
+	case TextureKind::Orm: return "ORM";
+	default: return "Color";
+	}
+}
+
+const char* TextureCooker::FormatName(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1: return "BC1";
+	case BlockFormat::BC4: return "BC4";
+	case BlockFormat::BC5: return "BC5";
+	case BlockFormat::BC7: return "BC7";
+	default: return "Unknown";
+	}
+}
+
+std::vector<MipLevel> TextureCooker::GenerateMips(const DecodedImage& image, MipFilter filter, bool wrap, bool renormalize)
+{
+	std::vector<MipLevel> mips;
+	mips.push_back({ image.width, image.height, image.pixels });
+
+	while (mips.back().width > 1 || mips.back().height > 1)
+	{
+		const MipLevel& source = mips.back();
+		MipLevel next = filter == MipFilter::Kaiser ? DownsampleKaiser(source, wrap) : DownsampleBox(source);
+		if (renormalize)
+			Renormalize(next);
+		mips.push_back(std::move(next));
+	}
+
+	return mips;
+}
+
+// --------------------------------------------------------
+// 2x2 average. The SSE2 path handles two output texels at
+// a time by widening both source rows to 16 bits.
+// --------------------------------------------------------
+MipLevel TextureCooker::DownsampleBox(const MipLevel& source)
+{
+	MipLevel dest = {};
+	dest.width = std::max(1, source.width / 2);
+	dest.height = std::max(1, source.height / 2);
+	dest.pixels.resize((size_t)dest.width * dest.height * 4);
+
+	bool even = source.width % 2 == 0 && source.height % 2 == 0;
+	if (!even)
+	{
+		BoxScalar(source, dest);
+		return dest;
+	}
+
+	for (int y = 0; y < dest.height; y++)
+	{
+		const unsigned char* row0 = &source.pixels[(size_t)(y * 2) * source.width * 4];
+		const unsigned char* row1 = row0 + (size_t)source.width * 4;
+		unsigned char* out = &dest.pixels[(size_t)y * dest.width * 4];
+
+		int x = 0;
+#ifdef COOKER_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		for (; x + 2 <= dest.width; x += 2)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+			__m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+			// Vertical sums of texels 0-1 and 2-3
+			__m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			__m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+			// Horizontal: add each half's two texels together
+			low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+			high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+			__m128i sum = _mm_unpacklo_epi64(low, high);
+
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+			_mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(sum, zero));
+		}
+#endif
+		for (; x < dest.width; x++)
+		{
+			for (int ch = 0; ch < 4; ch++)
+			{
+				int sum = row0[x * 8 + ch] + row0[x * 8 + 4 + ch] + row1[x * 8 + ch] + row1[x * 8 + 4 + ch];
+				out[x * 4 + ch] = (unsigned char)((sum + 2) >> 2);
+			}
+		}
+	}
+
+	return dest;
+}
+
+// --------------------------------------------------------
+// Separable Kaiser-windowed sinc, horizontal then vertical,
+// in float. Each texel's four channels are one SSE register.
+// Falls back to a box filter for odd sizes.
+// --------------------------------------------------------
+MipLevel TextureCooker::DownsampleKaiser(const MipLevel& source, bool wrap)
+{
+	if ((source.width > 1 && source.width % 2 != 0) || (source.height > 1 && source.height % 2 != 0))
+		return DownsampleBox(source);
+
+	float weights[KaiserTaps];
+	KaiserWeights(weights);
+
+	int srcW = source.width;
+	int srcH = source.height;
+	int dstW = std::max(1, srcW / 2);
+	int dstH = std::max(1, srcH / 2);
+
+	// Horizontal pass into floats (a 1 texel wide level just converts)
+	std::vector<float> horizontal((size_t)srcH * dstW * 4);
+	for (int y = 0; y < srcH; y++)
+	{
+		const unsigned char* row = &source.pixels[(size_t)y * srcW * 4];
+		float* out = &horizontal[(size_t)y * dstW * 4];
+		for (int x = 0; x < dstW; x++)
+		{
+			if (srcW == 1)
+			{
+				for (int ch = 0; ch < 4; ch++)
+					out[ch] = row[ch];
+				continue;
+			}
+
+#ifdef COOKER_SSE2
+			__m128 sum = _mm_setzero_ps();
+			for (int i = 0; i < KaiserTaps; i++)
+			{
+				int sx = Address(x * 2 + i - KaiserTaps / 2 + 1, srcW, wrap);
+				int packed;
+				memcpy(&packed, row + sx * 4, 4);
+				__m128i texel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), _mm_setzero_si128()), _mm_setzero_si128());
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(texel), _mm_set1_ps(weights[i])));
+			}
+			_mm_storeu_ps(out + x * 4, sum);
+#else
+			float sum[4] = {};
+			for (int i = 0; i < KaiserTaps; i++)
+			{
+				int sx = Address(x * 2 + i - KaiserTaps / 2 + 1, srcW, wrap);
+				for (int ch = 0; ch < 4; ch++)
+					sum[ch] += row[sx * 4 + ch] * weights[i];
+			}
+			memcpy(out + x * 4, sum, sizeof(sum));
+#endif
+		}
+	}
+
+	// Vertical pass back to bytes
+	MipLevel dest = {};
+	dest.width = dstW;
+	dest.height = dstH;
+	dest.pixels.resize((size_t)dstW * dstH * 4);
+	for (int y = 0; y < dstH; y++)
+	{
+		unsigned char* out = &dest.pixels[(size_t)y * dstW * 4];
+		for (int x = 0; x < dstW; x++)
+		{
+#ifdef COOKER_SSE2
+			__m128 sum = _mm_setzero_ps();
+			if (srcH == 1)
+				sum = _mm_loadu_ps(&horizontal[(size_t)x * 4]);
+			else
+			{
+				for (int i = 0; i < KaiserTaps; i++)
+				{
+					int sy = Address(y * 2 + i - KaiserTaps / 2 + 1, srcH, wrap);
+					__m128 texel = _mm_loadu_ps(&horizontal[((size_t)sy * dstW + x) * 4]);
+					sum = _mm_add_ps(sum, _mm_mul_ps(texel, _mm_set1_ps(weights[i])));
+				}
+			}
+
+			// Round, then saturate down to bytes (ringing can overshoot)
+			__m128i rounded = _mm_cvtps_epi32(sum);
+			__m128i words = _mm_packs_epi32(rounded, rounded);
+			int packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+			memcpy(out + x * 4, &packed, 4);
+#else
+			float sum[4] = {};
+			for (int i = 0; i < (srcH == 1 ? 1 : KaiserTaps); i++)
+			{
+				int sy = srcH == 1 ? 0 : Address(y * 2 + i - KaiserTaps / 2 + 1, srcH, wrap);
+				float weight = srcH == 1 ? 1.0f : weights[i];
+				for (int ch = 0; ch < 4; ch++)
+					sum[ch] += horizontal[((size_t)sy * dstW + x) * 4 + ch] * weight;
+			}
+			for (int ch = 0; ch < 4; ch++)
+				out[x * 4 + ch] = ToByte(sum[ch]);
+#endif
+		}
+	}
+
+	return dest;
+}
+
+uint64_t TextureCooker::HashSources(const std::vector<std::string>& sourcePaths, const CookSettings& settings)
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&hash](const unsigned char* data, size_t size) {
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	for (auto& path : sourcePaths)
+	{
+		std::vector<unsigned char> bytes;
+		if (!ReadFile(path, bytes))
+			return 0;
+		add(bytes.data(), bytes.size());
+	}
+
+	// Settings and cooker version are part of the key too
+	int key[5] = { (int)settings.kind, (int)settings.format, (int)settings.filter, settings.wrap ? 1 : 0, (int)Version };
+	add((const unsigned char*)key, sizeof(key));
+	return hash;
+}
+
+bool TextureCooker::IsUpToDate(const std::string& ddsPath, uint64_t hash)
+{
+	std::ifstream file(ddsPath, std::ios::binary);
+	if (!file || hash == 0)
+		return false;
+
+	uint32_t magic = 0;
+	DdsHeader header = {};
+	file.read((char*)&magic, 4);
+	file.read((char*)&header, sizeof(DdsHeader));
+	if (!file || magic != FourCC('D', 'D', 'S', ' '))
+		return false;
+
+	return header.reserved1[0] == CookedTag &&
+		header.reserved1[1] == Version &&
+		header.reserved1[2] == (uint32_t)(hash & 0xFFFFFFFF) &&
+		header.reserved1[3] == (uint32_t)(hash >> 32);
+}
+
+bool TextureCooker::ReadDdsInfo(const unsigned char* data, size_t size, CookedDdsInfo& info)
+{
+	size_t headersSize = 4 + sizeof(DdsHeader) + sizeof(DdsHeaderDx10);
+	if (!data || size < headersSize)
+		return false;
+
+	uint32_t magic = 0;
+	DdsHeader header = {};
+	DdsHeaderDx10 dx10 = {};
+	memcpy(&magic, data, 4);
+	memcpy(&header, data + 4, sizeof(DdsHeader));
+	memcpy(&dx10, data + 4 + sizeof(DdsHeader), sizeof(DdsHeaderDx10));
+	if (magic != FourCC('D', 'D', 'S', ' ') || header.pixelFormat.fourCC != FourCC('D', 'X', '1', '0'))
+		return false;
+
+	info = {};
+	info.width = (int)header.width;
+	info.height = (int)header.height;
+	info.mipCount = header.mipMapCount > 0 ? (int)header.mipMapCount : 1;
+	info.cube = (dx10.miscFlag & 0x4) != 0;
+	info.dataOffset = headersSize;
+
+	BlockFormat formats[4] = { BlockFormat::BC1, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 };
+	bool known = false;
+	for (BlockFormat format : formats)
+	{
+		if (DxgiFormat(format) == dx10.dxgiFormat)
+		{
+			info.format = format;
+			known = true;
+		}
+	}
+	if (!known || info.width <= 0 || info.height <= 0)
+		return false;
+
+	// Make sure every level of every face is actually there
+	size_t faceBytes = 0;
+	for (int mip = 0; mip < info.mipCount; mip++)
+		faceBytes += BlockCompression::CompressedSize(std::max(1, info.width >> mip), std::max(1, info.height >> mip), info.format);
+	return size >= headersSize + faceBytes * (info.cube ? 6 : 1);
+}
+
+bool TextureCooker::WriteDds(const std::string& path, int width, int height, BlockFormat format, bool cube, uint64_t hash,
+	const std::vector<std::vector<std::vector<unsigned char>>>& slices)
+{
+	return WriteDds(path, width, height, DxgiFormat(format), cube, hash, slices);
+}
+
+bool TextureCooker::WriteDds(const std::string& path, int width, int height, uint32_t dxgiFormat, bool cube, uint64_t hash,
+	const std::vector<std::vector<std::vector<unsigned char>>>& slices)
+{
+	if (slices.empty() || slices[0].empty())
+		return false;
+
+	DdsHeader header = {};
+	header.size = sizeof(DdsHeader);
+	header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // Caps, height, width, pixel format, mip count, linear size
+	header.height = height;
+	header.width = width;
+	header.pitchOrLinearSize = (uint32_t)slices[0][0].size();
+	header.mipMapCount = (uint32_t)slices[0].size();
+	header.reserved1[0] = CookedTag;
+	header.reserved1[1] = Version;
+	header.reserved1[2] = (uint32_t)(hash & 0xFFFFFFFF);
+	header.reserved1[3] = (uint32_t)(hash >> 32);
+	header.pixelFormat.size = sizeof(DdsPixelFormat);
+	header.pixelFormat.flags = 0x4; // FourCC
+	header.pixelFormat.fourCC = FourCC('D', 'X', '1', '0');
+	header.caps = 0x1000 | 0x400000 | 0x8; // Texture, mipmap, complex
+	header.caps2 = cube ? 0x200 | 0xFC00 : 0; // Cube map with all six faces
+
+	DdsHeaderDx10 dx10 = {};
+	dx10.dxgiFormat = dxgiFormat;
+	dx10.resourceDimension = 3; // Texture2D
+	dx10.miscFlag = cube ? 0x4 : 0; // TextureCube
+	dx10.arraySize = 1; // Cube count for cube maps
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	uint32_t magic = FourCC('D', 'D', 'S', ' ');
+	file.write((const char*)&magic, 4);
+	file.write((const char*)&header, sizeof(DdsHeader));
+	file.write((const char*)&dx10, sizeof(DdsHeaderDx10));
+
+	// Every face's whole mip chain, one face after another
+	for (auto& mips : slices)
+		for (auto& level : mips)
+			file.write((const char*)level.data(), level.size());
+
+	return (bool)file;
+}
+
+CookResult TextureCooker::CookTexture(const std::string& sourcePath, const std::string& outputPath, const CookSettings& settings, bool force)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	CookResult result = {};
+
+	uint64_t hash = HashSources({ sourcePath }, settings);
+	if (hash == 0)
+	{
+		result.error = "Couldn't read source";
+		return result;
+	}
+
+	if (!force && IsUpToDate(outputPath, hash))
+	{
+		result.succeeded = true;
+		result.upToDate = true;
+		result.cookedBytes = FileSize(outputPath);
+		result.ms = MsSince(start);
+		return result;
+	}
+
+	std::vector<DecodedImage> images(1);
+	if (!PngDecoder::DecodeFile(sourcePath, images[0], &result.error))
+		return result;
+
+	std::vector<std::vector<std::vector<unsigned char>>> slices;
+	CookFaces(images, settings, slices, result);
+	if (!WriteDds(outputPath, images[0].width, images[0].height, settings.format, false, hash, slices))
+	{
+		result.error = "Couldn't write output";
+		return result;
+	}
+
+	result.succeeded = true;
+	result.cookedBytes = FileSize(outputPath);
+	result.ms = MsSince(start);
+	return result;
+}
+
+DecodedImage TextureCooker::PackOrm(const DecodedImage* occlusion, const DecodedImage& roughness, const DecodedImage& metalness, bool wrap)
+{
+	DecodedImage packed = {};
+	packed.width = std::max(roughness.width, metalness.width);
+	packed.height = std::max(roughness.height, metalness.height);
+	if (occlusion)
+	{
+		packed.width = std::max(packed.width, occlusion->width);
+		packed.height = std::max(packed.height, occlusion->height);
+	}
+	packed.pixels.resize((size_t)packed.width * packed.height * 4);
+
+	// Inputs already at full size are copied, the rest filtered up
+	auto channel = [&](const DecodedImage& image, int x, int y) {
+		if (image.width == packed.width && image.height == packed.height)
+			return image.pixels[((size_t)y * image.width + x) * 4];
+		return ToByte(SampleRed(image, (x + 0.5f) / packed.width, (y + 0.5f) / packed.height, wrap));
+	};
+
+	for (int y = 0; y < packed.height; y++)
+	{
+		for (int x = 0; x < packed.width; x++)
+		{
+			unsigned char* out = &packed.pixels[((size_t)y * packed.width + x) * 4];
+			out[0] = occlusion ? channel(*occlusion, x, y) : 255;
+			out[1] = channel(roughness, x, y);
+			out[2] = channel(metalness, x, y);
+			out[3] = 255;
+		}
+	}
+
+	return packed;
+}
+
+CookResult TextureCooker::CookOrm(const std::string& occlusionPath, const std::string& roughnessPath, const std::string& metalnessPath,
+	const std::string& outputPath, const CookSettings& settings, bool force)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	CookResult result = {};
+
+	std::vector<std::string> sources = { roughnessPath, metalnessPath };
+	if (!occlusionPath.empty())
+		sources.push_back(occlusionPath);
+
+	uint64_t hash = HashSources(sources, settings);
+	if (hash == 0)
+	{
+		result.error = "Couldn't read source";
+		return result;
+	}
+
+	if (!force && IsUpToDate(outputPath, hash))
+	{
+		result.succeeded = true;
+		result.upToDate = true;
+		result.cookedBytes = FileSize(outputPath);
+		result.ms = MsSince(start);
+		return result;
+	}
+
+	DecodedImage occlusion;
+	DecodedImage roughness;
+	DecodedImage metalness;
+	if (!PngDecoder::DecodeFile(roughnessPath, roughness, &result.error) ||
+		!PngDecoder::DecodeFile(metalnessPath, metalness, &result.error) ||
+		(!occlusionPath.empty() && !PngDecoder::DecodeFile(occlusionPath, occlusion, &result.error)))
+		return result;
+
+	std::vector<DecodedImage> images(1);
+	images[0] = PackOrm(occlusionPath.empty() ? 0 : &occlusion, roughness, metalness, settings.wrap);
+
+	std::vector<std::vector<std::vector<unsigned char>>> slices;
+	CookFaces(images, settings, slices, result);
+	if (!WriteDds(outputPath, images[0].width, images[0].height, settings.format, false, hash, slices))
+	{
+		result.error = "Couldn't write output";
+		return result;
+	}
+
+	result.succeeded = true;
+	result.cookedBytes = FileSize(outputPath);
+	result.ms = MsSince(start);
+	return result;
+}
+
+CookResult TextureCooker::CookCubemap(const std::vector<std::string>& facePaths, const std::string& outputPath, const CookSettings& settings, bool force)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	CookResult result = {};
+
+	if (facePaths.size() != 6)
+	{
+		result.error = "Cube maps need six faces";
+		return result;
+	}
+
+	uint64_t hash = HashSources(facePaths, settings);
+	if (hash == 0)
+	{
+		result.error = "Couldn't read source";
+		return result;
+	}
+
+	if (!force && IsUpToDate(outputPath, hash))
+	{
+		result.succeeded = true;
+		result.upToDate = true;
+		result.cookedBytes = FileSize(outputPath);
+		result.ms = MsSince(start);
+		return result;
+	}
+
+	std::vector<DecodedImage> images(6);
+	for (int i = 0; i < 6; i++)
+	{
+		if (!PngDecoder::DecodeFile(facePaths[i], images[i], &result.error))
+			return result;
+
+		if (images[i].width != images[0].width || images[i].height != images[0].height || images[i].width != images[i].height)
+		{
+			result.error = "Cube faces must be square and the same size";
+			return result;
+		}
+	}
+
+	std::vector<std::vector<std::vector<unsigned char>>> slices;
+	CookFaces(images, settings, slices, result);
+	if (!WriteDds(outputPath, images[0].width, images[0].height, settings.format, true, hash, slices))
+	{
+		result.error = "Couldn't write output";
+		return result;
+	}
+
+	result.succeeded = true;
+	result.cookedBytes = FileSize(outputPath);
+	result.ms = MsSince(start);
+	return result;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BlockCompression.h"
+#include "PngDecoder.h"
+
+// What a texture is used for, which decides how it's cooked
+enum class TextureKind {
+	Color,		// Plain color data (sky faces, etc.)
+	Albedo,
+	Normal,
+	Roughness,
+	Metalness,
+	Occlusion,
+	Orm			// Occlusion, roughness and metalness packed into R, G and B
+};
+
+enum class MipFilter {
+	Box,		// 2x2 average - fast, a little soft
+	Kaiser		// Windowed sinc - sharper mips, costs more
+};
+
+struct CookSettings {
+	TextureKind kind;
+	BlockFormat format;
+	MipFilter filter;
+	bool wrap;			// Tiling texture? (sky faces clamp instead)
+};
+
+// One level of a mip chain, RGBA8
+struct MipLevel {
+	int width;
+	int height;
+	std::vector<unsigned char> pixels;
+};
+
+// Where things are in a DDS written by WriteDds
+struct CookedDdsInfo {
+	int width;
+	int height;
+	int mipCount;
+	BlockFormat format;
+	bool cube;
+	size_t dataOffset;	// First face's mip 0, other levels follow tightly packed
+};
+
+struct CookResult {
+	bool succeeded;
+	bool upToDate;		// Skipped - the existing output matched the source hash
+	std::string error;
+	size_t sourceBytes;	// Uncompressed RGBA8 size, all mips
+	size_t cookedBytes;	// Size of the written DDS
+	double ms;
+};
+
+// --------------------------------------------------------
+// Offline texture cooking: PNG in, block-compressed DDS
+// with a full mip chain out
+//
+// - Kind comes from the file name (_albedo, _normals,
+//   _roughness, _metal, _occlusion), picking BC7, BC5, BC4,
+//   BC4 and BC4; anything else is treated as opaque color
+//   and gets BC1
+// - A material's occlusion, roughness and metalness maps can
+//   instead be packed into one BC7 "ORM" texture, saving two
+//   SRV slots and two fetches in the pixel shader
+// - Normal map mips are renormalized after filtering
+// - The source hash and cooker version live in the DDS
+//   header's reserved words, so unchanged sources are
+//   skipped on the next run
+//
+// Pure CPU and platform independent; see Tools/CookTextures.cpp
+// --------------------------------------------------------
+namespace TextureCooker
+{
+	// Bump whenever cooked output changes, to invalidate old files
+	const unsigned int Version = 1;
+
+	TextureKind KindFromFileName(const std::string& fileName);
+	CookSettings DefaultSettings(TextureKind kind);
+	const char* KindName(TextureKind kind);
+	const char* FormatName(BlockFormat format);
+
+	// Full chain down to 1x1, level 0 included
+	std::vector<MipLevel> GenerateMips(const DecodedImage& image, MipFilter filter, bool wrap, bool renormalize);
+	MipLevel DownsampleBox(const MipLevel& source);
+	MipLevel DownsampleKaiser(const MipLevel& source, bool wrap);
+
+	// 64-bit FNV-1a over the source files plus the settings
+	uint64_t HashSources(const std::vector<std::string>& sourcePaths, const CookSettings& settings);
+
+	// True if the DDS exists and was cooked from the same sources
+	bool IsUpToDate(const std::string& ddsPath, uint64_t hash);
+
+	// Reads the headers back; false for anything not in the
+	// DX10-header, block-compressed layout the cooker writes
+	bool ReadDdsInfo(const unsigned char* data, size_t size, CookedDdsInfo& info);
+
+	// slices[face][mip] holds compressed blocks (6 faces for cubes)
+	bool WriteDds(const std::string& path, int width, int height, BlockFormat format, bool cube, uint64_t hash,
+		const std::vector<std::vector<std::vector<unsigned char>>>& slices);
+
+	// Same layout for uncompressed data in any DXGI format
+	bool WriteDds(const std::string& path, int width, int height, uint32_t dxgiFormat, bool cube, uint64_t hash,
+		const std::vector<std::vector<std::vector<unsigned char>>>& slices);
+
+	CookResult CookTexture(const std::string& sourcePath, const std::string& outputPath, const CookSettings& settings, bool force = false);
+
+	// Packs single-channel maps into R (occlusion), G (roughness)
+	// and B (metalness), resampling everything to the largest
+	// input. A null occlusion map means fully unoccluded.
+	DecodedImage PackOrm(const DecodedImage* occlusion, const DecodedImage& roughness, const DecodedImage& metalness, bool wrap);
+
+	// Occlusion path may be empty
+	CookResult CookOrm(const std::string& occlusionPath, const std::string& roughnessPath, const std::string& metalnessPath,
+		const std::string& outputPath, const CookSettings& settings, bool force = false);
+
+	// Six faces in +X, -X, +Y, -Y, +Z, -Z order
+	CookResult CookCubemap(const std::vector<std::string>& facePaths, const std::string& outputPath, const CookSettings& settings, bool force = false);
+}
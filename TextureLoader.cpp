@@ -0,0 +1,256 @@
+#include "TextureLoader.h"
+#include "Profiler.h"
+#include <fstream>
+#include <new>
+
+namespace
+{
+	bool IsDds(const std::string& path)
+	{
+		return path.size() >= 4 && path.compare(path.size() - 4, 4, ".dds") == 0;
+	}
+
+	bool ReadFile(const std::string& path, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file)
+			return false;
+
+		bytes.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)bytes.data(), bytes.size());
+		return (bool)file;
+	}
+}
+
+TextureLoader::TextureLoader(unsigned int threadCount) :
+	jobs(256),
+	results(256),
+	queuedJobs(0),
+	quitting(false),
+	nextId(0),
+	decoded(0),
+	failed(0),
+	bytesDecoded(0),
+	decodeMicroseconds(0),
+	requested(0),
+	uploaded(0),
+	uploadMs(0),
+	elapsedMs(0)
+{
+	if (threadCount == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads / 2 : 1;
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		quitting = true;
+	}
+	wake.notify_all();
+
+	for (auto& t : workers)
+		t.join();
+
+	// Anything nobody got around to
+	Job* job;
+	while (jobs.TryPop(job))
+		delete job;
+	for (Job* j : overflow)
+		delete j;
+
+	TextureLoadResult* result;
+	while (results.TryPop(result))
+		delete result;
+}
+
+int TextureLoader::Request(const std::string& path, UploadCallback onLoaded)
+{
+	// Already on its way - just wait for the same decode
+	auto it = inFlight.find(path);
+	if (it != inFlight.end())
+	{
+		callbacks[it->second].push_back(onLoaded);
+		return it->second;
+	}
+
+	if (IsIdle())
+	{
+		firstRequest = std::chrono::high_resolution_clock::now();
+		elapsedMs = 0;
+	}
+
+	int id = nextId++;
+	inFlight[path] = id;
+	callbacks[id].push_back(onLoaded);
+	requested++;
+
+	overflow.push_back(new Job{ id, path });
+	SubmitJobs();
+	return id;
+}
+
+int TextureLoader::ProcessCompleted(int maxUploads)
+{
+	PROFILE_SCOPE("Texture uploads");
+	SubmitJobs();
+
+	int count = 0;
+	TextureLoadResult* result;
+	while ((maxUploads < 0 || count < maxUploads) && results.TryPop(result))
+	{
+		// Done with the bookkeeping first, in case a callback requests more
+		std::vector<UploadCallback> ready;
+		ready.swap(callbacks[result->id]);
+		callbacks.erase(result->id);
+		inFlight.erase(result->path);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (auto& callback : ready)
+			callback(*result);
+		uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		delete result;
+
+		uploaded++;
+		count++;
+	}
+
+	if (count > 0 && IsIdle())
+		elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - firstRequest).count();
+
+	return count;
+}
+
+void TextureLoader::WaitForAll()
+{
+	while (!IsIdle())
+	{
+		if (ProcessCompleted() == 0)
+			std::this_thread::yield();
+	}
+}
+
+bool TextureLoader::IsIdle()
+{
+	return callbacks.empty();
+}
+
+unsigned int TextureLoader::GetThreadCount()
+{
+	return (unsigned int)workers.size();
+}
+
+TextureLoaderStats TextureLoader::GetStats()
+{
+	TextureLoaderStats stats = {};
+	stats.requested = requested;
+	stats.decoded = decoded;
+	stats.failed = failed;
+	stats.uploaded = uploaded;
+	stats.pending = (int)callbacks.size();
+	stats.bytesDecoded = bytesDecoded;
+	stats.decodeMs = decodeMicroseconds / 1000.0;
+	stats.uploadMs = uploadMs;
+	stats.elapsedMs = IsIdle() ? elapsedMs :
+		std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - firstRequest).count();
+	return stats;
+}
+
+// --------------------------------------------------------
+// Moves jobs from the overflow list into the lock-free
+// queue as long as there's room, waking a loader for each
+// --------------------------------------------------------
+void TextureLoader::SubmitJobs()
+{
+	size_t submitted = 0;
+	while (submitted < overflow.size() && jobs.TryPush(overflow[submitted]))
+		submitted++;
+
+	if (submitted == 0)
+		return;
+
+	overflow.erase(overflow.begin(), overflow.begin() + submitted);
+	queuedJobs += (int)submitted;
+
+	// Taking the lock means a loader can't miss the wake-up
+	// between checking queuedJobs and going to sleep
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	wake.notify_all();
+}
+
+void TextureLoader::WorkerLoop()
+{
+	PROFILE_THREAD("Texture loader");
+	while (true)
+	{
+		Job* job = 0;
+		if (!jobs.TryPop(job))
+		{
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [this] { return quitting || queuedJobs > 0; });
+			if (quitting)
+				return;
+			continue;
+		}
+		queuedJobs--;
+
+		PROFILE_SCOPE("Decode texture");
+		auto start = std::chrono::high_resolution_clock::now();
+
+		TextureLoadResult* result = new TextureLoadResult();
+		result->id = job->id;
+		result->path = job->path;
+		// Running out of memory fails this texture instead of the whole game
+		try
+		{
+			if (IsDds(job->path))
+			{
+				result->succeeded = ReadFile(job->path, result->fileData);
+				if (!result->succeeded)
+					result->error = "Couldn't read file";
+			}
+			else
+				result->succeeded = PngDecoder::DecodeFile(job->path, result->image, &result->error);
+		}
+		catch (const std::bad_alloc&)
+		{
+			result->succeeded = false;
+			result->error = "Out of memory";
+			result->image = DecodedImage();
+			result->fileData = std::vector<unsigned char>();
+		}
+		delete job;
+
+		auto end = std::chrono::high_resolution_clock::now();
+		result->decodeMs = std::chrono::duration<double, std::milli>(end - start).count();
+		decodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+		if (result->succeeded)
+		{
+			decoded++;
+			bytesDecoded += result->image.pixels.size() + result->fileData.size();
+		}
+		else
+			failed++;
+
+		// The render thread drains this every frame, so a full
+		// queue only ever means waiting a frame or two
+		while (!results.TryPush(result))
+		{
+			if (quitting)
+			{
+				delete result;
+				return;
+			}
+			std::this_thread::yield();
+		}
+	}
+}
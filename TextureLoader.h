@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "LockFreeQueue.h"
+#include "PngDecoder.h"
+
+// A finished decode, handed from a loader thread to the render thread
+struct TextureLoadResult {
+	int id;
+	std::string path;
+	bool succeeded;
+	std::string error;
+	DecodedImage image;
+	std::vector<unsigned char> fileData;	// Raw bytes of files the GPU takes as-is (.dds)
+	double decodeMs;
+};
+
+struct TextureLoaderStats {
+	int requested;
+	int decoded;
+	int failed;
+	int uploaded;
+	int pending;				// Requested but not uploaded yet
+	size_t bytesDecoded;		// RGBA8 bytes produced (or .dds bytes read)
+	double decodeMs;			// Summed across loader threads
+	double uploadMs;			// Time spent in upload callbacks
+	double elapsedMs;			// First request to last upload (or now)
+};
+
+// --------------------------------------------------------
+// Decodes textures on background threads
+//
+// - Request() queues a file and the callback that turns the
+//   decoded pixels into something usable (a GPU texture,
+//   or nothing at all when just measuring)
+// - Loader threads decode and push results onto a lock-free
+//   queue; ProcessCompleted() drains it on the calling
+//   thread, so callbacks can touch the device context
+// - Requests for a file already in flight share one decode
+// - Cooked .dds files are only read, never decoded
+//
+// Nothing here knows about D3D, so the whole pipeline runs
+// anywhere with a stubbed upload callback.
+// --------------------------------------------------------
+class TextureLoader
+{
+public:
+	typedef std::function<void(const TextureLoadResult&)> UploadCallback;
+
+	// 0 threads picks half the hardware threads
+	TextureLoader(unsigned int threadCount = 0);
+	~TextureLoader();
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	// Returns an id for the request (shared by duplicate paths)
+	int Request(const std::string& path, UploadCallback onLoaded);
+
+	// Runs upload callbacks for up to maxUploads finished
+	// textures (-1 for all of them), returns how many ran
+	int ProcessCompleted(int maxUploads = -1);
+
+	// Blocks until every request so far has been uploaded
+	void WaitForAll();
+
+	bool IsIdle();
+	unsigned int GetThreadCount();
+	TextureLoaderStats GetStats();
+
+private:
+	struct Job {
+		int id;
+		std::string path;
+	};
+
+	void WorkerLoop();
+	void SubmitJobs();
+
+	std::vector<std::thread> workers;
+
+	// Main thread -> loader threads -> main thread
+	LockFreeQueue<Job*> jobs;
+	LockFreeQueue<TextureLoadResult*> results;
+	std::vector<Job*> overflow;		// Jobs waiting for room in the queue
+
+	// Sleeping when there's nothing to decode
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<int> queuedJobs;
+	std::atomic<bool> quitting;
+
+	// Main thread only
+	std::unordered_map<int, std::vector<UploadCallback>> callbacks;
+	std::unordered_map<std::string, int> inFlight;
+	int nextId;
+
+	// Stats (the atomic ones are written by loader threads)
+	std::atomic<int> decoded;
+	std::atomic<int> failed;
+	std::atomic<size_t> bytesDecoded;
+	std::atomic<long long> decodeMicroseconds;
+	int requested;
+	int uploaded;
+	double uploadMs;
+	std::chrono::high_resolution_clock::time_point firstRequest;
+	double elapsedMs;
+};
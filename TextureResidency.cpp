@@ -0,0 +1,266 @@
+#include "TextureResidency.h"
+#include <algorithm>
+#include <cmath>
+
+TextureResidency::TextureResidency(size_t budgetBytes) :
+	budget(budgetBytes),
+	idleFrames(120),
+	maxStreamIns(2),
+	tailSize(64),
+	frame(0),
+	stats()
+{
+}
+
+int TextureResidency::AddTexture(const ResidencyTextureDesc& desc, int residentMip)
+{
+	Entry entry = {};
+	entry.desc = desc;
+	entry.desc.mipCount = std::max(1, desc.mipCount);
+	entry.residentMip = std::min(std::max(0, residentMip), entry.desc.mipCount - 1);
+	entry.neededMip = entry.residentMip;
+	entry.targetMip = entry.residentMip;
+	entry.lastUsedFrame = frame;
+	entries.push_back(entry);
+
+	// Works out the tail for the new entry
+	SetTailSize(tailSize);
+	return (int)entries.size() - 1;
+}
+
+void TextureResidency::SetBudget(size_t budgetBytes)
+{
+	budget = budgetBytes;
+}
+
+size_t TextureResidency::GetBudget()
+{
+	return budget;
+}
+
+void TextureResidency::SetIdleFrames(int frames)
+{
+	idleFrames = std::max(0, frames);
+}
+
+void TextureResidency::SetMaxStreamIns(int count)
+{
+	maxStreamIns = std::max(1, count);
+}
+
+void TextureResidency::SetTailSize(int texels)
+{
+	tailSize = std::max(1, texels);
+	for (auto& e : entries)
+	{
+		// First level no bigger than the tail size
+		int size = std::max(e.desc.width, e.desc.height);
+		int mip = 0;
+		while (mip < e.desc.mipCount - 1 && (size >> mip) > tailSize)
+			mip++;
+		e.tailMip = e.desc.pinned ? 0 : mip;
+	}
+}
+
+void TextureResidency::BeginFrame(unsigned long long _frame)
+{
+	frame = _frame;
+	for (auto& e : entries)
+	{
+		e.usedThisFrame = false;
+		e.screenTexels = 0;
+	}
+}
+
+void TextureResidency::ReportUse(int texture, float screenTexels)
+{
+	if (texture < 0 || texture >= (int)entries.size())
+		return;
+
+	Entry& e = entries[texture];
+	e.usedThisFrame = true;
+	e.screenTexels = std::max(e.screenTexels, screenTexels);
+	e.lastUsedFrame = frame;
+}
+
+// --------------------------------------------------------
+// Needed mips first, then the budget takes mips away from
+// the least recently used (and then smallest on screen)
+// textures until everything fits, one level at a time.
+// Whatever differs from what's resident becomes an action.
+// --------------------------------------------------------
+std::vector<ResidencyAction> TextureResidency::Update()
+{
+	size_t wanted = 0;
+	for (auto& e : entries)
+	{
+		if (e.desc.pinned)
+			e.neededMip = 0;
+		else if (e.usedThisFrame)
+		{
+			int needed = MipForScreenSize(std::max(e.desc.width, e.desc.height), e.screenTexels, e.desc.mipCount);
+
+			// One level of slack, so something hovering around a
+			// mip boundary doesn't evict and reload every frame
+			if (needed == e.residentMip + 1)
+				needed = e.residentMip;
+			e.neededMip = std::min(needed, e.tailMip);
+		}
+		else if (frame - e.lastUsedFrame > (unsigned long long)idleFrames)
+			e.neededMip = e.tailMip;
+
+		e.targetMip = e.neededMip;
+		wanted += MipChainBytes(e.desc, e.targetMip);
+	}
+
+	// Over budget? Least recently used, then least visible, lose mips first
+	size_t total = wanted;
+	if (total > budget)
+	{
+		std::vector<int> order;
+		for (int i = 0; i < (int)entries.size(); i++)
+			if (!entries[i].desc.pinned)
+				order.push_back(i);
+
+		std::sort(order.begin(), order.end(), [this](int a, int b) {
+			const Entry& ea = entries[a];
+			const Entry& eb = entries[b];
+			if (ea.lastUsedFrame != eb.lastUsedFrame) return ea.lastUsedFrame < eb.lastUsedFrame;
+			if (ea.screenTexels != eb.screenTexels) return ea.screenTexels < eb.screenTexels;
+			return a < b;
+		});
+
+		for (int i : order)
+		{
+			Entry& e = entries[i];
+			while (total > budget && e.targetMip < e.tailMip)
+			{
+				total -= MipChainBytes(e.desc, e.targetMip) - MipChainBytes(e.desc, e.targetMip + 1);
+				e.targetMip++;
+			}
+			if (total <= budget)
+				break;
+		}
+	}
+
+	std::vector<ResidencyAction> actions;
+
+	// Evictions first, they make room for the stream-ins
+	for (int i = 0; i < (int)entries.size(); i++)
+	{
+		Entry& e = entries[i];
+		if (!e.streaming && e.targetMip > e.residentMip)
+		{
+			actions.push_back({ ResidencyActionType::Evict, i, e.residentMip, e.targetMip });
+			stats.totalEvictions++;
+		}
+	}
+
+	// Stream-ins for whatever's most recently used and biggest on screen
+	std::vector<int> loads;
+	int inFlight = 0;
+	for (int i = 0; i < (int)entries.size(); i++)
+	{
+		if (entries[i].streaming)
+			inFlight++;
+		else if (entries[i].targetMip < entries[i].residentMip)
+			loads.push_back(i);
+	}
+
+	std::sort(loads.begin(), loads.end(), [this](int a, int b) {
+		const Entry& ea = entries[a];
+		const Entry& eb = entries[b];
+		if (ea.lastUsedFrame != eb.lastUsedFrame) return ea.lastUsedFrame > eb.lastUsedFrame;
+		if (ea.screenTexels != eb.screenTexels) return ea.screenTexels > eb.screenTexels;
+		return a < b;
+	});
+
+	for (int i : loads)
+	{
+		if (inFlight >= maxStreamIns)
+			break;
+
+		Entry& e = entries[i];
+		e.streaming = true;
+		actions.push_back({ ResidencyActionType::StreamIn, i, e.residentMip, e.targetMip });
+		stats.totalStreamIns++;
+		inFlight++;
+	}
+
+	// Stats
+	stats.budgetBytes = budget;
+	stats.wantedBytes = wanted;
+	stats.targetBytes = total;
+	stats.textures = (int)entries.size();
+	stats.streamingIn = inFlight;
+	stats.degraded = 0;
+	for (auto& e : entries)
+		if (e.targetMip > e.neededMip)
+			stats.degraded++;
+
+	return actions;
+}
+
+void TextureResidency::SetResidentMip(int texture, int mip)
+{
+	if (texture < 0 || texture >= (int)entries.size())
+		return;
+
+	Entry& e = entries[texture];
+	e.residentMip = std::min(std::max(0, mip), e.desc.mipCount - 1);
+	e.streaming = false;
+}
+
+int TextureResidency::GetResidentMip(int texture)
+{
+	return entries[texture].residentMip;
+}
+
+int TextureResidency::GetNeededMip(int texture)
+{
+	return entries[texture].neededMip;
+}
+
+int TextureResidency::GetTargetMip(int texture)
+{
+	return entries[texture].targetMip;
+}
+
+bool TextureResidency::IsStreaming(int texture)
+{
+	return entries[texture].streaming;
+}
+
+ResidencyStats TextureResidency::GetStats()
+{
+	stats.residentBytes = 0;
+	for (auto& e : entries)
+		stats.residentBytes += MipChainBytes(e.desc, e.residentMip);
+	return stats;
+}
+
+int TextureResidency::MipForScreenSize(int textureSize, float screenTexels, int mipCount)
+{
+	if (mipCount <= 1)
+		return 0;
+	if (screenTexels < 1.0f)
+		return mipCount - 1;
+
+	int mip = (int)floorf(log2f(textureSize / screenTexels));
+	return std::min(std::max(0, mip), mipCount - 1);
+}
+
+size_t TextureResidency::MipChainBytes(const ResidencyTextureDesc& desc, int fromMip)
+{
+	size_t bytes = 0;
+	for (int mip = std::max(0, fromMip); mip < desc.mipCount; mip++)
+	{
+		size_t w = (size_t)std::max(1, desc.width >> mip);
+		size_t h = (size_t)std::max(1, desc.height >> mip);
+		if (desc.bytesPerBlock > 0)
+			bytes += ((w + 3) / 4) * ((h + 3) / 4) * desc.bytesPerBlock;
+		else
+			bytes += w * h * 4;
+	}
+	return bytes;
+}
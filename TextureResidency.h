@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// What the policy needs to know about one texture
+struct ResidencyTextureDesc {
+	int width;
+	int height;
+	int mipCount;
+	int bytesPerBlock;	// 4x4 block size for compressed formats, 0 for RGBA8
+	bool pinned;		// Always fully resident (never streamed or evicted)
+};
+
+enum class ResidencyActionType {
+	StreamIn,	// Load finer mips (asynchronous)
+	Evict		// Drop the finest mips (immediate)
+};
+
+// Something the policy wants done; the caller reports back
+// with SetResidentMip() when it has happened
+struct ResidencyAction {
+	ResidencyActionType type;
+	int texture;
+	int fromMip;	// Finest mip resident now
+	int toMip;		// Finest mip resident afterwards
+};
+
+struct ResidencyStats {
+	size_t budgetBytes;
+	size_t residentBytes;		// Mips on the GPU right now
+	size_t wantedBytes;			// What every texture would like, ignoring the budget
+	size_t targetBytes;			// What the budget allows this frame
+	int textures;
+	int streamingIn;			// Stream-ins in flight
+	int degraded;				// Textures held coarser than they'd like
+	int totalStreamIns;
+	int totalEvictions;
+};
+
+// --------------------------------------------------------
+// Decides which mip levels of each texture should be on the
+// GPU, within a memory budget
+//
+// - Each frame, ReportUse() says how many texels across a
+//   texture would be shown at most; that picks the mip it
+//   needs (textures that aren't reported keep what they have
+//   until they've gone unused for a while)
+// - Update() fits the needed mips into the budget, taking
+//   mips away from the least recently used textures first,
+//   then from the ones covering the least of the screen
+// - It returns stream-ins and evictions for the caller to
+//   carry out; a texture with a stream-in in flight isn't
+//   touched again until SetResidentMip() reports it done
+//
+// Knows nothing about files or D3D, and the frame number is
+// handed in, so the same calls always give the same actions.
+// --------------------------------------------------------
+class TextureResidency
+{
+public:
+	TextureResidency(size_t budgetBytes);
+
+	// Returns the id used by every other call
+	int AddTexture(const ResidencyTextureDesc& desc, int residentMip);
+
+	void SetBudget(size_t budgetBytes);
+	size_t GetBudget();
+
+	// Frames a texture can go unused before it drops to its tail
+	void SetIdleFrames(int frames);
+
+	// Most stream-ins Update() starts at once
+	void SetMaxStreamIns(int count);
+
+	// Mips no smaller than this many texels are never evicted,
+	// so there's always something to sample
+	void SetTailSize(int texels);
+
+	void BeginFrame(unsigned long long frame);
+	void ReportUse(int texture, float screenTexels);
+	std::vector<ResidencyAction> Update();
+
+	// Called once an action (or anything else) has changed
+	// what's actually on the GPU
+	void SetResidentMip(int texture, int mip);
+
+	int GetResidentMip(int texture);
+	int GetNeededMip(int texture);
+	int GetTargetMip(int texture);
+	bool IsStreaming(int texture);
+	ResidencyStats GetStats();
+
+	// Coarsest mip that still has at least screenTexels texels across
+	static int MipForScreenSize(int textureSize, float screenTexels, int mipCount);
+
+	// Bytes for levels fromMip through the smallest
+	static size_t MipChainBytes(const ResidencyTextureDesc& desc, int fromMip);
+
+private:
+	struct Entry {
+		ResidencyTextureDesc desc;
+		int residentMip;
+		int neededMip;
+		int targetMip;
+		int tailMip;
+		float screenTexels;					// Largest use this frame
+		unsigned long long lastUsedFrame;
+		bool usedThisFrame;
+		bool streaming;
+	};
+
+	std::vector<Entry> entries;
+	size_t budget;
+	int idleFrames;
+	int maxStreamIns;
+	int tailSize;
+	unsigned long long frame;
+	ResidencyStats stats;
+};
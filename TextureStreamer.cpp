@@ -0,0 +1,303 @@
+#include "TextureStreamer.h"
+#include "Graphics.h"
+#include "Profiler.h"
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	DXGI_FORMAT ToDxgiFormat(BlockFormat format)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+		case BlockFormat::BC4: return DXGI_FORMAT_BC4_UNORM;
+		case BlockFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+		case BlockFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+		default: return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+
+	// Size of a mip level along one axis
+	int MipSize(int size, int mip)
+	{
+		int s = size >> mip;
+		return s > 0 ? s : 1;
+	}
+}
+
+TextureStreamer::TextureStreamer(TextureLoader& loader, size_t budgetBytes) :
+	loader(loader),
+	policy(budgetBytes),
+	frame(0),
+	mipBias(0)
+{
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> TextureStreamer::Create(const std::string& path, const std::vector<unsigned char>& fileData)
+{
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> existing = Find(path);
+	if (existing)
+		return existing;
+
+	StreamedTexture streamed = {};
+	streamed.path = path;
+	if (!TextureCooker::ReadDdsInfo(fileData.data(), fileData.size(), streamed.info) || streamed.info.cube)
+		return nullptr;
+
+	// Starts out fully resident; the policy trims it next frame if needed
+	int residentMip = Upload(streamed, fileData.data(), 0);
+	if (residentMip < 0)
+		return nullptr;
+
+	ResidencyTextureDesc desc = {};
+	desc.width = streamed.info.width;
+	desc.height = streamed.info.height;
+	desc.mipCount = streamed.info.mipCount;
+	desc.bytesPerBlock = BlockCompression::BytesPerBlock(streamed.info.format);
+
+	int id = policy.AddTexture(desc, residentMip);
+	textureIndices[path] = id;
+	textures.push_back(streamed);
+	return textures[id].srv;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> TextureStreamer::Find(const std::string& path)
+{
+	auto it = textureIndices.find(path);
+	if (it == textureIndices.end())
+		return nullptr;
+	return textures[it->second].srv;
+}
+
+void TextureStreamer::Bind(const std::string& path, std::shared_ptr<Material> material, unsigned int slot)
+{
+	auto it = textureIndices.find(path);
+	if (it == textureIndices.end())
+		return;
+
+	textures[it->second].bindings.push_back({ material, slot });
+	materialTextures[material.get()].push_back(it->second);
+}
+
+// --------------------------------------------------------
+// Screen size of every entity -> texels each of its
+// material's textures needs, then carries out whatever the
+// policy decides
+// --------------------------------------------------------
+void TextureStreamer::Update(const RenderSnapshot& snapshot, const std::vector<std::shared_ptr<Material>>& materials, int screenWidth, int screenHeight)
+{
+	PROFILE_SCOPE("Texture streaming");
+	policy.BeginFrame(++frame);
+
+	const SnapshotCamera& camera = snapshot.camera;
+	XMMATRIX viewMatrix = XMLoadFloat4x4(&camera.view);
+	bool perspective = camera.perspective;
+	float pixelsPerUnit = perspective ?
+		screenHeight / (2.0f * tanf(camera.fieldOfView * 0.5f)) :	// At a distance of 1
+		screenWidth / camera.orthographicWidth;
+	float bias = powf(2.0f, -mipBias);
+
+	for (const Renderable& r : snapshot.renderables)
+	{
+		Material* material = materials[r.material].get();
+		auto found = materialTextures.find(material);
+		if (found == materialTextures.end())
+			continue;
+
+		XMFLOAT3 center = r.center;
+		float radius = r.radius;
+		float viewZ = XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&center), viewMatrix));
+		if (viewZ + radius < camera.nearClip)
+			continue; // Behind the camera
+
+		// Diameter on screen, capped once the camera is inside the sphere
+		float pixels = 2.0f * radius * pixelsPerUnit;
+		if (perspective)
+			pixels /= viewZ > radius ? viewZ : radius;
+
+		// Tiling spreads the texture's texels over less of the screen
+		XMFLOAT2 uvScale = material->GetUVScale();
+		float tiling = fabsf(uvScale.x) > fabsf(uvScale.y) ? fabsf(uvScale.x) : fabsf(uvScale.y);
+		if (tiling < 1.0f) tiling = 1.0f;
+
+		for (int index : found->second)
+			policy.ReportUse(index, pixels / tiling * bias);
+	}
+
+	for (auto& action : policy.Update())
+	{
+		StreamedTexture& streamed = textures[action.texture];
+		if (action.type == ResidencyActionType::Evict)
+		{
+			int mip = Evict(streamed, action.fromMip, action.toMip);
+			policy.SetResidentMip(action.texture, mip < 0 ? action.fromMip : mip);
+		}
+		else
+			StreamIn(action.texture, action.toMip);
+	}
+}
+
+// --------------------------------------------------------
+// Re-reads the file on a loader thread; the upload happens
+// in TextureLoader::ProcessCompleted() on the main thread
+// --------------------------------------------------------
+void TextureStreamer::StreamIn(int index, int toMip)
+{
+	loader.Request(textures[index].path,
+		[this, index, toMip](const TextureLoadResult& result) {
+			StreamedTexture& streamed = textures[index];
+			int mip = -1;
+			CookedDdsInfo info;
+			if (result.succeeded &&
+				TextureCooker::ReadDdsInfo(result.fileData.data(), result.fileData.size(), info) &&
+				info.width == streamed.info.width && info.height == streamed.info.height &&
+				info.mipCount == streamed.info.mipCount && info.format == streamed.info.format)
+				mip = Upload(streamed, result.fileData.data(), toMip);
+
+			// Failures keep what's there (and clear the in-flight flag)
+			policy.SetResidentMip(index, mip < 0 ? policy.GetResidentMip(index) : mip);
+		});
+}
+
+// --------------------------------------------------------
+// Block-compressed textures need a top level that's a
+// multiple of 4 texels, so this backs up to the nearest
+// mip that is
+// --------------------------------------------------------
+int TextureStreamer::ValidTopMip(const StreamedTexture& streamed, int mip)
+{
+	if (mip > streamed.info.mipCount - 1) mip = streamed.info.mipCount - 1;
+	if (mip < 0) mip = 0;
+	while (mip > 0 && (((streamed.info.width >> mip) % 4) != 0 || ((streamed.info.height >> mip) % 4) != 0))
+		mip--;
+	return mip;
+}
+
+int TextureStreamer::Upload(StreamedTexture& streamed, const unsigned char* fileData, int fromMip)
+{
+	const CookedDdsInfo& info = streamed.info;
+	fromMip = ValidTopMip(streamed, fromMip);
+
+	// Levels are tightly packed after the headers
+	std::vector<D3D11_SUBRESOURCE_DATA> levels;
+	size_t offset = info.dataOffset;
+	for (int mip = 0; mip < info.mipCount; mip++)
+	{
+		int w = MipSize(info.width, mip);
+		int h = MipSize(info.height, mip);
+		if (mip >= fromMip)
+		{
+			D3D11_SUBRESOURCE_DATA level = {};
+			level.pSysMem = fileData + offset;
+			level.SysMemPitch = ((w + 3) / 4) * BlockCompression::BytesPerBlock(info.format);
+			levels.push_back(level);
+		}
+		offset += BlockCompression::CompressedSize(w, h, info.format);
+	}
+
+	D3D11_TEXTURE2D_DESC texDesc = {};
+	texDesc.Width = MipSize(info.width, fromMip);
+	texDesc.Height = MipSize(info.height, fromMip);
+	texDesc.MipLevels = info.mipCount - fromMip;
+	texDesc.ArraySize = 1;
+	texDesc.Format = ToDxgiFormat(info.format);
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Usage = D3D11_USAGE_DEFAULT;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Graphics::Device->CreateTexture2D(&texDesc, levels.data(), texture.GetAddressOf());
+	if (!texture)
+		return -1;
+
+	Replace(streamed, texture);
+	return streamed.srv ? fromMip : -1;
+}
+
+// --------------------------------------------------------
+// Copies the mips that stay into a smaller texture, all on
+// the GPU, so dropping detail never touches the disk
+// --------------------------------------------------------
+int TextureStreamer::Evict(StreamedTexture& streamed, int fromMip, int toMip)
+{
+	toMip = ValidTopMip(streamed, toMip);
+	if (toMip <= fromMip || !streamed.texture)
+		return fromMip;
+
+	D3D11_TEXTURE2D_DESC texDesc = {};
+	streamed.texture->GetDesc(&texDesc);
+	texDesc.Width = MipSize(streamed.info.width, toMip);
+	texDesc.Height = MipSize(streamed.info.height, toMip);
+	texDesc.MipLevels = streamed.info.mipCount - toMip;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Graphics::Device->CreateTexture2D(&texDesc, 0, texture.GetAddressOf());
+	if (!texture)
+		return -1;
+
+	int dropped = toMip - fromMip;
+	for (UINT mip = 0; mip < texDesc.MipLevels; mip++)
+		Graphics::Context->CopySubresourceRegion(texture.Get(), mip, 0, 0, 0, streamed.texture.Get(), mip + dropped, 0);
+
+	Replace(streamed, texture);
+	return streamed.srv ? toMip : -1;
+}
+
+void TextureStreamer::Replace(StreamedTexture& streamed, Microsoft::WRL::ComPtr<ID3D11Texture2D> texture)
+{
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	Graphics::Device->CreateShaderResourceView(texture.Get(), 0, srv.GetAddressOf());
+	if (!srv)
+		return;
+
+	// The old texture goes away once nothing references it
+	streamed.texture = texture;
+	streamed.srv = srv;
+	for (auto& binding : streamed.bindings)
+		binding.material->SetTextureSRV(binding.slot, srv);
+}
+
+void TextureStreamer::SetBudget(size_t budgetBytes)
+{
+	policy.SetBudget(budgetBytes);
+}
+
+size_t TextureStreamer::GetBudget()
+{
+	return policy.GetBudget();
+}
+
+void TextureStreamer::SetMipBias(float bias)
+{
+	mipBias = bias;
+}
+
+float TextureStreamer::GetMipBias()
+{
+	return mipBias;
+}
+
+int TextureStreamer::GetTextureCount()
+{
+	return (int)textures.size();
+}
+
+StreamedTextureInfo TextureStreamer::GetTextureInfo(int index)
+{
+	StreamedTextureInfo info = {};
+	info.path = textures[index].path;
+	info.width = textures[index].info.width;
+	info.height = textures[index].info.height;
+	info.residentMip = policy.GetResidentMip(index);
+	info.neededMip = policy.GetNeededMip(index);
+	info.targetMip = policy.GetTargetMip(index);
+	info.streaming = policy.IsStreaming(index);
+	return info;
+}
+
+ResidencyStats TextureStreamer::GetStats()
+{
+	return policy.GetStats();
+}
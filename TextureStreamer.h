@@ -0,0 +1,95 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Material.h"
+#include "RenderSnapshot.h"
+#include "TextureCooker.h"
+#include "TextureLoader.h"
+#include "TextureResidency.h"
+
+// One streamed texture, for the UI
+struct StreamedTextureInfo {
+	std::string path;
+	int width;
+	int height;
+	int residentMip;
+	int neededMip;
+	int targetMip;
+	bool streaming;
+};
+
+// --------------------------------------------------------
+// Keeps cooked (DDS) textures within a GPU memory budget
+//
+// - Every frame, estimates how big each material's textures
+//   appear from the screen-space size of the entities using
+//   them, and hands that to a TextureResidency policy
+// - Evictions copy the remaining mips into a smaller texture
+//   on the GPU; stream-ins re-read the DDS on the loader
+//   threads and upload from the finer mip on this thread
+// - New textures replace the old ones in every material
+//   slot they were bound to
+//
+// PNG fallbacks (GPU-generated mips) and cube maps aren't
+// streamed and don't count against the budget.
+// --------------------------------------------------------
+class TextureStreamer
+{
+public:
+	TextureStreamer(TextureLoader& loader, size_t budgetBytes);
+
+	// Full chain from a cooked DDS already in memory, or null
+	// for anything the streamer can't manage
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Create(const std::string& path, const std::vector<unsigned char>& fileData);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Find(const std::string& path);
+
+	// Material slots get the new texture whenever it changes
+	void Bind(const std::string& path, std::shared_ptr<Material> material, unsigned int slot);
+
+	// The snapshot's material indices point into materials
+	void Update(const RenderSnapshot& snapshot, const std::vector<std::shared_ptr<Material>>& materials, int screenWidth, int screenHeight);
+
+	void SetBudget(size_t budgetBytes);
+	size_t GetBudget();
+
+	// Positive values ask for coarser mips than the screen size suggests
+	void SetMipBias(float bias);
+	float GetMipBias();
+
+	int GetTextureCount();
+	StreamedTextureInfo GetTextureInfo(int index);
+	ResidencyStats GetStats();
+
+private:
+	struct Binding {
+		std::shared_ptr<Material> material;
+		unsigned int slot;
+	};
+
+	struct StreamedTexture {
+		std::string path;
+		CookedDdsInfo info;
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+		std::vector<Binding> bindings;
+	};
+
+	// Both return the finest mip now resident, or -1 on failure
+	int Upload(StreamedTexture& streamed, const unsigned char* fileData, int fromMip);
+	int Evict(StreamedTexture& streamed, int fromMip, int toMip);
+	int ValidTopMip(const StreamedTexture& streamed, int mip);
+	void StreamIn(int index, int toMip);
+	void Replace(StreamedTexture& streamed, Microsoft::WRL::ComPtr<ID3D11Texture2D> texture);
+
+	TextureLoader& loader;
+	TextureResidency policy;
+	std::vector<StreamedTexture> textures;		// Same indices as the policy's ids
+	std::unordered_map<std::string, int> textureIndices;
+	std::unordered_map<Material*, std::vector<int>> materialTextures;
+	unsigned long long frame;
+	float mipBias;
+};
@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+ThreadPool::ThreadPool(unsigned int workerCount) :
+	job(0),
+	jobCount(0),
+	nextIndex(0),
+	generation(0),
+	busyWorkers(0),
+	quitting(false)
+{
+	if (workerCount == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quitting = true;
+	}
+	wake.notify_all();
+
+	for (auto& t : workers)
+		t.join();
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& _job)
+{
+	if (count <= 0)
+		return;
+
+	// Not worth waking anyone for a single item
+	if (count == 1 || workers.empty())
+	{
+		for (int i = 0; i < count; i++)
+			_job(i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> callerLock(callerMutex);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &_job;
+		jobCount = count;
+		nextIndex = 0;
+		busyWorkers = (unsigned int)workers.size();
+		generation++;
+	}
+	wake.notify_all();
+
+	// Help out instead of just waiting
+	RunJobs();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this] { return busyWorkers == 0; });
+	job = 0;
+}
+
+unsigned int ThreadPool::GetThreadCount()
+{
+	return (unsigned int)workers.size() + 1;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	PROFILE_THREAD("Pool worker");
+	unsigned int seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quitting || generation != seenGeneration; });
+			if (quitting)
+				return;
+			seenGeneration = generation;
+		}
+
+		RunJobs();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+		finished.notify_one();
+	}
+}
+
+// --------------------------------------------------------
+// Grabs indices until the batch is used up
+// --------------------------------------------------------
+void ThreadPool::RunJobs()
+{
+	while (true)
+	{
+		int index = nextIndex.fetch_add(1);
+		if (index >= jobCount)
+			return;
+		(*job)(index);
+	}
+}
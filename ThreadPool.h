@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Small fixed-size pool of worker threads
+//
+// ParallelFor() hands out indices [0, count) to the workers
+// and the calling thread, then blocks until all of them
+// have run. Jobs must not call ParallelFor() themselves;
+// calls from different threads take turns.
+// --------------------------------------------------------
+class ThreadPool
+{
+public:
+	// 0 workers picks one per hardware thread, minus the caller
+	ThreadPool(unsigned int workerCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void ParallelFor(int count, const std::function<void(int)>& job);
+
+	// Workers plus the calling thread
+	unsigned int GetThreadCount();
+
+private:
+	void WorkerLoop();
+	void RunJobs();
+
+	std::vector<std::thread> workers;
+
+	// One batch at a time, whoever asks
+	std::mutex callerMutex;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+
+	// Current batch
+	const std::function<void(int)>* job;
+	int jobCount;
+	std::atomic<int> nextIndex;
+	unsigned int generation;
+	unsigned int busyWorkers;
+	bool quitting;
+};
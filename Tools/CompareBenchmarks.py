@@ -0,0 +1,63 @@
+"""
+Compares two PerfBenchmarks JSON files and flags regressions
+
+Cases are matched by name and scale and compared on their
+median time. Anything slower than the baseline by more than
+the threshold is a regression, and the script exits with 1
+so it can gate a build.
+
+    python Tools/CompareBenchmarks.py baseline.json current.json [--threshold 10]
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {(r["name"], r["scale"]): r for r in data["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag PerfBenchmarks regressions")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="percent slower than the baseline that counts as a regression")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    print(f"{'case':<18} {'scale':>7} {'baseline':>12} {'current':>12} {'change':>8}")
+    for key in sorted(set(baseline) | set(current)):
+        name, scale = key
+        if key not in current:
+            print(f"{name:<18} {scale:>7}  missing from {args.current}")
+            continue
+        if key not in baseline:
+            print(f"{name:<18} {scale:>7}  new, {current[key]['median_ms']:.3f} ms")
+            continue
+
+        before = baseline[key]["median_ms"]
+        after = current[key]["median_ms"]
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+        status = ""
+        if change > args.threshold:
+            status = "REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            status = "faster"
+        print(f"{name:<18} {scale:>7} {before:>9.3f} ms {after:>9.3f} ms {change:>+7.1f}%  {status}".rstrip())
+
+    if regressions:
+        print(f"{regressions} regression(s) over {args.threshold:g}%")
+        return 1
+    print(f"No regressions over {args.threshold:g}%")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
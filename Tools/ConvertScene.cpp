@@ -0,0 +1,208 @@
+// --------------------------------------------------------
+// Offline scene converter
+//
+// Turns an authored text scene (.scene) into the binary form
+// (.sceneb) the game loads at startup, stamped with a hash of
+// the text so the game can tell when the binary is stale.
+//
+// Before writing, checks that nothing is lost on the way:
+// - text -> binary -> load gives back exactly the same data
+// - text -> WriteText -> parse gives back the same data, to
+//   within float formatting and the degree/radian round trip
+//
+// Standalone and platform independent, e.g. from the repo root:
+//   g++ -O2 -std=c++17 -I. Tools/ConvertScene.cpp SceneFile.cpp -o ConvertScene
+//   ./ConvertScene Assets/Scenes/Default.scene Assets/Cooked/Default.sceneb
+// ctest runs it on the default scene (SceneRoundTrip), writing into the build folder.
+// --------------------------------------------------------
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include "SceneFile.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	bool Near(const float* a, const float* b, int count)
+	{
+		for (int i = 0; i < count; i++)
+			if (std::fabs(a[i] - b[i]) > 1e-5f * (1.0f + std::fabs(a[i])))
+				return false;
+		return true;
+	}
+
+	// Every record is plain data, so exact means byte for byte
+	template <typename T>
+	bool SameBytes(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0);
+	}
+
+	bool Identical(const SceneDesc& a, const SceneDesc& b)
+	{
+		return memcmp(&a.settings, &b.settings, sizeof(SceneSettings)) == 0 &&
+			SameBytes(a.meshes, b.meshes) &&
+			SameBytes(a.materials, b.materials) &&
+			SameBytes(a.entities, b.entities) &&
+			SameBytes(a.lights, b.lights) &&
+			SameBytes(a.cameras, b.cameras);
+	}
+
+	// Floats within a tolerance, everything else exactly
+	bool Equivalent(const SceneDesc& a, const SceneDesc& b)
+	{
+		const SceneSettings& sa = a.settings;
+		const SceneSettings& sb = b.settings;
+		if (!Near(sa.ambientColor, sb.ambientColor, 3) || sa.activeCamera != sb.activeCamera || sa.skyMesh != sb.skyMesh ||
+			strcmp(sa.skyVertexShader, sb.skyVertexShader) || strcmp(sa.skyPixelShader, sb.skyPixelShader) ||
+			strcmp(sa.skyCubemap, sb.skyCubemap))
+			return false;
+		for (int i = 0; i < 6; i++)
+			if (strcmp(sa.skyFaces[i], sb.skyFaces[i]))
+				return false;
+
+		if (!SameBytes(a.meshes, b.meshes) || a.materials.size() != b.materials.size() || a.entities.size() != b.entities.size() ||
+			a.lights.size() != b.lights.size() || a.cameras.size() != b.cameras.size())
+			return false;
+
+		for (size_t i = 0; i < a.materials.size(); i++)
+		{
+			const SceneMaterialDesc& ma = a.materials[i];
+			const SceneMaterialDesc& mb = b.materials[i];
+			if (strcmp(ma.name, mb.name) || strcmp(ma.vertexShader, mb.vertexShader) || strcmp(ma.pixelShader, mb.pixelShader) ||
+				!Near(ma.colorTint, mb.colorTint, 3) || !Near(&ma.roughness, &mb.roughness, 1) ||
+				!Near(ma.uvScale, mb.uvScale, 2) || !Near(ma.uvOffset, mb.uvOffset, 2))
+				return false;
+			for (int t = 0; t < 4; t++)
+				if (strcmp(ma.textures[t], mb.textures[t]))
+					return false;
+		}
+
+		for (size_t i = 0; i < a.entities.size(); i++)
+		{
+			const SceneEntityDesc& ea = a.entities[i];
+			const SceneEntityDesc& eb = b.entities[i];
+			if (ea.mesh != eb.mesh || ea.material != eb.material || ea.flags != eb.flags ||
+				!Near(ea.position, eb.position, 3) || !Near(ea.rotation, eb.rotation, 3) || !Near(ea.scale, eb.scale, 3) ||
+				!Near(ea.spin, eb.spin, 3) || !Near(ea.sway, eb.sway, 3))
+				return false;
+			// The speed is only written out with a sway
+			bool sways = ea.sway[0] != 0 || ea.sway[1] != 0 || ea.sway[2] != 0;
+			if (sways && !Near(&ea.swaySpeed, &eb.swaySpeed, 1))
+				return false;
+		}
+
+		for (size_t i = 0; i < a.lights.size(); i++)
+		{
+			const SceneLightDesc& la = a.lights[i];
+			const SceneLightDesc& lb = b.lights[i];
+			if (la.type != lb.type || !Near(la.color, lb.color, 3) || !Near(&la.intensity, &lb.intensity, 1))
+				return false;
+			// Only the fields that apply to the type are written out
+			if (la.type != 1 && !Near(la.direction, lb.direction, 3))
+				return false;
+			if (la.type != 0 && (!Near(la.position, lb.position, 3) || !Near(&la.range, &lb.range, 1)))
+				return false;
+			if (la.type == 2 && (!Near(&la.spotInnerAngle, &lb.spotInnerAngle, 1) || !Near(&la.spotOuterAngle, &lb.spotOuterAngle, 1)))
+				return false;
+			if (la.attachEntity != lb.attachEntity || (la.attachEntity >= 0 && !Near(la.attachOffset, lb.attachOffset, 3)))
+				return false;
+		}
+
+		for (size_t i = 0; i < a.cameras.size(); i++)
+		{
+			const SceneCameraDesc& ca = a.cameras[i];
+			const SceneCameraDesc& cb = b.cameras[i];
+			if (ca.projection != cb.projection || !Near(ca.position, cb.position, 3) || !Near(&ca.moveSpeed, &cb.moveSpeed, 1) ||
+				!Near(&ca.lookSpeed, &cb.lookSpeed, 1) || !Near(&ca.fieldOfView, &cb.fieldOfView, 1) ||
+				!Near(&ca.nearClip, &cb.nearClip, 1) || !Near(&ca.farClip, &cb.farClip, 1))
+				return false;
+			if (ca.projection == SCENE_CAMERA_ORTHOGRAPHIC && !Near(&ca.orthoWidth, &cb.orthoWidth, 1))
+				return false;
+		}
+		return true;
+	}
+
+	double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: ConvertScene <input.scene> <output.sceneb>\n");
+		return 1;
+	}
+
+	std::string inputPath = argv[1];
+	std::string outputPath = argv[2];
+
+	auto start = std::chrono::high_resolution_clock::now();
+	SceneDesc scene;
+	std::string error;
+	if (!SceneFile::LoadText(inputPath, scene, &error))
+	{
+		printf("%s: %s\n", inputPath.c_str(), error.c_str());
+		return 1;
+	}
+	double textMs = MillisecondsSince(start);
+
+	// Text -> text
+	SceneDesc reparsed;
+	if (!SceneFile::ParseText(SceneFile::WriteText(scene), reparsed, &error))
+	{
+		printf("Written text doesn't parse: %s\n", error.c_str());
+		return 1;
+	}
+	if (!Equivalent(scene, reparsed))
+	{
+		printf("Written text doesn't match the original\n");
+		return 1;
+	}
+
+	// Text -> binary, written next to the output first so a failed check leaves the old one alone
+	fs::path outputDir = fs::path(outputPath).parent_path();
+	if (!outputDir.empty())
+		fs::create_directories(outputDir);
+
+	std::string tempPath = outputPath + ".tmp";
+	if (!SceneFile::SaveBinary(tempPath, scene, SceneFile::HashFile(inputPath)))
+	{
+		printf("Couldn't write %s\n", tempPath.c_str());
+		return 1;
+	}
+
+	start = std::chrono::high_resolution_clock::now();
+	SceneDesc loaded;
+	bool loadedOk = SceneFile::LoadBinary(tempPath, loaded, &error);
+	double binaryMs = MillisecondsSince(start);
+	if (!loadedOk || !Identical(scene, loaded))
+	{
+		printf("Binary round trip failed%s%s\n", loadedOk ? "" : ": ", error.c_str());
+		fs::remove(tempPath);
+		return 1;
+	}
+
+	std::error_code ec;
+	fs::rename(tempPath, outputPath, ec);
+	if (ec)
+	{
+		printf("Couldn't write %s: %s\n", outputPath.c_str(), ec.message().c_str());
+		return 1;
+	}
+
+	printf("%s: %d meshes, %d materials, %d entities, %d lights, %d cameras\n",
+		inputPath.c_str(), (int)scene.meshes.size(), (int)scene.materials.size(),
+		(int)scene.entities.size(), (int)scene.lights.size(), (int)scene.cameras.size());
+	printf("  text   %7d bytes, parsed in %.3f ms\n", (int)fs::file_size(inputPath), textMs);
+	printf("  binary %7d bytes, loaded in %.3f ms\n", (int)fs::file_size(outputPath), binaryMs);
+	printf("Round trips OK, wrote %s\n", outputPath.c_str());
+	return 0;
+}
@@ -0,0 +1,185 @@
+// --------------------------------------------------------
+// Offline texture cooker
+//
+// Cooks every PNG in a folder into a block-compressed DDS
+// with a full mip chain (see TextureCooker.h). The six sky
+// faces (right/left/up/down/front/back.png) become a single
+// cube map, sky.dds, and each material's _roughness, _metal
+// (and _occlusion, if there is one) maps are also packed into
+// a single <material>_orm.dds. Sources that haven't changed
+// since the last cook are skipped unless --force is given.
+//
+// Standalone and platform independent, e.g. from the repo root:
+//   g++ -O2 -std=c++17 -pthread -I. Tools/CookTextures.cpp TextureCooker.cpp
+//       BlockCompression.cpp PngDecoder.cpp ThreadPool.cpp Profiler.cpp -o CookTextures
+//   ./CookTextures Assets/Textures Assets/Cooked [--force] [--box]
+// --------------------------------------------------------
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "TextureCooker.h"
+#include "ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+struct CookJob {
+	std::string name;
+	std::vector<std::string> sources;	// Six for the sky cube
+	bool orm;							// Sources are roughness, metalness, occlusion (maybe empty)
+	std::string output;
+	CookSettings settings;
+	CookResult result;
+};
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: CookTextures <source folder> <output folder> [--force] [--box]\n");
+		return 1;
+	}
+
+	fs::path sourceDir = argv[1];
+	fs::path outputDir = argv[2];
+	bool force = false;
+	bool box = false;
+	for (int i = 3; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--force") == 0) force = true;
+		else if (strcmp(argv[i], "--box") == 0) box = true;
+	}
+
+	std::error_code error;
+	fs::create_directories(outputDir, error);
+
+	// Sky faces in cube map order: +X, -X, +Y, -Y, +Z, -Z
+	const char* skyFaces[6] = { "right", "left", "up", "down", "front", "back" };
+	std::vector<CookJob> jobs;
+	std::vector<std::string> skySources;
+	for (auto& face : skyFaces)
+	{
+		fs::path path = sourceDir / (std::string(face) + ".png");
+		if (fs::exists(path))
+			skySources.push_back(path.string());
+	}
+
+	for (auto& entry : fs::directory_iterator(sourceDir, error))
+	{
+		if (entry.path().extension() != ".png")
+			continue;
+
+		// Sky faces are cooked together below
+		std::string stem = entry.path().stem().string();
+		bool isSkyFace = false;
+		for (auto& face : skyFaces)
+			isSkyFace |= skySources.size() == 6 && stem == face;
+		if (isSkyFace)
+			continue;
+
+		CookJob job = {};
+		job.name = stem;
+		job.sources = { entry.path().string() };
+		job.output = (outputDir / (stem + ".dds")).string();
+		job.settings = TextureCooker::DefaultSettings(TextureCooker::KindFromFileName(stem));
+		jobs.push_back(job);
+	}
+
+	// Pack every material that has both roughness and metalness
+	const std::string roughnessSuffix = "_roughness";
+	size_t singleJobs = jobs.size();
+	for (size_t i = 0; i < singleJobs; i++)
+	{
+		const std::string& stem = jobs[i].name;
+		if (stem.size() <= roughnessSuffix.size() ||
+			stem.compare(stem.size() - roughnessSuffix.size(), roughnessSuffix.size(), roughnessSuffix) != 0)
+			continue;
+
+		std::string prefix = stem.substr(0, stem.size() - roughnessSuffix.size());
+		fs::path metalness = sourceDir / (prefix + "_metal.png");
+		fs::path occlusion = sourceDir / (prefix + "_occlusion.png");
+		if (!fs::exists(metalness))
+			continue;
+
+		CookJob job = {};
+		job.name = prefix + "_orm";
+		job.sources = { jobs[i].sources[0], metalness.string(), fs::exists(occlusion) ? occlusion.string() : "" };
+		job.orm = true;
+		job.output = (outputDir / (job.name + ".dds")).string();
+		job.settings = TextureCooker::DefaultSettings(TextureKind::Orm);
+		jobs.push_back(job);
+	}
+
+	if (skySources.size() == 6)
+	{
+		CookJob job = {};
+		job.name = "sky";
+		job.sources = skySources;
+		job.output = (outputDir / "sky.dds").string();
+		job.settings = TextureCooker::DefaultSettings(TextureKind::Color);
+		jobs.push_back(job);
+	}
+
+	if (box)
+	{
+		for (auto& job : jobs)
+			job.settings.filter = MipFilter::Box;
+	}
+
+	// One texture per thread
+	ThreadPool threadPool;
+	std::atomic<int> done(0);
+	threadPool.ParallelFor((int)jobs.size(), [&](int i) {
+		CookJob& job = jobs[i];
+		if (job.orm)
+			job.result = TextureCooker::CookOrm(job.sources[2], job.sources[0], job.sources[1], job.output, job.settings, force);
+		else if (job.sources.size() == 6)
+			job.result = TextureCooker::CookCubemap(job.sources, job.output, job.settings, force);
+		else
+			job.result = TextureCooker::CookTexture(job.sources[0], job.output, job.settings, force);
+		done++;
+	});
+
+	// Report
+	int failed = 0;
+	int skipped = 0;
+	size_t sourceBytes = 0;
+	size_t cookedBytes = 0;
+	double ms = 0;
+	for (auto& job : jobs)
+	{
+		const CookResult& r = job.result;
+		if (!r.succeeded)
+		{
+			printf("%-24s FAILED: %s\n", job.name.c_str(), r.error.c_str());
+			failed++;
+			continue;
+		}
+
+		if (r.upToDate)
+		{
+			printf("%-24s up to date\n", job.name.c_str());
+			skipped++;
+			continue;
+		}
+
+		printf("%-24s %-9s %s  %7.2f MB -> %6.2f MB  %7.1f ms\n", job.name.c_str(),
+			TextureCooker::KindName(job.settings.kind), TextureCooker::FormatName(job.settings.format),
+			r.sourceBytes / (1024.0 * 1024.0), r.cookedBytes / (1024.0 * 1024.0), r.ms);
+		sourceBytes += r.sourceBytes;
+		cookedBytes += r.cookedBytes;
+		ms += r.ms;
+	}
+
+	printf("\n%d cooked, %d up to date, %d failed on %u threads\n",
+		(int)jobs.size() - skipped - failed, skipped, failed, threadPool.GetThreadCount());
+	if (sourceBytes > 0)
+	{
+		printf("RGBA8 with mips: %.2f MB -> cooked: %.2f MB (%.1fx smaller), %.1f ms of cooking\n",
+			sourceBytes / (1024.0 * 1024.0), cookedBytes / (1024.0 * 1024.0), (double)sourceBytes / cookedBytes, ms);
+	}
+
+	return failed > 0 ? 1 : 0;
+}
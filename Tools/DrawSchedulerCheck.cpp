@@ -0,0 +1,193 @@
+// --------------------------------------------------------
+// Checks for DrawScheduler
+//
+//   order    opaque draws front-to-back by the nearest point
+//            of their bounds, transparent ones back-to-front,
+//            entity index breaking ties both ways
+//   passes   the pass list with the depth pre-pass on and
+//            off, with and without transparent draws, and
+//            which list each pass draws
+//   reuse    Begin starts the next frame from nothing
+//
+// Needs DirectXMath for XMFLOAT3, e.g. from the repo root:
+//   cl /O2 /EHsc /std:c++17 /I. Tools\DrawSchedulerCheck.cpp DrawScheduler.cpp
+//   g++ -O2 -std=c++17 -I. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs Tools/DrawSchedulerCheck.cpp DrawScheduler.cpp -o DrawSchedulerCheck
+// or with CMake (Tools/CMakeLists.txt), where ctest runs it.
+// Exits with 1 if any check fails.
+// --------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "DrawScheduler.h"
+
+using namespace DirectX;
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool ok, const char* what)
+	{
+		printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+		if (!ok)
+			failures++;
+	}
+
+	std::vector<int> Indices(const std::vector<DrawItem>& items)
+	{
+		std::vector<int> indices;
+		for (const DrawItem& item : items)
+			indices.push_back(item.entityIndex);
+		return indices;
+	}
+
+	bool SamePass(const ScheduledPass& pass, const char* name, bool depthOnly, DepthTest depthTest, bool transparent)
+	{
+		return strcmp(pass.name, name) == 0 &&
+			pass.depthOnly == depthOnly &&
+			pass.depthTest == depthTest &&
+			pass.transparent == transparent;
+	}
+
+	// Camera at the origin; everything sits down +Z unless a test says otherwise
+	void AddAt(DrawScheduler& scheduler, int index, float z, float radius, bool transparent = false)
+	{
+		scheduler.Add(index, XMFLOAT3(0, 0, z), radius, transparent);
+	}
+
+	void CheckOrder()
+	{
+		printf("Sort order\n");
+		DrawScheduler scheduler;
+
+		// Added out of order on purpose
+		scheduler.Begin(XMFLOAT3(0, 0, 0), false);
+		AddAt(scheduler, 0, 30, 1);
+		AddAt(scheduler, 1, 10, 1);
+		AddAt(scheduler, 2, 20, 1);
+		AddAt(scheduler, 3, 5, 1);
+		scheduler.Finish();
+		Check(Indices(scheduler.GetDrawList()) == std::vector<int>({ 3, 1, 2, 0 }), "opaque draws front-to-back");
+
+		// A big floor centered far away still starts right in front of the camera
+		scheduler.Begin(XMFLOAT3(0, 0, 0), false);
+		AddAt(scheduler, 0, 10, 1);
+		AddAt(scheduler, 1, 50, 48);
+		scheduler.Finish();
+		Check(Indices(scheduler.GetDrawList()) == std::vector<int>({ 1, 0 }), "distance is to the nearest point of the bounds");
+		Check(scheduler.GetDrawList()[0].distance == 2.0f && scheduler.GetDrawList()[1].distance == 9.0f, "distance values");
+
+		// Distance is measured from the camera, not the origin
+		scheduler.Begin(XMFLOAT3(0, 0, 40), false);
+		AddAt(scheduler, 0, 10, 1);
+		AddAt(scheduler, 1, 35, 1);
+		scheduler.Finish();
+		Check(Indices(scheduler.GetDrawList()) == std::vector<int>({ 1, 0 }), "distance from the camera position");
+
+		// Equal distances in any direction fall back to the index, so frames don't flicker
+		scheduler.Begin(XMFLOAT3(0, 0, 0), false);
+		scheduler.Add(7, XMFLOAT3(10, 0, 0), 1);
+		scheduler.Add(2, XMFLOAT3(0, -10, 0), 1);
+		scheduler.Add(5, XMFLOAT3(0, 0, 10), 1);
+		scheduler.Add(1, XMFLOAT3(0, 0, 20), 1);
+		scheduler.Finish();
+		Check(Indices(scheduler.GetDrawList()) == std::vector<int>({ 2, 5, 7, 1 }), "opaque ties broken by index");
+
+		// Transparent draws are kept apart and reversed
+		scheduler.Begin(XMFLOAT3(0, 0, 0), false);
+		AddAt(scheduler, 0, 10, 1);
+		AddAt(scheduler, 1, 10, 1, true);
+		AddAt(scheduler, 2, 30, 1, true);
+		AddAt(scheduler, 3, 20, 1);
+		AddAt(scheduler, 4, 5, 1, true);
+		scheduler.Finish();
+		Check(Indices(scheduler.GetDrawList()) == std::vector<int>({ 0, 3 }), "opaque list holds only opaque draws");
+		Check(Indices(scheduler.GetTransparentList()) == std::vector<int>({ 2, 1, 4 }), "transparent draws back-to-front");
+
+		scheduler.Begin(XMFLOAT3(0, 0, 0), false);
+		AddAt(scheduler, 6, 10, 1, true);
+		AddAt(scheduler, 3, 10, 1, true);
+		AddAt(scheduler, 9, 15, 1, true);
+		scheduler.Finish();
+		Check(Indices(scheduler.GetTransparentList()) == std::vector<int>({ 9, 3, 6 }), "transparent ties broken by index");
+	}
+
+	void CheckPasses()
+	{
+		printf("Pass scheduling\n");
+		DrawScheduler scheduler;
+
+		scheduler.Begin(XMFLOAT3(0, 0, 0), false);
+		AddAt(scheduler, 0, 10, 1);
+		scheduler.Finish();
+		const std::vector<ScheduledPass>& off = scheduler.GetPasses();
+		Check(!scheduler.UsesDepthPrepass(), "pre-pass off is reported");
+		Check(off.size() == 1 && SamePass(off[0], "Main", false, DepthTest::LessWrite, false), "pre-pass off: one shaded pass with normal depth");
+
+		scheduler.Begin(XMFLOAT3(0, 0, 0), true);
+		AddAt(scheduler, 0, 10, 1);
+		scheduler.Finish();
+		const std::vector<ScheduledPass>& on = scheduler.GetPasses();
+		Check(scheduler.UsesDepthPrepass(), "pre-pass on is reported");
+		Check(on.size() == 2 &&
+			SamePass(on[0], "Depth Pre-Pass", true, DepthTest::LessWrite, false) &&
+			SamePass(on[1], "Main (Depth Equal)", false, DepthTest::EqualNoWrite, false),
+			"pre-pass on: depth only, then shaded with depth equal");
+
+		// Both opaque passes draw the same, already sorted list
+		Check(&scheduler.GetItems(on[0]) == &scheduler.GetDrawList() &&
+			&scheduler.GetItems(on[1]) == &scheduler.GetDrawList(), "pre-pass and main pass draw the opaque list");
+
+		for (bool prepass : { false, true })
+		{
+			scheduler.Begin(XMFLOAT3(0, 0, 0), prepass);
+			AddAt(scheduler, 0, 10, 1);
+			AddAt(scheduler, 1, 20, 1, true);
+			scheduler.Finish();
+			const std::vector<ScheduledPass>& passes = scheduler.GetPasses();
+			const ScheduledPass& last = passes.back();
+			bool ok = passes.size() == (prepass ? 3u : 2u) &&
+				SamePass(last, "Transparent", false, DepthTest::LessNoWrite, true) &&
+				&scheduler.GetItems(last) == &scheduler.GetTransparentList();
+			for (size_t i = 0; i + 1 < passes.size(); i++)
+				ok = ok && !passes[i].transparent && Indices(scheduler.GetItems(passes[i])) == std::vector<int>({ 0 });
+			Check(ok, prepass ? "pre-pass on: transparent pass last, kept out of the pre-pass" : "pre-pass off: transparent pass last");
+		}
+	}
+
+	void CheckReuse()
+	{
+		printf("Frame to frame\n");
+		DrawScheduler scheduler;
+
+		scheduler.Begin(XMFLOAT3(0, 0, 0), true);
+		AddAt(scheduler, 0, 10, 1);
+		AddAt(scheduler, 1, 20, 1, true);
+		scheduler.Finish();
+
+		scheduler.Begin(XMFLOAT3(0, 0, 0), false);
+		AddAt(scheduler, 2, 10, 1);
+		scheduler.Finish();
+		Check(Indices(scheduler.GetDrawList()) == std::vector<int>({ 2 }) && scheduler.GetTransparentList().empty(), "Begin clears both lists");
+		Check(scheduler.GetPasses().size() == 1, "Begin clears the passes");
+
+		scheduler.Begin(XMFLOAT3(0, 0, 0), true);
+		scheduler.Finish();
+		Check(scheduler.GetDrawList().empty() && scheduler.GetPasses().size() == 2, "an empty frame still schedules the opaque passes");
+	}
+}
+
+int main()
+{
+	CheckOrder();
+	CheckPasses();
+	CheckReuse();
+
+	if (failures)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
@@ -0,0 +1,237 @@
+// --------------------------------------------------------
+// World (archetype ECS) vs the old vector<shared_ptr<Entity>>
+// layout
+//
+// The old layout is rebuilt here as it was: each entity a
+// heap object holding shared_ptrs to its mesh, material and
+// a heap allocated Transform, handed out by value from the
+// getters. Both sides create the entities, walk them the
+// way a frame does (move, then read transform, mesh and
+// material), destroy and recreate half of them in random
+// order, and clear; the checksums must agree.
+//
+// Needs DirectXMath for Transform, e.g. from a Visual Studio
+// developer prompt at the repo root:
+//   cl /O2 /EHsc /std:c++17 /I. Tools\EntityStorageBenchmark.cpp World.cpp Transform.cpp
+//   EntityStorageBenchmark [entities] [walks]
+// --------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "Components.h"
+#include "World.h"
+
+namespace
+{
+	// Stand-ins for Mesh and Material, which need a device
+	struct BenchMesh {
+		int id;
+		float boundingRadius;
+	};
+
+	struct BenchMaterial {
+		int id;
+		float roughness;
+	};
+
+	class LegacyEntity
+	{
+	public:
+		LegacyEntity(std::shared_ptr<BenchMesh> mesh, std::shared_ptr<BenchMaterial> material) :
+			mesh(mesh),
+			material(material),
+			isStatic(false),
+			isOccluder(false)
+		{
+			transform = std::make_shared<Transform>();
+		}
+
+		std::shared_ptr<BenchMesh> GetMesh() { return mesh; }
+		std::shared_ptr<Transform> GetTransform() { return transform; }
+		std::shared_ptr<BenchMaterial> GetMaterial() { return material; }
+
+	private:
+		std::shared_ptr<BenchMesh> mesh;
+		std::shared_ptr<Transform> transform;
+		std::shared_ptr<BenchMaterial> material;
+
+		bool isStatic;
+		bool isOccluder;
+	};
+
+	struct Timings {
+		double create;
+		double walk;
+		double churn;
+		double clear;
+	};
+
+	uint32_t Hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	}
+
+	double Since(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// Order independent, since the World walks by archetype
+	uint64_t Accumulate(uint64_t checksum, const DirectX::XMFLOAT3& position, unsigned int version, int mesh, int material)
+	{
+		return checksum + Hash((uint32_t)(int32_t)(position.x * 16.0f) ^ (version << 20) ^ (mesh << 8) ^ material);
+	}
+
+	uint64_t RunLegacy(const std::vector<std::shared_ptr<BenchMesh>>& meshes, const std::vector<std::shared_ptr<BenchMaterial>>& materials,
+		int count, int walks, Timings& t)
+	{
+		uint64_t checksum = 0;
+		std::vector<std::shared_ptr<LegacyEntity>> entities;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		entities.reserve(count);
+		for (int i = 0; i < count; i++)
+			entities.push_back(std::make_shared<LegacyEntity>(meshes[i % meshes.size()], materials[i % materials.size()]));
+		t.create = Since(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int w = 0; w < walks; w++)
+		{
+			for (auto& e : entities)
+			{
+				e->GetTransform()->MoveAbsolute(0.25f, 0, 0);
+				checksum = Accumulate(checksum, e->GetTransform()->GetPosition(), e->GetTransform()->GetVersion(),
+					e->GetMesh()->id, e->GetMaterial()->id);
+			}
+		}
+		t.walk = Since(start) / walks;
+
+		// Destroy half at random spots, then make them again
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count / 2; i++)
+		{
+			size_t index = Hash(i) % entities.size();
+			entities[index] = entities.back();
+			entities.pop_back();
+		}
+		for (int i = 0; i < count / 2; i++)
+			entities.push_back(std::make_shared<LegacyEntity>(meshes[i % meshes.size()], materials[i % materials.size()]));
+		t.churn = Since(start);
+
+		for (auto& e : entities)
+			checksum = Accumulate(checksum, e->GetTransform()->GetPosition(), e->GetTransform()->GetVersion(),
+				e->GetMesh()->id, e->GetMaterial()->id);
+
+		start = std::chrono::high_resolution_clock::now();
+		entities.clear();
+		entities.shrink_to_fit();
+		t.clear = Since(start);
+		return checksum;
+	}
+
+	uint64_t RunWorld(const std::vector<std::shared_ptr<BenchMesh>>& meshes, const std::vector<std::shared_ptr<BenchMaterial>>& materials,
+		int count, int walks, Timings& t)
+	{
+		uint64_t checksum = 0;
+		World world;
+
+		// Handles in the legacy vector's order, to destroy the same entities
+		std::vector<EntityHandle> handles;
+		handles.reserve(count);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+			handles.push_back(world.Create(Transform(), MeshRenderer{ i % (int)meshes.size(), i % (int)materials.size(), 0 }));
+		t.create = Since(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int w = 0; w < walks; w++)
+		{
+			world.Each<Transform, const MeshRenderer>([&](EntityHandle, Transform& transform, const MeshRenderer& renderer) {
+				transform.MoveAbsolute(0.25f, 0, 0);
+				checksum = Accumulate(checksum, transform.GetPosition(), transform.GetVersion(),
+					meshes[renderer.mesh]->id, materials[renderer.material]->id);
+			});
+		}
+		t.walk = Since(start) / walks;
+
+		// Same entities as the legacy side, through handles
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count / 2; i++)
+		{
+			size_t index = Hash(i) % handles.size();
+			world.Destroy(handles[index]);
+			handles[index] = handles.back();
+			handles.pop_back();
+		}
+		for (int i = 0; i < count / 2; i++)
+			handles.push_back(world.Create(Transform(), MeshRenderer{ i % (int)meshes.size(), i % (int)materials.size(), 0 }));
+		t.churn = Since(start);
+
+		world.Each<Transform, const MeshRenderer>([&](EntityHandle, Transform& transform, const MeshRenderer& renderer) {
+			checksum = Accumulate(checksum, transform.GetPosition(), transform.GetVersion(),
+				meshes[renderer.mesh]->id, materials[renderer.material]->id);
+		});
+
+		start = std::chrono::high_resolution_clock::now();
+		world.Clear();
+		t.clear = Since(start);
+		return checksum;
+	}
+
+	void Best(Timings& best, const Timings& t)
+	{
+		best.create = std::min(best.create, t.create);
+		best.walk = std::min(best.walk, t.walk);
+		best.churn = std::min(best.churn, t.churn);
+		best.clear = std::min(best.clear, t.clear);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	int walks = argc > 2 ? atoi(argv[2]) : 10;
+
+	std::vector<std::shared_ptr<BenchMesh>> meshes;
+	std::vector<std::shared_ptr<BenchMaterial>> materials;
+	for (int i = 0; i < 8; i++)
+		meshes.push_back(std::make_shared<BenchMesh>(BenchMesh{ i, 1.0f + i }));
+	for (int i = 0; i < 12; i++)
+		materials.push_back(std::make_shared<BenchMaterial>(BenchMaterial{ i, i / 12.0f }));
+
+	Timings legacy = { 1e30, 1e30, 1e30, 1e30 };
+	Timings ecs = legacy;
+	uint64_t legacyChecksum = 0, ecsChecksum = 0;
+	for (int run = 0; run < 5; run++)
+	{
+		Timings t;
+		legacyChecksum = RunLegacy(meshes, materials, count, walks, t);
+		Best(legacy, t);
+		ecsChecksum = RunWorld(meshes, materials, count, walks, t);
+		Best(ecs, t);
+	}
+
+	printf("%d entities, %d walks (best of 5 runs, ms)\n", count, walks);
+	printf("                 create     walk    churn    clear\n");
+	printf("shared_ptr     %8.2f %8.2f %8.2f %8.2f\n", legacy.create, legacy.walk, legacy.churn, legacy.clear);
+	printf("World          %8.2f %8.2f %8.2f %8.2f\n", ecs.create, ecs.walk, ecs.churn, ecs.clear);
+	printf("speedup        %7.2fx %7.2fx %7.2fx %7.2fx\n",
+		legacy.create / ecs.create, legacy.walk / ecs.walk, legacy.churn / ecs.churn, legacy.clear / ecs.clear);
+
+	if (legacyChecksum != ecsChecksum)
+	{
+		printf("Checksums differ: %llu vs %llu\n", (unsigned long long)legacyChecksum, (unsigned long long)ecsChecksum);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,163 @@
+// --------------------------------------------------------
+// FrameArena vs std::allocator on a synthetic frame
+//
+// Each frame builds the kind of short-lived containers the
+// render path does: a visibility list, draw items sorted by
+// key, per-light lists, and per-object scratch arrays (some
+// on thread pool jobs, like the occlusion culler's projected
+// vertices). The same work runs with both allocators; the
+// checksums must agree.
+//
+// Standalone and platform independent, e.g. from the repo root:
+//   g++ -O2 -std=c++17 -pthread -I. Tools/FrameArenaBenchmark.cpp FrameArena.cpp ThreadPool.cpp Profiler.cpp -o FrameArenaBenchmark
+//   ./FrameArenaBenchmark [entities] [frames]
+// --------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "FrameArena.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	struct DrawItem {
+		uint64_t key;
+		int entity;
+		float depth;
+	};
+
+	struct HeapPolicy {
+		template <typename T> using Allocator = std::allocator<T>;
+		template <typename T> Allocator<T> Get() { return Allocator<T>(); }
+		void BeginFrame() {}
+	};
+
+	struct ArenaPolicy {
+		FrameArena* arena;
+		template <typename T> using Allocator = FrameAllocator<T>;
+		template <typename T> Allocator<T> Get() { return Allocator<T>(arena); }
+		void BeginFrame() { arena->BeginFrame(); }
+	};
+
+	uint32_t Hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	}
+
+	template <typename Policy, typename T>
+	using Vector = std::vector<T, typename Policy::template Allocator<T>>;
+
+	template <typename Policy>
+	uint64_t RunFrame(Policy& policy, ThreadPool& pool, int entityCount, int frame)
+	{
+		policy.BeginFrame();
+		uint64_t checksum = 0;
+
+		// Visibility list
+		Vector<Policy, int> visible(policy.template Get<int>());
+		for (int e = 0; e < entityCount; e++)
+			if (Hash(e * 31 + frame) % 4 != 0)
+				visible.push_back(e);
+
+		// Draw items, sorted front to back within each material
+		Vector<Policy, DrawItem> draws(policy.template Get<DrawItem>());
+		for (int e : visible)
+		{
+			float depth = (Hash(e + frame * 7919) % 10000) / 100.0f;
+			draws.push_back({ ((uint64_t)(e % 12) << 32) | (uint32_t)(depth * 1000), e, depth });
+		}
+		std::sort(draws.begin(), draws.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+		for (size_t i = 0; i < draws.size(); i += 97)
+			checksum += draws[i].entity;
+
+		// Which entities each light touches
+		for (int light = 0; light < 16; light++)
+		{
+			Vector<Policy, int> touched(policy.template Get<int>());
+			for (int e : visible)
+				if ((Hash(e ^ (light * 2654435761u)) & 15) < 3)
+					touched.push_back(e);
+			checksum += touched.size();
+		}
+
+		// Per-object scratch arrays, on the pool like the occlusion culler
+		const int chunk = 64;
+		int chunks = ((int)visible.size() + chunk - 1) / chunk;
+		std::vector<uint64_t> partial(chunks);
+		pool.ParallelFor(chunks, [&](int c) {
+			uint64_t sum = 0;
+			int end = std::min((int)visible.size(), (c + 1) * chunk);
+			for (int i = c * chunk; i < end; i++)
+			{
+				int e = visible[i];
+				Vector<Policy, float> vertices(8 + (e % 24) * 4, 0.0f, policy.template Get<float>());
+				for (size_t v = 0; v < vertices.size(); v++)
+					vertices[v] = (float)((e + v) & 255);
+				float total = 0;
+				for (float v : vertices)
+					total += v;
+				sum += (uint64_t)total;
+			}
+			partial[c] = sum;
+		});
+		for (uint64_t p : partial)
+			checksum += p;
+
+		return checksum;
+	}
+
+	template <typename Policy>
+	double Measure(Policy& policy, ThreadPool& pool, int entityCount, int frames, uint64_t& checksum)
+	{
+		double best = 1e30;
+		for (int run = 0; run < 5; run++)
+		{
+			checksum = 0;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int f = 0; f < frames; f++)
+				checksum += RunFrame(policy, pool, entityCount, f);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			best = std::min(best, ms / frames);
+		}
+		return best;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int entityCount = argc > 1 ? atoi(argv[1]) : 5000;
+	int frames = argc > 2 ? atoi(argv[2]) : 200;
+
+	ThreadPool pool;
+	FrameArena arena(64 * 1024);
+	HeapPolicy heap;
+	ArenaPolicy arenaPolicy = { &arena };
+
+	uint64_t heapChecksum = 0, arenaChecksum = 0;
+	double heapMs = Measure(heap, pool, entityCount, frames, heapChecksum);
+	double arenaMs = Measure(arenaPolicy, pool, entityCount, frames, arenaChecksum);
+
+	arena.BeginFrame();
+	FrameArenaStats stats = arena.GetStats();
+	printf("%d entities, %d frames, %u threads (best of 5 runs)\n", entityCount, frames, pool.GetThreadCount());
+	printf("std::allocator: %.3f ms/frame\n", heapMs);
+	printf("FrameArena:     %.3f ms/frame (%.2fx), %d allocations and %.1f KB per frame, %d heap fallbacks, grew %d times to %.0f KB\n",
+		arenaMs, heapMs / arenaMs, stats.allocations, stats.usedBytes / 1024.0, stats.overflowAllocations, stats.grows, stats.capacity / 1024.0);
+
+	if (heapChecksum != arenaChecksum)
+	{
+		printf("Checksums differ: %llu vs %llu\n", (unsigned long long)heapChecksum, (unsigned long long)arenaChecksum);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,290 @@
+// --------------------------------------------------------
+// Golden check and benchmark for GaussianBlur
+//
+// The golden for each radius is the plain separable kernel,
+// every weight from ComputeWeights read as its own texel,
+// computed here in doubles. Against it:
+//   linear     Blur (bilinear taps folding texel pairs) must
+//              match to within float rounding
+//   downsample BlurDownsampled only approximates it, so its
+//              mean error is held to a looser bound, on a
+//              smooth image, for the radii the game sends
+//              down that path
+// Images have odd sizes so clamping at the edges and the
+// rounded up half resolution are both exercised.
+//
+// The benchmark then times the box, separable, linear tap
+// and downsampled paths per radius, next to the reads per
+// pixel each one does.
+//
+// Standalone and platform independent, e.g. from the repo root:
+//   g++ -O2 -std=c++17 -I. Tools/GaussianBlurCheck.cpp GaussianBlur.cpp -o GaussianBlurCheck
+// or with CMake (Tools/CMakeLists.txt), where ctest runs the check.
+//
+//   ./GaussianBlurCheck [--no-bench] [--size 512]
+// Exits with 1 if any check fails.
+// --------------------------------------------------------
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "GaussianBlur.h"
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Image {
+		int width;
+		int height;
+		std::vector<float> pixels;	// RGBA
+	};
+
+	uint32_t Hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	}
+
+	// Edges, a gradient and per-pixel noise: everything a blur can get wrong
+	Image MakeDetailed(int width, int height)
+	{
+		Image image = { width, height, std::vector<float>((size_t)width * height * 4) };
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				float* p = &image.pixels[((size_t)y * width + x) * 4];
+				p[0] = ((x / 7 + y / 5) & 1) ? 1.0f : 0.0f;
+				p[1] = (float)x / (width - 1);
+				p[2] = (Hash(y * width + x) & 0xFFFF) / 65535.0f;
+				p[3] = 1.0f - (float)y / (height - 1);
+			}
+		}
+		return image;
+	}
+
+	// Low frequencies only, which is what a downsampled blur keeps
+	Image MakeSmooth(int width, int height)
+	{
+		Image image = { width, height, std::vector<float>((size_t)width * height * 4) };
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				float* p = &image.pixels[((size_t)y * width + x) * 4];
+				p[0] = 0.5f + 0.5f * sinf(x * 0.11f) * cosf(y * 0.07f);
+				p[1] = (float)x / (width - 1);
+				p[2] = (float)y / (height - 1);
+				p[3] = 0.5f + 0.5f * cosf((x + y) * 0.05f);
+			}
+		}
+		return image;
+	}
+
+	int Clamp(int i, int count)
+	{
+		return i < 0 ? 0 : (i >= count ? count - 1 : i);
+	}
+
+	// --------------------------------------------------------
+	// The golden: horizontal then vertical, one read per weight,
+	// with the same clamp addressing as the GPU sampler
+	// --------------------------------------------------------
+	Image ReferenceBlur(const Image& src, int radius)
+	{
+		std::vector<float> weights = GaussianBlur::ComputeWeights(radius);
+		int w = src.width;
+		int h = src.height;
+		std::vector<double> pass((size_t)w * h * 4);
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++)
+				for (int c = 0; c < 4; c++)
+				{
+					double sum = 0;
+					for (int k = -radius; k <= radius; k++)
+						sum += weights[abs(k)] * (double)src.pixels[((size_t)y * w + Clamp(x + k, w)) * 4 + c];
+					pass[((size_t)y * w + x) * 4 + c] = sum;
+				}
+
+		Image out = { w, h, std::vector<float>((size_t)w * h * 4) };
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++)
+				for (int c = 0; c < 4; c++)
+				{
+					double sum = 0;
+					for (int k = -radius; k <= radius; k++)
+						sum += weights[abs(k)] * pass[((size_t)Clamp(y + k, h) * w + x) * 4 + c];
+					out.pixels[((size_t)y * w + x) * 4 + c] = (float)sum;
+				}
+		return out;
+	}
+
+	// The same kernel in floats, unfolded, for timing against the linear taps
+	void SeparableBlur(const float* src, float* dst, float* scratch, int width, int height, int radius)
+	{
+		std::vector<float> weights = GaussianBlur::ComputeWeights(radius);
+		std::vector<GaussianBlur::Tap> taps;
+		taps.push_back({ 0.0f, weights[0] });
+		for (int i = 1; i <= radius; i++)
+			taps.push_back({ (float)i, weights[i] });
+		GaussianBlur::BlurPass(src, scratch, width, height, taps, true);
+		GaussianBlur::BlurPass(scratch, dst, width, height, taps, false);
+	}
+
+	struct Difference {
+		double maxError;
+		double meanError;
+	};
+
+	Difference Compare(const Image& a, const Image& b)
+	{
+		Difference d = { 0, 0 };
+		for (size_t i = 0; i < a.pixels.size(); i++)
+		{
+			double e = fabs((double)a.pixels[i] - b.pixels[i]);
+			d.maxError = e > d.maxError ? e : d.maxError;
+			d.meanError += e;
+		}
+		d.meanError /= a.pixels.size();
+		return d;
+	}
+
+	int failures = 0;
+
+	void Check(bool ok, const char* what, int radius, const Difference& d, double limit)
+	{
+		printf("  %-4s %-10s r=%-3d max %.2e  mean %.2e  (limit %.0e)\n", ok ? "ok" : "FAIL", what, radius, d.maxError, d.meanError, limit);
+		if (!ok)
+			failures++;
+	}
+
+	void RunChecks()
+	{
+		printf("Golden checks against the unfolded separable kernel\n");
+
+		// Linear taps are the same sum regrouped, so only rounding may differ
+		const double linearLimit = 1e-5;
+		Image detailed = MakeDetailed(67, 45);
+		for (int radius : { 0, 1, 2, 3, 4, 5, 8, 13, 16 })
+		{
+			Image golden = ReferenceBlur(detailed, radius);
+			Image linear = { detailed.width, detailed.height, std::vector<float>(detailed.pixels.size()) };
+			std::vector<float> scratch(detailed.pixels.size());
+			GaussianBlur::Blur(detailed.pixels.data(), linear.pixels.data(), scratch.data(), detailed.width, detailed.height, radius);
+
+			Difference d = Compare(linear, golden);
+			Check(d.maxError <= linearLimit, "linear", radius, d, linearLimit);
+		}
+
+		// Half resolution trades detail for speed; on smooth content it should barely show
+		const double downsampleLimit = 0.01;
+		Image smooth = MakeSmooth(131, 97);
+		for (int radius : { 8, 12, 16, 24 })
+		{
+			Image golden = ReferenceBlur(smooth, radius);
+			Image downsampled = { smooth.width, smooth.height, std::vector<float>(smooth.pixels.size()) };
+			GaussianBlur::BlurDownsampled(smooth.pixels.data(), downsampled.pixels.data(), smooth.width, smooth.height, radius);
+
+			Difference d = Compare(downsampled, golden);
+			Check(d.meanError <= downsampleLimit, "downsample", radius, d, downsampleLimit);
+		}
+
+		// The kernel itself: symmetric weights summing to one
+		for (int radius : { 1, 4, 16 })
+		{
+			std::vector<float> weights = GaussianBlur::ComputeWeights(radius);
+			double total = weights[0];
+			for (int i = 1; i <= radius; i++)
+				total += 2.0 * weights[i];
+			Difference d = { fabs(total - 1.0), fabs(total - 1.0) };
+			Check(d.maxError <= 1e-6, "weights", radius, d, 1e-6);
+		}
+	}
+
+	template<typename Body>
+	double TimeMs(Body body)
+	{
+		body();
+		double best = 1e30;
+		for (int run = 0; run < 3; run++)
+		{
+			Clock::time_point start = Clock::now();
+			body();
+			double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			best = ms < best ? ms : best;
+		}
+		return best;
+	}
+
+	void RunBenchmark(int size)
+	{
+		Image src = MakeDetailed(size, size);
+		std::vector<float> dst(src.pixels.size());
+		std::vector<float> scratch(src.pixels.size());
+		const float* in = src.pixels.data();
+
+		printf("\n%dx%d, best of 3; reads per pixel / ms\n", size, size);
+		printf("%-6s %18s %18s %18s %18s\n", "radius", "box", "separable", "linear taps", "downsampled");
+		for (int radius : { 1, 2, 4, 8, 16 })
+		{
+			// The box blur gets slow quickly, so past radius 8 it's only counted
+			double boxMs = radius <= 8 ?
+				TimeMs([&]() { GaussianBlur::BoxBlur(in, dst.data(), size, size, radius); }) : -1;
+			double separableMs = TimeMs([&]() { SeparableBlur(in, dst.data(), scratch.data(), size, size, radius); });
+			double linearMs = TimeMs([&]() { GaussianBlur::Blur(in, dst.data(), scratch.data(), size, size, radius); });
+			double downsampledMs = TimeMs([&]() { GaussianBlur::BlurDownsampled(in, dst.data(), size, size, radius); });
+
+			// Downsampled reads: the 2x2 average, the half res blur (a quarter of the pixels), the bilinear upsample
+			int downsampledReads = 1 + (GaussianBlur::LinearTapCount(GaussianBlur::DownsampledRadius(radius)) + 3) / 4 + 1;
+
+			char box[32];
+			if (boxMs < 0)
+				snprintf(box, sizeof(box), "%5d /    -    ", GaussianBlur::BoxTapCount(radius));
+			else
+				snprintf(box, sizeof(box), "%5d / %7.2f", GaussianBlur::BoxTapCount(radius), boxMs);
+			printf("%-6d %18s %8d / %7.2f %8d / %7.2f %8d / %7.2f\n", radius, box,
+				GaussianBlur::SeparableTapCount(radius), separableMs,
+				GaussianBlur::LinearTapCount(radius), linearMs,
+				downsampledReads, downsampledMs);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	bool bench = true;
+	int size = 512;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--no-bench")
+			bench = false;
+		else if (arg == "--size" && i + 1 < argc)
+			size = atoi(argv[++i]);
+		else
+		{
+			printf("Usage: GaussianBlurCheck [--no-bench] [--size 512]\n");
+			return 2;
+		}
+	}
+
+	RunChecks();
+	if (bench && size > 0)
+		RunBenchmark(size);
+
+	if (failures)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
@@ -0,0 +1,291 @@
+// --------------------------------------------------------
+// Golden image check for OcclusionCuller
+//
+// Rasterizes fixed occluder sets from fixed cameras and
+// compares each depth buffer, as written by SaveDepthImage,
+// with the PGM saved in Tools/Golden:
+//   walls    overlapping rotated cubes at several depths
+//   meshes   the sphere, torus and cylinder from
+//            Assets/Meshes on a floor quad
+//   clipped  occluders crossing the near plane and the
+//            screen edges
+// A pixel matches if it's within a couple of grey levels;
+// a few may miss along silhouettes, where a different
+// DirectXMath or compiler can round the other way. On a
+// mismatch the actual image and a diff (white where it's
+// off) are written to the working directory.
+//
+// Also checks that the depth buffer doesn't depend on the
+// number of threads, and a few visibility answers on top.
+//
+// Needs DirectXMath, e.g. from the repo root:
+//   g++ -O2 -std=c++17 -pthread -I. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs Tools/OcclusionGoldenCheck.cpp OcclusionCuller.cpp MeshGeometry.cpp ThreadPool.cpp FrameArena.cpp Profiler.cpp -o OcclusionGoldenCheck
+// or with CMake (Tools/CMakeLists.txt), where ctest runs it.
+//
+//   OcclusionGoldenCheck [--update] [repo root, default .]
+// --update rewrites the goldens instead; look at them before
+// committing. Exits with 1 if any check fails.
+// --------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+#include "MeshGeometry.h"
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Same size as the game's culler
+	const int Width = 320;
+	const int Height = 192;
+
+	// Grey levels a pixel may be off by, and how many pixels may be off by more
+	const int LevelTolerance = 2;
+	const double MismatchFraction = 0.005;
+
+	int failures = 0;
+
+	void Check(bool ok, const char* what)
+	{
+		printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+		if (!ok)
+			failures++;
+	}
+
+	struct Geometry {
+		std::vector<XMFLOAT3> positions;
+		std::vector<unsigned int> indices;
+	};
+
+	struct Placed {
+		const Geometry* geometry;
+		XMFLOAT4X4 world;
+	};
+
+	struct Scene {
+		const char* name;
+		XMFLOAT4X4 viewProjection;
+		std::vector<Placed> occluders;
+	};
+
+	Geometry Cube()
+	{
+		Geometry cube;
+		for (int i = 0; i < 8; i++)
+			cube.positions.push_back(XMFLOAT3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f));
+		unsigned int faces[] = {
+			0, 2, 3, 0, 3, 1,	4, 5, 7, 4, 7, 6,
+			0, 1, 5, 0, 5, 4,	2, 6, 7, 2, 7, 3,
+			0, 4, 6, 0, 6, 2,	1, 3, 7, 1, 7, 5 };
+		cube.indices.assign(faces, faces + 36);
+		return cube;
+	}
+
+	bool LoadMesh(const std::string& fileName, Geometry& geometry)
+	{
+		std::vector<Vertex> verts;
+		if (!MeshGeometry::LoadObj(fileName.c_str(), verts, geometry.indices))
+			return false;
+		for (const Vertex& v : verts)
+			geometry.positions.push_back(v.Position);
+		return true;
+	}
+
+	XMFLOAT4X4 World(float x, float y, float z, float sx, float sy, float sz, float pitch, float yaw, float roll)
+	{
+		XMFLOAT4X4 world;
+		XMMATRIX scaleRotation = XMMatrixMultiply(XMMatrixScaling(sx, sy, sz), XMMatrixRotationRollPitchYaw(pitch, yaw, roll));
+		XMStoreFloat4x4(&world, XMMatrixMultiply(scaleRotation, XMMatrixTranslation(x, y, z)));
+		return world;
+	}
+
+	// Near and far close together so the 8 bit image keeps some contrast
+	XMFLOAT4X4 ViewProjection(XMFLOAT3 position, XMFLOAT3 direction)
+	{
+		XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&position), XMLoadFloat3(&direction), XMVectorSet(0, 1, 0, 0));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, (float)Width / Height, 3.0f, 30.0f);
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(view, projection));
+		return viewProjection;
+	}
+
+	void Rasterize(OcclusionCuller& culler, const Scene& scene)
+	{
+		culler.BeginFrame(scene.viewProjection);
+		for (const Placed& p : scene.occluders)
+			culler.AddOccluder(p.geometry->positions, p.geometry->indices, p.world);
+		culler.RasterizeOccluders();
+	}
+
+	bool ReadPgm(const std::string& fileName, int& width, int& height, std::vector<unsigned char>& pixels)
+	{
+		std::ifstream file(fileName, std::ios::binary);
+		std::string magic;
+		int maxValue = 0;
+		if (!(file >> magic >> width >> height >> maxValue) || magic != "P5" || maxValue != 255 || width <= 0 || height <= 0)
+			return false;
+		file.get();
+
+		pixels.resize((size_t)width * height);
+		file.read((char*)pixels.data(), pixels.size());
+		return file.gcount() == (std::streamsize)pixels.size();
+	}
+
+	bool WritePgm(const std::string& fileName, int width, int height, const std::vector<unsigned char>& pixels)
+	{
+		std::ofstream file(fileName, std::ios::binary);
+		file << "P5\n" << width << " " << height << "\n255\n";
+		file.write((const char*)pixels.data(), pixels.size());
+		return file.good();
+	}
+
+	void CompareWithGolden(OcclusionCuller& culler, const Scene& scene, const std::string& goldenDir, bool update)
+	{
+		std::string golden = goldenDir + "/Occlusion_" + scene.name + ".pgm";
+		if (update)
+		{
+			bool saved = culler.SaveDepthImage(golden.c_str());
+			printf("  %-4s wrote %s\n", saved ? "ok" : "FAIL", golden.c_str());
+			if (!saved)
+				failures++;
+			return;
+		}
+
+		// Round trip through SaveDepthImage, the same path that made the golden
+		std::string actual = std::string("Occlusion_") + scene.name + ".actual.pgm";
+		int w = 0, h = 0, gw = 0, gh = 0;
+		std::vector<unsigned char> pixels, expected;
+		if (!culler.SaveDepthImage(actual.c_str()) || !ReadPgm(actual, w, h, pixels))
+		{
+			Check(false, (std::string(scene.name) + ": can't write " + actual).c_str());
+			return;
+		}
+		if (!ReadPgm(golden, gw, gh, expected) || gw != w || gh != h)
+		{
+			Check(false, (std::string(scene.name) + ": missing or wrong size golden " + golden).c_str());
+			return;
+		}
+
+		int mismatched = 0;
+		int worst = 0;
+		int covered = 0;
+		std::vector<unsigned char> diff(pixels.size());
+		for (size_t i = 0; i < pixels.size(); i++)
+		{
+			int d = abs((int)pixels[i] - (int)expected[i]);
+			worst = d > worst ? d : worst;
+			if (d > LevelTolerance)
+				mismatched++;
+			if (expected[i] != 0)
+				covered++;
+			diff[i] = d > LevelTolerance ? 255 : 0;
+		}
+
+		bool ok = mismatched <= MismatchFraction * pixels.size();
+		char what[160];
+		snprintf(what, sizeof(what), "%-8s %d of %d pixels off by more than %d (worst %d), %d covered",
+			scene.name, mismatched, (int)pixels.size(), LevelTolerance, worst, covered);
+		Check(ok, what);
+
+		if (ok)
+			remove(actual.c_str());
+		else
+			WritePgm(std::string("Occlusion_") + scene.name + ".diff.pgm", w, h, diff);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	bool update = false;
+	std::string root = ".";
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--update")
+			update = true;
+		else if (arg[0] != '-')
+			root = arg;
+		else
+		{
+			printf("Usage: OcclusionGoldenCheck [--update] [repo root]\n");
+			return 2;
+		}
+	}
+	std::string goldenDir = root + "/Tools/Golden";
+
+	Geometry cube = Cube();
+	Geometry sphere, torus, cylinder, quad;
+	if (!LoadMesh(root + "/Assets/Meshes/sphere.obj", sphere) ||
+		!LoadMesh(root + "/Assets/Meshes/torus.obj", torus) ||
+		!LoadMesh(root + "/Assets/Meshes/cylinder.obj", cylinder) ||
+		!LoadMesh(root + "/Assets/Meshes/quad.obj", quad))
+	{
+		printf("Can't load Assets/Meshes from %s\n", root.c_str());
+		return 2;
+	}
+
+	std::vector<Scene> scenes;
+	scenes.push_back({ "walls", ViewProjection(XMFLOAT3(0, 0, -5), XMFLOAT3(0, 0, 1)), {
+		{ &cube, World(0, 0, 8, 6, 3, 0.5f, 0, 0, 0) },
+		{ &cube, World(-3, 1, 4, 2, 2, 2, 0.3f, 0.6f, 0) },
+		{ &cube, World(2.5f, -1, 12, 3, 3, 3, 0, 0.8f, 0.2f) },
+		{ &cube, World(1, 2, 6, 1, 4, 1, 0, 0, 0.7f) },
+		{ &cube, World(-8, -3, 20, 4, 1, 4, 0.5f, 0, 0) } } });
+	scenes.push_back({ "meshes", ViewProjection(XMFLOAT3(0, 4, -8), XMFLOAT3(0, -0.4f, 1)), {
+		{ &quad, World(0, -1, 6, 8, 1, 8, 0, 0, 0) },
+		{ &sphere, World(-3, 0.5f, 4, 3, 3, 3, 0, 0, 0) },
+		{ &torus, World(1.5f, 0, 3, 3, 3, 3, 0.9f, 0.4f, 0) },
+		{ &cylinder, World(4, 1, 8, 2, 4, 2, 0, 0, 0) } } });
+	scenes.push_back({ "clipped", ViewProjection(XMFLOAT3(0, 0, 0), XMFLOAT3(0.2f, 0, 1)), {
+		{ &cube, World(0, 0, 3, 1.5f, 1.5f, 1.5f, 0, 0.4f, 0) },
+		{ &cube, World(-4, 0, 7, 3, 8, 1, 0, 0, 0) },
+		{ &cube, World(4, -3, 10, 6, 2, 6, 0, 0.3f, 0) },
+		{ &sphere, World(1, 2, 14, 6, 6, 6, 0, 0, 0) } } });
+
+	ThreadPool pool;
+	ThreadPool single(1);
+	OcclusionCuller culler(&pool, Width, Height);
+	OcclusionCuller singleCuller(&single, Width, Height);
+
+	printf(update ? "Updating goldens in %s\n" : "Depth against the goldens in %s\n", goldenDir.c_str());
+	for (const Scene& scene : scenes)
+	{
+		Rasterize(culler, scene);
+		CompareWithGolden(culler, scene, goldenDir, update);
+	}
+	if (update)
+		return failures ? 1 : 0;
+
+	printf("Threads\n");
+	for (const Scene& scene : scenes)
+	{
+		Rasterize(culler, scene);
+		Rasterize(singleCuller, scene);
+		std::string what = std::string(scene.name) + ": same depth with 1 and " + std::to_string(pool.GetThreadCount()) + " threads";
+		Check(culler.GetDepthBuffer() == singleCuller.GetDepthBuffer(), what.c_str());
+	}
+
+	// What the game asks of the depth: hidden behind the wall, or not
+	printf("Visibility\n");
+	Rasterize(culler, scenes[0]);
+	XMFLOAT3 boxMin(-0.5f, -0.5f, -0.5f);
+	XMFLOAT3 boxMax(0.5f, 0.5f, 0.5f);
+	Check(culler.IsOccluded(boxMin, boxMax, World(0, -0.5f, 14, 1, 1, 1, 0, 0, 0)), "box behind the wall is occluded");
+	Check(!culler.IsOccluded(boxMin, boxMax, World(0, -0.5f, 3, 1, 1, 1, 0, 0, 0)), "box in front of the wall is visible");
+	Check(!culler.IsOccluded(boxMin, boxMax, World(0, 5, 14, 1, 1, 1, 0, 0, 0)), "box above the wall is visible");
+	Check(!culler.IsOccluded(boxMin, boxMax, World(0, 0, -10, 1, 1, 1, 0, 0, 0)), "box behind the camera isn't culled");
+
+	if (failures)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
@@ -0,0 +1,463 @@
+// --------------------------------------------------------
+// CPU performance regression suite
+//
+// Times the device-free parts of a frame and of loading on
+// synthetic scenes of increasing size:
+//   obj_load           MeshGeometry::LoadObj on a generated grid
+//   tangents           MeshGeometry::CalculateTangents
+//   transform_rebuild  Dirty transforms rebuilding their matrices
+//   camera_update      Camera::Update with scripted input
+//   occlusion_culling  Rasterizing occluders and testing every box
+//   draw_list          DrawScheduler building the sorted list
+//   cb_packing         Filling per-draw constant buffer data into
+//                      a 256 byte aligned ring, like
+//                      Graphics::FillAndBindNextConstantBuffer
+//
+// Each case is warmed up, then repeated until it has run for
+// at least --min-ms; the median and best run are reported
+// and written as JSON. Compare two runs with
+// Tools/CompareBenchmarks.py.
+//
+// From the repo root on Windows:
+//   cl /O2 /EHsc /std:c++17 /I. Tools\PerfBenchmarks.cpp MeshGeometry.cpp Transform.cpp Camera.cpp DrawScheduler.cpp OcclusionCuller.cpp ThreadPool.cpp FrameArena.cpp Profiler.cpp
+// Elsewhere, with the DirectXMath headers (and sal.h from
+// DirectX-Headers' wsl/stubs) on the include path:
+//   g++ -O2 -std=c++17 -pthread -I. -ITools/Shims -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs Tools/PerfBenchmarks.cpp MeshGeometry.cpp Transform.cpp Camera.cpp DrawScheduler.cpp OcclusionCuller.cpp ThreadPool.cpp FrameArena.cpp Profiler.cpp -o PerfBenchmarks
+//
+// Or with CMake, which fetches DirectXMath (Tools/CMakeLists.txt):
+//   cmake -S Tools -B build/tools && cmake --build build/tools
+//
+//   ./PerfBenchmarks [--out results.json] [--scales 1000,10000,50000] [--filter name] [--min-ms 200]
+// --------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BufferStructs.h"
+#include "Camera.h"
+#include "DrawScheduler.h"
+#include "FrameArena.h"
+#include "MeshGeometry.h"
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+#include "Transform.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Scripted input for Camera::Update, in place of Input.cpp:
+// always moving forward and right, looking around with the
+// left button held
+// --------------------------------------------------------
+namespace
+{
+	int scriptedFrame = 0;
+}
+
+bool Input::KeyDown(int key) { return key == 'W' || key == 'D'; }
+bool Input::MouseLeftDown() { return true; }
+int Input::GetMouseXDelta() { return (scriptedFrame % 16) - 8; }
+int Input::GetMouseYDelta() { return ((scriptedFrame / 16) % 8) - 4; }
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Options {
+		std::string outPath = "results.json";
+		std::vector<int> scales = { 1000, 10000, 50000 };
+		std::string filter;
+		double minMs = 200.0;
+	};
+
+	struct Result {
+		std::string name;
+		int scale;
+		int iterations;
+		double medianMs;
+		double minMs;
+	};
+
+	// Everything a case computes ends up here, so none of it can be optimized away
+	volatile uint64_t sink = 0;
+
+	uint32_t Hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	}
+
+	// 0 to 1, the same for the same seed on every run
+	float Random(uint32_t seed)
+	{
+		return (Hash(seed) & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	uint64_t Checksum(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	// --------------------------------------------------------
+	// Runs body once to warm up, then again and again until
+	// options.minMs has passed (at least 5 runs, at most 1000)
+	// --------------------------------------------------------
+	template<typename Body>
+	Result Measure(const Options& options, const char* name, int scale, Body body)
+	{
+		sink = sink + body();
+
+		std::vector<double> samples;
+		double totalMs = 0;
+		while ((totalMs < options.minMs || samples.size() < 5) && samples.size() < 1000)
+		{
+			Clock::time_point start = Clock::now();
+			sink = sink + body();
+			double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			samples.push_back(ms);
+			totalMs += ms;
+		}
+
+		std::sort(samples.begin(), samples.end());
+		Result result;
+		result.name = name;
+		result.scale = scale;
+		result.iterations = (int)samples.size();
+		result.medianMs = samples[samples.size() / 2];
+		result.minMs = samples.front();
+		return result;
+	}
+
+	// --------------------------------------------------------
+	// A scene of scale entities spread through a box that
+	// grows with the count, so density stays about the same
+	// --------------------------------------------------------
+	struct Scene {
+		std::vector<Transform> transforms;
+		std::vector<XMFLOAT3> centers;
+		std::vector<float> radii;
+	};
+
+	void BuildScene(int scale, Scene& scene)
+	{
+		float extent = 4.0f * std::cbrt((float)scale);
+		scene.transforms.assign(scale, Transform());
+		scene.centers.resize(scale);
+		scene.radii.resize(scale);
+		for (int i = 0; i < scale; i++)
+		{
+			uint32_t seed = (uint32_t)i * 4;
+			Transform& t = scene.transforms[i];
+			t.SetPosition((Random(seed) - 0.5f) * extent, (Random(seed + 1) - 0.5f) * extent * 0.25f, Random(seed + 2) * extent + 2.0f);
+			t.SetRotation(0, Random(seed + 3) * XM_2PI, 0);
+			t.SetScale(0.5f + Random(seed + 1) * 1.5f, 0.5f + Random(seed + 2), 0.5f + Random(seed + 3));
+			t.GetWorldBoundingSphere(XMFLOAT3(0, 0, 0), 0.866f, scene.centers[i], scene.radii[i]);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Writes a flat grid of about vertexCount vertices as an
+	// OBJ with positions, UVs, normals and quad faces
+	// --------------------------------------------------------
+	bool WriteGridObj(const std::string& path, int vertexCount)
+	{
+		std::ofstream out(path);
+		if (!out)
+			return false;
+
+		int side = std::max(2, (int)std::sqrt((float)vertexCount));
+		for (int y = 0; y < side; y++)
+			for (int x = 0; x < side; x++)
+				out << "v " << x << " " << std::sin(x * 0.1f) * std::cos(y * 0.1f) << " " << y << "\n";
+		for (int y = 0; y < side; y++)
+			for (int x = 0; x < side; x++)
+				out << "vt " << x / (float)(side - 1) << " " << y / (float)(side - 1) << "\n";
+		out << "vn 0 1 0\n";
+
+		for (int y = 0; y < side - 1; y++)
+		{
+			for (int x = 0; x < side - 1; x++)
+			{
+				int a = y * side + x + 1;
+				int b = a + 1;
+				int c = a + side + 1;
+				int d = a + side;
+				out << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 "
+					<< c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+			}
+		}
+		return (bool)out;
+	}
+
+	// A unit cube, used as both occluder and occludee bounds
+	void BuildCube(std::vector<XMFLOAT3>& positions, std::vector<unsigned int>& indices)
+	{
+		positions.clear();
+		for (int i = 0; i < 8; i++)
+			positions.push_back(XMFLOAT3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f));
+		indices = {
+			0, 2, 3, 0, 3, 1,	4, 5, 7, 4, 7, 6,
+			0, 4, 6, 0, 6, 2,	1, 3, 7, 1, 7, 5,
+			0, 1, 5, 0, 5, 4,	2, 6, 7, 2, 7, 3
+		};
+	}
+
+	bool Selected(const Options& options, const char* name)
+	{
+		return options.filter.empty() || strstr(name, options.filter.c_str()) != 0;
+	}
+
+	void RunScale(const Options& options, int scale, ThreadPool& pool, std::vector<Result>& results)
+	{
+		Scene scene;
+		BuildScene(scale, scene);
+
+		auto add = [&](const Result& result) {
+			results.push_back(result);
+			printf("%-18s %7d  %10.3f ms  %10.3f ms  %8.1f ns/item  (%d runs)\n",
+				result.name.c_str(), result.scale, result.medianMs, result.minMs,
+				result.medianMs * 1000000.0 / result.scale, result.iterations);
+		};
+
+		// --- Loading ---
+		std::vector<Vertex> verts;
+		std::vector<unsigned int> indices;
+		if (Selected(options, "obj_load") || Selected(options, "tangents"))
+		{
+			std::string objPath = "PerfBenchmarks_" + std::to_string(scale) + ".obj";
+			if (!WriteGridObj(objPath, scale) || !MeshGeometry::LoadObj(objPath.c_str(), verts, indices))
+			{
+				printf("Couldn't write or read %s\n", objPath.c_str());
+				return;
+			}
+
+			if (Selected(options, "obj_load"))
+			{
+				add(Measure(options, "obj_load", scale, [&]() {
+					std::vector<Vertex> v;
+					std::vector<unsigned int> i;
+					MeshGeometry::LoadObj(objPath.c_str(), v, i);
+					return (uint64_t)v.size() + i.size();
+				}));
+			}
+			remove(objPath.c_str());
+		}
+
+		if (Selected(options, "tangents"))
+		{
+			add(Measure(options, "tangents", scale, [&]() {
+				MeshGeometry::CalculateTangents(verts.data(), (int)verts.size(), indices.data(), (int)indices.size());
+				return Checksum(verts[verts.size() / 2].Tangent.x);
+			}));
+		}
+
+		// --- Per frame ---
+		if (Selected(options, "transform_rebuild"))
+		{
+			add(Measure(options, "transform_rebuild", scale, [&]() {
+				uint64_t sum = 0;
+				for (Transform& t : scene.transforms)
+				{
+					t.Rotate(0, 0.001f, 0);
+					XMFLOAT4X4 world = t.GetWorldMatrix();
+					XMFLOAT4X4 worldInvTrans = t.GetWorldInverseTransposeMatrix();
+					sum += Checksum(world._41 + worldInvTrans._11);
+				}
+				return sum;
+			}));
+		}
+
+		if (Selected(options, "camera_update"))
+		{
+			Camera camera(XMFLOAT3(0, 0, -5), 5.0f, 0.002f, XM_PIDIV4, 16.0f / 9.0f);
+			add(Measure(options, "camera_update", scale, [&]() {
+				for (int i = 0; i < scale; i++)
+				{
+					scriptedFrame++;
+					camera.Update(1.0f / 60.0f);
+				}
+				return Checksum(camera.GetView()._41);
+			}));
+		}
+
+		// One occluder per hundred entities, all in front of the rest
+		if (Selected(options, "occlusion_culling"))
+		{
+			std::vector<XMFLOAT3> cubePositions;
+			std::vector<unsigned int> cubeIndices;
+			BuildCube(cubePositions, cubeIndices);
+
+			Camera camera(XMFLOAT3(0, 0, -5), 5.0f, 0.002f, XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+			XMFLOAT4X4 view = camera.GetView();
+			XMFLOAT4X4 projection = camera.GetProjection();
+			XMFLOAT4X4 viewProjection;
+			XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection)));
+
+			int occluderCount = std::max(1, scale / 100);
+			std::vector<XMFLOAT4X4> occluderWorlds(occluderCount);
+			for (int i = 0; i < occluderCount; i++)
+				occluderWorlds[i] = scene.transforms[i].GetWorldMatrix();
+
+			std::vector<XMFLOAT4X4> worlds(scale);
+			for (int i = 0; i < scale; i++)
+				worlds[i] = scene.transforms[i].GetWorldMatrix();
+
+			FrameArena arena;
+			OcclusionCuller culler(&pool);
+			culler.SetFrameArena(&arena);
+			add(Measure(options, "occlusion_culling", scale, [&]() {
+				arena.BeginFrame();
+				culler.BeginFrame(viewProjection);
+				for (const XMFLOAT4X4& world : occluderWorlds)
+					culler.AddOccluder(cubePositions, cubeIndices, world);
+				culler.RasterizeOccluders();
+
+				uint64_t culled = 0;
+				for (int i = occluderCount; i < scale; i++)
+					culled += culler.IsOccluded(XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, 0.5f, 0.5f), worlds[i]);
+				return culled;
+			}));
+		}
+
+		if (Selected(options, "draw_list"))
+		{
+			DrawScheduler scheduler;
+			add(Measure(options, "draw_list", scale, [&]() {
+				scheduler.Begin(XMFLOAT3(0, 0, -5), true);
+				for (int i = 0; i < scale; i++)
+					scheduler.Add(i, scene.centers[i], scene.radii[i]);
+				scheduler.Finish();
+				return (uint64_t)scheduler.GetDrawList().front().entityIndex;
+			}));
+		}
+
+		// Same layout and ring as Graphics::FillAndBindNextConstantBuffer, minus the Map/Unmap
+		if (Selected(options, "cb_packing"))
+		{
+			const unsigned int ringSize = 16 * 1024 * 1024;
+			std::vector<unsigned char> ring(ringSize);
+			unsigned int ringOffset = 0;
+			auto upload = [&](const void* data, unsigned int size) {
+				unsigned int reservationSize = (size + 255) / 256 * 256;
+				if (ringOffset + reservationSize >= ringSize)
+					ringOffset = 0;
+				memcpy(ring.data() + ringOffset, data, size);
+				ringOffset += reservationSize;
+			};
+
+			Camera camera(XMFLOAT3(0, 0, -5), 5.0f, 0.002f, XM_PIDIV4, 16.0f / 9.0f);
+			Light lights[5] = {};
+			add(Measure(options, "cb_packing", scale, [&]() {
+				VertexShaderExternalData vsData = {};
+				PixelShaderExternalData psData = {};
+				psData.camPos = camera.GetTransform()->GetPosition();
+				memcpy(&psData.lights, lights, sizeof(lights));
+				for (int i = 0; i < scale; i++)
+				{
+					Transform& t = scene.transforms[i];
+					vsData.world = t.GetWorldMatrix();
+					vsData.worldInvTrans = t.GetWorldInverseTransposeMatrix();
+					vsData.viewMatrix = camera.GetView();
+					vsData.projectionMatrix = camera.GetProjection();
+					upload(&vsData, sizeof(VertexShaderExternalData));
+
+					psData.colorTint = XMFLOAT3(1, 1, 1);
+					psData.roughness = (i & 7) / 7.0f;
+					psData.uvScale = XMFLOAT2(1, 1);
+					upload(&psData, sizeof(PixelShaderExternalData));
+				}
+				return (uint64_t)ringOffset + ring[ringOffset / 2];
+			}));
+		}
+	}
+
+	bool WriteJson(const std::string& path, const std::vector<Result>& results)
+	{
+		std::ofstream out(path);
+		if (!out)
+			return false;
+
+		char line[512];
+		out << "{\n\t\"suite\": \"PerfBenchmarks\",\n\t\"version\": 1,\n\t\"results\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			snprintf(line, sizeof(line),
+				"\t\t{\"name\": \"%s\", \"scale\": %d, \"iterations\": %d, \"median_ms\": %.6f, \"min_ms\": %.6f, \"ns_per_item\": %.3f}%s\n",
+				r.name.c_str(), r.scale, r.iterations, r.medianMs, r.minMs,
+				r.medianMs * 1000000.0 / r.scale, i + 1 < results.size() ? "," : "");
+			out << line;
+		}
+		out << "\t]\n}\n";
+		return (bool)out;
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--out" && hasValue)
+				options.outPath = argv[++i];
+			else if (arg == "--filter" && hasValue)
+				options.filter = argv[++i];
+			else if (arg == "--min-ms" && hasValue)
+				options.minMs = atof(argv[++i]);
+			else if (arg == "--scales" && hasValue)
+			{
+				options.scales.clear();
+				for (const char* s = argv[++i]; *s; )
+				{
+					int scale = atoi(s);
+					if (scale > 0)
+						options.scales.push_back(scale);
+					while (*s && *s != ',') s++;
+					if (*s == ',') s++;
+				}
+			}
+			else
+				return false;
+		}
+		return !options.scales.empty();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		printf("Usage: PerfBenchmarks [--out results.json] [--scales 1000,10000,50000] [--filter name] [--min-ms 200]\n");
+		return 2;
+	}
+
+	ThreadPool pool;
+	printf("%u worker threads, at least %.0f ms per case\n", pool.GetThreadCount(), options.minMs);
+	printf("%-18s %7s  %13s  %13s\n", "case", "scale", "median", "best");
+
+	std::vector<Result> results;
+	for (int scale : options.scales)
+		RunScale(options, scale, pool, results);
+
+	if (!WriteJson(options.outPath, results))
+	{
+		printf("Couldn't write %s\n", options.outPath.c_str());
+		return 1;
+	}
+	printf("Wrote %d results to %s (checksum %llu)\n", (int)results.size(), options.outPath.c_str(), (unsigned long long)sink);
+	return 0;
+}
@@ -0,0 +1,347 @@
+// --------------------------------------------------------
+// Serial vs pipelined frames, through FramePipeline
+//
+// Runs the game's frame loop without a device: the update
+// stage records previous transforms, spins every entity one
+// step and gathers interpolated renderables into a snapshot,
+// like GameSystems; the render stage builds the sorted draw
+// list with DrawScheduler and packs each draw's constant
+// buffers into a ring, without presenting. Each mode reports
+//   throughput  frames per second through the whole loop
+//   latency     from a frame's input being read to the end of
+//               rendering what it caused, mean and 95th
+//               percentile
+// Pipelining should raise throughput towards the slower of
+// the two stages, at the cost of about a frame of latency.
+//
+// From the repo root on Windows:
+//   cl /O2 /EHsc /std:c++20 /I. Tools\PipelineBenchmark.cpp FramePipeline.cpp World.cpp Transform.cpp DrawScheduler.cpp Profiler.cpp
+// Elsewhere, with the DirectXMath headers (and sal.h from
+// DirectX-Headers' wsl/stubs) on the include path:
+//   g++ -O2 -std=c++20 -pthread -I. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs Tools/PipelineBenchmark.cpp FramePipeline.cpp World.cpp Transform.cpp DrawScheduler.cpp Profiler.cpp -o PipelineBenchmark
+//
+// Or with CMake, which fetches DirectXMath (Tools/CMakeLists.txt):
+//   cmake -S Tools -B build/tools && cmake --build build/tools
+//
+//   ./PipelineBenchmark [--entities 20000] [--frames 600]
+// --------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "BufferStructs.h"
+#include "Components.h"
+#include "DrawScheduler.h"
+#include "FramePipeline.h"
+#include "World.h"
+
+using namespace DirectX;
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Options {
+		int entities = 20000;
+		int frames = 600;
+	};
+
+	struct ModeResult {
+		const char* name;
+		double framesPerSecond;
+		double meanFrameMs;
+		double updateMs;	// Mean per snapshot, on whichever thread built it
+		double waitMs;		// Mean time the main thread waited for the update
+		double meanLatencyMs;
+		double p95LatencyMs;
+	};
+
+	// Everything the stages compute ends up here, so none of it can be optimized away
+	volatile uint64_t sink = 0;
+
+	uint32_t Hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	}
+
+	// 0 to 1, the same for the same seed on every run
+	float Random(uint32_t seed)
+	{
+		return (Hash(seed) & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	// --------------------------------------------------------
+	// The World and what an Update() leaves for the update
+	// stage, as Game keeps them
+	// --------------------------------------------------------
+	struct Scene {
+		World world;
+		std::vector<Renderable> renderables;
+		std::vector<Light> lights;
+
+		// Set on the main thread before each Start()
+		float deltaTime;
+		float totalTime;
+		Clock::time_point inputTime;
+		SnapshotCamera camera;
+	};
+
+	void BuildScene(Scene& scene, int entities)
+	{
+		int side = (int)ceilf(sqrtf((float)entities));
+		for (int i = 0; i < entities; i++)
+		{
+			Transform transform;
+			transform.SetPosition((i % side - side / 2) * 2.0f, Random(i * 3 + 1) * 4.0f, (float)(i / side) * 2.0f);
+			transform.SetScale(0.5f + Random(i * 3 + 2), 0.5f + Random(i * 3 + 2), 0.5f + Random(i * 3 + 2));
+
+			MeshRenderer renderer = { i % 8, i % 5, 0 };
+			EntityHandle entity = scene.world.Create(transform, renderer, PreviousTransform{ transform.GetState(), transform.GetVersion() });
+
+			// Three in four move, so most renderables are interpolated
+			if (i % 4 != 0)
+				scene.world.Add(entity, Spin{ XMFLOAT3(0, Random(i * 3 + 3) * 2.0f, 0) });
+		}
+
+		// As many as PixelShaderExternalData holds
+		scene.lights.resize(5);
+		for (int i = 0; i < (int)scene.lights.size(); i++)
+		{
+			scene.lights[i].type = LIGHT_TYPE_POINT;
+			scene.lights[i].position = XMFLOAT3((float)i * 4.0f, 3.0f, 10.0f);
+			scene.lights[i].range = 20.0f;
+			scene.lights[i].intensity = 1.0f;
+			scene.lights[i].color = XMFLOAT3(1, 1, 1);
+		}
+
+		XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0, 5, -20, 0), XMVectorSet(0, -0.2f, 1, 0), XMVectorSet(0, 1, 0, 0));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+		scene.camera = {};
+		XMStoreFloat4x4(&scene.camera.view, view);
+		XMStoreFloat4x4(&scene.camera.projection, projection);
+		scene.camera.position = XMFLOAT3(0, 5, -20);
+		scene.camera.perspective = true;
+		scene.camera.fieldOfView = XM_PIDIV4;
+		scene.camera.nearClip = 0.1f;
+	}
+
+	// --------------------------------------------------------
+	// The update stage: one simulation step, then the render
+	// list half way towards it (GameSystems' simulation and
+	// frame systems, minus the meshes)
+	// --------------------------------------------------------
+	void UpdateStage(Scene& scene, RenderSnapshot& snapshot)
+	{
+		float deltaTime = scene.deltaTime;
+		scene.world.Each<Transform, PreviousTransform>([](EntityHandle, Transform& transform, PreviousTransform& previous) {
+			previous.state = transform.GetState();
+			previous.version = transform.GetVersion();
+		});
+		scene.world.Each<Transform, const Spin>([&](EntityHandle, Transform& transform, const Spin& spin) {
+			transform.Rotate(spin.rate.x * deltaTime, spin.rate.y * deltaTime, spin.rate.z * deltaTime);
+		});
+
+		const float interpolation = 0.5f;
+		scene.renderables.clear();
+		scene.world.Each<Transform, const PreviousTransform, const MeshRenderer>([&](EntityHandle entity, Transform& transform, const PreviousTransform& previous, const MeshRenderer& renderer) {
+			Renderable r = {};
+			r.entity = entity;
+			r.version = transform.GetVersion();
+			r.mesh = renderer.mesh;
+			r.material = renderer.material;
+			r.flags = renderer.flags;
+			transform.GetWorldBoundingSphere(XMFLOAT3(0, 0, 0), 0.87f, r.center, r.radius);
+			if (previous.version != transform.GetVersion())
+				transform.GetInterpolatedMatrices(previous.state, interpolation, r.world, r.worldInvTrans);
+			else
+			{
+				r.world = transform.GetWorldMatrix();
+				r.worldInvTrans = transform.GetWorldInverseTransposeMatrix();
+			}
+			scene.renderables.push_back(r);
+		});
+
+		std::swap(snapshot.renderables, scene.renderables);
+		snapshot.lights = scene.lights;
+		snapshot.deltaTime = scene.deltaTime;
+		snapshot.totalTime = scene.totalTime;
+		snapshot.inputTime = scene.inputTime;
+		snapshot.camera = scene.camera;
+	}
+
+	// --------------------------------------------------------
+	// The render stage's CPU side: RenderScene's draw list and
+	// constant buffers, into the same 256 byte aligned ring as
+	// Graphics::FillAndBindNextConstantBuffer
+	// --------------------------------------------------------
+	struct Renderer {
+		DrawScheduler scheduler;
+		std::vector<unsigned char> ring = std::vector<unsigned char>(16 * 1024 * 1024);
+		unsigned int ringOffset = 0;
+
+		void Upload(const void* data, unsigned int size)
+		{
+			unsigned int reservationSize = (size + 255) / 256 * 256;
+			if (ringOffset + reservationSize >= ring.size())
+				ringOffset = 0;
+			memcpy(ring.data() + ringOffset, data, size);
+			ringOffset += reservationSize;
+		}
+
+		uint64_t Render(const RenderSnapshot& frame)
+		{
+			scheduler.Begin(frame.camera.position, true);
+			for (int i = 0; i < (int)frame.renderables.size(); i++)
+				scheduler.Add(i, frame.renderables[i].center, frame.renderables[i].radius);
+			scheduler.Finish();
+
+			VertexShaderExternalData vsData = {};
+			PixelShaderExternalData psData = {};
+			psData.camPos = frame.camera.position;
+			memcpy(&psData.lights, frame.lights.data(), sizeof(Light) * frame.lights.size());
+			psData.time = frame.totalTime;
+			for (auto& pass : scheduler.GetPasses())
+			{
+				for (auto& item : scheduler.GetItems(pass))
+				{
+					const Renderable& r = frame.renderables[item.entityIndex];
+					vsData.world = r.world;
+					vsData.worldInvTrans = r.worldInvTrans;
+					vsData.viewMatrix = frame.camera.view;
+					vsData.projectionMatrix = frame.camera.projection;
+					Upload(&vsData, sizeof(VertexShaderExternalData));
+					if (pass.depthOnly)
+						continue;
+
+					psData.colorTint = XMFLOAT3(1, 1, 1);
+					psData.roughness = (r.material & 7) / 7.0f;
+					psData.uvScale = XMFLOAT2(1, 1);
+					Upload(&psData, sizeof(PixelShaderExternalData));
+				}
+			}
+			return (uint64_t)ringOffset + ring[ringOffset / 2] + scheduler.GetDrawList().size();
+		}
+	};
+
+	// --------------------------------------------------------
+	// Game's Update() and Draw() with a fixed 60 Hz clock: a
+	// few warm-up frames, then options.frames measured ones
+	// --------------------------------------------------------
+	ModeResult RunMode(const Options& options, const char* name, bool pipelined)
+	{
+		Scene scene;
+		BuildScene(scene, options.entities);
+		Renderer renderer;
+
+		FramePipeline pipeline;
+		pipeline.SetUpdate([&scene](RenderSnapshot& snapshot) { UpdateStage(scene, snapshot); });
+		pipeline.SetPipelined(pipelined);
+
+		const int warmupFrames = 10;
+		std::vector<double> latencies;
+		latencies.reserve(options.frames);
+		double updateMs = 0;
+		double waitMs = 0;
+		Clock::time_point start;
+
+		for (int frame = 0; frame < warmupFrames + options.frames; frame++)
+		{
+			if (frame == warmupFrames)
+				start = Clock::now();
+
+			// Update(): the last update is done, so the scene can take this frame's input
+			pipeline.Finish();
+			FramePipelineStats stats = pipeline.GetStats();
+			scene.deltaTime = 1.0f / 60.0f;
+			scene.totalTime = frame / 60.0f;
+			scene.inputTime = Clock::now();
+			pipeline.Start();
+
+			// Draw()
+			const RenderSnapshot& current = pipeline.GetCurrent();
+			sink = sink + renderer.Render(current);
+			Clock::time_point end = Clock::now();
+
+			if (frame >= warmupFrames)
+			{
+				latencies.push_back(std::chrono::duration<double, std::milli>(end - current.inputTime).count());
+				updateMs += pipeline.GetStats().updateMs;
+				waitMs += stats.waitMs;
+			}
+		}
+		pipeline.Finish();
+		double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		double latencySum = 0;
+		for (double ms : latencies)
+			latencySum += ms;
+		std::sort(latencies.begin(), latencies.end());
+
+		ModeResult result;
+		result.name = name;
+		result.framesPerSecond = options.frames / (totalMs / 1000.0);
+		result.meanFrameMs = totalMs / options.frames;
+		result.updateMs = updateMs / options.frames;
+		result.waitMs = waitMs / options.frames;
+		result.meanLatencyMs = latencySum / latencies.size();
+		result.p95LatencyMs = latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)];
+		return result;
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (i + 1 >= argc)
+				return false;
+
+			if (arg == "--entities")
+				options.entities = atoi(argv[++i]);
+			else if (arg == "--frames")
+				options.frames = atoi(argv[++i]);
+			else
+				return false;
+		}
+		return options.entities > 0 && options.frames > 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		printf("Usage: PipelineBenchmark [--entities 20000] [--frames 600]\n");
+		return 2;
+	}
+
+	printf("%d entities, %d frames per mode\n", options.entities, options.frames);
+	printf("%-10s %9s %10s %10s %10s %14s %14s\n", "mode", "fps", "frame", "update", "waited", "latency mean", "latency p95");
+
+	ModeResult results[2] = {
+		RunMode(options, "serial", false),
+		RunMode(options, "pipelined", true)
+	};
+	for (const ModeResult& r : results)
+	{
+		printf("%-10s %9.1f %7.3f ms %7.3f ms %7.3f ms %11.3f ms %11.3f ms\n",
+			r.name, r.framesPerSecond, r.meanFrameMs, r.updateMs, r.waitMs, r.meanLatencyMs, r.p95LatencyMs);
+	}
+
+	printf("Pipelined: %.2fx the throughput, %+.3f ms mean latency (checksum %llu)\n",
+		results[1].framesPerSecond / results[0].framesPerSecond,
+		results[1].meanLatencyMs - results[0].meanLatencyMs,
+		(unsigned long long)sink);
+	return 0;
+}
@@ -0,0 +1,287 @@
+// --------------------------------------------------------
+// Checks for RenderGraph
+//
+//   culling   passes whose output never reaches an imported
+//             texture are culled, along with whatever only
+//             fed them; imports are never culled
+//   lifetimes first and last use of every texture, counted
+//             over the surviving passes, and the execution
+//             order they run in
+//   aliasing  transients share a physical texture only when
+//             their lifetimes don't overlap and their
+//             descriptions match
+//   errors    reading before anything writes, unknown
+//             handles, and reading and writing one texture
+//   reuse     Reset() and the frame arena, frame after frame
+//
+// Standalone and platform independent, e.g. from the repo root:
+//   g++ -O2 -std=c++17 -I. Tools/RenderGraphCheck.cpp RenderGraph.cpp FrameArena.cpp -o RenderGraphCheck
+// or with CMake (Tools/CMakeLists.txt), where ctest runs it.
+// Exits with 1 if any check fails.
+// --------------------------------------------------------
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+#include "RenderGraph.h"
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool ok, const char* what)
+	{
+		printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+		if (!ok)
+			failures++;
+	}
+
+	const RGTextureDesc fullDesc = { 1280, 720, RGFormat::RGBA8_UNORM };
+	const RGTextureDesc halfDesc = { 640, 360, RGFormat::RGBA8_UNORM };
+	const RGTextureDesc hdrDesc = { 1280, 720, RGFormat::RGBA16_FLOAT };
+
+	// A pass from the graph (so its lists use the graph's arena), named with a literal
+	int AddPass(RenderGraph& graph, const char* name, std::vector<RGHandle> reads, std::vector<RGHandle> writes)
+	{
+		RenderGraphPass pass = graph.CreatePass(name);
+		pass.reads.assign(reads.begin(), reads.end());
+		pass.writes.assign(writes.begin(), writes.end());
+		return graph.AddPass(std::move(pass));
+	}
+
+	bool Contains(const std::string& text, const char* part)
+	{
+		return text.find(part) != std::string::npos;
+	}
+
+	void CheckCulling()
+	{
+		printf("Culling\n");
+		RenderGraph graph;
+		RGHandle backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		RGHandle scene = graph.CreateTexture("Scene", fullDesc);
+		RGHandle debug = graph.CreateTexture("Debug", fullDesc);
+		RGHandle debugBlur = graph.CreateTexture("Debug Blur", fullDesc);
+
+		int scenePass = AddPass(graph, "Scene", {}, { scene });
+		int debugPass = AddPass(graph, "Debug", { scene }, { debug });
+		int debugBlurPass = AddPass(graph, "Debug Blur", { debug }, { debugBlur });
+		int presentPass = AddPass(graph, "Present", { scene }, { backBuffer });
+
+		Check(graph.Compile(), "compiles");
+		Check(!graph.IsPassCulled(scenePass) && !graph.IsPassCulled(presentPass), "passes reaching the back buffer survive");
+		Check(graph.IsPassCulled(debugBlurPass), "a pass nothing reads is culled");
+		Check(graph.IsPassCulled(debugPass), "a pass only feeding culled passes is culled too");
+		RenderGraphStats stats = graph.GetStats();
+		Check(stats.passes == 4 && stats.culledPasses == 2, "stats count the culled passes");
+		Check(graph.GetFirstUse(debug) == -1 && graph.GetLastUse(debugBlur) == -1, "textures of culled passes are unused");
+
+		// Writing an import is enough to survive, read or not
+		graph.Reset();
+		RGHandle screenshot = graph.ImportTexture("Screenshot", fullDesc);
+		scene = graph.CreateTexture("Scene", fullDesc);
+		scenePass = AddPass(graph, "Scene", {}, { scene });
+		int copyPass = AddPass(graph, "Copy", { scene }, { screenshot });
+		Check(graph.Compile() && !graph.IsPassCulled(scenePass) && !graph.IsPassCulled(copyPass), "writing any import keeps a pass");
+		Check(graph.IsImported(screenshot) && graph.GetPhysicalIndex(screenshot) == -1, "imports get no physical texture");
+
+		// No imports at all: nothing is worth running
+		graph.Reset();
+		scene = graph.CreateTexture("Scene", fullDesc);
+		AddPass(graph, "Scene", {}, { scene });
+		Check(graph.Compile() && graph.GetExecutionOrder().empty(), "a graph without imports culls everything");
+	}
+
+	void CheckLifetimes()
+	{
+		printf("Lifetimes and order\n");
+		RenderGraph graph;
+		RGHandle backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		RGHandle scene = graph.CreateTexture("Scene", fullDesc);
+		RGHandle unused = graph.CreateTexture("Unused", fullDesc);
+		RGHandle horizontal = graph.CreateTexture("Horizontal", fullDesc);
+		RGHandle blurred = graph.CreateTexture("Blurred", fullDesc);
+
+		AddPass(graph, "Scene", {}, { scene });
+		AddPass(graph, "Unused", { scene }, { unused });
+		AddPass(graph, "Blur Horizontal", { scene }, { horizontal });
+		AddPass(graph, "Blur Vertical", { horizontal }, { blurred });
+		AddPass(graph, "Composite", { scene, blurred }, { backBuffer });
+
+		Check(graph.Compile(), "compiles");
+		Check(graph.GetExecutionOrder() == std::vector<int>({ 0, 2, 3, 4 }), "survivors run in declaration order");
+
+		// Positions are in the execution order, so the culled pass doesn't count
+		Check(graph.GetFirstUse(scene) == 0 && graph.GetLastUse(scene) == 3, "scene: written first, read by the last pass");
+		Check(graph.GetFirstUse(horizontal) == 1 && graph.GetLastUse(horizontal) == 2, "horizontal: positions 1 to 2");
+		Check(graph.GetFirstUse(blurred) == 2 && graph.GetLastUse(blurred) == 3, "blurred: positions 2 to 3");
+		Check(graph.GetFirstUse(backBuffer) == 3 && graph.GetLastUse(backBuffer) == 3, "imports are tracked too");
+		Check(graph.GetFirstUse(unused) == -1 && graph.GetLastUse(unused) == -1, "a culled pass's output is unused");
+
+		const RenderGraphPass& pass = graph.GetPass(4);
+		Check(std::string(pass.name) == "Composite" && pass.reads.size() == 2 && pass.writes.size() == 1, "passes keep their name, reads and writes");
+		Check(std::string(graph.GetName(blurred)) == "Blurred", "textures keep their name");
+	}
+
+	void CheckAliasing()
+	{
+		printf("Aliasing\n");
+		RenderGraph graph;
+		RGHandle backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		RGHandle a = graph.CreateTexture("A", fullDesc);
+		RGHandle b = graph.CreateTexture("B", fullDesc);
+		RGHandle c = graph.CreateTexture("C", fullDesc);
+		RGHandle d = graph.CreateTexture("D", fullDesc);
+
+		// A chain: each texture dies as the one after next is born
+		AddPass(graph, "1", {}, { a });
+		AddPass(graph, "2", { a }, { b });
+		AddPass(graph, "3", { b }, { c });
+		AddPass(graph, "4", { c }, { d });
+		AddPass(graph, "5", { d }, { backBuffer });
+
+		Check(graph.Compile(), "compiles");
+		Check(graph.GetPhysicalIndex(a) != graph.GetPhysicalIndex(b), "a texture isn't aliased with the one its last pass writes");
+		Check(graph.GetPhysicalIndex(a) == graph.GetPhysicalIndex(c) && graph.GetPhysicalIndex(b) == graph.GetPhysicalIndex(d), "once a texture is dead, a matching one takes its place");
+		RenderGraphStats stats = graph.GetStats();
+		Check(stats.transientTextures == 4 && stats.physicalTextures == 2, "four transients on two textures");
+		Check(stats.transientBytes == 4 * 1280 * 720 * 4u && stats.physicalBytes == 2 * 1280 * 720 * 4u, "bytes with and without aliasing");
+
+		// The same chain with mixed descriptions: only the matching pair is shared
+		graph.Reset();
+		backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		a = graph.CreateTexture("A", fullDesc);
+		b = graph.CreateTexture("B", halfDesc);
+		c = graph.CreateTexture("C", hdrDesc);
+		d = graph.CreateTexture("D", fullDesc);
+		AddPass(graph, "1", {}, { a });
+		AddPass(graph, "2", { a }, { b });
+		AddPass(graph, "3", { b }, { c });
+		AddPass(graph, "4", { c }, { d });
+		AddPass(graph, "5", { d }, { backBuffer });
+		Check(graph.Compile(), "compiles");
+		Check(graph.GetPhysicalIndex(a) != graph.GetPhysicalIndex(c) && graph.GetPhysicalIndex(b) != graph.GetPhysicalIndex(d), "size or format differences aren't aliased");
+		Check(graph.GetPhysicalIndex(a) == graph.GetPhysicalIndex(d), "a matching description is, once free");
+		Check(graph.GetStats().physicalTextures == 3, "three physical textures");
+
+		// Everything alive at once: one texture each
+		graph.Reset();
+		backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		a = graph.CreateTexture("A", fullDesc);
+		b = graph.CreateTexture("B", fullDesc);
+		c = graph.CreateTexture("C", fullDesc);
+		AddPass(graph, "Write", {}, { a, b, c });
+		AddPass(graph, "Read", { a, b, c }, { backBuffer });
+		Check(graph.Compile(), "compiles");
+		Check(graph.GetStats().physicalTextures == 3, "overlapping lifetimes never share");
+
+		// Physical descriptions match what was aliased onto them
+		bool matches = true;
+		for (RGHandle h : { a, b, c })
+		{
+			RGTextureDesc want = graph.GetDesc(h);
+			RGTextureDesc got = graph.GetPhysicalTextures()[graph.GetPhysicalIndex(h)];
+			matches = matches && want.width == got.width && want.height == got.height && want.format == got.format;
+		}
+		Check(matches, "physical textures have their transients' descriptions");
+	}
+
+	void CheckErrors()
+	{
+		printf("Errors\n");
+		RenderGraph graph;
+		RGHandle backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		RGHandle scene = graph.CreateTexture("Scene", fullDesc);
+		RGHandle blurred = graph.CreateTexture("Blurred", fullDesc);
+
+		// The blur is declared before the scene that feeds it
+		AddPass(graph, "Blur", { scene }, { blurred });
+		AddPass(graph, "Scene", {}, { scene });
+		AddPass(graph, "Present", { blurred }, { backBuffer });
+		Check(!graph.Compile(), "reading before anything writes fails");
+		Check(Contains(graph.GetError(), "'Blur'") && Contains(graph.GetError(), "'Scene'") && Contains(graph.GetError(), "before anything writes it"),
+			"the error names the pass and the texture");
+		Check(graph.GetExecutionOrder().empty(), "a failed compile runs nothing");
+
+		// An import can be read without being written
+		graph.Reset();
+		RGHandle history = graph.ImportTexture("History", fullDesc);
+		backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		AddPass(graph, "Resolve", { history }, { backBuffer });
+		Check(graph.Compile(), "imports count as written");
+
+		graph.Reset();
+		backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		AddPass(graph, "Present", { 7 }, { backBuffer });
+		Check(!graph.Compile() && Contains(graph.GetError(), "reads an unknown texture"), "reading an unknown handle fails");
+
+		graph.Reset();
+		AddPass(graph, "Present", {}, { -1 });
+		Check(!graph.Compile() && Contains(graph.GetError(), "writes an unknown texture"), "writing an unknown handle fails");
+
+		graph.Reset();
+		backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		scene = graph.CreateTexture("Scene", fullDesc);
+		AddPass(graph, "Scene", {}, { scene });
+		AddPass(graph, "In Place", { scene }, { scene });
+		AddPass(graph, "Present", { scene }, { backBuffer });
+		Check(!graph.Compile() && Contains(graph.GetError(), "reads and writes 'Scene'"), "reading and writing one texture fails");
+
+		// The error clears on the next good compile
+		graph.Reset();
+		backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+		AddPass(graph, "Clear", {}, { backBuffer });
+		Check(graph.Compile() && graph.GetError().empty(), "a good compile clears the error");
+	}
+
+	void CheckReuse()
+	{
+		printf("Frame to frame\n");
+		FrameArena arena(16 * 1024);
+		RenderGraph graph;
+		graph.SetFrameArena(&arena);
+
+		bool same = true;
+		for (int frame = 0; frame < 8; frame++)
+		{
+			arena.BeginFrame();
+			graph.Reset();
+			RGHandle backBuffer = graph.ImportTexture("Back Buffer", fullDesc);
+			RGHandle scene = graph.CreateTexture("Scene", fullDesc);
+			RGHandle half = graph.CreateTexture("Half", halfDesc);
+
+			// Every other frame adds a pass that gets culled
+			AddPass(graph, "Scene", {}, { scene });
+			if (frame & 1)
+				AddPass(graph, "Unused", { scene }, { half });
+			AddPass(graph, "Present", { scene }, { backBuffer });
+
+			same = same && graph.Compile() &&
+				graph.GetExecutionOrder() == std::vector<int>({ 0, (frame & 1) ? 2 : 1 }) &&
+				graph.GetStats().physicalTextures == 1 &&
+				graph.GetStats().culledPasses == (frame & 1);
+		}
+		Check(same, "every frame compiles the same from nothing");
+
+		arena.BeginFrame();
+		FrameArenaStats stats = arena.GetStats();
+		Check(stats.allocations > 0 && stats.overflowAllocations == 0, "pass lists and compile scratch came from the arena");
+	}
+}
+
+int main()
+{
+	CheckCulling();
+	CheckLifetimes();
+	CheckAliasing();
+	CheckErrors();
+	CheckReuse();
+
+	if (failures)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
@@ -0,0 +1,304 @@
+// --------------------------------------------------------
+// Checks for ShadowAtlas
+//
+//   layout    over many random frames, every tile lies inside
+//             the atlas, no two overlap, a light has all of
+//             its faces (in order) or none, and there are
+//             never more than maxTiles tiles
+//   limit     a light whose faces would pass maxTiles is
+//             skipped on its own, lights after it still fit
+//   pressure  when the atlas is too small the least important
+//             lights are halved first, then evicted; lights
+//             too far away or off screen never get tiles
+//   dirty     unchanged frames keep their tiles clean, and
+//             caster changes, MarkLightDirty and repacking
+//             only dirty the tiles they affect
+//
+// Needs DirectXMath for XMFLOAT3, e.g. from the repo root:
+//   cl /O2 /EHsc /std:c++17 /I. Tools\ShadowAtlasCheck.cpp ShadowAtlas.cpp
+//   g++ -O2 -std=c++17 -I. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs Tools/ShadowAtlasCheck.cpp ShadowAtlas.cpp -o ShadowAtlasCheck
+// or with CMake (Tools/CMakeLists.txt), where ctest runs it.
+// Exits with 1 if any check fails.
+// --------------------------------------------------------
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "ShadowAtlas.h"
+
+using namespace DirectX;
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool ok, const char* what)
+	{
+		printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+		if (!ok)
+			failures++;
+	}
+
+	uint32_t Hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+		x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	}
+
+	float Random(uint32_t& seed)
+	{
+		seed = Hash(seed + 0x9e3779b9);
+		return (seed & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	ShadowAtlasRequest Light(int lightIndex, int faceCount, float coverage, float distance, XMFLOAT3 position = XMFLOAT3(0, 0, 0), float range = 5)
+	{
+		return { lightIndex, faceCount, position, range, coverage, distance };
+	}
+
+	// Size of a light's tiles, -1 if it has none
+	int TileSize(ShadowAtlas& atlas, int lightIndex)
+	{
+		int first = atlas.FindFirstTile(lightIndex);
+		return first < 0 ? -1 : atlas.GetTiles()[first].size;
+	}
+
+	int CountTiles(ShadowAtlas& atlas, int lightIndex, bool dirtyOnly = false)
+	{
+		int count = 0;
+		for (const ShadowAtlasTile& t : atlas.GetTiles())
+			if (t.lightIndex == lightIndex && (t.dirty || !dirtyOnly))
+				count++;
+		return count;
+	}
+
+	bool Overlap(const ShadowAtlasTile& a, const ShadowAtlasTile& b)
+	{
+		return a.x < b.x + b.size && b.x < a.x + a.size &&
+			a.y < b.y + b.size && b.y < a.y + a.size;
+	}
+
+	// Bounds, overlap, all-or-none faces and the tile limit for one Update()
+	struct LayoutResult {
+		bool inBounds = true;
+		bool disjoint = true;
+		bool wholeLights = true;
+		bool underLimit = true;
+	};
+
+	void CheckLayout(ShadowAtlas& atlas, const std::vector<ShadowAtlasRequest>& requests, int maxTiles, LayoutResult& result)
+	{
+		const std::vector<ShadowAtlasTile>& tiles = atlas.GetTiles();
+		int size = atlas.GetAtlasSize();
+
+		for (size_t i = 0; i < tiles.size(); i++)
+		{
+			const ShadowAtlasTile& t = tiles[i];
+			if (t.x < 0 || t.y < 0 || t.x + t.size > size || t.y + t.size > size)
+				result.inBounds = false;
+			for (size_t j = i + 1; j < tiles.size(); j++)
+				if (Overlap(t, tiles[j]))
+					result.disjoint = false;
+		}
+
+		// A light either has none, or faces 0..n-1 back to back
+		for (const ShadowAtlasRequest& r : requests)
+		{
+			int first = atlas.FindFirstTile(r.lightIndex);
+			if (first < 0)
+				continue;
+			if (CountTiles(atlas, r.lightIndex) != r.faceCount || first + r.faceCount > (int)tiles.size())
+			{
+				result.wholeLights = false;
+				continue;
+			}
+			for (int f = 0; f < r.faceCount; f++)
+			{
+				const ShadowAtlasTile& t = tiles[first + f];
+				if (t.lightIndex != r.lightIndex || t.face != f || t.size != tiles[first].size)
+					result.wholeLights = false;
+			}
+		}
+
+		if ((int)tiles.size() > maxTiles)
+			result.underLimit = false;
+	}
+
+	void CheckLayouts()
+	{
+		printf("Layout over random frames\n");
+		const int maxTiles = 12;
+		ShadowAtlas atlas(1024, 64, 512, maxTiles, 50.0f);
+		LayoutResult result;
+		uint32_t seed = 1;
+		int allocated = 0;
+		int downsized = 0;
+		int evicted = 0;
+
+		// Lights persist between frames with drifting coverage, so hysteresis and repacking both happen
+		const int lightCount = 10;
+		std::vector<ShadowAtlasRequest> lights;
+		for (int i = 0; i < lightCount; i++)
+			lights.push_back(Light(i, Random(seed) < 0.4f ? 6 : 1, Random(seed), Random(seed) * 60.0f));
+
+		for (int frame = 0; frame < 500; frame++)
+		{
+			std::vector<ShadowAtlasRequest> requests;
+			for (ShadowAtlasRequest& light : lights)
+			{
+				light.screenCoverage += (Random(seed) - 0.5f) * 0.2f;
+				light.screenCoverage = light.screenCoverage < 0 ? 0 : (light.screenCoverage > 1 ? 1 : light.screenCoverage);
+				light.distance = Random(seed) < 0.05f ? Random(seed) * 60.0f : light.distance;
+				if (Random(seed) < 0.8f)
+					requests.push_back(light);
+			}
+
+			atlas.Update(requests.data(), (int)requests.size());
+			CheckLayout(atlas, requests, maxTiles, result);
+
+			ShadowAtlasStats stats = atlas.GetStats();
+			allocated += stats.allocatedLights;
+			downsized += stats.downsizedLights;
+			evicted += stats.evictedLights;
+		}
+
+		Check(result.inBounds, "tiles stay inside the atlas");
+		Check(result.disjoint, "tiles never overlap");
+		Check(result.wholeLights, "lights get all of their faces, in order, or none");
+		Check(result.underLimit, "never more than maxTiles tiles");
+		Check(allocated > 0 && downsized > 0 && evicted > 0, "the frames exercised allocation, downsizing and eviction");
+	}
+
+	void CheckTileLimit()
+	{
+		printf("Tile limit\n");
+		ShadowAtlas atlas(4096, 64, 512, 12, 50.0f);
+
+		// Priority order: point (6), spot (1), point (6, would make 13), spot (1)
+		std::vector<ShadowAtlasRequest> requests = {
+			Light(0, 6, 1.0f, 1),
+			Light(1, 1, 0.8f, 1),
+			Light(2, 6, 0.6f, 1),
+			Light(3, 1, 0.4f, 1),
+		};
+		atlas.Update(requests.data(), (int)requests.size());
+		ShadowAtlasStats stats = atlas.GetStats();
+		Check(CountTiles(atlas, 2) == 0, "the point light past the limit gets nothing");
+		Check(CountTiles(atlas, 0) == 6 && CountTiles(atlas, 1) == 1 && CountTiles(atlas, 3) == 1, "lights before and after it keep theirs");
+		Check(stats.tiles == 8 && stats.allocatedLights == 3 && stats.evictedLights == 1, "stats count the one eviction");
+
+		// Exactly at the limit is fine
+		requests = { Light(0, 6, 1.0f, 1), Light(1, 6, 0.8f, 1) };
+		atlas.Update(requests.data(), (int)requests.size());
+		Check(atlas.GetStats().tiles == 12 && atlas.GetStats().evictedLights == 0, "two point lights fill the limit exactly");
+	}
+
+	void CheckPressure()
+	{
+		printf("Pressure\n");
+
+		// 256x256 holds one 256 tile, or four 128s, or sixteen 64s
+		ShadowAtlas atlas(256, 64, 256, 64, 50.0f);
+		std::vector<ShadowAtlasRequest> requests;
+		for (int i = 0; i < 4; i++)
+			requests.push_back(Light(i, 1, 1.0f - i * 0.1f, 1));
+		atlas.Update(requests.data(), (int)requests.size());
+		ShadowAtlasStats stats = atlas.GetStats();
+		Check(stats.allocatedLights == 4 && stats.evictedLights == 0 && stats.downsizedLights > 0, "four full size spots are downsized to fit");
+		bool ordered = true;
+		for (int i = 1; i < 4; i++)
+			ordered = ordered && TileSize(atlas, i) <= TileSize(atlas, i - 1);
+		Check(ordered, "less important lights are never bigger than more important ones");
+
+		// Seventeen 64s can't fit; the least important goes
+		requests.clear();
+		for (int i = 0; i < 17; i++)
+			requests.push_back(Light(i, 1, 1.0f - i * 0.05f, 1));
+		atlas.Update(requests.data(), (int)requests.size());
+		stats = atlas.GetStats();
+		Check(stats.allocatedLights == 16 && stats.evictedLights == 1, "one light too many is evicted");
+		Check(CountTiles(atlas, 16) == 0 && CountTiles(atlas, 0) == 1, "eviction takes the least important light");
+		bool allMin = true;
+		for (const ShadowAtlasTile& t : atlas.GetTiles())
+			allMin = allMin && t.size == 64;
+		Check(allMin, "everything was shrunk to the minimum before evicting");
+
+		// Distance and coverage cut-offs
+		requests = { Light(0, 1, 0.5f, 60), Light(1, 1, 0.0f, 1), Light(2, 1, 0.5f, 10) };
+		atlas.Update(requests.data(), (int)requests.size());
+		Check(CountTiles(atlas, 0) == 0 && CountTiles(atlas, 1) == 0 && CountTiles(atlas, 2) == 1, "too far or off screen gets no tile");
+		Check(atlas.GetStats().evictedLights == 2, "and counts as evicted");
+	}
+
+	void CheckDirty()
+	{
+		printf("Dirty tracking\n");
+		ShadowAtlas atlas(2048, 64, 512, 12, 50.0f);
+
+		// Two lights far apart
+		std::vector<ShadowAtlasRequest> requests = {
+			Light(0, 6, 0.5f, 5, XMFLOAT3(-20, 0, 0), 5),
+			Light(1, 1, 0.5f, 5, XMFLOAT3(20, 0, 0), 5),
+		};
+		atlas.Update(requests.data(), (int)requests.size());
+		Check(atlas.GetStats().dirtyTiles == 7, "new tiles start dirty");
+
+		atlas.ClearDirtyFlags();
+		atlas.Update(requests.data(), (int)requests.size());
+		Check(atlas.GetStats().dirtyTiles == 0 && !atlas.GetStats().repacked, "an unchanged frame keeps every tile clean");
+
+		atlas.NotifyCasterChanged(XMFLOAT3(-18, 0, 0), 1);
+		Check(CountTiles(atlas, 0, true) == 6 && CountTiles(atlas, 1, true) == 0, "a caster change dirties only the light it touches");
+
+		atlas.ClearDirtyFlags();
+		atlas.NotifyCasterChanged(XMFLOAT3(0, 0, 0), 1);
+		Check(CountTiles(atlas, 0, true) == 0 && CountTiles(atlas, 1, true) == 0, "a caster out of every range dirties nothing");
+
+		atlas.MarkLightDirty(1);
+		Check(CountTiles(atlas, 0, true) == 0 && CountTiles(atlas, 1, true) == 1, "MarkLightDirty dirties one light");
+
+		// Dirty flags survive an Update that doesn't move the tiles
+		atlas.Update(requests.data(), (int)requests.size());
+		Check(CountTiles(atlas, 1, true) == 1 && CountTiles(atlas, 0, true) == 0, "pending dirty flags survive an unchanged Update");
+
+		// A new light packed after the others leaves their tiles where they were
+		atlas.ClearDirtyFlags();
+		requests.push_back(Light(2, 1, 0.1f, 10, XMFLOAT3(0, 20, 0), 5));
+		atlas.Update(requests.data(), (int)requests.size());
+		Check(atlas.GetStats().dirtyTiles == 1 && CountTiles(atlas, 2, true) == 1, "a new least important light dirties only its own tile");
+
+		// One that packs first moves things: tiles that kept their spot stay clean, moved ones are dirty
+		atlas.ClearDirtyFlags();
+		std::vector<ShadowAtlasTile> before = atlas.GetTiles();
+		requests.push_back(Light(3, 1, 1.0f, 1, XMFLOAT3(0, -20, 0), 5));
+		atlas.Update(requests.data(), (int)requests.size());
+		bool exact = true;
+		for (const ShadowAtlasTile& t : atlas.GetTiles())
+		{
+			bool kept = false;
+			for (const ShadowAtlasTile& old : before)
+				kept = kept || (old.lightIndex == t.lightIndex && old.face == t.face && old.x == t.x && old.y == t.y && old.size == t.size);
+			exact = exact && t.dirty == !kept;
+		}
+		Check(atlas.GetStats().repacked && exact, "after a repack only new and moved tiles are dirty");
+	}
+}
+
+int main()
+{
+	CheckLayouts();
+	CheckTileLimit();
+	CheckPressure();
+	CheckDirty();
+
+	if (failures)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+// --------------------------------------------------------
+// Just enough of Windows.h for Input.h to parse, so the
+// device-free code that reads Input (Camera) can be built
+// into the benchmarks off Windows. Only put this folder on
+// the include path for non-Windows builds.
+// --------------------------------------------------------
+typedef void* HWND;
+typedef intptr_t LPARAM;
+typedef uintptr_t WPARAM;
@@ -0,0 +1,197 @@
+// --------------------------------------------------------
+// Texture loading before and after TextureLoader
+//
+// Runs every PNG in a folder (Assets/Textures by default)
+// through
+//   serial   decoding one after another on the main thread,
+//            the way the game used to before its first frame
+//   async    TextureLoader with 1, 2, 4... loader threads,
+//            the main thread running frames meanwhile and
+//            draining a few uploads per frame, like Game
+//
+// Uploads are stubbed out (the callback only counts), so it
+// measures decoding and hand-off alone: decode throughput,
+// time to the first frame, and time until every texture is
+// in.
+//
+// Standalone and platform independent, e.g. from the repo root:
+//   g++ -O2 -std=c++17 -pthread -I. Tools/TextureLoaderBenchmark.cpp TextureLoader.cpp PngDecoder.cpp Profiler.cpp -o TextureLoaderBenchmark
+// or with CMake (Tools/CMakeLists.txt).
+//
+//   ./TextureLoaderBenchmark [folder] [--threads 4] [--uploads 4] [--frame-ms 16.7]
+// --------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PngDecoder.h"
+#include "TextureLoader.h"
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	double MB(size_t bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	struct Result {
+		double firstFrameMs;
+		double allTexturesMs;
+		int frames;
+		int uploaded;
+		int failed;
+		size_t bytesDecoded;
+		double decodeMs;		// Summed across threads
+	};
+
+	// --------------------------------------------------------
+	// Everything decoded before the first frame can start
+	// --------------------------------------------------------
+	Result RunSerial(const std::vector<std::string>& files)
+	{
+		Result r = {};
+		Clock::time_point start = Clock::now();
+		for (const std::string& file : files)
+		{
+			DecodedImage image;
+			if (PngDecoder::DecodeFile(file, image))
+			{
+				r.uploaded++;
+				r.bytesDecoded += image.pixels.size();
+			}
+			else
+				r.failed++;
+		}
+		r.allTexturesMs = MsSince(start);
+		r.firstFrameMs = r.allTexturesMs;
+		r.decodeMs = r.allTexturesMs;
+		r.frames = 1;
+		return r;
+	}
+
+	// --------------------------------------------------------
+	// Everything requested up front, then frames run (paced
+	// to frameMs) while the loader threads decode
+	// --------------------------------------------------------
+	Result RunAsync(const std::vector<std::string>& files, unsigned int threads, int uploadsPerFrame, double frameMs)
+	{
+		Result r = {};
+		Clock::time_point start = Clock::now();
+
+		TextureLoader loader(threads);
+		int uploaded = 0;
+		for (const std::string& file : files)
+			loader.Request(file, [&uploaded](const TextureLoadResult&) { uploaded++; });
+
+		while (true)
+		{
+			Clock::time_point frameStart = Clock::now();
+			loader.ProcessCompleted(uploadsPerFrame);
+			r.frames++;
+			if (r.frames == 1)
+				r.firstFrameMs = MsSince(start);
+			if (loader.IsIdle())
+				break;
+
+			std::this_thread::sleep_until(frameStart + std::chrono::microseconds((long long)(frameMs * 1000)));
+		}
+		r.allTexturesMs = MsSince(start);
+
+		TextureLoaderStats stats = loader.GetStats();
+		r.uploaded = uploaded;
+		r.failed = stats.failed;
+		r.bytesDecoded = stats.bytesDecoded;
+		r.decodeMs = stats.decodeMs;
+		return r;
+	}
+
+	void Print(const char* name, const Result& r)
+	{
+		printf("%-10s %10.1f %12.1f %7d %9.1f %12.1f %9d\n", name,
+			r.firstFrameMs, r.allTexturesMs, r.frames,
+			MB(r.bytesDecoded) / (r.allTexturesMs / 1000.0),
+			r.decodeMs, r.failed);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string folder = "Assets/Textures";
+	unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	int uploadsPerFrame = 4;
+	double frameMs = 1000.0 / 60.0;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc)
+			maxThreads = (unsigned int)std::max(1, atoi(argv[++i]));
+		else if (arg == "--uploads" && i + 1 < argc)
+			uploadsPerFrame = std::max(1, atoi(argv[++i]));
+		else if (arg == "--frame-ms" && i + 1 < argc)
+			frameMs = atof(argv[++i]);
+		else if (arg[0] != '-')
+			folder = arg;
+		else
+		{
+			printf("Usage: TextureLoaderBenchmark [folder] [--threads 4] [--uploads 4] [--frame-ms 16.7]\n");
+			return 2;
+		}
+	}
+
+	std::vector<std::string> files;
+	size_t fileBytes = 0;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(folder, error))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".png")
+		{
+			files.push_back(entry.path().string());
+			fileBytes += (size_t)entry.file_size();
+		}
+	}
+	if (files.empty())
+	{
+		printf("No .png files in %s (run from the repo root, or pass the folder)\n", folder.c_str());
+		return 1;
+	}
+	std::sort(files.begin(), files.end());
+
+	printf("%d PNGs, %.1f MB on disk, %d uploads per %.1f ms frame\n", (int)files.size(), MB(fileBytes), uploadsPerFrame, frameMs);
+	printf("%-10s %10s %12s %7s %9s %12s %9s\n", "", "first ms", "all in ms", "frames", "MB/s", "decode ms", "failed");
+
+	Result serial = RunSerial(files);
+	Print("serial", serial);
+	int failed = serial.failed;
+
+	// Powers of two up to the limit, and the limit itself
+	for (unsigned int threads = 1; ; threads *= 2)
+	{
+		threads = std::min(threads, maxThreads);
+		char name[32];
+		snprintf(name, sizeof(name), "%u thread%s", threads, threads == 1 ? "" : "s");
+		Result async = RunAsync(files, threads, uploadsPerFrame, frameMs);
+		Print(name, async);
+		failed += async.failed;
+		if (threads == maxThreads)
+			break;
+	}
+
+	printf("MB/s is decoded RGBA over the wall time until every texture is in\n");
+	if (failed)
+	{
+		printf("%d decode(s) failed\n", failed);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,362 @@
+// --------------------------------------------------------
+// Deterministic driver for TextureResidency
+//
+// Scripts frames by hand (frame numbers, uses, completed
+// stream-ins) and checks what the policy decides:
+//   sizes      MipChainBytes and MipForScreenSize
+//   budget     targets fit the budget whenever they can
+//   lru        least recently used textures lose mips first,
+//              one level at a time
+//   ties       same frame: least on screen first, then the
+//              lower id
+//   floors     pinned textures stay at mip 0 and everything
+//              else stops at its tail, even over budget
+//   streaming  stream-ins go most recent first, capped, and
+//              a texture in flight isn't touched again
+//   idle       unused textures drop to their tail
+//   replay     the same script gives the same actions
+//
+// Standalone and platform independent, e.g. from the repo root:
+//   g++ -O2 -std=c++17 -I. Tools/TextureResidencyCheck.cpp TextureResidency.cpp -o TextureResidencyCheck
+// or with CMake (Tools/CMakeLists.txt), where ctest runs it.
+// Exits with 1 if any check fails.
+// --------------------------------------------------------
+#include <cstdio>
+#include <vector>
+#include "TextureResidency.h"
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool ok, const char* what)
+	{
+		printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+		if (!ok)
+			failures++;
+	}
+
+	// 256x256 RGBA8 with a full chain: the tail (64 texels) is mip 2
+	const ResidencyTextureDesc Texture = { 256, 256, 9, 0, false };
+	const ResidencyTextureDesc Pinned = { 256, 256, 9, 0, true };
+	const size_t Full = TextureResidency::MipChainBytes(Texture, 0);
+	const size_t Mip1 = TextureResidency::MipChainBytes(Texture, 1);
+	const size_t Tail = TextureResidency::MipChainBytes(Texture, 2);
+
+	// Does what the game's streamer would: evictions land at
+	// once, stream-ins only when told to
+	void ApplyEvictions(TextureResidency& residency, const std::vector<ResidencyAction>& actions)
+	{
+		for (const ResidencyAction& a : actions)
+			if (a.type == ResidencyActionType::Evict)
+				residency.SetResidentMip(a.texture, a.toMip);
+	}
+
+	void ApplyAll(TextureResidency& residency, const std::vector<ResidencyAction>& actions)
+	{
+		for (const ResidencyAction& a : actions)
+			residency.SetResidentMip(a.texture, a.toMip);
+	}
+
+	bool SameAction(const ResidencyAction& a, ResidencyActionType type, int texture, int fromMip, int toMip)
+	{
+		return a.type == type && a.texture == texture && a.fromMip == fromMip && a.toMip == toMip;
+	}
+
+	std::vector<int> Targets(TextureResidency& residency, int count)
+	{
+		std::vector<int> targets;
+		for (int i = 0; i < count; i++)
+			targets.push_back(residency.GetTargetMip(i));
+		return targets;
+	}
+
+	void CheckSizes()
+	{
+		printf("Sizes\n");
+		Check(Full == 4 * 87381 && Mip1 == 4 * 21845 && Tail == 4 * 5461, "RGBA8 chain bytes");
+
+		// BC1: 8 bytes per 4x4 block, at least one block per level
+		ResidencyTextureDesc bc1 = { 256, 256, 9, 8, false };
+		size_t expected = 0;
+		for (int blocks : { 64, 32, 16, 8, 4, 2, 1, 1, 1 })
+			expected += (size_t)blocks * blocks * 8;
+		Check(TextureResidency::MipChainBytes(bc1, 0) == expected, "block compressed chain bytes");
+
+		Check(TextureResidency::MipForScreenSize(256, 256, 9) == 0 &&
+			TextureResidency::MipForScreenSize(256, 1000, 9) == 0 &&
+			TextureResidency::MipForScreenSize(256, 128, 9) == 1 &&
+			TextureResidency::MipForScreenSize(256, 100, 9) == 1 &&
+			TextureResidency::MipForScreenSize(256, 0.5f, 9) == 8 &&
+			TextureResidency::MipForScreenSize(256, 1, 1) == 0, "mip for screen size");
+	}
+
+	// Four textures all wanting mip 0 from the same resident mip 0
+	TextureResidency MakeFour(size_t budget)
+	{
+		TextureResidency residency(budget);
+		residency.SetMaxStreamIns(8);
+		for (int i = 0; i < 4; i++)
+			residency.AddTexture(Texture, 0);
+		return residency;
+	}
+
+	void CheckBudgetAndLru()
+	{
+		printf("Budget and LRU\n");
+
+		// Used last on frames 1, 2, 3 and 4, so A is the oldest
+		TextureResidency residency = MakeFour(4 * Full);
+		for (unsigned long long frame = 1; frame <= 4; frame++)
+		{
+			residency.BeginFrame(frame);
+			for (int i = (int)frame - 1; i < 4; i++)
+				residency.ReportUse(i, 256);
+			std::vector<ResidencyAction> actions = residency.Update();
+			if (frame == 4)
+				Check(actions.empty() && Targets(residency, 4) == std::vector<int>({ 0, 0, 0, 0 }), "within budget nothing changes");
+		}
+
+		// A must go to its tail and B lose one level to fit
+		size_t budget = 4 * Full - (Full - Tail) - 1;
+		residency.SetBudget(budget);
+		residency.BeginFrame(5);
+		std::vector<ResidencyAction> actions = residency.Update();
+		ResidencyStats stats = residency.GetStats();
+		Check(Targets(residency, 4) == std::vector<int>({ 2, 1, 0, 0 }), "oldest loses mips first, one level at a time");
+		Check(stats.targetBytes == 2 * Full + Mip1 + Tail && stats.targetBytes <= budget, "targets fit the budget");
+		Check(stats.wantedBytes == 4 * Full && stats.degraded == 2, "wanted and degraded stats");
+		Check(actions.size() == 2 &&
+			SameAction(actions[0], ResidencyActionType::Evict, 0, 0, 2) &&
+			SameAction(actions[1], ResidencyActionType::Evict, 1, 0, 1), "evictions for exactly those mips");
+
+		ApplyEvictions(residency, actions);
+		Check(residency.GetStats().residentBytes <= budget, "resident bytes within budget after evicting");
+
+		// Use A again: it's now the most recent, so C and then D give way to it
+		residency.BeginFrame(6);
+		residency.ReportUse(0, 256);
+		actions = residency.Update();
+		Check(Targets(residency, 4) == std::vector<int>({ 0, 2, 1, 0 }), "a texture used again moves to the back of the line");
+		Check(actions.size() == 3 &&
+			SameAction(actions[0], ResidencyActionType::Evict, 1, 1, 2) &&
+			SameAction(actions[1], ResidencyActionType::Evict, 2, 0, 1) &&
+			SameAction(actions[2], ResidencyActionType::StreamIn, 0, 2, 0), "evictions come before the stream-in they make room for");
+
+		// Budget back up: everything returns
+		residency.SetBudget(4 * Full);
+		ApplyAll(residency, actions);
+		residency.BeginFrame(7);
+		for (int i = 0; i < 4; i++)
+			residency.ReportUse(i, 256);
+		actions = residency.Update();
+		ApplyAll(residency, actions);
+		Check(Targets(residency, 4) == std::vector<int>({ 0, 0, 0, 0 }) && residency.GetStats().residentBytes == 4 * Full, "raising the budget streams everything back");
+	}
+
+	void CheckTies()
+	{
+		printf("Tie breaking\n");
+
+		// All used this frame and all needing mip 0, but covering different amounts of screen
+		TextureResidency residency = MakeFour(4 * Full);
+		residency.BeginFrame(1);
+		const float screen[] = { 256, 400, 300, 256 };
+		for (int i = 0; i < 4; i++)
+			residency.ReportUse(i, screen[i]);
+		residency.Update();
+
+		// Two go to the tail and one more loses a level: 0 and 3 (smallest, by id), then 2
+		residency.SetBudget(Full + Mip1 + 2 * Tail);
+		residency.BeginFrame(1);
+		for (int i = 0; i < 4; i++)
+			residency.ReportUse(i, screen[i]);
+		std::vector<ResidencyAction> actions = residency.Update();
+		Check(Targets(residency, 4) == std::vector<int>({ 2, 0, 1, 2 }), "least on screen first, then the lower id");
+		Check(actions.size() == 3 && actions[0].texture == 0 && actions[1].texture == 2 && actions[2].texture == 3, "actions come out in id order");
+	}
+
+	void CheckFloors()
+	{
+		printf("Floors\n");
+
+		TextureResidency residency(0);
+		residency.SetMaxStreamIns(8);
+		int pinned = residency.AddTexture(Pinned, 0);
+		int streamed = residency.AddTexture(Texture, 0);
+		int late = residency.AddTexture(Pinned, 3);
+
+		residency.BeginFrame(1);
+		residency.ReportUse(streamed, 256);
+		std::vector<ResidencyAction> actions = residency.Update();
+		Check(residency.GetTargetMip(pinned) == 0, "pinned stays at mip 0 with no budget at all");
+		Check(residency.GetTargetMip(streamed) == 2, "unpinned stops at its tail even over budget");
+		Check(residency.GetStats().targetBytes == 2 * Full + Tail, "over budget is reported, not hidden");
+
+		bool pinnedEvicted = false;
+		bool lateStreamed = false;
+		for (const ResidencyAction& a : actions)
+		{
+			if (a.texture != streamed && a.type == ResidencyActionType::Evict)
+				pinnedEvicted = true;
+			if (a.texture == late && a.type == ResidencyActionType::StreamIn && a.toMip == 0)
+				lateStreamed = true;
+		}
+		Check(!pinnedEvicted, "pinned textures are never evicted");
+		Check(lateStreamed, "a pinned texture added coarse is streamed up to mip 0");
+
+		// Pinned ignores use and idleness alike
+		ApplyAll(residency, actions);
+		residency.BeginFrame(1000);
+		residency.ReportUse(pinned, 1);
+		residency.Update();
+		Check(residency.GetTargetMip(pinned) == 0 && residency.GetTargetMip(late) == 0, "pinned ignores screen size and idle time");
+
+		// A smaller tail size moves the floor down
+		residency.SetTailSize(16);
+		residency.BeginFrame(1001);
+		residency.Update();
+		Check(residency.GetTargetMip(streamed) == 4 && residency.GetTargetMip(pinned) == 0, "tail size sets the unpinned floor");
+	}
+
+	void CheckStreaming()
+	{
+		printf("Streaming\n");
+
+		// Three textures resident at their tails, all wanting mip 0, two stream-ins allowed
+		TextureResidency residency(1 << 30);
+		residency.SetMaxStreamIns(2);
+		for (int i = 0; i < 3; i++)
+			residency.AddTexture(Texture, 2);
+
+		residency.BeginFrame(1);
+		residency.ReportUse(0, 256);
+		residency.BeginFrame(2);
+		residency.ReportUse(0, 256);
+		residency.ReportUse(1, 256);
+		residency.ReportUse(2, 512);
+		std::vector<ResidencyAction> actions = residency.Update();
+		Check(actions.size() == 2 &&
+			SameAction(actions[0], ResidencyActionType::StreamIn, 2, 2, 0) &&
+			SameAction(actions[1], ResidencyActionType::StreamIn, 0, 2, 0), "capped, biggest on screen first");
+		Check(residency.IsStreaming(2) && residency.IsStreaming(0) && !residency.IsStreaming(1), "in flight flags");
+
+		// Nothing completes: no new work, and nothing in flight is touched
+		residency.BeginFrame(3);
+		for (int i = 0; i < 3; i++)
+			residency.ReportUse(i, 256);
+		actions = residency.Update();
+		Check(actions.empty() && residency.GetStats().streamingIn == 2, "nothing new while the cap is used up");
+
+		// One finishes and frees a slot
+		residency.SetResidentMip(2, 0);
+		residency.BeginFrame(4);
+		for (int i = 0; i < 3; i++)
+			residency.ReportUse(i, 256);
+		actions = residency.Update();
+		Check(actions.size() == 1 && SameAction(actions[0], ResidencyActionType::StreamIn, 1, 2, 0), "a finished stream-in frees a slot");
+
+		// Screen size between mips: one level of slack keeps what's resident
+		residency.SetResidentMip(0, 0);
+		residency.SetResidentMip(1, 0);
+		residency.BeginFrame(5);
+		residency.ReportUse(0, 128);
+		residency.ReportUse(1, 64);
+		residency.ReportUse(2, 256);
+		actions = residency.Update();
+		Check(residency.GetNeededMip(0) == 0 && residency.GetNeededMip(1) == 2, "one level of slack, no more");
+		Check(actions.size() == 1 && SameAction(actions[0], ResidencyActionType::Evict, 1, 0, 2), "only the texture past the slack is evicted");
+	}
+
+	void CheckIdle()
+	{
+		printf("Idle\n");
+
+		TextureResidency residency(1 << 30);
+		residency.SetIdleFrames(10);
+		int texture = residency.AddTexture(Texture, 0);
+
+		residency.BeginFrame(1);
+		residency.ReportUse(texture, 256);
+		residency.Update();
+
+		residency.BeginFrame(11);
+		std::vector<ResidencyAction> actions = residency.Update();
+		Check(actions.empty() && residency.GetTargetMip(texture) == 0, "kept through the idle window");
+
+		residency.BeginFrame(12);
+		actions = residency.Update();
+		Check(actions.size() == 1 && SameAction(actions[0], ResidencyActionType::Evict, texture, 0, 2), "dropped to its tail after it");
+	}
+
+	// A fixed mixed script: budget swings, uses, and stream-ins
+	// that finish a few frames after they start
+	std::vector<ResidencyAction> Replay()
+	{
+		std::vector<ResidencyAction> log;
+		std::vector<ResidencyAction> loading;
+		TextureResidency residency(3 * Full);
+		residency.SetIdleFrames(20);
+		for (int i = 0; i < 8; i++)
+			residency.AddTexture(i % 3 ? Texture : ResidencyTextureDesc{ 512, 256, 10, 16, false }, 4);
+
+		for (unsigned long long frame = 1; frame <= 200; frame++)
+		{
+			residency.BeginFrame(frame);
+			for (int i = 0; i < 8; i++)
+				if ((frame * 7 + i * 13) % 5 < 2)
+					residency.ReportUse(i, (float)((frame * 31 + i * 17) % 300));
+			if (frame % 50 == 0)
+				residency.SetBudget(frame % 100 ? Full : 4 * Full);
+
+			if (frame % 3 == 0 && !loading.empty())
+			{
+				residency.SetResidentMip(loading.front().texture, loading.front().toMip);
+				loading.erase(loading.begin());
+			}
+
+			std::vector<ResidencyAction> actions = residency.Update();
+			for (const ResidencyAction& a : actions)
+			{
+				log.push_back(a);
+				if (a.type == ResidencyActionType::Evict)
+					residency.SetResidentMip(a.texture, a.toMip);
+				else
+					loading.push_back(a);
+			}
+		}
+		return log;
+	}
+
+	void CheckReplay()
+	{
+		printf("Replay\n");
+
+		std::vector<ResidencyAction> first = Replay();
+		std::vector<ResidencyAction> second = Replay();
+		bool same = first.size() == second.size() && !first.empty();
+		for (size_t i = 0; same && i < first.size(); i++)
+			same = SameAction(second[i], first[i].type, first[i].texture, first[i].fromMip, first[i].toMip);
+		printf("       %d actions\n", (int)first.size());
+		Check(same, "same script, same actions");
+	}
+}
+
+int main()
+{
+	CheckSizes();
+	CheckBudgetAndLru();
+	CheckTies();
+	CheckFloors();
+	CheckStreaming();
+	CheckIdle();
+	CheckReplay();
+
+	if (failures)
+	{
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
@@ -1,4 +1,5 @@
 #include "Transform.h"
+#include <cmath>
 
 // Set Position, Rotation, Scale to 1, 1, 1
 // Then Set both matrices to the identity matrix
@@ -12,6 +13,7 @@ Transform::Transform() :
 
 	// dirty flag to use when calling World Matrix
 	dirtyMatrices = true;
+	version = 0;
 }
 
 Transform::~Transform()
@@ -26,6 +28,7 @@ void Transform::SetPosition(float x, float y, float z)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 
 }
 
@@ -35,6 +38,7 @@ void Transform::SetPosition(DirectX::XMFLOAT3 _position)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 
 }
 
@@ -46,6 +50,7 @@ void Transform::SetRotation(float pitch, float yaw, float roll)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 
 }
 
@@ -55,6 +60,7 @@ void Transform::SetRotation(DirectX::XMFLOAT3 _rotation)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 
 }
 
@@ -66,6 +72,7 @@ void Transform::SetScale(float x, float y, float z)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 
 }
 
@@ -75,6 +82,7 @@ void Transform::SetScale(DirectX::XMFLOAT3 _scale)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 }
 
 DirectX::XMFLOAT3 Transform::GetPosition()
@@ -92,6 +100,37 @@ DirectX::XMFLOAT3 Transform::GetScale()
 	return scale;
 }
 
+unsigned int Transform::GetVersion()
+{
+	return version;
+}
+
+TransformState Transform::GetState()
+{
+	TransformState state = { position, rotation, scale };
+	return state;
+}
+
+void Transform::GetInterpolatedMatrices(const TransformState& from, float alpha, DirectX::XMFLOAT4X4& world, DirectX::XMFLOAT4X4& worldInvTrans)
+{
+	// Rotations blend as quaternions, which also takes the short way
+	// round when an angle has wrapped
+	DirectX::XMVECTOR rotationFrom = DirectX::XMQuaternionRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&from.rotation));
+	DirectX::XMVECTOR rotationTo = DirectX::XMQuaternionRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&rotation));
+
+	DirectX::XMMATRIX translationMatrix = DirectX::XMMatrixTranslationFromVector(
+		DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&from.position), DirectX::XMLoadFloat3(&position), alpha));
+	DirectX::XMMATRIX rotationMatrix = DirectX::XMMatrixRotationQuaternion(
+		DirectX::XMQuaternionSlerp(rotationFrom, rotationTo, alpha));
+	DirectX::XMMATRIX scalingMatrix = DirectX::XMMatrixScalingFromVector(
+		DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&from.scale), DirectX::XMLoadFloat3(&scale), alpha));
+
+	// Same order as CalculateMatrices()
+	DirectX::XMMATRIX blended = DirectX::XMMatrixMultiply(XMMatrixMultiply(scalingMatrix, rotationMatrix), translationMatrix);
+	DirectX::XMStoreFloat4x4(&world, blended);
+	DirectX::XMStoreFloat4x4(&worldInvTrans, XMMatrixInverse(0, XMMatrixTranspose(blended)));
+}
+
 DirectX::XMFLOAT4X4 Transform::GetWorldMatrix()
 {
 	CalculateMatrices();
@@ -122,6 +161,7 @@ void Transform::MoveAbsolute(float x, float y, float z)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 }
 
 void Transform::MoveAbsolute(DirectX::XMFLOAT3 offset)
@@ -138,6 +178,7 @@ void Transform::MoveAbsolute(DirectX::XMFLOAT3 offset)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 }
 
 void Transform::MoveRelative(float x, float y, float z)
@@ -154,6 +195,7 @@ void Transform::MoveRelative(float x, float y, float z)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 }
 
 void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
@@ -175,6 +217,7 @@ void Transform::Rotate(float pitch, float yaw, float roll)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 }
 
 void Transform::Rotate(DirectX::XMFLOAT3 _rotation)
@@ -191,6 +234,7 @@ void Transform::Rotate(DirectX::XMFLOAT3 _rotation)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 }
 
 void Transform::Scale(float x, float y, float z)
@@ -207,6 +251,7 @@ void Transform::Scale(float x, float y, float z)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 }
 
 void Transform::Scale(DirectX::XMFLOAT3 _scale)
@@ -223,6 +268,7 @@ void Transform::Scale(DirectX::XMFLOAT3 _scale)
 
 	// Matrix was changed
 	dirtyMatrices = true;
+	version++;
 }
 
 DirectX::XMFLOAT3 Transform::GetRight()
@@ -294,3 +340,18 @@ void Transform::CalculateMatrices() {
 		dirtyMatrices = false;
 	}
 }
+
+void Transform::GetWorldBoundingSphere(DirectX::XMFLOAT3 localCenter, float localRadius, DirectX::XMFLOAT3& center, float& radius)
+{
+	// Move the local center into the world
+	DirectX::XMFLOAT4X4 world = GetWorldMatrix();
+	DirectX::XMStoreFloat3(&center, DirectX::XMVector3TransformCoord(
+		DirectX::XMLoadFloat3(&localCenter),
+		DirectX::XMLoadFloat4x4(&world)));
+
+	// Non-uniform scale stretches the sphere by the largest axis
+	float maxScale = fabsf(scale.x);
+	if (fabsf(scale.y) > maxScale) maxScale = fabsf(scale.y);
+	if (fabsf(scale.z) > maxScale) maxScale = fabsf(scale.z);
+	radius = localRadius * maxScale;
+}
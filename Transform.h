@@ -1,5 +1,14 @@
 #pragma once
 #include <DirectXMath.h>
+
+// Position, rotation and scale without the matrices, for
+// remembering where a Transform was
+struct TransformState {
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 rotation;		// Pitch, yaw, roll
+	DirectX::XMFLOAT3 scale;
+};
+
 class Transform
 {
 public:
@@ -21,6 +30,15 @@ public:
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
 
+	// Incremented on every change, lets other systems
+	// (like shadow caching) detect movement since they last looked
+	unsigned int GetVersion();
+
+	// For blending between simulation steps: the matrices part
+	// way from an earlier state (alpha 0) to this one (alpha 1)
+	TransformState GetState();
+	void GetInterpolatedMatrices(const TransformState& from, float alpha, DirectX::XMFLOAT4X4& world, DirectX::XMFLOAT4X4& worldInvTrans);
+
 	// Transformers
 	void MoveAbsolute(float x, float y, float z);
 	void MoveAbsolute(DirectX::XMFLOAT3 offset);
@@ -36,6 +54,10 @@ public:
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetForward();
 
+	// A local space bounding sphere moved into world space
+	// (the radius grows with the largest scale)
+	void GetWorldBoundingSphere(DirectX::XMFLOAT3 localCenter, float localRadius, DirectX::XMFLOAT3& center, float& radius);
+
 	
 
 
@@ -54,5 +76,8 @@ private:
 	// Dirty Flag
 	bool dirtyMatrices;
 
+	// Change counter
+	unsigned int version;
+
 };
 
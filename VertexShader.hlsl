@@ -40,7 +40,10 @@ VertexToPixel main( VertexShaderInput input )
 	//   which we're leaving at 1.0 for now (this is more useful when dealing with 
 	//   a perspective projection matrix, which we'll get to in the future).
     matrix wvp = mul(projection, mul(view, world));
-    output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+
+    // precise so depth matches the pre-pass in ShadowVS.hlsl exactly
+    precise float4 screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+    output.screenPosition = screenPosition;
 
 	// Pass the color through 
 	// - The values will be interpolated per-pixel by the rasterizer
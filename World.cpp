@@ -0,0 +1,311 @@
+#include "World.h"
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+namespace
+{
+	// Chunks start on a cache line
+	const size_t ChunkAlignment = 64;
+
+	std::mutex registryMutex;
+	std::vector<ComponentInfo>& Registry()
+	{
+		// Reserved up front so GetComponentInfo() references stay put
+		static std::vector<ComponentInfo> registry = [] {
+			std::vector<ComponentInfo> infos;
+			infos.reserve(MAX_COMPONENT_TYPES);
+			return infos;
+		}();
+		return registry;
+	}
+
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+World::World() :
+	count(0)
+{
+}
+
+World::~World()
+{
+	Clear();
+	for (Archetype* archetype : archetypes)
+		delete archetype;
+}
+
+int World::RegisterComponent(const ComponentInfo& info)
+{
+	std::lock_guard<std::mutex> lock(registryMutex);
+	std::vector<ComponentInfo>& registry = Registry();
+	if (registry.size() >= MAX_COMPONENT_TYPES)
+	{
+		printf("World: more than %d component types (%s)\n", MAX_COMPONENT_TYPES, info.name);
+		abort();
+	}
+	registry.push_back(info);
+	return (int)registry.size() - 1;
+}
+
+const ComponentInfo& World::GetComponentInfo(int id)
+{
+	return Registry()[id];
+}
+
+EntityHandle World::Create()
+{
+	return CreateIn(0);
+}
+
+EntityHandle World::CreateIn(ComponentMask mask)
+{
+	unsigned int slot;
+	if (!freeSlots.empty())
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (unsigned int)slots.size();
+		slots.push_back({ 0, 0, 0, 0 });
+	}
+
+	Slot& s = slots[slot];
+	s.archetype = GetArchetype(mask);
+	AddRow(*s.archetype, slot, s.chunk, s.row);
+	for (size_t c = 0; c < s.archetype->infos.size(); c++)
+		s.archetype->infos[c]->construct(Element(*s.archetype, s.chunk, s.row, (int)c));
+	count++;
+	return { slot, s.generation };
+}
+
+bool World::Destroy(EntityHandle entity)
+{
+	if (!IsAlive(entity))
+		return false;
+
+	Slot& slot = slots[entity.index];
+	Archetype& archetype = *slot.archetype;
+	for (size_t c = 0; c < archetype.infos.size(); c++)
+		archetype.infos[c]->destroy(Element(archetype, slot.chunk, slot.row, (int)c));
+	RemoveRow(archetype, slot.chunk, slot.row);
+
+	// Old handles to this slot stop resolving
+	slot.archetype = 0;
+	slot.generation++;
+	freeSlots.push_back(entity.index);
+	count--;
+	return true;
+}
+
+void World::Clear()
+{
+	for (Archetype* archetype : archetypes)
+	{
+		for (size_t c = 0; c < archetype->infos.size(); c++)
+		{
+			const ComponentInfo& info = *archetype->infos[c];
+			for (Chunk& chunk : archetype->chunks)
+				for (int row = 0; row < chunk.count; row++)
+					info.destroy(chunk.memory + archetype->offsets[c] + row * info.size);
+		}
+		for (Chunk& chunk : archetype->chunks)
+			::operator delete(chunk.memory, std::align_val_t(ChunkAlignment));
+		archetype->chunks.clear();
+		archetype->count = 0;
+	}
+
+	for (unsigned int i = 0; i < slots.size(); i++)
+	{
+		if (!slots[i].archetype)
+			continue;
+		slots[i].archetype = 0;
+		slots[i].generation++;
+		freeSlots.push_back(i);
+	}
+	count = 0;
+}
+
+bool World::IsAlive(EntityHandle entity) const
+{
+	return entity.IsValid() &&
+		entity.index < slots.size() &&
+		slots[entity.index].archetype != 0 &&
+		slots[entity.index].generation == entity.generation;
+}
+
+int World::GetCount() const
+{
+	return count;
+}
+
+WorldStats World::GetStats() const
+{
+	WorldStats stats = {};
+	stats.entities = count;
+	stats.archetypes = (int)archetypes.size();
+	for (Archetype* archetype : archetypes)
+	{
+		stats.chunks += (int)archetype->chunks.size();
+		stats.chunkBytes += archetype->chunks.size() * archetype->chunkBytes;
+	}
+	return stats;
+}
+
+// --------------------------------------------------------
+// Finds or makes the archetype for a set of components,
+// laying out its chunks: the handles first, then one
+// aligned array per component
+// --------------------------------------------------------
+World::Archetype* World::GetArchetype(ComponentMask mask)
+{
+	for (Archetype* archetype : archetypes)
+		if (archetype->mask == mask)
+			return archetype;
+
+	Archetype* archetype = new Archetype();
+	archetype->mask = mask;
+	archetype->count = 0;
+	for (int id = 0; id < MAX_COMPONENT_TYPES; id++)
+	{
+		archetype->columns[id] = -1;
+		if (mask & Bit(id))
+		{
+			archetype->columns[id] = (int)archetype->components.size();
+			archetype->components.push_back(id);
+			archetype->infos.push_back(&GetComponentInfo(id));
+		}
+	}
+
+	// As many rows as fit, counting the padding between arrays
+	size_t rowBytes = sizeof(EntityHandle);
+	for (const ComponentInfo* info : archetype->infos)
+		rowBytes += info->size;
+	int capacity = (int)(ChunkSize / rowBytes);
+	if (capacity < 1)
+		capacity = 1;
+
+	size_t bytes;
+	while (true)
+	{
+		archetype->offsets.clear();
+		bytes = sizeof(EntityHandle) * capacity;
+		for (const ComponentInfo* info : archetype->infos)
+		{
+			bytes = AlignUp(bytes, info->alignment);
+			archetype->offsets.push_back(bytes);
+			bytes += info->size * capacity;
+		}
+		if (bytes <= ChunkSize || capacity == 1)
+			break;
+		capacity--;
+	}
+
+	// Anything too big for one chunk gets one row per (larger) chunk
+	archetype->capacity = capacity;
+	archetype->chunkBytes = AlignUp(bytes > ChunkSize ? bytes : ChunkSize, ChunkAlignment);
+	archetypes.push_back(archetype);
+	return archetype;
+}
+
+void* World::Find(EntityHandle entity, int id)
+{
+	if (!IsAlive(entity))
+		return 0;
+
+	Slot& slot = slots[entity.index];
+	int column = slot.archetype->columns[id];
+	if (column < 0)
+		return 0;
+	return Element(*slot.archetype, slot.chunk, slot.row, column);
+}
+
+void* World::Element(Archetype& archetype, int chunk, int row, int column)
+{
+	return archetype.chunks[chunk].memory + archetype.offsets[column] + row * archetype.infos[column]->size;
+}
+
+// --------------------------------------------------------
+// Components both archetypes share are moved across, new
+// ones are default constructed, dropped ones destroyed
+// --------------------------------------------------------
+void* World::MoveEntity(EntityHandle entity, ComponentMask mask, int id)
+{
+	Slot& slot = slots[entity.index];
+	Archetype& from = *slot.archetype;
+	Archetype& to = *GetArchetype(mask);
+
+	int chunk, row;
+	AddRow(to, entity.index, chunk, row);
+
+	for (size_t c = 0; c < to.components.size(); c++)
+	{
+		void* destination = Element(to, chunk, row, (int)c);
+		int oldColumn = from.columns[to.components[c]];
+		if (oldColumn >= 0)
+			to.infos[c]->moveConstruct(destination, Element(from, slot.chunk, slot.row, oldColumn));
+		else
+			to.infos[c]->construct(destination);
+	}
+
+	// Whatever was moved out still needs its destructor run
+	for (size_t c = 0; c < from.infos.size(); c++)
+		from.infos[c]->destroy(Element(from, slot.chunk, slot.row, (int)c));
+	RemoveRow(from, slot.chunk, slot.row);
+
+	slot.archetype = &to;
+	slot.chunk = chunk;
+	slot.row = row;
+	return id >= 0 ? Element(to, chunk, row, to.columns[id]) : 0;
+}
+
+void World::AddRow(Archetype& archetype, unsigned int slot, int& chunk, int& row)
+{
+	if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity)
+	{
+		Chunk fresh;
+		fresh.memory = (unsigned char*)::operator new(archetype.chunkBytes, std::align_val_t(ChunkAlignment));
+		fresh.count = 0;
+		archetype.chunks.push_back(fresh);
+	}
+
+	chunk = (int)archetype.chunks.size() - 1;
+	row = archetype.chunks[chunk].count++;
+	Handles(archetype.chunks[chunk])[row] = { slot, slots[slot].generation };
+	archetype.count++;
+}
+
+void World::RemoveRow(Archetype& archetype, int chunk, int row)
+{
+	int lastChunk = (int)archetype.chunks.size() - 1;
+	int lastRow = archetype.chunks[lastChunk].count - 1;
+
+	if (chunk != lastChunk || row != lastRow)
+	{
+		// The archetype's last entity moves into the hole
+		for (size_t c = 0; c < archetype.infos.size(); c++)
+		{
+			void* last = Element(archetype, lastChunk, lastRow, (int)c);
+			archetype.infos[c]->moveConstruct(Element(archetype, chunk, row, (int)c), last);
+			archetype.infos[c]->destroy(last);
+		}
+
+		EntityHandle moved = Handles(archetype.chunks[lastChunk])[lastRow];
+		Handles(archetype.chunks[chunk])[row] = moved;
+		slots[moved.index].chunk = chunk;
+		slots[moved.index].row = row;
+	}
+
+	// Empty chunks go back to the heap
+	if (--archetype.chunks[lastChunk].count == 0)
+	{
+		::operator delete(archetype.chunks[lastChunk].memory, std::align_val_t(ChunkAlignment));
+		archetype.chunks.pop_back();
+	}
+	archetype.count--;
+}
@@ -0,0 +1,296 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// Reference to an entity in a World
+//
+// Like ResourceHandle, the generation catches handles that
+// outlived their entity: once it's destroyed, old handles
+// to its slot stop resolving.
+// --------------------------------------------------------
+struct EntityHandle {
+	unsigned int index = 0xFFFFFFFF;		// Slot
+	unsigned int generation = 0;
+
+	bool IsValid() const { return index != 0xFFFFFFFF; }
+	bool operator==(const EntityHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+namespace std
+{
+	template <>
+	struct hash<EntityHandle> {
+		size_t operator()(const EntityHandle& handle) const
+		{
+			return std::hash<unsigned long long>()(((unsigned long long)handle.generation << 32) | handle.index);
+		}
+	};
+}
+
+// One bit per component type
+typedef uint64_t ComponentMask;
+#define MAX_COMPONENT_TYPES 64
+
+// How to build, move and tear down a component in raw memory
+struct ComponentInfo {
+	const char* name;
+	size_t size;
+	size_t alignment;
+	void (*construct)(void* memory);
+	void (*moveConstruct)(void* memory, void* source);
+	void (*destroy)(void* memory);
+};
+
+struct WorldStats {
+	int entities;
+	int archetypes;
+	int chunks;
+	size_t chunkBytes;
+};
+
+// --------------------------------------------------------
+// Entities and their components, stored by archetype
+//
+// - Every distinct set of components is an archetype, and
+//   its entities live in fixed-size chunks with one array
+//   per component (structure of arrays), so a query walks
+//   each array linearly
+// - Adding or removing a component moves the entity to the
+//   archetype for its new set; destroying one moves the
+//   archetype's last entity into the hole
+// - Any type can be a component; it's registered the first
+//   time it's used
+//
+// Pointers and references into components are only good
+// until the next Create/Add/Remove/Destroy, and none of those
+// may happen inside Each() or EachChunk().
+// --------------------------------------------------------
+class World
+{
+public:
+	World();
+	~World();
+	World(const World&) = delete;
+	World& operator=(const World&) = delete;
+
+	// Bytes per chunk; archetypes fit as many entities as they can
+	static const size_t ChunkSize = 16 * 1024;
+
+	EntityHandle Create();
+	bool Destroy(EntityHandle entity);
+
+	// Creates the entity straight in the archetype for its
+	// components, rather than moving it once per Add()
+	template <typename T, typename... Rest>
+	EntityHandle Create(T first, Rest... rest)
+	{
+		EntityHandle entity = CreateIn(MaskOf<T, Rest...>());
+		Assign(entity, std::move(first), std::move(rest)...);
+		return entity;
+	}
+	void Clear();
+
+	bool IsAlive(EntityHandle entity) const;
+	int GetCount() const;
+	WorldStats GetStats() const;
+
+	// Adds (or overwrites) a component and returns it, or
+	// null if the entity is gone
+	template <typename T>
+	T* Add(EntityHandle entity, T value = T())
+	{
+		if (!IsAlive(entity))
+			return 0;
+
+		int id = ComponentId<T>();
+		T* component = (T*)Find(entity, id);
+		if (!component)
+			component = (T*)MoveEntity(entity, slots[entity.index].archetype->mask | Bit(id), id);
+		*component = std::move(value);
+		return component;
+	}
+
+	template <typename T>
+	void Remove(EntityHandle entity)
+	{
+		int id = ComponentId<T>();
+		if (Find(entity, id))
+			MoveEntity(entity, slots[entity.index].archetype->mask & ~Bit(id), -1);
+	}
+
+	// Null if the entity is gone or doesn't have one
+	template <typename T>
+	T* Get(EntityHandle entity)
+	{
+		return (T*)Find(entity, ComponentId<T>());
+	}
+
+	template <typename T>
+	bool Has(EntityHandle entity)
+	{
+		return Find(entity, ComponentId<T>()) != 0;
+	}
+
+	// f(EntityHandle, T&...) for every entity with all of T.
+	// Ask for const T to only read it.
+	template <typename... T, typename F>
+	void Each(F&& f)
+	{
+		ComponentMask required = MaskOf<T...>();
+		for (Archetype* archetype : archetypes)
+		{
+			if ((archetype->mask & required) != required)
+				continue;
+			for (Chunk& chunk : archetype->chunks)
+				RunRows(f, chunk.count, Handles(chunk), Column<T>(*archetype, chunk)...);
+		}
+	}
+
+	// f(count, const EntityHandle*, T*...) once per chunk, for
+	// loops that want the arrays themselves
+	template <typename... T, typename F>
+	void EachChunk(F&& f)
+	{
+		ComponentMask required = MaskOf<T...>();
+		for (Archetype* archetype : archetypes)
+		{
+			if ((archetype->mask & required) != required)
+				continue;
+			for (Chunk& chunk : archetype->chunks)
+				f(chunk.count, (const EntityHandle*)Handles(chunk), Column<T>(*archetype, chunk)...);
+		}
+	}
+
+	// How many entities Each<T...>() would visit
+	template <typename... T>
+	int Count()
+	{
+		ComponentMask required = MaskOf<T...>();
+		int total = 0;
+		for (Archetype* archetype : archetypes)
+			if ((archetype->mask & required) == required)
+				total += archetype->count;
+		return total;
+	}
+
+	// Component type ids, shared by every World (const T is T)
+	template <typename T>
+	static int ComponentId()
+	{
+		return TypeId<typename std::remove_const<T>::type>();
+	}
+
+	template <typename... T>
+	static ComponentMask MaskOf()
+	{
+		ComponentMask mask = 0;
+		int ids[] = { 0, ComponentId<T>()... };
+		for (size_t i = 1; i < sizeof(ids) / sizeof(ids[0]); i++)
+			mask |= Bit(ids[i]);
+		return mask;
+	}
+
+	static const ComponentInfo& GetComponentInfo(int id);
+
+private:
+	struct Chunk {
+		unsigned char* memory;
+		int count;
+	};
+
+	struct Archetype {
+		ComponentMask mask;
+		std::vector<int> components;		// Ids, in bit order
+		std::vector<const ComponentInfo*> infos;
+		int columns[MAX_COMPONENT_TYPES];	// Id to index in components, or -1
+		std::vector<size_t> offsets;		// Where each component's array starts in a chunk
+		int capacity;						// Entities per chunk
+		size_t chunkBytes;
+		int count;
+		std::vector<Chunk> chunks;			// All full but the last
+	};
+
+	struct Slot {
+		Archetype* archetype;
+		int chunk;
+		int row;
+		unsigned int generation;
+	};
+
+	static ComponentMask Bit(int id) { return (ComponentMask)1 << id; }
+	static int RegisterComponent(const ComponentInfo& info);
+
+	template <typename T>
+	static int TypeId()
+	{
+		static const int id = RegisterComponent(MakeInfo<T>());
+		return id;
+	}
+
+	template <typename T>
+	static ComponentInfo MakeInfo()
+	{
+		ComponentInfo info;
+		info.name = typeid(T).name();
+		info.size = sizeof(T);
+		info.alignment = alignof(T);
+		info.construct = [](void* memory) { new (memory) T(); };
+		info.moveConstruct = [](void* memory, void* source) { new (memory) T(std::move(*(T*)source)); };
+		info.destroy = [](void* memory) { ((T*)memory)->~T(); };
+		return info;
+	}
+
+	template <typename F, typename... T>
+	static void RunRows(F& f, int count, EntityHandle* handles, T*... columns)
+	{
+		for (int i = 0; i < count; i++)
+			f(handles[i], columns[i]...);
+	}
+
+	static EntityHandle* Handles(Chunk& chunk) { return (EntityHandle*)chunk.memory; }
+
+	template <typename T>
+	static T* Column(Archetype& archetype, Chunk& chunk)
+	{
+		return (T*)(chunk.memory + archetype.offsets[archetype.columns[ComponentId<T>()]]);
+	}
+
+	template <typename T, typename... Rest>
+	void Assign(EntityHandle entity, T&& first, Rest&&... rest)
+	{
+		*(T*)Find(entity, ComponentId<T>()) = std::move(first);
+		if constexpr (sizeof...(Rest) > 0)
+			Assign(entity, std::move(rest)...);
+	}
+
+	// A new entity with default constructed components
+	EntityHandle CreateIn(ComponentMask mask);
+
+	Archetype* GetArchetype(ComponentMask mask);
+	void* Find(EntityHandle entity, int id);
+	void* Element(Archetype& archetype, int chunk, int row, int column);
+
+	// Moves the entity to the archetype for mask, returning
+	// component id's storage in the new one (or null)
+	void* MoveEntity(EntityHandle entity, ComponentMask mask, int id);
+
+	// Claims a row at the end of the archetype
+	void AddRow(Archetype& archetype, unsigned int slot, int& chunk, int& row);
+
+	// Fills the row with the archetype's last entity (its
+	// components must already be destroyed or moved out)
+	void RemoveRow(Archetype& archetype, int chunk, int row);
+
+	std::vector<Archetype*> archetypes;
+	std::vector<Slot> slots;
+	std::vector<unsigned int> freeSlots;
+	int count;
+};